@@ -27,6 +27,7 @@
 #include "sln_local_voice.h"
 #include "sln_dsp_toolbox.h"
 #include "sln_afe.h"
+#include "sln_audio_tap.h"
 
 /* LED include. */
 #include "sln_RT10xx_RGB_LED_driver.h"
@@ -76,8 +77,6 @@ static uint32_t s_numItems    = 0;
 static uint32_t s_waterMark   = 0;
 static uint32_t s_outputIndex = 0;
 
-uint8_t *cloud_buffer;
-uint32_t cloud_buffer_len = 0;
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -189,10 +188,15 @@ void audio_processing_task(void *pvParameters)
         // Process microphone streams
         int16_t *pcmIn = (int16_t *)((*s_micInputStream)[pingPongIdx]);
 
+        // Capture the AFE inputs for the audio tap, if a client is connected
+        SLN_AUDIO_TAP_WriteInputs(pcmIn, &s_ampInputStream[pingPongAmpIdx * PCM_SINGLE_CH_SMPL_COUNT]);
+
         // Run mic streams through the AFE
         SLN_AFE_Process_Audio(&s_afe_mem_pool, pcmIn, &s_ampInputStream[pingPongAmpIdx * PCM_SINGLE_CH_SMPL_COUNT],
                               cleanAudioBuff);
 
+        SLN_AUDIO_TAP_WriteOutput((int16_t *)cleanAudioBuff);
+
         // Pass output of AFE to wake word
         memcpy((uint8_t *)g_out_ptr, (uint8_t *)cleanAudioBuff, PCM_SINGLE_CH_SMPL_COUNT * 2);
         g_out_ptr += PCM_SINGLE_CH_SMPL_COUNT;
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "fsl_common.h"
+#include "loopback_ring.h"
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void loopback_ring_init(loopback_ring_t *ring, uint8_t *buffer, uint32_t size)
+{
+    memset(ring, 0, sizeof(loopback_ring_t));
+
+    ring->buffer = buffer;
+    ring->size   = size;
+}
+
+uint32_t loopback_ring_get_occupancy(loopback_ring_t *ring)
+{
+    uint32_t head = ring->head;
+    uint32_t tail = ring->tail;
+
+    return (head >= tail) ? (head - tail) : (ring->size - tail + head);
+}
+
+bool loopback_ring_write(
+    loopback_ring_t *ring, const uint8_t *data, uint32_t length, uint32_t timestamp, bool newSegment)
+{
+    uint32_t head  = ring->head;
+    uint32_t first = 0;
+
+    if ((ring->buffer == NULL) || (length > (ring->size - 1 - loopback_ring_get_occupancy(ring))) ||
+        (newSegment && ((ring->segmentHead - ring->segmentTail) >= LOOPBACK_RING_SEGMENTS)))
+    {
+        ring->overruns++;
+        return false;
+    }
+
+    first = MIN(length, ring->size - head);
+    memcpy(&ring->buffer[head], data, first);
+    memcpy(ring->buffer, &data[first], length - first);
+
+    /* Publish the segment before the data, so the consumer sees it as soon as it sees the data */
+    if (newSegment)
+    {
+        ring->segments[ring->segmentHead % LOOPBACK_RING_SEGMENTS].index     = head;
+        ring->segments[ring->segmentHead % LOOPBACK_RING_SEGMENTS].timestamp = timestamp;
+        __DMB();
+        ring->segmentHead++;
+    }
+
+    __DMB();
+    ring->head = (head + length) % ring->size;
+
+    return true;
+}
+
+bool loopback_ring_is_reader_active(loopback_ring_t *ring)
+{
+    return ring->readerActive;
+}
+
+void loopback_ring_request_reset(loopback_ring_t *ring)
+{
+    ring->resetRequest++;
+}
+
+bool loopback_ring_apply_reset(loopback_ring_t *ring)
+{
+    uint32_t request = ring->resetRequest;
+
+    if (request == ring->resetDone)
+    {
+        return false;
+    }
+
+    /* Only the consumer moves tail, so the reset is done on its side */
+    ring->tail        = ring->head;
+    ring->segmentTail = ring->segmentHead;
+    ring->resetDone   = request;
+    __DMB();
+
+    return true;
+}
+
+bool loopback_ring_take_segment(loopback_ring_t *ring, loopback_segment_t *segment)
+{
+    loopback_segment_t *next;
+
+    /* Segments are published before their data: check the data first */
+    if ((loopback_ring_get_occupancy(ring) == 0) || (ring->segmentTail == ring->segmentHead))
+    {
+        return false;
+    }
+    __DMB();
+
+    next = &ring->segments[ring->segmentTail % LOOPBACK_RING_SEGMENTS];
+    if (next->index != ring->tail)
+    {
+        return false;
+    }
+
+    *segment = *next;
+    ring->segmentTail++;
+
+    return true;
+}
+
+uint32_t loopback_ring_get_read_span(loopback_ring_t *ring, const uint8_t **span)
+{
+    uint32_t head;
+    uint32_t tail;
+
+    ring->readerActive = true;
+
+    head = ring->head;
+    tail = ring->tail;
+    __DMB();
+
+    *span = &ring->buffer[tail];
+
+    return (head >= tail) ? (head - tail) : (ring->size - tail);
+}
+
+void loopback_ring_consume(loopback_ring_t *ring, uint32_t length)
+{
+    /* Done with the data before handing the space back to the producer */
+    __DMB();
+    ring->tail = (ring->tail + length) % ring->size;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __LOOPBACK_RING_H__
+#define __LOOPBACK_RING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ * @addtogroup loopback_ring
+ * @{
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Number of playback segments that can be pending in the ring */
+#define LOOPBACK_RING_SEGMENTS 4
+
+/*! @brief Start of a playback, the amplifier data following it starts playing at timestamp */
+typedef struct _loopback_segment
+{
+    uint32_t index;
+    uint32_t timestamp;
+} loopback_segment_t;
+
+/*!
+ * @brief Single producer / single consumer byte ring used for the amplifier reference signal.
+ * The producer (amplifier) only moves head, the consumer (pdm_to_pcm_task) only moves tail,
+ * so no lock is needed on either side.
+ */
+typedef struct _loopback_ring
+{
+    uint8_t *buffer;
+    uint32_t size;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    loopback_segment_t segments[LOOPBACK_RING_SEGMENTS];
+    volatile uint32_t segmentHead;
+    volatile uint32_t segmentTail;
+    volatile uint32_t resetRequest;
+    uint32_t resetDone;
+    volatile bool readerActive;
+    volatile uint32_t overruns;
+} loopback_ring_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /*_cplusplus*/
+
+/*!
+ * @brief Initialize the ring over a buffer. One byte of the buffer is never used.
+ *
+ * @param ring Pointer to the ring
+ * @param buffer Storage of the ring, must be 2 bytes aligned
+ * @param size Size of the storage in bytes, must be even
+ */
+void loopback_ring_init(loopback_ring_t *ring, uint8_t *buffer, uint32_t size);
+
+/*!
+ * @brief Get the number of bytes waiting to be read. Can be called from both sides.
+ */
+uint32_t loopback_ring_get_occupancy(loopback_ring_t *ring);
+
+/*!
+ * @brief Producer side. Write a packet, it is written whole or not at all.
+ *
+ * @param ring Pointer to the ring
+ * @param data Pointer to the data
+ * @param length Length of the data
+ * @param timestamp Start time of the packet. Used only when the packet starts a new segment.
+ * @param newSegment true if the packet is the first one of a playback
+ * @returns true if the packet was written, false if it did not fit
+ */
+bool loopback_ring_write(
+    loopback_ring_t *ring, const uint8_t *data, uint32_t length, uint32_t timestamp, bool newSegment);
+
+/*!
+ * @brief Producer side. Check if the consumer started reading the ring.
+ */
+bool loopback_ring_is_reader_active(loopback_ring_t *ring);
+
+/*!
+ * @brief Any side. Ask the consumer to drop all the data, done by loopback_ring_apply_reset.
+ */
+void loopback_ring_request_reset(loopback_ring_t *ring);
+
+/*!
+ * @brief Consumer side. Drop all the data if a reset was requested. To be called before reading.
+ *
+ * @param ring Pointer to the ring
+ * @returns true if the data was dropped
+ */
+bool loopback_ring_apply_reset(loopback_ring_t *ring);
+
+/*!
+ * @brief Consumer side. Get the segment starting at the read position, if any.
+ * A segment is only reported once its first packet is available.
+ *
+ * @param ring Pointer to the ring
+ * @param segment Filled with the segment
+ * @returns true if a segment starts at the read position
+ */
+bool loopback_ring_take_segment(loopback_ring_t *ring, loopback_segment_t *segment);
+
+/*!
+ * @brief Consumer side. Get the contiguous span that can be read without copy.
+ *
+ * @param ring Pointer to the ring
+ * @param span Filled with the address of the span
+ * @returns Length of the span in bytes, 0 if the ring is empty
+ */
+uint32_t loopback_ring_get_read_span(loopback_ring_t *ring, const uint8_t **span);
+
+/*!
+ * @brief Consumer side. Release bytes returned by loopback_ring_get_read_span.
+ */
+void loopback_ring_consume(loopback_ring_t *ring, uint32_t length);
+
+#if defined(__cplusplus)
+}
+#endif /*_cplusplus*/
+
+/*! @} */
+
+#endif /* __LOOPBACK_RING_H__ */
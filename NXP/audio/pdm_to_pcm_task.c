@@ -19,10 +19,10 @@
 #include "pdm_to_pcm_task.h"
 #include "pdm_pcm_definitions.h"
 #include "sln_pdm_mic.h"
+#include "sln_metrics.h"
 
 #if USE_MQS
-#include "semphr.h"
-#include "ringbuffer.h"
+#include "loopback_ring.h"
 #endif
 
 #if defined(SLN_DSP_TOOLBOX_LIB)
@@ -58,6 +58,10 @@
  * Global Vars
  ******************************************************************************/
 
+SLN_METRICS_DEFINE_COUNTER(s_saiRepairs, "audio.sai_repairs");
+SLN_METRICS_DEFINE_COUNTER(s_loopbackRepairs, "audio.loopback_repairs");
+SLN_METRICS_DEFINE_COUNTER(s_missedEvents, "audio.missed_events");
+
 #if SAI1_CH_COUNT
 __attribute__((aligned(8))) uint32_t g_Sai1PdmPingPong[EDMA_TCD_COUNT][PDM_SAMPLE_COUNT * SAI1_CH_COUNT];
 
@@ -100,6 +104,10 @@ bool g_decimationStarted = false;
 __attribute__((section(".data.$SRAM_DTC")))
 __attribute__((aligned(2))) static int16_t s_AmpRXDataBuffer[PCM_AMP_SAMPLE_COUNT];
 volatile static uint32_t s_pingPongTimestamp = 0;
+/* Ping/Pong timestamp of the previous pdm_to_pcm_prepare_amp_data call */
+static uint32_t s_lastReadTimestamp = 0;
+/* Zeroes still to be inserted before the current playback */
+static uint32_t s_loopbackPadBytes = 0;
 #endif /* USE_MQS */
 
 /*******************************************************************************
@@ -108,7 +116,7 @@ volatile static uint32_t s_pingPongTimestamp = 0;
 
 #if USE_MQS
 /*!
- * @brief * Read the loopback data (if exists) from the amplifier ringbuffer.
+ * @brief * Read the loopback data (if exists) from the amplifier loopback ring.
  *
  * @param type Ping or Pong in order to specify the downsampled (ping or pong) buffer.
  */
@@ -175,8 +183,8 @@ status_t pcm_to_pcm_set_config(pcm_pcm_task_config_t *config)
             status = kStatus_InvalidArgument;
         }
 #elif USE_MQS
-        if ((s_config.loopbackRingBuffer == NULL) || (s_config.loopbackMutex == NULL) ||
-            (s_config.updateTimestamp == NULL) || (s_config.getTimestamp == NULL))
+        if ((s_config.loopbackRing == NULL) || (s_config.getTimestamp == NULL) ||
+            (s_config.getLoopbackDelay == NULL))
         {
             status = kStatus_InvalidArgument;
         }
@@ -293,14 +301,9 @@ EventBits_t pdm_to_pcm_get_amp_loopback_error_event(void)
 }
 
 #elif USE_MQS
-void pdm_to_pcm_set_loopback_mutex(SemaphoreHandle_t *mutex)
-{
-    s_config.loopbackMutex = *mutex;
-}
-
-void pdm_to_pcm_set_loopback_ring_buffer(ringbuf_t *ring_buf)
+void pdm_to_pcm_set_loopback_ring(loopback_ring_t *ring)
 {
-    s_config.loopbackRingBuffer = ring_buf;
+    s_config.loopbackRing = ring;
 }
 #endif /* USE_TFA */
 
@@ -329,11 +332,16 @@ static void pdm_to_pcm_prepare_amp_data(pcm_event_t type)
     uint32_t i                    = 0;
     uint32_t ampProcessDataSize   = 0;
     uint32_t ampPingPongBufferIdx = 0;
-    uint32_t ampRingBuffOcc       = 0;
+    uint32_t chunkSize            = 0;
+    uint32_t spanSize             = 0;
+    uint32_t micTimestamp         = 0;
+    const uint8_t *span           = NULL;
+    int16_t *ampData              = s_AmpRXDataBuffer;
+    loopback_segment_t segment;
     static uint8_t ampOutputClean = 0;
 
-    if ((s_config.loopbackMutex == NULL) || (s_config.loopbackRingBuffer == NULL) ||
-        (s_config.updateTimestamp == NULL) || ((type != PCM_PING) && (type != PCM_PONG)))
+    if ((s_config.loopbackRing == NULL) || (s_config.getLoopbackDelay == NULL) ||
+        ((type != PCM_PING) && (type != PCM_PONG)))
     {
         return;
     }
@@ -347,25 +355,55 @@ static void pdm_to_pcm_prepare_amp_data(pcm_event_t type)
         ampPingPongBufferIdx = 0;
     }
 
-    /* Read the loopback data from the amplifier`s ringbuffer.
-     * Do not read more than 10ms of data. */
-    xSemaphoreTake(s_config.loopbackMutex, portMAX_DELAY);
+    micTimestamp        = s_lastReadTimestamp;
+    s_lastReadTimestamp = s_pingPongTimestamp;
 
-    s_config.updateTimestamp(s_pingPongTimestamp);
+    if (loopback_ring_apply_reset(s_config.loopbackRing))
+    {
+        s_loopbackPadBytes = 0;
+    }
 
-    ampRingBuffOcc = ringbuf_get_occupancy(s_config.loopbackRingBuffer);
-    if (ampRingBuffOcc > PCM_AMP_DATA_SIZE_10_MS)
+    /* A new playback started since the previous Ping/Pong event.
+     * Add the delay data in order to sync the microphones with the amplifier. */
+    if (loopback_ring_take_segment(s_config.loopbackRing, &segment))
     {
-        ampProcessDataSize = PCM_AMP_DATA_SIZE_10_MS;
+        s_loopbackPadBytes = s_config.getLoopbackDelay(segment.timestamp, micTimestamp);
     }
-    else
+
+    /* Read the loopback data from the amplifier`s ring, delay zeroes first.
+     * Do not read more than 10ms of data. */
+    if (s_loopbackPadBytes == 0)
     {
-        ampProcessDataSize = ampRingBuffOcc;
+        spanSize = loopback_ring_get_read_span(s_config.loopbackRing, &span);
+        if (spanSize >= PCM_AMP_DATA_SIZE_10_MS)
+        {
+            /* A whole chunk is contiguous in the ring, downsample it in place */
+            ampData            = (int16_t *)span;
+            ampProcessDataSize = PCM_AMP_DATA_SIZE_10_MS;
+        }
     }
 
-    ringbuf_read(s_config.loopbackRingBuffer, (uint8_t *)s_AmpRXDataBuffer, ampProcessDataSize);
+    if (ampData == s_AmpRXDataBuffer)
+    {
+        chunkSize = MIN(s_loopbackPadBytes, PCM_AMP_DATA_SIZE_10_MS);
+        memset(s_AmpRXDataBuffer, 0, chunkSize);
+        s_loopbackPadBytes -= chunkSize;
+        ampProcessDataSize = chunkSize;
 
-    xSemaphoreGive(s_config.loopbackMutex);
+        while (ampProcessDataSize < PCM_AMP_DATA_SIZE_10_MS)
+        {
+            spanSize = loopback_ring_get_read_span(s_config.loopbackRing, &span);
+            if (spanSize == 0)
+            {
+                break;
+            }
+
+            chunkSize = MIN(spanSize, PCM_AMP_DATA_SIZE_10_MS - ampProcessDataSize);
+            memcpy(&((uint8_t *)s_AmpRXDataBuffer)[ampProcessDataSize], span, chunkSize);
+            loopback_ring_consume(s_config.loopbackRing, chunkSize);
+            ampProcessDataSize += chunkSize;
+        }
+    }
 
     /* In case of need, add padding zeroes to form a 10ms chunk of data.
      * Downsample by 3 the data and place it in the downsampled buffer.
@@ -373,11 +411,21 @@ static void pdm_to_pcm_prepare_amp_data(pcm_event_t type)
      * In case there is no available data, clear the downsampled buffer. */
     if (ampProcessDataSize > 0)
     {
-        memset(&((uint8_t *)s_AmpRXDataBuffer)[ampProcessDataSize], 0, (PCM_AMP_DATA_SIZE_10_MS - ampProcessDataSize));
+        if (ampData == s_AmpRXDataBuffer)
+        {
+            memset(&((uint8_t *)s_AmpRXDataBuffer)[ampProcessDataSize], 0,
+                   (PCM_AMP_DATA_SIZE_10_MS - ampProcessDataSize));
+        }
 
-        SLN_DSP_downsample_by_3(&dspMemPool, AMP_DSP_STREAM, s_AmpRXDataBuffer, PCM_AMP_SAMPLE_COUNT,
+        SLN_DSP_downsample_by_3(&dspMemPool, AMP_DSP_STREAM, ampData, PCM_AMP_SAMPLE_COUNT,
                                 &s_ampOutput[ampPingPongBufferIdx * PCM_SINGLE_CH_SMPL_COUNT]);
 
+        /* The in place data can be overwritten by the amplifier only once released */
+        if (ampData != s_AmpRXDataBuffer)
+        {
+            loopback_ring_consume(s_config.loopbackRing, PCM_AMP_DATA_SIZE_10_MS);
+        }
+
         for (i = ampPingPongBufferIdx * PCM_SINGLE_CH_SMPL_COUNT;
              i < ((ampPingPongBufferIdx + 1) * PCM_SINGLE_CH_SMPL_COUNT); i++)
         {
@@ -413,6 +461,10 @@ void pdm_to_pcm_task(void *pvParameters)
         configPRINTF(("Failed to create s_PdmDmaEventGroup\r\n"));
     }
 
+    SLN_METRICS_Register(&s_saiRepairs);
+    SLN_METRICS_Register(&s_loopbackRepairs);
+    SLN_METRICS_Register(&s_missedEvents);
+
 #if SAI1_CH_COUNT
     g_pdmMicSai1Handle.eventGroup        = s_PdmDmaEventGroup;
     g_pdmMicSai1Handle.config            = &g_pdmMicSai1;
@@ -500,6 +552,7 @@ void pdm_to_pcm_task(void *pvParameters)
 #ifndef NO_DEBUG_MICS
                 configPRINTF(("SAI stopped working. Repairing it.\r\n"));
 #endif
+                SLN_METRICS_Add(&s_saiRepairs, 1);
                 pdm_to_pcm_mics_off();
                 pdm_to_pcm_mics_on();
             }
@@ -514,6 +567,7 @@ void pdm_to_pcm_task(void *pvParameters)
             configPRINTF(("Loopback stopped working. Repairing it.\r\n"));
 #endif
 
+            SLN_METRICS_Add(&s_loopbackRepairs, 1);
             pdm_to_pcm_mics_off();
             pdm_to_pcm_mics_on();
         }
@@ -623,6 +677,7 @@ void pdm_to_pcm_task(void *pvParameters)
         if (preProcessEvents & PDM_ERROR_FLAG)
         {
             configPRINTF(("[PDM-PCM] - Missed Event \r\n"));
+            SLN_METRICS_Add(&s_missedEvents, 1);
             preProcessEvents &= ~PDM_ERROR_FLAG;
         }
 #else
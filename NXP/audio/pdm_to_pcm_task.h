@@ -17,8 +17,7 @@
 #include "fsl_common.h"
 
 #if USE_MQS
-#include "semphr.h"
-#include "ringbuffer.h"
+#include "loopback_ring.h"
 #endif
 
 /*!
@@ -53,10 +52,9 @@ typedef struct __pdm_pcm_task_config
     int16_t *feedbackBuffer;
 
 #elif USE_MQS
-    ringbuf_t *loopbackRingBuffer;
-    SemaphoreHandle_t loopbackMutex;
-    void (*updateTimestamp)(uint32_t);
+    loopback_ring_t *loopbackRing;
     uint32_t (*getTimestamp)(void);
+    uint32_t (*getLoopbackDelay)(uint32_t, uint32_t);
 #endif /* USE_TFA */
 } pcm_pcm_task_config_t;
 
@@ -141,20 +139,12 @@ EventBits_t pdm_to_pcm_get_amp_loopback_error_event(void);
 #elif USE_MQS
 
 /*!
- * @brief Set the loopback mutex.
-          Used for exclusive access to the loopback ringbuffer.
+ * @brief Set the loopback ring.
+          pdm_to_pcm_task is its only reader.
  *
- * @param mutex    Pointer to the mutex handler
+ * @param *ring Reference to the ring for amp loopback
  */
-void pdm_to_pcm_set_loopback_mutex(SemaphoreHandle_t *mutex);
-
-/*!
- * @brief Set the loopback ringbuffer.
-          Used for setting the pointer to the ringbuffer.
- *
- * @param *ring_buf Reference to the ring buffer for amp loopback
- */
-void pdm_to_pcm_set_loopback_ring_buffer(ringbuf_t *ring_buf);
+void pdm_to_pcm_set_loopback_ring(loopback_ring_t *ring);
 #endif /* USE_TFA */
 
 /*!
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022 NXP
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Listen to the ASR events the device publishes over UDP, print them and their latency.
+#
+#   python3 asr_events_listen.py                      # multicast group of the device
+#   python3 asr_events_listen.py --group "" --seconds 60   # unicast, after SLN_ASR_EVENTS_SetDestination
+#   python3 asr_events_listen.py --loopback 2000      # benchmark of the listener on 127.0.0.1
+#
+# The queue latency is the time an event waited on the device before its datagram was sent. The
+# network latency is measured against the clock of the device, unknown here, so it is given above
+# the fastest datagram received; its spread is the jitter the listeners see. Gaps in the sequence
+# numbers are the events lost on the network.
+#
+# With --loopback, a thread sends datagrams in the format of the device to the listener over the
+# loopback interface, with the clock of this host, so the latency of the receive path is exact.
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+EVENTS_PORT = 8890
+EVENTS_GROUP = "239.255.0.45"
+EVENTS_MAGIC = 0x4541
+EVENTS_HEADER = struct.Struct("<HBBII")
+EVENT = struct.Struct("<BBhhhhHI")
+EVENTS_BATCH = 8
+
+EVENT_TYPES = ["session_started", "session_ended", "session_timeout", "wake_word", "command"]
+
+
+def now_ms():
+    return time.monotonic() * 1000.0
+
+
+def percentiles(values):
+    if not values:
+        return "none"
+    ordered = sorted(values)
+    pick = lambda ratio: ordered[min(len(ordered) - 1, int(ratio * len(ordered)))]
+    return "min %.2f, median %.2f, p95 %.2f, max %.2f ms (%d)" % (
+        ordered[0], pick(0.5), pick(0.95), ordered[-1], len(ordered))
+
+
+def open_socket(group, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    if group:
+        membership = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton("0.0.0.0"))
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    return sock
+
+
+def parse(datagram):
+    """Header fields and events of a datagram, None if it is not one of the device"""
+    if len(datagram) < EVENTS_HEADER.size:
+        return None
+    magic, version, count, seq, send_ms = EVENTS_HEADER.unpack_from(datagram)
+    if magic != EVENTS_MAGIC or len(datagram) < EVENTS_HEADER.size + count * EVENT.size:
+        return None
+    events = [EVENT.unpack_from(datagram, EVENTS_HEADER.size + idx * EVENT.size) for idx in range(count)]
+    return version, seq, send_ms, events
+
+
+def describe(event):
+    kind, language, keyword, map_id, trust, sg_diff, _, _ = event
+    name = EVENT_TYPES[kind] if kind < len(EVENT_TYPES) else "type %d" % kind
+    if kind == 4:
+        return "%s %d (keyword %d, language %d, trust %d, sg diff %d)" % (name, map_id, keyword, language, trust,
+                                                                         sg_diff)
+    if kind == 3:
+        return "%s (keyword %d, language %d, trust %d)" % (name, keyword, language, trust)
+    return name
+
+
+def send_loopback(port, count, stop):
+    """Datagrams of the device, bursts of 1 to EVENTS_BATCH events queued for 0 to 20 ms"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    seq = 0
+    sent = 0
+    while sent < count and not stop.is_set():
+        batch = min(random.randint(1, EVENTS_BATCH), count - sent)
+        send_ms = int(now_ms()) & 0xFFFFFFFF
+        events = b"".join(EVENT.pack(4, 0, 7, 12, 300, 40, 0, (send_ms - random.randint(0, 20)) & 0xFFFFFFFF)
+                          for _ in range(batch))
+        sock.sendto(EVENTS_HEADER.pack(EVENTS_MAGIC, 1, batch, seq, send_ms) + events, ("127.0.0.1", port))
+        seq += batch
+        sent += batch
+        time.sleep(0.001)
+    sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Listen to the ASR events of the device")
+    parser.add_argument("--port", type=int, default=EVENTS_PORT)
+    parser.add_argument("--group", default=EVENTS_GROUP, help="multicast group, empty for unicast")
+    parser.add_argument("--seconds", type=float, default=0, help="stop after that long (default until Ctrl+C)")
+    parser.add_argument("--loopback", type=int, default=0, metavar="EVENTS",
+                        help="benchmark: send that many events to the listener over the loopback interface")
+    parser.add_argument("--quiet", action="store_true", help="print the statistics only")
+    args = parser.parse_args()
+
+    sock = open_socket("" if args.loopback else args.group, args.port)
+    sock.settimeout(0.5)
+
+    stop = threading.Event()
+    sender = None
+    if args.loopback:
+        sender = threading.Thread(target=send_loopback, args=(args.port, args.loopback, stop), daemon=True)
+        sender.start()
+
+    deadline = now_ms() + args.seconds * 1000.0 if args.seconds > 0 else None
+    queue_ms = []
+    network_ms = []
+    offset = None
+    expected = None
+    events = 0
+    lost = 0
+
+    try:
+        while deadline is None or now_ms() < deadline:
+            try:
+                datagram = sock.recv(2048)
+            except socket.timeout:
+                if sender is not None and not sender.is_alive():
+                    break
+                continue
+
+            received = now_ms()
+            parsed = parse(datagram)
+            if parsed is None:
+                continue
+            version, seq, send_ms, batch = parsed
+
+            if expected is not None and seq != expected:
+                lost += (seq - expected) & 0xFFFFFFFF
+            expected = (seq + len(batch)) & 0xFFFFFFFF
+
+            # On the loopback the clocks are the same, else relative to the fastest datagram
+            delay = received - send_ms if args.loopback else (received - send_ms) % (1 << 32)
+            if not args.loopback:
+                offset = delay if offset is None else min(offset, delay)
+            network_ms.append(delay)
+
+            for event in batch:
+                queue_ms.append((send_ms - event[7]) & 0xFFFFFFFF)
+                events += 1
+                if not args.quiet:
+                    print("%10d ms  seq %-6d %s" % (event[7], seq, describe(event)))
+                seq += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stop.set()
+        sock.close()
+
+    if offset is not None:
+        network_ms = [delay - offset for delay in network_ms]
+
+    print("%d events, %d lost" % (events, lost))
+    print("queue latency on the device: %s" % percentiles(queue_ms))
+    print("%s latency: %s" % ("loopback" if args.loopback else "network (above the fastest)",
+                               percentiles(network_ms)))
+
+
+if __name__ == "__main__":
+    main()
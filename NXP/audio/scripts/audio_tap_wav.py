@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022 NXP
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Record the audio tap of the device into a multi-channel WAV file.
+#
+#   python3 audio_tap_wav.py 192.168.1.20 capture.wav --sources mic0,mic1,afe,amp --seconds 30
+#
+# The channels are written in the order mic0..mic3, afe, amp. The blocks the device dropped
+# because the network did not keep up are replaced by silence, so the channels stay aligned
+# in time, and are reported at the end.
+
+import argparse
+import socket
+import struct
+import sys
+import wave
+
+TAP_PORT = 8891
+TAP_MAGIC = 0x50415441
+TAP_HEADER = struct.Struct("<IHHBBHI")
+
+SOURCES = {"mic0": 1 << 0, "mic1": 1 << 1, "mic2": 1 << 2, "mic3": 1 << 3, "afe": 1 << 4, "amp": 1 << 5}
+
+
+def recv_exact(sock, size):
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed by the device")
+        data += chunk
+    return bytes(data)
+
+
+def source_names(mask):
+    return [name for name, bit in SOURCES.items() if mask & bit]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record the audio tap of the device into a WAV file")
+    parser.add_argument("host", help="IP address of the device")
+    parser.add_argument("output", help="WAV file to write")
+    parser.add_argument("--port", type=int, default=TAP_PORT)
+    parser.add_argument("--sources", default="", help="comma separated: " + ",".join(SOURCES) + " (default all)")
+    parser.add_argument("--seconds", type=float, default=0, help="stop after that long (default until Ctrl+C)")
+    args = parser.parse_args()
+
+    mask = 0
+    for name in filter(None, args.sources.split(",")):
+        if name not in SOURCES:
+            parser.error("unknown source " + name)
+        mask |= SOURCES[name]
+
+    sock = socket.create_connection((args.host, args.port), timeout=5)
+    sock.sendall(struct.pack("<I", mask))
+
+    magic, version, rate, channels, bits, samples, sources = TAP_HEADER.unpack(recv_exact(sock, TAP_HEADER.size))
+    if magic != TAP_MAGIC or bits != 16:
+        sys.exit("unexpected stream header")
+
+    print("version %d, %d Hz, channels %s" % (version, rate, ",".join(source_names(sources))))
+
+    block_size = samples * channels * 2
+    silence = bytes(block_size)
+    max_blocks = int(args.seconds * rate / samples) if args.seconds > 0 else None
+    blocks = 0
+    lost = 0
+    expected = None
+
+    with wave.open(args.output, "wb") as wav:
+        wav.setnchannels(channels)
+        wav.setsampwidth(2)
+        wav.setframerate(rate)
+
+        try:
+            while max_blocks is None or blocks < max_blocks:
+                (seq,) = struct.unpack("<I", recv_exact(sock, 4))
+                data = recv_exact(sock, block_size)
+
+                if expected is not None and seq != expected:
+                    gap = (seq - expected) & 0xFFFFFFFF
+                    lost += gap
+                    for _ in range(gap):
+                        wav.writeframes(silence)
+                    blocks += gap
+
+                wav.writeframes(data)
+                blocks += 1
+                expected = (seq + 1) & 0xFFFFFFFF
+        except KeyboardInterrupt:
+            pass
+        except (ConnectionError, socket.timeout) as error:
+            print("stopped: %s" % error)
+        finally:
+            sock.close()
+
+    print("%d blocks written, %d dropped by the device" % (blocks, lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -11,6 +11,7 @@
 #include "queue.h"
 #include "task.h"
 #include "timers.h"
+#include "semphr.h"
 
 #include "board.h"
 #include "fsl_dmamux.h"
@@ -24,8 +25,7 @@
 
 #if USE_MQS
 #include "fsl_gpt.h"
-#include "semphr.h"
-#include "ringbuffer.h"
+#include "loopback_ring.h"
 #endif /* USE_MQS */
 
 #if USE_AUDIO_SPEAKER
@@ -42,6 +42,8 @@
 #define AMPLIFIER_SEND_TASK_STACK_SIZE 1024
 #define AMPLIFIER_SEND_TASK_PRIORITY   configMAX_PRIORITIES - 1
 
+/* Clips are sent in blocks of 10ms. The SAI EDMA driver chains up to SAI_XFER_QUEUE_SIZE of them in its TCD pool,
+ * the next blocks are queued as soon as one is played. */
 #if USE_MQS
 #define PCM_AMP_DMA_CHUNK_SIZE 2 * PCM_AMP_SAMPLE_COUNT *PCM_SAMPLE_SIZE_BYTES
 
@@ -68,18 +70,56 @@ typedef enum _loopback_state
 } loopback_state_t;
 
 #elif USE_TFA
-#define PCM_AMP_DMA_CHUNK_SIZE 0x80000
+#define PCM_AMP_DMA_CHUNK_SIZE PCM_AMP_DATA_SIZE_10_MS
 #endif /* USE_MQS */
 
 #define PCM_AMP_DMA_TX_COMPLETE_EVT_BIT 1
 #define PCM_AMP_AUDIO_ABORT_EVT_BIT     2
+#define PCM_AMP_PLAYBACK_DONE_EVT_BIT   4
 
 #define WAIT_SAI_RX_FEF_FLAG_CLEAR  3
 #define WAIT_SAI_TX_FEF_FLAG_CLEAR  3
 #define LOOPBACK_STOP_SCHEDULE_WAIT 20
+
+/* Number of committed stream blocks required before the stream (re)starts playing */
+#define AMP_STREAM_PREFILL_BLOCKS 2
+/* Stream blocks are AMP_STREAM_BLOCK_SIZE long, wait twice their play time for all of them to drain */
+#define AMP_STREAM_DRAIN_TIMEOUT_MS (AMP_STREAM_BLOCK_COUNT * 20 * 2)
+
+/* Bookkeeping of the transfers handed to the SAI EDMA queue. The sizes are kept in submission order
+ * so that the TX callback knows how many bytes the finished transfer carried. */
+typedef struct _amp_playback_progress
+{
+    uint32_t queuedBytes;
+    uint32_t completedBytes;
+    uint32_t xferSize[SAI_XFER_QUEUE_SIZE];
+    uint8_t *xferData[SAI_XFER_QUEUE_SIZE];
+    uint8_t xferHead;
+    uint8_t xferCount;
+} amp_playback_progress_t;
+
+/* State of the SLN_AMP_Stream* producer ring */
+typedef struct _amp_stream
+{
+    volatile bool active;
+    volatile bool primed;
+    volatile bool draining;
+    bool held;
+    uint8_t fillIdx;
+    uint8_t submitIdx;
+    volatile uint8_t committed;
+    volatile uint8_t inFlight;
+    uint8_t *partialBlock;
+    uint32_t partialLen;
+    uint32_t blockLen[AMP_STREAM_BLOCK_COUNT];
+    SemaphoreHandle_t freeBlocks;
+    amp_stream_stats_t stats;
+} amp_stream_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
+void audio_send_task(void *pvParameters);
 
 /*******************************************************************************
  * Variables
@@ -98,11 +138,12 @@ __attribute__((section(".data.$SRAM_DTC")))
 __attribute__((aligned(2))) static uint8_t s_AmpRxDataBuffer[PCM_AMP_SAMPLE_COUNT * PCM_SAMPLE_SIZE_BYTES];
 
 #elif USE_MQS
-static SemaphoreHandle_t s_LoopBackMutex         = NULL;
-static ringbuf_t *s_AmpRxDataRingBuffer          = NULL;
-static volatile uint32_t s_PdmPcmTimestamp       = -1;
+static loopback_ring_t s_LoopbackRing            = {0};
 static SemaphoreHandle_t s_LoopBackStateMutex    = NULL;
 static volatile loopback_state_t s_LoopbackState = kLoopbackEnabled;
+/* One slot of the ring is never used */
+__attribute__((section(".bss.$SRAM_DTC")))
+__attribute__((aligned(4))) static uint8_t s_LoopbackRingBuffer[AMP_LOOPBACK_RINGBUF_SIZE + PCM_SAMPLE_SIZE_BYTES];
 #endif /* USE_TFA */
 
 /* The DMA Handle for audio amplifier SAI3 */
@@ -127,6 +168,12 @@ USB_DMA_NONINIT_DATA_ALIGN(USB_DATA_ALIGN_SIZE)
 static uint8_t audioPlayDMATempBuff[FS_ISO_OUT_ENDP_PACKET_SIZE];
 #endif
 
+static volatile amp_playback_progress_t s_PlaybackProgress = {0};
+
+static amp_stream_t s_Stream = {0};
+__attribute__((section(".bss.$SRAM_DTC")))
+__attribute__((aligned(4))) static uint8_t s_StreamBlocks[AMP_STREAM_BLOCK_COUNT][AMP_STREAM_BLOCK_SIZE];
+
 static volatile uint8_t *pu8BufferPool   = NULL;
 static uint8_t *pDefaultAudioData        = NULL;
 static uint32_t s_DefaultAudioDataLength = 0;
@@ -143,6 +190,78 @@ static volatile bool s_LoopBackStopScheduled = false;
 /*******************************************************************************
  * Code
  ******************************************************************************/
+static bool SLN_AMP_PlaybackIdle(void)
+{
+    return ((s_PlaybackProgress.xferCount == 0) && (u32AudioLength == 0) && (loop == 0) && !s_Stream.active);
+}
+
+/*
+ * Start a new playback session if nothing is playing. When data is appended to an ongoing playback
+ * (e.g. a stream of SLN_AMP_WriteNoWait packets) the counters keep running.
+ */
+static void SLN_AMP_PlaybackSessionStart(void)
+{
+    taskENTER_CRITICAL();
+    if (SLN_AMP_PlaybackIdle())
+    {
+        s_PlaybackProgress.queuedBytes    = 0;
+        s_PlaybackProgress.completedBytes = 0;
+        s_PlaybackProgress.xferHead       = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    xEventGroupClearBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT);
+}
+
+/* Send a chunk over SAI and account for it in the playback progress. */
+static status_t SLN_AMP_SendEDMA(sai_transfer_t *write_xfer)
+{
+    status_t status = kStatus_Success;
+    uint8_t tail;
+
+    /* The TX callback must not run before the transfer size is registered */
+    taskENTER_CRITICAL();
+    status = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, write_xfer);
+    if ((status == kStatus_Success) && (s_PlaybackProgress.xferCount < SAI_XFER_QUEUE_SIZE))
+    {
+        tail = (s_PlaybackProgress.xferHead + s_PlaybackProgress.xferCount) % SAI_XFER_QUEUE_SIZE;
+
+        s_PlaybackProgress.xferSize[tail] = write_xfer->dataSize;
+        s_PlaybackProgress.xferData[tail] = write_xfer->data;
+        s_PlaybackProgress.xferCount++;
+        s_PlaybackProgress.queuedBytes += write_xfer->dataSize;
+    }
+    taskEXIT_CRITICAL();
+
+    return status;
+}
+
+/* Bytes already shifted out by the SAI. Must be called from a critical section. */
+static uint32_t SLN_AMP_PlayedBytes(void)
+{
+    size_t inFlight = 0;
+
+    if ((s_PlaybackProgress.xferCount == 0) ||
+        (SAI_TransferGetSendCountEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &inFlight) != kStatus_Success))
+    {
+        inFlight = 0;
+    }
+
+    return s_PlaybackProgress.completedBytes + inFlight;
+}
+
+/* Stop the SAI transmission and close the playback session at the current position. */
+static void SLN_AMP_TerminateSend(void)
+{
+    taskENTER_CRITICAL();
+    s_PlaybackProgress.completedBytes = SLN_AMP_PlayedBytes();
+    s_PlaybackProgress.queuedBytes    = s_PlaybackProgress.completedBytes;
+    s_PlaybackProgress.xferCount      = 0;
+
+    SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
+    taskEXIT_CRITICAL();
+}
+
 void SAI_UserTxIRQHandler(void)
 {
     uint8_t i;
@@ -206,26 +325,21 @@ void SAI_UserRxIRQHandler(void)
 
 #if USE_MQS
 /*
- * In case of NOT being already synchronized, calculate the delay between the last Ping/Pong event and the current call.
- * Add this delay as zeroes to the ringbuffer.
- * After synchronization (if was needed), start the playback and place the playback data into the ringbuffer.
+ * After synchronization (if was needed), start the playback and place the playback data into the loopback ring.
+ * The first packet of a playback is marked with its start time, pdm_to_pcm_task uses it to add the delay
+ * between the last Ping/Pong event and the start of the playback.
  */
 static status_t SLN_AMP_RxCallback(uint8_t *data, uint32_t length, sai_transfer_t *write_xfer)
 {
     status_t status          = kStatus_Success;
     uint16_t i               = 0;
-    uint8_t dummyZero        = 0;
-    uint32_t ringbufOcc      = 0;
+    bool newSegment          = false;
     uint32_t slnAmpTimestamp = 0;
-    uint32_t delayTicks      = 0;
-    uint32_t delayUs         = 0;
-    uint32_t delayBytes      = 0;
 
-    if ((s_LoopBackStateMutex == NULL) || (s_LoopBackMutex == NULL) || (s_AmpRxDataRingBuffer == NULL) ||
-        (s_PdmPcmTimestamp == -1))
+    if ((s_LoopBackStateMutex == NULL) || (loopback_ring_is_reader_active(&s_LoopbackRing) == false))
     {
         /* Loopback is not ready, just send the sound chunk to dma */
-        status = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, write_xfer);
+        status = SLN_AMP_SendEDMA(write_xfer);
         return status;
     }
 
@@ -239,7 +353,7 @@ static status_t SLN_AMP_RxCallback(uint8_t *data, uint32_t length, sai_transfer_
          * This is needed for a new synchronization to be performed after a loopback disable-enable. */
         for (i = 0; i < AMP_LOOPBACK_NEW_SYNC_MAX_WAIT_MS; i++)
         {
-            if ((*pu8BufferPool) == AMP_WRITE_SLOTS)
+            if (s_PlaybackProgress.xferCount == 0)
             {
                 s_LoopbackState = kLoopbackEnabled;
                 break;
@@ -248,69 +362,21 @@ static status_t SLN_AMP_RxCallback(uint8_t *data, uint32_t length, sai_transfer_
         }
     }
 
-    if (s_LoopbackState == kLoopbackEnabled)
+    status = SLN_AMP_SendEDMA(write_xfer);
+
+    if ((s_LoopbackState == kLoopbackEnabled) && (status == kStatus_Success))
     {
-        xSemaphoreTake(s_LoopBackMutex, portMAX_DELAY);
+        /* The current packet is the first one of a playback session if nothing is left in the ring */
+        newSegment      = (loopback_ring_get_occupancy(&s_LoopbackRing) == 0);
+        slnAmpTimestamp = GPT_GetCurrentTimerCount(AMP_LOOPBACK_GPT);
 
-        status = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, write_xfer);
-        if (status == kStatus_Success)
+        /* Place the data in the ring. This data will be used for barge-in.
+         * It should not happen, but the packet is skipped if the ring is full. */
+        if (loopback_ring_write(&s_LoopbackRing, data, length, slnAmpTimestamp, newSegment) == false)
         {
-            /* Check if the current packet is the first one of a playback session.
-             * If it is the first packet, add delay data to the ringbuffer. */
-            ringbufOcc = ringbuf_get_occupancy(s_AmpRxDataRingBuffer);
-            if (ringbufOcc == 0)
-            {
-                slnAmpTimestamp = GPT_GetCurrentTimerCount(AMP_LOOPBACK_GPT);
-
-                /* Add the delay data in order to sync the microphones with the amplifier. */
-                if (slnAmpTimestamp > s_PdmPcmTimestamp)
-                {
-                    delayTicks = slnAmpTimestamp - s_PdmPcmTimestamp;
-                }
-                else
-                {
-                    delayTicks = (UINT32_MAX - s_PdmPcmTimestamp) + slnAmpTimestamp;
-                }
-
-                delayUs = AMP_LOOPBACK_GPT_TICKS_TO_US(delayTicks) + AMP_LOOPBACK_CONST_DELAY_US;
-
-                /* Delay in bytes should be multiple of 4. Number 4 is selected because it is needed
-                 * to keep samples grouped by 2(positive and negative) and one sample is an int16 (on 2 bytes). */
-                delayBytes = (delayUs * PCM_AMP_DATA_SIZE_1_MS) / 1000;
-                delayBytes = delayBytes - (delayBytes % 4);
-
-                if (delayBytes > AMP_LOOPBACK_MAX_DELAY_BYTES)
-                {
-                    /* Should not happen, but better safe */
-                    configPRINTF(("WARNING: loopback desync of %d packets\r\n",
-                                  delayBytes - (AMP_LOOPBACK_MAX_DELAY_BYTES - (AMP_LOOPBACK_MAX_DELAY_BYTES % 4))));
-                    delayBytes = AMP_LOOPBACK_MAX_DELAY_BYTES - (AMP_LOOPBACK_MAX_DELAY_BYTES % 4);
-                }
-
-                for (i = 0; i < delayBytes; i++)
-                {
-                    ringbuf_write(s_AmpRxDataRingBuffer, &dummyZero, 1);
-                }
-            }
-
-            /* Place the data in the ringbuffer. This data will be used for barge-in.
-             * It should not happen, but skip the packet if the ring buffer is full. */
-            if (ringbufOcc + length <= AMP_LOOPBACK_RINGBUF_SIZE)
-            {
-                ringbuf_write(s_AmpRxDataRingBuffer, data, length);
-            }
-            else
-            {
-                configPRINTF(("Failed to write data to the loopback ringbuffer. data len = %d, free space = %d\r\n",
-                              length, AMP_LOOPBACK_RINGBUF_SIZE - ringbufOcc));
-            }
+            configPRINTF(("Failed to write data to the loopback ring. data len = %d, overruns = %d\r\n", length,
+                          s_LoopbackRing.overruns));
         }
-
-        xSemaphoreGive(s_LoopBackMutex);
-    }
-    else
-    {
-        status = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, write_xfer);
     }
 
     xSemaphoreGive(s_LoopBackStateMutex);
@@ -352,8 +418,39 @@ static void SLN_AMP_RxCallback(I2S_Type *base, sai_edma_handle_t *handle, status
 static void SLN_AMP_TxCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t status, void *userData)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    EventBits_t events                  = PCM_AMP_DMA_TX_COMPLETE_EVT_BIT;
+
+    if (s_PlaybackProgress.xferCount > 0)
+    {
+        uint8_t *xferData = s_PlaybackProgress.xferData[s_PlaybackProgress.xferHead];
+
+        s_PlaybackProgress.completedBytes += s_PlaybackProgress.xferSize[s_PlaybackProgress.xferHead];
+        s_PlaybackProgress.xferHead = (s_PlaybackProgress.xferHead + 1) % SAI_XFER_QUEUE_SIZE;
+        s_PlaybackProgress.xferCount--;
+
+        /* A stream block was played, hand it back to the producer */
+        if ((xferData >= &s_StreamBlocks[0][0]) && (xferData < &s_StreamBlocks[AMP_STREAM_BLOCK_COUNT][0]))
+        {
+            s_Stream.inFlight--;
+            s_Stream.stats.blocksPlayed++;
+
+            if ((s_Stream.inFlight == 0) && s_Stream.active && !s_Stream.draining)
+            {
+                /* The producer did not keep up. Prefill again before restarting. */
+                s_Stream.stats.underruns++;
+                s_Stream.primed = false;
+            }
+
+            xSemaphoreGiveFromISR(s_Stream.freeBlocks, &xHigherPriorityTaskWoken);
+        }
+
+        if (SLN_AMP_PlaybackIdle())
+        {
+            events |= PCM_AMP_PLAYBACK_DONE_EVT_BIT;
+        }
+    }
 
-    xEventGroupSetBitsFromISR(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, &xHigherPriorityTaskWoken);
+    xEventGroupSetBitsFromISR(s_DmaTxComplete, events, &xHigherPriorityTaskWoken);
 
     if (pu8BufferPool != NULL)
     {
@@ -431,79 +528,128 @@ amplifier_status_t SLN_AMP_WriteDefault(void)
         xfer_codec.dataSize = s_DefaultAudioDataLength - (overFlow);
     }
     xfer_codec.data = pDefaultAudioData;
-    SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &xfer_codec);
+    SLN_AMP_PlaybackSessionStart();
+    SLN_AMP_SendEDMA(&xfer_codec);
 #endif
     return 0;
 }
 
-void audio_send_task(void *pvParameters)
+/* Queue blocks of data until the SAI queue is full. Returns the number of bytes queued. */
+static uint32_t SLN_AMP_SubmitBlocks(uint8_t *data, uint32_t length)
 {
     sai_transfer_t write_xfer = {0};
-    EventBits_t events;
+    status_t status           = kStatus_Success;
+    uint32_t submitted        = 0;
 
-    /* Chop into PCM_AMP_DMA_CHUNK_SIZE chunks so the DMA can handle it. */
-    while (1)
+    while ((submitted < length) && (s_PlaybackProgress.xferCount < SAI_XFER_QUEUE_SIZE))
     {
-        events = xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_AUDIO_ABORT_EVT_BIT | PCM_AMP_DMA_TX_COMPLETE_EVT_BIT,
-                                     pdTRUE, pdFALSE, portMAX_DELAY);
+        write_xfer.data     = &data[submitted];
+        write_xfer.dataSize = MIN(length - submitted, PCM_AMP_DMA_CHUNK_SIZE);
 
-        /* We are assured that we waited for all the SAI_TransferSendEDMA to finish and we can stop safely. */
-        if (u32AudioLength == 0)
+#if USE_TFA
+        status = SLN_AMP_SendEDMA(&write_xfer);
+
+#elif USE_MQS
+        SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
+        status = SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
+#endif /* USE_TFA */
+
+        if (status != kStatus_Success)
         {
             break;
         }
 
-        // Abort
-        if (events & 2)
+        submitted += write_xfer.dataSize;
+    }
+
+    return submitted;
+}
+
+/* Queue the next blocks of the current clip, restarting it when looping. */
+static void SLN_AMP_RefillClip(void)
+{
+    uint32_t submitted = 0;
+
+    while (u32AudioLength > 0)
+    {
+        submitted = SLN_AMP_SubmitBlocks(pu8AudioPlay, u32AudioLength);
+
+        pu8AudioPlay += submitted;
+        u32AudioLength -= submitted;
+
+        if ((u32AudioLength == 0) && loop)
+        {
+            u32AudioLength = startAudioLength;
+            pu8AudioPlay   = startAudioPlay;
+        }
+
+        if (submitted == 0)
+        {
+            /* The SAI queue is full */
+            break;
+        }
+    }
+
+    if (u32AudioLength == 0)
+    {
+        pu8AudioPlay = NULL;
+    }
+}
+
+/* Start playing a clip, audio_send_task keeps the SAI queue filled until its end. */
+static amplifier_status_t SLN_AMP_StartClip(void)
+{
+    amplifier_status_t eAmpStatus = 0;
+
+    /* Clear all the bits before queuing the first blocks, audio_send_task must not miss their completion */
+    xEventGroupClearBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT | PCM_AMP_AUDIO_ABORT_EVT_BIT);
+
+    SLN_AMP_RefillClip();
+
+    if (u32AudioLength > 0)
+    {
+        if (xTaskCreate(audio_send_task, AMPLIFIER_SEND_TASK_NAME, AMPLIFIER_SEND_TASK_STACK_SIZE, NULL,
+                        AMPLIFIER_SEND_TASK_PRIORITY, &s_AmplifierSendTaskHandle) != pdPASS)
         {
-            SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
+            configPRINTF(("Failed to create amplifier_send_task!\r\n"));
+
             u32AudioLength = 0;
             pu8AudioPlay   = NULL;
             loop           = 0;
-            break;
+            eAmpStatus     = 1;
         }
-        else
-        {
-            if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
-            {
-                write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-                write_xfer.data     = pu8AudioPlay;
+    }
 
-#if USE_TFA
-                SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    return eAmpStatus;
+}
 
-#elif USE_MQS
-                SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-                SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+void audio_send_task(void *pvParameters)
+{
+    EventBits_t events;
 
-                pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-                u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
-            }
-            else
-            {
-                write_xfer.dataSize = u32AudioLength;
-                write_xfer.data     = pu8AudioPlay;
+    /* Queue a new block each time one is played, until the clip ends or is aborted. */
+    while (1)
+    {
+        events = xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_AUDIO_ABORT_EVT_BIT | PCM_AMP_DMA_TX_COMPLETE_EVT_BIT,
+                                     pdTRUE, pdFALSE, portMAX_DELAY);
 
-#if USE_TFA
-                SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+        // Abort
+        if (events & PCM_AMP_AUDIO_ABORT_EVT_BIT)
+        {
+            u32AudioLength = 0;
+            pu8AudioPlay   = NULL;
+            loop           = 0;
+            SLN_AMP_TerminateSend();
+            xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT);
+            break;
+        }
 
-#elif USE_MQS
-                SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-                SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+        SLN_AMP_RefillClip();
 
-                if (loop)
-                {
-                    u32AudioLength = startAudioLength;
-                    pu8AudioPlay   = startAudioPlay;
-                }
-                else
-                {
-                    u32AudioLength = 0;
-                    pu8AudioPlay   = NULL;
-                }
-            }
+        /* Everything is queued, the remaining blocks play without help */
+        if (u32AudioLength == 0)
+        {
+            break;
         }
     }
 
@@ -512,11 +658,12 @@ void audio_send_task(void *pvParameters)
 
 amplifier_status_t SLN_AMP_Write(uint8_t *data, uint32_t length)
 {
-    sai_transfer_t write_xfer     = {0};
     amplifier_status_t eAmpStatus = 1;
 
     if (0 == u32AudioLength)
     {
+        SLN_AMP_PlaybackSessionStart();
+
         pu8AudioPlay = data;
         if (length)
         {
@@ -527,62 +674,19 @@ amplifier_status_t SLN_AMP_Write(uint8_t *data, uint32_t length)
             u32AudioLength = length;
         }
 
-        /* Chop into 512KB chunks so the DMA can handle it. */
-        if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
-        {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = pu8AudioPlay;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-            u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
-
-            if (xTaskCreate(audio_send_task, AMPLIFIER_SEND_TASK_NAME, AMPLIFIER_SEND_TASK_STACK_SIZE, NULL,
-                            AMPLIFIER_SEND_TASK_PRIORITY, &s_AmplifierSendTaskHandle) == pdPASS)
-            {
-                eAmpStatus = 0;
-            }
-            else
-            {
-                configPRINTF(("Failed to create amplifier_send_task for SLN_AMP_Write!\r\n"));
-            }
-        }
-        else
-        {
-            write_xfer.dataSize = u32AudioLength;
-            write_xfer.data     = pu8AudioPlay;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            u32AudioLength = 0;
-            pu8AudioPlay   = NULL;
-
-            eAmpStatus = 0;
-        }
+        eAmpStatus = SLN_AMP_StartClip();
     }
     return eAmpStatus;
 }
 
 amplifier_status_t SLN_AMP_WriteLoop(uint8_t *data, uint32_t length)
 {
-    sai_transfer_t write_xfer     = {0};
     amplifier_status_t eAmpStatus = 1;
 
     if (0 == u32AudioLength)
     {
+        SLN_AMP_PlaybackSessionStart();
+
         pu8AudioPlay = data;
         if (length)
         {
@@ -595,56 +699,9 @@ amplifier_status_t SLN_AMP_WriteLoop(uint8_t *data, uint32_t length)
 
         startAudioLength = u32AudioLength;
         startAudioPlay   = data;
-        loop             = 1;
-
-        /* Chop into 512KB chunks so the DMA can handle it. */
-        if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
-        {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = pu8AudioPlay;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-            u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
-
-            /* Clear all the bits before creating the task */
-            xEventGroupClearBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT | PCM_AMP_AUDIO_ABORT_EVT_BIT);
-
-            if (xTaskCreate(audio_send_task, AMPLIFIER_SEND_TASK_NAME, AMPLIFIER_SEND_TASK_STACK_SIZE, NULL,
-                            AMPLIFIER_SEND_TASK_PRIORITY, &s_AmplifierSendTaskHandle) == pdPASS)
-            {
-                eAmpStatus = 0;
-            }
-            else
-            {
-                configPRINTF(("Failed to create amplifier_send_task for SLN_AMP_WriteLoop!\r\n"));
-            }
-        }
-        else
-        {
-            write_xfer.dataSize = u32AudioLength;
-            write_xfer.data     = pu8AudioPlay;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            u32AudioLength = 0;
-            pu8AudioPlay   = NULL;
+        loop             = (u32AudioLength > 0) ? 1 : 0;
 
-            eAmpStatus = 0;
-        }
+        eAmpStatus = SLN_AMP_StartClip();
     }
     return eAmpStatus;
 }
@@ -665,12 +722,14 @@ amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length)
         total_len = length;
     }
 
-    /* Chop into 512KB chunks so the DMA can handle it. */
+    SLN_AMP_PlaybackSessionStart();
+
+    /* Sent as a single transfer, the packets of this API are small. */
     write_xfer.dataSize = total_len;
     write_xfer.data     = ptr;
 
 #if USE_TFA
-    ret = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    ret = SLN_AMP_SendEDMA(&write_xfer);
 
 #elif USE_MQS
     SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
@@ -683,8 +742,8 @@ amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length)
 amplifier_status_t SLN_AMP_WriteBlocking(uint8_t *data, uint32_t length)
 {
     uint32_t total_len;
-    uint8_t *ptr              = data;
-    sai_transfer_t write_xfer = {0};
+    uint8_t *ptr       = data;
+    uint32_t submitted = 0;
 
     if (length)
     {
@@ -695,39 +754,19 @@ amplifier_status_t SLN_AMP_WriteBlocking(uint8_t *data, uint32_t length)
         total_len = length;
     }
 
-    /* Chop into 512KB chunks so the DMA can handle it. */
-    while (total_len)
-    {
-        if (total_len > PCM_AMP_DMA_CHUNK_SIZE)
-        {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = ptr;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    SLN_AMP_PlaybackSessionStart();
 
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+    /* Keep the SAI queue filled with 10ms blocks, then wait for the last ones to be played. */
+    while ((total_len > 0) || (s_PlaybackProgress.xferCount > 0))
+    {
+        submitted = SLN_AMP_SubmitBlocks(ptr, total_len);
+        ptr += submitted;
+        total_len -= submitted;
 
-            ptr += PCM_AMP_DMA_CHUNK_SIZE;
-            total_len -= PCM_AMP_DMA_CHUNK_SIZE;
-        }
-        else
+        if ((total_len > 0) && (submitted == 0) && (s_PlaybackProgress.xferCount == 0))
         {
-            write_xfer.dataSize = total_len;
-            write_xfer.data     = ptr;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            total_len = 0;
+            configPRINTF(("Failed to send data to the amplifier\r\n"));
+            return 1;
         }
 
         xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, pdTRUE, pdTRUE, portMAX_DELAY);
@@ -789,6 +828,13 @@ amplifier_status_t SLN_AMP_Init(volatile uint8_t *pu8BuffNum)
 
     pu8BufferPool   = pu8BuffNum;
     s_DmaTxComplete = xEventGroupCreate();
+    xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT);
+
+    s_Stream.freeBlocks = xSemaphoreCreateCounting(AMP_STREAM_BLOCK_COUNT, AMP_STREAM_BLOCK_COUNT);
+    if (s_Stream.freeBlocks == NULL)
+    {
+        configPRINTF(("Failed to create the amplifier stream semaphore\r\n"));
+    }
 
 #if USE_TFA
     BOARD_Codec_I2C_Init();
@@ -801,17 +847,10 @@ amplifier_status_t SLN_AMP_Init(volatile uint8_t *pu8BuffNum)
     ret = CODEC_Init(&codecHandle, (codec_config_t *)BOARD_GetBoardCodecConfig());
 
 #if USE_MQS
-    s_AmpRxDataRingBuffer =
-        (ringbuf_t *)(((mqs_config_t *)(codecHandle.codecConfig->codecDevConfig))->s_AmpRxDataRingBuffer);
-
-    s_LoopBackMutex = xSemaphoreCreateMutex();
-    if (s_LoopBackMutex == NULL)
-    {
-        configPRINTF(("Failed to create s_LoopBackMutex\r\n"));
-    }
+    loopback_ring_init(&s_LoopbackRing, s_LoopbackRingBuffer, sizeof(s_LoopbackRingBuffer));
 
     s_LoopBackStateMutex = xSemaphoreCreateMutex();
-    if (s_LoopBackMutex == NULL)
+    if (s_LoopBackStateMutex == NULL)
     {
         configPRINTF(("Failed to create s_LoopBackStateMutex\r\n"));
     }
@@ -847,14 +886,9 @@ void SLN_AMP_SetLoopBackErrorEventBits(EventBits_t event)
 }
 
 #elif USE_MQS
-SemaphoreHandle_t SLN_AMP_GetLoopBackMutex(void)
-{
-    return s_LoopBackMutex;
-}
-
-ringbuf_t *SLN_AMP_GetRingBuffer(void)
+loopback_ring_t *SLN_AMP_GetLoopbackRing(void)
 {
-    return s_AmpRxDataRingBuffer;
+    return &s_LoopbackRing;
 }
 
 uint32_t SLN_AMP_GetTimestamp(void)
@@ -862,9 +896,36 @@ uint32_t SLN_AMP_GetTimestamp(void)
     return GPT_GetCurrentTimerCount(AMP_LOOPBACK_GPT);
 }
 
-void SLN_AMP_UpdateTimestamp(uint32_t timestamp)
+uint32_t SLN_AMP_GetLoopbackDelayBytes(uint32_t ampTimestamp, uint32_t micTimestamp)
 {
-    s_PdmPcmTimestamp = timestamp;
+    uint32_t delayTicks = 0;
+    uint32_t delayUs    = 0;
+    uint32_t delayBytes = 0;
+
+    /* The timer wraps around, the unsigned difference handles it.
+     * The playback may also have been registered just before the Ping/Pong event, count no variable delay then. */
+    delayTicks = ampTimestamp - micTimestamp;
+    if ((int32_t)delayTicks < 0)
+    {
+        delayTicks = 0;
+    }
+
+    delayUs = AMP_LOOPBACK_GPT_TICKS_TO_US(delayTicks) + AMP_LOOPBACK_CONST_DELAY_US;
+
+    /* Delay in bytes should be multiple of 4. Number 4 is selected because it is needed
+     * to keep samples grouped by 2(positive and negative) and one sample is an int16 (on 2 bytes). */
+    delayBytes = (delayUs * PCM_AMP_DATA_SIZE_1_MS) / 1000;
+    delayBytes = delayBytes - (delayBytes % 4);
+
+    if (delayBytes > AMP_LOOPBACK_MAX_DELAY_BYTES)
+    {
+        /* Should not happen, but better safe */
+        configPRINTF(("WARNING: loopback desync of %d packets\r\n",
+                      delayBytes - (AMP_LOOPBACK_MAX_DELAY_BYTES - (AMP_LOOPBACK_MAX_DELAY_BYTES % 4))));
+        delayBytes = AMP_LOOPBACK_MAX_DELAY_BYTES - (AMP_LOOPBACK_MAX_DELAY_BYTES % 4);
+    }
+
+    return delayBytes;
 }
 #endif /* USE_TFA */
 
@@ -882,7 +943,59 @@ void *SLN_AMP_GetAmpTxHandler()
 void SLN_AMP_Abort(void)
 {
     /* Stop playback. This will flush the SAI transmit buffers. */
-    SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
+    SLN_AMP_TerminateSend();
+
+    if (SLN_AMP_PlaybackIdle())
+    {
+        xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT);
+    }
+}
+
+uint32_t SLN_AMP_GetPlayedSamples(void)
+{
+    uint32_t played;
+
+    taskENTER_CRITICAL();
+    played = SLN_AMP_PlayedBytes();
+    taskEXIT_CRITICAL();
+
+    return played / PCM_SAMPLE_SIZE_BYTES;
+}
+
+uint32_t SLN_AMP_GetRemainingSamples(void)
+{
+    uint32_t remaining;
+
+    taskENTER_CRITICAL();
+    remaining = s_PlaybackProgress.queuedBytes - SLN_AMP_PlayedBytes() + u32AudioLength;
+    taskEXIT_CRITICAL();
+
+    return remaining / PCM_SAMPLE_SIZE_BYTES;
+}
+
+bool SLN_AMP_IsPlaybackDone(void)
+{
+    bool done;
+
+    taskENTER_CRITICAL();
+    done = SLN_AMP_PlaybackIdle();
+    taskEXIT_CRITICAL();
+
+    return done;
+}
+
+amplifier_status_t SLN_AMP_WaitPlaybackDone(TickType_t timeout)
+{
+    EventBits_t events;
+
+    if (s_DmaTxComplete == NULL)
+    {
+        return 1;
+    }
+
+    events = xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT, pdFALSE, pdTRUE, timeout);
+
+    return (events & PCM_AMP_PLAYBACK_DONE_EVT_BIT) ? 0 : 1;
 }
 
 void SLN_AMP_LoopbackEnable(void)
@@ -937,12 +1050,261 @@ void SLN_AMP_LoopbackDisable(void)
 #elif USE_MQS
     xSemaphoreTake(s_LoopBackStateMutex, portMAX_DELAY);
 
-    /* Clear the loopback ringbuffer for a future clean start */
-    xSemaphoreTake(s_LoopBackMutex, portMAX_DELAY);
-    ringbuf_clear(s_AmpRxDataRingBuffer);
-    xSemaphoreGive(s_LoopBackMutex);
+    /* Clear the loopback ring for a future clean start */
+    loopback_ring_request_reset(&s_LoopbackRing);
 
     s_LoopbackState = kLoopbackDisabled;
     xSemaphoreGive(s_LoopBackStateMutex);
 #endif /* USE_TFA */
 }
+
+/* Hand the committed stream blocks to the SAI. Called from task context only. */
+static amplifier_status_t SLN_AMP_StreamSubmitPending(void)
+{
+    amplifier_status_t eAmpStatus = 0;
+    sai_transfer_t write_xfer     = {0};
+
+    while (s_Stream.committed > 0)
+    {
+        write_xfer.data     = s_StreamBlocks[s_Stream.submitIdx];
+        write_xfer.dataSize = s_Stream.blockLen[s_Stream.submitIdx];
+
+        /* Account for the block before sending it, the TX callback may run right after */
+        taskENTER_CRITICAL();
+        s_Stream.committed--;
+        s_Stream.inFlight++;
+        taskEXIT_CRITICAL();
+
+#if USE_TFA
+        eAmpStatus = SLN_AMP_SendEDMA(&write_xfer);
+#elif USE_MQS
+        eAmpStatus = SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
+#endif /* USE_TFA */
+
+        if (eAmpStatus != kStatus_Success)
+        {
+            taskENTER_CRITICAL();
+            s_Stream.committed++;
+            s_Stream.inFlight--;
+            taskEXIT_CRITICAL();
+
+            configPRINTF(("Failed to send stream block to the amplifier, status %d\r\n", eAmpStatus));
+            break;
+        }
+
+        s_Stream.submitIdx = (s_Stream.submitIdx + 1) % AMP_STREAM_BLOCK_COUNT;
+    }
+
+    return eAmpStatus;
+}
+
+amplifier_status_t SLN_AMP_StreamStart(void)
+{
+    if ((s_Stream.freeBlocks == NULL) || s_Stream.active || !SLN_AMP_IsPlaybackDone())
+    {
+        return 1;
+    }
+
+    s_Stream.primed     = false;
+    s_Stream.draining   = false;
+    s_Stream.held       = false;
+    s_Stream.fillIdx    = 0;
+    s_Stream.submitIdx  = 0;
+    s_Stream.committed  = 0;
+    s_Stream.inFlight   = 0;
+    s_Stream.partialLen = 0;
+    memset(&s_Stream.stats, 0, sizeof(s_Stream.stats));
+
+    SLN_AMP_PlaybackSessionStart();
+    s_Stream.active = true;
+
+    return 0;
+}
+
+amplifier_status_t SLN_AMP_StreamGetBuffer(uint8_t **buffer, TickType_t timeout)
+{
+    if ((buffer == NULL) || !s_Stream.active)
+    {
+        return 1;
+    }
+
+    /* The block being filled is handed out again until it is committed */
+    if (s_Stream.held)
+    {
+        *buffer = s_StreamBlocks[s_Stream.fillIdx];
+        return 0;
+    }
+
+    if (xSemaphoreTake(s_Stream.freeBlocks, 0) != pdTRUE)
+    {
+        s_Stream.stats.producerWaits++;
+
+        if (xSemaphoreTake(s_Stream.freeBlocks, timeout) != pdTRUE)
+        {
+            return 1;
+        }
+    }
+
+    s_Stream.held = true;
+    *buffer       = s_StreamBlocks[s_Stream.fillIdx];
+
+    return 0;
+}
+
+amplifier_status_t SLN_AMP_StreamCommit(uint32_t length)
+{
+    uint32_t pad = 0;
+
+    if (!s_Stream.active || !s_Stream.held || (length > AMP_STREAM_BLOCK_SIZE))
+    {
+        return 1;
+    }
+
+    s_Stream.held = false;
+
+    if (length == 0)
+    {
+        /* Nothing to play, the block goes back to the pool */
+        xSemaphoreGive(s_Stream.freeBlocks);
+        return 0;
+    }
+
+    /* The SAI sends multiples of 32 bytes, pad the end of the audio with silence rather than cut it */
+    pad = (32 - (length % 32)) % 32;
+    memset(&s_StreamBlocks[s_Stream.fillIdx][length], 0, pad);
+    length += pad;
+
+#if USE_MQS
+    SLN_AMP_VolAndDiffInputControl(s_StreamBlocks[s_Stream.fillIdx], length);
+#endif /* USE_MQS */
+
+    s_Stream.blockLen[s_Stream.fillIdx] = length;
+    s_Stream.fillIdx                    = (s_Stream.fillIdx + 1) % AMP_STREAM_BLOCK_COUNT;
+
+    taskENTER_CRITICAL();
+    s_Stream.committed++;
+    s_Stream.stats.blocksCommitted++;
+    if (!s_Stream.primed && (s_Stream.committed >= AMP_STREAM_PREFILL_BLOCKS))
+    {
+        s_Stream.primed = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (s_Stream.primed)
+    {
+        return SLN_AMP_StreamSubmitPending();
+    }
+
+    return 0;
+}
+
+uint32_t SLN_AMP_StreamWrite(const uint8_t *data, uint32_t length, TickType_t timeout)
+{
+    uint32_t written = 0;
+    uint32_t chunk   = 0;
+
+    while (written < length)
+    {
+        if (s_Stream.partialLen == 0)
+        {
+            if (SLN_AMP_StreamGetBuffer(&s_Stream.partialBlock, timeout) != 0)
+            {
+                break;
+            }
+        }
+
+        chunk = MIN(length - written, AMP_STREAM_BLOCK_SIZE - s_Stream.partialLen);
+        memcpy(&s_Stream.partialBlock[s_Stream.partialLen], &data[written], chunk);
+        s_Stream.partialLen += chunk;
+        written += chunk;
+
+        if (s_Stream.partialLen == AMP_STREAM_BLOCK_SIZE)
+        {
+            s_Stream.partialLen = 0;
+            if (SLN_AMP_StreamCommit(AMP_STREAM_BLOCK_SIZE) != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return written;
+}
+
+amplifier_status_t SLN_AMP_StreamStop(bool drain)
+{
+    amplifier_status_t eAmpStatus = 0;
+    uint8_t i;
+
+    if (!s_Stream.active)
+    {
+        return 1;
+    }
+
+    s_Stream.draining = true;
+
+    if (drain)
+    {
+        /* Play what is left, including the partially written block */
+        if (s_Stream.partialLen > 0)
+        {
+            SLN_AMP_StreamCommit(s_Stream.partialLen);
+            s_Stream.partialLen = 0;
+        }
+        SLN_AMP_StreamSubmitPending();
+
+        /* A block taken but never committed has nothing to play, it does not come back from the SAI */
+        if (s_Stream.held)
+        {
+            s_Stream.held = false;
+            xSemaphoreGive(s_Stream.freeBlocks);
+        }
+
+        /* All the blocks are back in the pool once the last one was played */
+        for (i = 0; i < AMP_STREAM_BLOCK_COUNT; i++)
+        {
+            if (xSemaphoreTake(s_Stream.freeBlocks, pdMS_TO_TICKS(AMP_STREAM_DRAIN_TIMEOUT_MS)) != pdTRUE)
+            {
+                configPRINTF(("Amplifier stream did not drain, %d blocks still playing\r\n", s_Stream.inFlight));
+                eAmpStatus = 1;
+                break;
+            }
+        }
+    }
+
+    if (s_Stream.inFlight > 0)
+    {
+        SLN_AMP_TerminateSend();
+    }
+
+    taskENTER_CRITICAL();
+    s_Stream.committed  = 0;
+    s_Stream.inFlight   = 0;
+    s_Stream.partialLen = 0;
+    s_Stream.held       = false;
+    s_Stream.active     = false;
+    taskEXIT_CRITICAL();
+
+    /* Aborted blocks never reach the TX callback, refill the pool for the next stream */
+    while (uxSemaphoreGetCount(s_Stream.freeBlocks) < AMP_STREAM_BLOCK_COUNT)
+    {
+        xSemaphoreGive(s_Stream.freeBlocks);
+    }
+
+    if (SLN_AMP_PlaybackIdle())
+    {
+        xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_PLAYBACK_DONE_EVT_BIT);
+    }
+
+    return eAmpStatus;
+}
+
+void SLN_AMP_StreamGetStats(amp_stream_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        taskENTER_CRITICAL();
+        *stats = s_Stream.stats;
+        taskEXIT_CRITICAL();
+    }
+}
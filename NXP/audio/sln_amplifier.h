@@ -13,15 +13,20 @@
 #include "event_groups.h"
 #include "fsl_common.h"
 #include "fsl_edma.h"
+#include "pdm_pcm_definitions.h"
 
 #if USE_MQS
-#include "semphr.h"
-#include "ringbuffer.h"
+#include "loopback_ring.h"
 #endif
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
+/*! @brief Size of one SLN_AMP_Stream* block. 20ms of 48KHz, 16 bit audio, a multiple of 32 bytes */
+#define AMP_STREAM_BLOCK_SIZE PCM_AMP_DATA_SIZE_20_MS
+
+/*! @brief Number of SLN_AMP_Stream* blocks. All of them may be queued in the SAI at the same time */
+#define AMP_STREAM_BLOCK_COUNT AMP_WRITE_SLOTS
 
 /*******************************************************************************
  * Globals
@@ -30,6 +35,15 @@ typedef int32_t amplifier_status_t;
 typedef void (*amp_get_cal_callback_t)(uint8_t *state);
 typedef void (*amp_set_cal_callback_t)(uint8_t state);
 
+/*! @brief Statistics of the current (or last) amplifier stream */
+typedef struct _amp_stream_stats
+{
+    uint32_t blocksCommitted; /*!< Blocks handed over by the producer */
+    uint32_t blocksPlayed;    /*!< Blocks sent out by the SAI */
+    uint32_t underruns;       /*!< Times the amplifier ran out of data while streaming */
+    uint32_t producerWaits;   /*!< Times the producer had to wait for a free block */
+} amp_stream_stats_t;
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -57,7 +71,7 @@ amplifier_status_t SLN_AMP_Read(void);
 
 /**
  * @brief Writes the data to the amplifier
- * The data is chop into 512KB chunks and sent to the SAI interface
+ * The data is chop into 10ms blocks, queued to the SAI interface by audio_send_task as the previous ones are played
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
@@ -91,7 +105,7 @@ amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length);
  * @brief Writes data to the amplifier
  * This function is blocking meaning it waits, after each SAI send, for the
  * g_dmaTxComplete to be cleared by the amplifier TX callback. The data is sent
- * in 512KB chunks
+ * in 10ms blocks and the function returns once all of them are played
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
@@ -145,20 +159,12 @@ void SLN_AMP_SetLoopBackErrorEventBits(EventBits_t event);
 #elif USE_MQS
 
 /**
- * @brief Gets the loopback mutex.
-          Used for exclusive access to the loopback ringbuffer.
+ * @brief Gets the loopback ring.
+          Used for getting the amplifier data (to be used for barge-in). The ring has a single reader.
  *
- * @return SemaphoreHandle_t Loopback mutex handler
+ * @return loopback_ring_t*  Pointer to the loopback ring
  */
-SemaphoreHandle_t SLN_AMP_GetLoopBackMutex(void);
-
-/**
- * @brief Gets the loopback ringbuffer.
-          Used for getting the amplifier data (to be used for barge-in).
- *
- * @return ringbuf_t*        Pointer to the Ring buffer
- */
-ringbuf_t *SLN_AMP_GetRingBuffer(void);
+loopback_ring_t *SLN_AMP_GetLoopbackRing(void);
 
 /**
  * @brief Gets the current tick count of the LOOPBACK_GPT.
@@ -167,10 +173,14 @@ ringbuf_t *SLN_AMP_GetRingBuffer(void);
 uint32_t SLN_AMP_GetTimestamp(void);
 
 /**
- * @brief Sets the tick count of the LOOPBACK_GPT of the last Ping/Pong event.
+ * @brief Gets the number of zero bytes to be inserted before a playback in the loopback signal.
  *        Used for synchronization between the amplifier and the microphones (Ping/Pong).
+ *
+ * @param ampTimestamp  Tick count of the LOOPBACK_GPT at the start of the playback
+ * @param micTimestamp  Tick count of the LOOPBACK_GPT at the last Ping/Pong event before it
+ * @return uint32_t     Delay in bytes, a multiple of 4
  */
-void SLN_AMP_UpdateTimestamp(uint32_t timestamp);
+uint32_t SLN_AMP_GetLoopbackDelayBytes(uint32_t ampTimestamp, uint32_t micTimestamp);
 #endif /* USE_TFA */
 
 /**
@@ -206,6 +216,92 @@ void SLN_AMP_LoopbackEnable(void);
  */
 void SLN_AMP_LoopbackDisable(void);
 
+/**
+ * @brief Gets the number of samples played by the amplifier in the current playback session.
+ * The position is taken from the EDMA progress, so it is sample accurate.
+ * A session starts with a write issued while the amplifier is idle.
+ *
+ * @return uint32_t             Number of PCM_AMP_SAMPLE_RATE_HZ samples already sent to the amplifier
+ */
+uint32_t SLN_AMP_GetPlayedSamples(void);
+
+/**
+ * @brief Gets the number of samples left to be played in the current playback session.
+ * For a looped playback this is what is left of the current loop iteration.
+ *
+ * @return uint32_t             Number of PCM_AMP_SAMPLE_RATE_HZ samples still to be played
+ */
+uint32_t SLN_AMP_GetRemainingSamples(void);
+
+/**
+ * @brief Checks if the amplifier finished playing everything it was given
+ *
+ * @return bool                 true if no playback is in progress
+ */
+bool SLN_AMP_IsPlaybackDone(void);
+
+/**
+ * @brief Waits for the current playback session to finish or to be aborted
+ *
+ * @param timeout               Maximum number of ticks to wait
+ * @return amplifier_status_t   0 if the playback is done, 1 on timeout
+ */
+amplifier_status_t SLN_AMP_WaitPlaybackDone(TickType_t timeout);
+
+/**
+ * @brief Starts a streaming playback session
+ * The audio is provided incrementally by a single producer task using either
+ * SLN_AMP_StreamGetBuffer/SLN_AMP_StreamCommit (zero copy) or SLN_AMP_StreamWrite.
+ * Playback starts once two blocks are committed and restarts the same way after an underrun.
+ *
+ * @return amplifier_status_t   0 if success, 1 if the amplifier is busy
+ */
+amplifier_status_t SLN_AMP_StreamStart(void);
+
+/**
+ * @brief Gets a free AMP_STREAM_BLOCK_SIZE block to be filled by the producer
+ * The same block is returned until it is committed.
+ *
+ * @param buffer                Pointer filled with the address of the block
+ * @param timeout               Maximum number of ticks to wait for a block to be played
+ * @return amplifier_status_t   0 if success, 1 if no block got free in time
+ */
+amplifier_status_t SLN_AMP_StreamGetBuffer(uint8_t **buffer, TickType_t timeout);
+
+/**
+ * @brief Queues the block obtained with SLN_AMP_StreamGetBuffer for playback
+ *
+ * @param length                Number of valid bytes in the block, padded with silence to a multiple of 32
+ * @return amplifier_status_t   0 if success
+ */
+amplifier_status_t SLN_AMP_StreamCommit(uint32_t length);
+
+/**
+ * @brief Copies audio data into the stream blocks and queues each one once it is full
+ * Do not mix with SLN_AMP_StreamGetBuffer/SLN_AMP_StreamCommit in the same session.
+ *
+ * @param data                  Pointer to the audio data
+ * @param length                The length of the data
+ * @param timeout               Maximum number of ticks to wait for each free block
+ * @return uint32_t             Number of bytes consumed
+ */
+uint32_t SLN_AMP_StreamWrite(const uint8_t *data, uint32_t length, TickType_t timeout);
+
+/**
+ * @brief Ends the streaming playback session
+ *
+ * @param drain                 true to play the queued data first, false to stop right away
+ * @return amplifier_status_t   0 if success
+ */
+amplifier_status_t SLN_AMP_StreamStop(bool drain);
+
+/**
+ * @brief Gets the statistics of the current (or last) streaming session
+ *
+ * @param stats                 Pointer to the structure to be filled
+ */
+void SLN_AMP_StreamGetStats(amp_stream_stats_t *stats);
+
 /**
  * @brief Set default audio data used by SLN_AMP_WriteDefault.
  *
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2022 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+#include "fsl_common.h"
+#include "sln_amplifier.h"
+#include "sln_prompt.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/*! @brief PROMPT Task settings */
+#define PROMPT_TASK_NAME       "prompt_task"
+#define PROMPT_TASK_STACK_SIZE 512
+#define PROMPT_TASK_PRIORITY   (configMAX_PRIORITIES - 3)
+
+#define PROMPT_BLOCK_SAMPLES (AMP_STREAM_BLOCK_SIZE / sizeof(int16_t))
+
+/* Q15 weights used by the cross-fade */
+#define PROMPT_Q15_ONE (1 << 15)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const sln_prompt_clip_t *s_promptClips = NULL;
+static QueueHandle_t s_promptQueue            = NULL;
+static TaskHandle_t s_promptTaskHandle        = NULL;
+
+/* Stream block being filled */
+static int16_t *s_outBlock     = NULL;
+static uint32_t s_outBlockFill = 0;
+
+/* End of the previous unit, kept back to be mixed with the start of the next one */
+static int16_t s_fadeTail[SLN_PROMPT_FADE_SAMPLES];
+static uint32_t s_fadeTailLen = 0;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static int32_t prompt_emit(const int16_t *samples, uint32_t count)
+{
+    uint32_t chunk = 0;
+
+    while (count > 0)
+    {
+        if (s_outBlock == NULL)
+        {
+            if (SLN_AMP_StreamGetBuffer((uint8_t **)&s_outBlock, portMAX_DELAY) != 0)
+            {
+                return SLN_PROMPT_EAMP;
+            }
+            s_outBlockFill = 0;
+        }
+
+        chunk = MIN(count, PROMPT_BLOCK_SAMPLES - s_outBlockFill);
+        memcpy(&s_outBlock[s_outBlockFill], samples, chunk * sizeof(int16_t));
+        s_outBlockFill += chunk;
+        samples += chunk;
+        count -= chunk;
+
+        if (s_outBlockFill == PROMPT_BLOCK_SAMPLES)
+        {
+            s_outBlock = NULL;
+            if (SLN_AMP_StreamCommit(AMP_STREAM_BLOCK_SIZE) != 0)
+            {
+                return SLN_PROMPT_EAMP;
+            }
+        }
+    }
+
+    return SLN_PROMPT_OK;
+}
+
+static int32_t prompt_flush(void)
+{
+    int32_t ret = SLN_PROMPT_OK;
+
+    if (s_fadeTailLen > 0)
+    {
+        ret           = prompt_emit(s_fadeTail, s_fadeTailLen);
+        s_fadeTailLen = 0;
+    }
+
+    if ((ret == SLN_PROMPT_OK) && (s_outBlock != NULL))
+    {
+        /* The amplifier pads the last block with silence */
+        s_outBlock = NULL;
+        if (SLN_AMP_StreamCommit(s_outBlockFill * sizeof(int16_t)) != 0)
+        {
+            ret = SLN_PROMPT_EAMP;
+        }
+    }
+
+    return ret;
+}
+
+/*
+ * Emit one unit. Its first samples are cross-faded with the tail of the previous unit,
+ * its last SLN_PROMPT_FADE_SAMPLES are kept back for the next one.
+ */
+static int32_t prompt_emit_unit(const int16_t *samples, uint32_t count)
+{
+    int16_t mixed[SLN_PROMPT_FADE_SAMPLES];
+    int32_t ret         = SLN_PROMPT_OK;
+    uint32_t overlap    = MIN(s_fadeTailLen, count);
+    const int16_t *tail = &s_fadeTail[s_fadeTailLen - overlap];
+    uint32_t keep       = 0;
+    uint32_t weight     = 0;
+    uint32_t i;
+
+    /* Part of the tail not covered by a (very short) unit is played as it is */
+    ret = prompt_emit(s_fadeTail, s_fadeTailLen - overlap);
+
+    if ((ret == SLN_PROMPT_OK) && (overlap > 0))
+    {
+        for (i = 0; i < overlap; i++)
+        {
+            weight   = ((i + 1) * PROMPT_Q15_ONE) / (overlap + 1);
+            mixed[i] = (int16_t)(((int32_t)tail[i] * (int32_t)(PROMPT_Q15_ONE - weight) +
+                                  (int32_t)samples[i] * (int32_t)weight) >>
+                                 15);
+        }
+        ret = prompt_emit(mixed, overlap);
+    }
+
+    samples += overlap;
+    count -= overlap;
+
+    if (ret == SLN_PROMPT_OK)
+    {
+        keep = MIN(count, SLN_PROMPT_FADE_SAMPLES);
+        ret  = prompt_emit(samples, count - keep);
+
+        memcpy(s_fadeTail, &samples[count - keep], keep * sizeof(int16_t));
+        s_fadeTailLen = keep;
+    }
+
+    return ret;
+}
+
+static int32_t prompt_render(const sln_prompt_t *prompt)
+{
+    int32_t ret = SLN_PROMPT_OK;
+    const sln_prompt_clip_t *clip;
+    uint8_t i;
+
+    if (SLN_AMP_StreamStart() != 0)
+    {
+        return SLN_PROMPT_EBUSY;
+    }
+
+    s_outBlock     = NULL;
+    s_outBlockFill = 0;
+    s_fadeTailLen  = 0;
+
+    for (i = 0; (i < prompt->count) && (ret == SLN_PROMPT_OK); i++)
+    {
+        clip = &s_promptClips[prompt->units[i]];
+        ret = prompt_emit_unit(clip->samples, clip->count);
+    }
+
+    if (ret == SLN_PROMPT_OK)
+    {
+        ret = prompt_flush();
+    }
+
+    SLN_AMP_StreamStop(ret == SLN_PROMPT_OK);
+
+    return ret;
+}
+
+static void prompt_task(void *pvParameters)
+{
+    sln_prompt_t prompt;
+    int32_t ret = SLN_PROMPT_OK;
+
+    while (1)
+    {
+        /* Peek so that SLN_PROMPT_Play reports busy until the prompt is rendered */
+        if (xQueuePeek(s_promptQueue, &prompt, portMAX_DELAY) == pdTRUE)
+        {
+            ret = prompt_render(&prompt);
+            if (ret != SLN_PROMPT_OK)
+            {
+                configPRINTF(("[WARNING] Prompt could not be played: %d\r\n", ret));
+            }
+
+            xQueueReceive(s_promptQueue, &prompt, 0);
+        }
+    }
+}
+
+int32_t SLN_PROMPT_Init(const sln_prompt_clip_t *clips)
+{
+    uint32_t missing = 0;
+    uint32_t i;
+
+    if (clips == NULL)
+    {
+        return SLN_PROMPT_EINVAL;
+    }
+
+    for (i = 0; i < kPromptUnit_Count; i++)
+    {
+        if ((clips[i].samples == NULL) || (clips[i].count == 0))
+        {
+            missing++;
+        }
+    }
+    if (missing > 0)
+    {
+        // A prompt missing its digits or units would not say what it is played for
+        configPRINTF(("[ERROR] %d prompt units have no recording\r\n", missing));
+        return SLN_PROMPT_ENOENTRY;
+    }
+
+    s_promptClips = clips;
+
+    if (s_promptQueue == NULL)
+    {
+        s_promptQueue = xQueueCreate(1, sizeof(sln_prompt_t));
+        if (s_promptQueue == NULL)
+        {
+            return SLN_PROMPT_ENOMEM;
+        }
+    }
+
+    if (s_promptTaskHandle == NULL)
+    {
+        if (xTaskCreate(prompt_task, PROMPT_TASK_NAME, PROMPT_TASK_STACK_SIZE, NULL, PROMPT_TASK_PRIORITY,
+                        &s_promptTaskHandle) != pdPASS)
+        {
+            configPRINTF(("Failed to create prompt_task\r\n"));
+            return SLN_PROMPT_ENOMEM;
+        }
+    }
+
+    return SLN_PROMPT_OK;
+}
+
+void SLN_PROMPT_Clear(sln_prompt_t *prompt)
+{
+    if (prompt != NULL)
+    {
+        prompt->count = 0;
+    }
+}
+
+int32_t SLN_PROMPT_AppendUnit(sln_prompt_t *prompt, sln_prompt_unit_t unit)
+{
+    if ((prompt == NULL) || (unit >= kPromptUnit_Count))
+    {
+        return SLN_PROMPT_EINVAL;
+    }
+
+    if (prompt->count >= SLN_PROMPT_MAX_UNITS)
+    {
+        return SLN_PROMPT_ENOMEM;
+    }
+
+    prompt->units[prompt->count++] = (uint8_t)unit;
+
+    return SLN_PROMPT_OK;
+}
+
+int32_t SLN_PROMPT_AppendNumber(sln_prompt_t *prompt, uint32_t integer, int8_t decimal)
+{
+    int32_t ret       = SLN_PROMPT_OK;
+    uint32_t hundreds = integer / 100;
+    uint32_t tens     = (integer / 10) % 10;
+    uint32_t units    = integer % 10;
+
+    if ((integer > 999) || (decimal > 9))
+    {
+        return SLN_PROMPT_EINVAL;
+    }
+
+    if (hundreds > 0)
+    {
+        ret = SLN_PROMPT_AppendUnit(prompt, (sln_prompt_unit_t)(kPromptUnit_Digit0 + hundreds));
+        if (ret == SLN_PROMPT_OK)
+        {
+            ret = SLN_PROMPT_AppendUnit(prompt, kPromptUnit_Hundred);
+        }
+    }
+
+    if ((ret == SLN_PROMPT_OK) && (tens > 0))
+    {
+        /* 10 to 19 are read without the leading one, unless there are hundreds */
+        if ((tens > 1) || (hundreds > 0))
+        {
+            ret = SLN_PROMPT_AppendUnit(prompt, (sln_prompt_unit_t)(kPromptUnit_Digit0 + tens));
+        }
+        if (ret == SLN_PROMPT_OK)
+        {
+            ret = SLN_PROMPT_AppendUnit(prompt, kPromptUnit_Ten);
+        }
+    }
+    else if ((ret == SLN_PROMPT_OK) && (hundreds > 0) && (units > 0))
+    {
+        /* A zero is said between the hundreds and the units, e.g. 105 */
+        ret = SLN_PROMPT_AppendUnit(prompt, kPromptUnit_Digit0);
+    }
+
+    if ((ret == SLN_PROMPT_OK) && ((units > 0) || (integer == 0)))
+    {
+        ret = SLN_PROMPT_AppendUnit(prompt, (sln_prompt_unit_t)(kPromptUnit_Digit0 + units));
+    }
+
+    if ((ret == SLN_PROMPT_OK) && (decimal >= 0))
+    {
+        ret = SLN_PROMPT_AppendUnit(prompt, kPromptUnit_Point);
+        if (ret == SLN_PROMPT_OK)
+        {
+            ret = SLN_PROMPT_AppendUnit(prompt, (sln_prompt_unit_t)(kPromptUnit_Digit0 + decimal));
+        }
+    }
+
+    return ret;
+}
+
+int32_t SLN_PROMPT_Play(const sln_prompt_t *prompt)
+{
+    if (s_promptQueue == NULL)
+    {
+        return SLN_PROMPT_ENOINIT;
+    }
+
+    if ((prompt == NULL) || (prompt->count == 0) || (prompt->count > SLN_PROMPT_MAX_UNITS))
+    {
+        return SLN_PROMPT_EINVAL;
+    }
+
+    if (xQueueSend(s_promptQueue, prompt, 0) != pdTRUE)
+    {
+        return SLN_PROMPT_EBUSY;
+    }
+
+    return SLN_PROMPT_OK;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __SLN_PROMPT_H__
+#define __SLN_PROMPT_H__
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Maximum number of units in one prompt */
+#define SLN_PROMPT_MAX_UNITS 16
+
+/*! @brief Length of the cross-fade between two units, 5ms at 48KHz */
+#define SLN_PROMPT_FADE_SAMPLES 240
+
+/*! @brief Prompt status codes */
+typedef enum _sln_prompt_status
+{
+    SLN_PROMPT_OK       = 0,
+    SLN_PROMPT_EINVAL   = -1,
+    SLN_PROMPT_ENOMEM   = -2,
+    SLN_PROMPT_EBUSY    = -3,
+    SLN_PROMPT_ENOINIT  = -4,
+    SLN_PROMPT_EAMP     = -5,
+    SLN_PROMPT_ENOENTRY = -6,
+} sln_prompt_status_t;
+
+/*! @brief Units a prompt is built from. Numbers are read the Chinese way (e.g. 36.5 -> 3 Ten 6 Point 5) */
+typedef enum _sln_prompt_unit
+{
+    kPromptUnit_Digit0 = 0,
+    kPromptUnit_Digit1,
+    kPromptUnit_Digit2,
+    kPromptUnit_Digit3,
+    kPromptUnit_Digit4,
+    kPromptUnit_Digit5,
+    kPromptUnit_Digit6,
+    kPromptUnit_Digit7,
+    kPromptUnit_Digit8,
+    kPromptUnit_Digit9,
+    kPromptUnit_Ten,
+    kPromptUnit_Hundred,
+    kPromptUnit_Point,
+    kPromptUnit_Degree,
+    kPromptUnit_SetTo,
+    kPromptUnit_Confirm,
+    kPromptUnit_Count,
+} sln_prompt_unit_t;
+
+/*! @brief Recording of one unit, 48KHz 16 bit mono like the other clips played by the amplifier */
+typedef struct _sln_prompt_clip
+{
+    const int16_t *samples;
+    uint32_t count;
+} sln_prompt_clip_t;
+
+/*! @brief A sequence of units to be played as one continuous prompt */
+typedef struct _sln_prompt
+{
+    uint8_t units[SLN_PROMPT_MAX_UNITS];
+    uint8_t count;
+} sln_prompt_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /*_cplusplus*/
+
+/**
+ * @brief Initialize the prompt synthesizer and start its playback task
+ *
+ * @param clips                 Table of kPromptUnit_Count recordings, indexed by sln_prompt_unit_t.
+ *                              Every unit must have a recording.
+ * @return sln_prompt_status_t  SLN_PROMPT_OK if success, SLN_PROMPT_ENOENTRY if a unit has no recording
+ */
+int32_t SLN_PROMPT_Init(const sln_prompt_clip_t *clips);
+
+/**
+ * @brief Empty a prompt
+ *
+ * @param prompt                Pointer to the prompt
+ */
+void SLN_PROMPT_Clear(sln_prompt_t *prompt);
+
+/**
+ * @brief Append one unit to a prompt
+ *
+ * @param prompt                Pointer to the prompt
+ * @param unit                  The unit to append
+ * @return sln_prompt_status_t  SLN_PROMPT_OK if success, SLN_PROMPT_ENOMEM if the prompt is full
+ */
+int32_t SLN_PROMPT_AppendUnit(sln_prompt_t *prompt, sln_prompt_unit_t unit);
+
+/**
+ * @brief Append a number with at most one decimal to a prompt
+ *
+ * @param prompt                Pointer to the prompt
+ * @param integer               Integer part, from 0 to 999
+ * @param decimal               Decimal digit from 0 to 9, or -1 if there is no decimal part
+ * @return sln_prompt_status_t  SLN_PROMPT_OK if success
+ */
+int32_t SLN_PROMPT_AppendNumber(sln_prompt_t *prompt, uint32_t integer, int8_t decimal);
+
+/**
+ * @brief Play a prompt. The units are cross-faded into one continuous stream.
+ * The function returns once the prompt is queued, use SLN_AMP_WaitPlaybackDone to wait for its end.
+ *
+ * @param prompt                Pointer to the prompt, it is copied
+ * @return sln_prompt_status_t  SLN_PROMPT_OK if success, SLN_PROMPT_EBUSY if a prompt is already playing
+ */
+int32_t SLN_PROMPT_Play(const sln_prompt_t *prompt);
+
+#if defined(__cplusplus)
+}
+#endif /*_cplusplus*/
+
+#endif /* __SLN_PROMPT_H__ */
@@ -128,6 +128,12 @@
 #ifndef MEMP_NUM_TCP_SEG
 #define MEMP_NUM_TCP_SEG 22
 #endif
+/* MEMP_NUM_NETCONN: the number of struct netconns: the DHCP server,
+   the TCP server listener and its clients, the ASR events and the
+   audio tap listener and client. */
+#ifndef MEMP_NUM_NETCONN
+#define MEMP_NUM_NETCONN 10
+#endif
 /* MEMP_NUM_SYS_TIMEOUT: the number of simultaneously active
    timeouts. */
 #ifndef MEMP_NUM_SYS_TIMEOUT
@@ -222,6 +228,9 @@
 
 #define MEMP_STATS 1
 
+/* 32-bit counters, read by the metrics snapshot */
+#define LWIP_STATS_LARGE 1
+
 /*
    --------------------------------------
    ---------- Checksum options ----------
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _THREADING_ALT_H_
+#define _THREADING_ALT_H_
+
+/*!
+ * Mutexes of mbedTLS (MBEDTLS_THREADING_ALT): FreeRTOS mutexes with their memory in the context they
+ * protect, no heap. The functions are installed by SLN_TLS_SERVER_Init, see sln_tls_server.c.
+ */
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+typedef struct _mbedtls_threading_mutex
+{
+    SemaphoreHandle_t handle;  /*!< handle: The mutex, NULL until initialized. */
+    StaticSemaphore_t storage; /*!< storage: Memory of the mutex. */
+} mbedtls_threading_mutex_t;
+
+#endif /* _THREADING_ALT_H_ */
@@ -135,7 +135,24 @@ status_t flexspi_nor_wait_bus_busy(FLEXSPI_Type *base)
     return status;
 }
 
-status_t flexspi_nor_flash_erase_sector(FLEXSPI_Type *base, uint32_t address)
+status_t flexspi_nor_read_status(FLEXSPI_Type *base, uint32_t *value)
+{
+    flexspi_transfer_t flashXfer;
+
+    *value = 0;
+
+    flashXfer.deviceAddress = 0;
+    flashXfer.port          = kFLEXSPI_PortA1;
+    flashXfer.cmdType       = kFLEXSPI_Read;
+    flashXfer.SeqNumber     = 2;
+    flashXfer.seqIndex      = HYPERFLASH_CMD_LUT_SEQ_IDX_READSTATUS;
+    flashXfer.data          = value;
+    flashXfer.dataSize      = 2;
+
+    return FLEXSPI_TransferBlocking(base, &flashXfer);
+}
+
+status_t flexspi_nor_flash_erase_sector_start(FLEXSPI_Type *base, uint32_t address)
 {
     status_t status;
     flexspi_transfer_t flashXfer;
@@ -154,6 +171,15 @@ status_t flexspi_nor_flash_erase_sector(FLEXSPI_Type *base, uint32_t address)
     flashXfer.seqIndex      = HYPERFLASH_CMD_LUT_SEQ_IDX_ERASESECTOR;
     status                  = FLEXSPI_TransferBlocking(base, &flashXfer);
 
+    return status;
+}
+
+status_t flexspi_nor_flash_erase_sector(FLEXSPI_Type *base, uint32_t address)
+{
+    status_t status;
+
+    status = flexspi_nor_flash_erase_sector_start(base, address);
+
     if (status != kStatus_Success)
     {
         return status;
@@ -164,6 +190,21 @@ status_t flexspi_nor_flash_erase_sector(FLEXSPI_Type *base, uint32_t address)
     return status;
 }
 
+/* Single cycle commands, no write enable needed; the LUT has no free sequence for them */
+status_t flexspi_nor_flash_erase_suspend(FLEXSPI_Type *base, uint32_t address)
+{
+    uint8_t data[4] = {0x00, 0xB0, 0x00, 0x00};
+
+    return flexspi_nor_hyperbus_write(base, address / 2, (uint32_t *)data, 2);
+}
+
+status_t flexspi_nor_flash_erase_resume(FLEXSPI_Type *base, uint32_t address)
+{
+    uint8_t data[4] = {0x00, 0x30, 0x00, 0x00};
+
+    return flexspi_nor_hyperbus_write(base, address / 2, (uint32_t *)data, 2);
+}
+
 static status_t flexspi_nor_flash_page_program_with_buffer_seq2(FLEXSPI_Type *base,
                                                                 uint32_t address,
                                                                 const uint32_t *src)
@@ -15,6 +15,11 @@
  * Definitions
  ******************************************************************************/
 
+/* Status register bits */
+#define HYPERFLASH_STATUS_READY         (0x8000U)
+#define HYPERFLASH_STATUS_ERASE_SUSPEND (0x0040U)
+#define HYPERFLASH_STATUS_ERROR         (0x3200U)
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -31,8 +36,16 @@ status_t flexspi_nor_write_enable(FLEXSPI_Type *base, uint32_t baseAddr);
 
 status_t flexspi_nor_wait_bus_busy(FLEXSPI_Type *base);
 
+status_t flexspi_nor_read_status(FLEXSPI_Type *base, uint32_t *value);
+
+status_t flexspi_nor_flash_erase_sector_start(FLEXSPI_Type *base, uint32_t address);
+
 status_t flexspi_nor_flash_erase_sector(FLEXSPI_Type *base, uint32_t address);
 
+status_t flexspi_nor_flash_erase_suspend(FLEXSPI_Type *base, uint32_t address);
+
+status_t flexspi_nor_flash_erase_resume(FLEXSPI_Type *base, uint32_t address);
+
 status_t flexspi_nor_flash_page_program_with_buffer(FLEXSPI_Type *base, uint32_t address, const uint32_t *src);
 
 status_t flexspi_nor_read_vcr(FLEXSPI_Type *base, uint32_t *vcr);
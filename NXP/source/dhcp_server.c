@@ -49,6 +49,7 @@
 #include "RTOS/wwd_rtos_interface.h"
 
 #include "FreeRTOS.h"
+#include "semphr.h"
 #include "task.h"
 
 #include "lwip/opt.h"
@@ -56,6 +57,7 @@
 #include "lwip/sys.h"
 
 #include "wwd_logging.h"
+#include "sln_metrics.h"
 
 /******************************************************
  *                      Macros
@@ -66,6 +68,9 @@
  ******************************************************/
 #define DHCP_STACK_SIZE               (800)
 
+/* Time quit_dhcp_server waits for the thread to exit, it only has to delete its connection */
+#define DHCP_QUIT_TIMEOUT_MS            (2 * 1000)
+
 /* BOOTP operations */
 #define BOOTP_OP_REQUEST                (1)
 #define BOOTP_OP_REPLY                  (2)
@@ -80,19 +85,39 @@
 #define DHCPRELEASE                     (7)
 #define DHCPINFORM                      (8)
 
+/* DHCP options used by the server */
+#define DHCP_OPTION_PAD                 (0)
+#define DHCP_OPTION_REQUESTED_IP        (50)
+#define DHCP_OPTION_MESSAGE_TYPE        (53)
+#define DHCP_OPTION_SERVER_ID           (54)
+#define DHCP_OPTION_END                 (255)
+
 /* UDP port numbers for DHCP server and client */
 #define IPPORT_DHCPS                   (67)
 #define IPPORT_DHCPC                   (68)
 
-/* DHCP socket timeout value in milliseconds. Modify this to make thread exiting more responsive */
-#define DHCP_SOCKET_TIMEOUT     500
+/* Leases, one address of the pool each: 192.168.1.100 to 192.168.1.(100 + DHCP_MAX_LEASES - 1) */
+#define DHCP_MAX_LEASES                 (16)
+#define DHCP_POOL_FIRST_ADDR            ( ( 1 << 8 ) + 100 )
 
+/* Buckets of the MAC hash, a power of two */
+#define DHCP_LEASE_BUCKETS              (16)
 
+/* Time an offered address is kept for the client, and lease time given in lease_time_option_buff */
+#define DHCP_OFFER_TIMEOUT_MS           (10 * 1000)
+#define DHCP_LEASE_TIME_S               (24 * 60 * 60)
 
 /******************************************************
  *                   Enumerations
  ******************************************************/
 
+typedef enum
+{
+    DHCP_LEASE_FREE,    /* never given, no client */
+    DHCP_LEASE_OFFERED, /* offered to the client, until the offer timeout */
+    DHCP_LEASE_BOUND,   /* acknowledged, until the lease time */
+} dhcp_lease_state_t;
+
 /******************************************************
  *                 Type Definitions
  ******************************************************/
@@ -122,17 +147,34 @@ typedef struct
     /* as of RFC2131 it is variable length */
 } dhcp_header_t;
 
+/* Options of a request the server uses, found in one pass over the options area */
+typedef struct
+{
+    const uint8_t* message_type;         /* DHCP command, 1 byte */
+    const uint8_t* requested_ip;         /* requested IP address, 4 bytes, NULL if absent */
+    const uint8_t* server_id;            /* server chosen by the client, 4 bytes, NULL if absent */
+} dhcp_options_t;
+
+/* Lease of an address of the pool; the client MAC stays attached once the lease expires, so a client
+ * coming back gets the same address unless it was given to another one in the meantime */
+typedef struct
+{
+    uint8_t    mac[6];                   /* client hardware address */
+    uint8_t    state;                    /* dhcp_lease_state_t */
+    int8_t     next;                     /* next lease of the hash bucket, -1 for none */
+    TickType_t expiry;                   /* tick the offer or lease ends */
+} dhcp_lease_t;
+
 /******************************************************
  *               Static Function Declarations
  ******************************************************/
-static unsigned char * find_option( dhcp_header_t* request, unsigned char option_num );
+static int parse_options( const dhcp_header_t* request, uint32_t len, dhcp_options_t* options );
 static void dhcp_thread( void * thread_input );
 
 /******************************************************
  *               Variable Definitions
  ******************************************************/
 static char             new_ip_addr[4]                = { 192, 168, 0, 0 };
-static uint16_t         next_available_ip_addr        = ( 1 << 8 ) + 100;
 static char             subnet_option_buff[]          = { 1, 4, 255, 255, 0, 0 };
 static char             server_ip_addr_option_buff[]  = { 54, 4, 192, 168, 1, 1 };
 static char             mtu_option_buff[]             = { 26, 2, WICED_PAYLOAD_MTU>>8, WICED_PAYLOAD_MTU&0xff };
@@ -143,7 +185,15 @@ static char             lease_time_option_buff[]      = { 51, 4, 0x00, 0x01, 0x5
 static char             dhcp_magic_cookie[]           = { 0x63, 0x82, 0x53, 0x63 };
 static volatile char    dhcp_quit_flag = 0;
 static TaskHandle_t     dhcp_thread_handle;
+static SemaphoreHandle_t dhcp_exit_sem;
+static StaticSemaphore_t dhcp_exit_sem_buff;
 static dhcp_header_t    dhcp_header_buff;
+static dhcp_lease_t     dhcp_leases[DHCP_MAX_LEASES];
+static int8_t           dhcp_lease_buckets[DHCP_LEASE_BUCKETS];
+
+SLN_METRICS_DEFINE_COUNTER(dhcp_requests_metric, "dhcp.requests");
+SLN_METRICS_DEFINE_COUNTER(dhcp_naks_metric, "dhcp.naks");
+SLN_METRICS_DEFINE_COUNTER(dhcp_no_address_metric, "dhcp.no_address");
 
 /******************************************************
  *               Function Definitions
@@ -151,46 +201,394 @@ static dhcp_header_t    dhcp_header_buff;
 
 void start_dhcp_server( uint32_t local_addr )
 {
-    //xTaskCreate( dhcp_thread, "DHCP thread", DHCP_STACK_SIZE/sizeof( portSTACK_TYPE ), (void*)local_addr, DEFAULT_THREAD_PRIO, &dhcp_thread_handle);
+    SLN_METRICS_Register( &dhcp_requests_metric );
+    SLN_METRICS_Register( &dhcp_naks_metric );
+    SLN_METRICS_Register( &dhcp_no_address_metric );
+
+    if ( dhcp_exit_sem == NULL )
+    {
+        dhcp_exit_sem = xSemaphoreCreateBinaryStatic( &dhcp_exit_sem_buff );
+    }
+
+    /* Drop the exit of a thread that stopped on its own, quit_dhcp_server must wait for the new one */
+    (void) xSemaphoreTake( dhcp_exit_sem, 0 );
+
+    /* Reset before the thread runs, it would otherwise clear a quit coming right after the start */
+    dhcp_quit_flag = 0;
+
     xTaskCreate( dhcp_thread, "DHCP thread", DHCP_STACK_SIZE/sizeof( portSTACK_TYPE ), (void*)local_addr, DEFAULT_THREAD_PRIO, &dhcp_thread_handle);
 }
 
+/* Returns once the thread exited: a server started next cannot have its handle cleared by this one */
 void quit_dhcp_server( void )
 {
     dhcp_quit_flag = 1;
+
+    /* Wake the thread up, it sleeps until a request comes */
+    if ( dhcp_thread_handle != NULL )
+    {
+        xTaskNotifyGive( dhcp_thread_handle );
+
+        if ( xSemaphoreTake( dhcp_exit_sem, pdMS_TO_TICKS( DHCP_QUIT_TIMEOUT_MS ) ) != pdTRUE )
+        {
+            WWD_LOG(("dhcp srv: thread not stopped\r\n"));
+        }
+    }
+}
+
+/* Called from the tcpip thread: a request is queued on the connection */
+static void dhcp_netconn_callback( struct netconn* conn, enum netconn_evt event, uint16_t len )
+{
+    if ( ( event == NETCONN_EVT_RCVPLUS ) && ( dhcp_thread_handle != NULL ) )
+    {
+        xTaskNotifyGive( dhcp_thread_handle );
+    }
+}
+
+/* The vendor part of the MAC is often shared by the clients, all the bytes are hashed (FNV-1a) */
+static uint32_t lease_bucket( const uint8_t* mac )
+{
+    uint32_t hash = 2166136261u;
+    int      i;
+
+    for ( i = 0; i < 6; i++ )
+    {
+        hash = ( hash ^ mac[i] ) * 16777619u;
+    }
+
+    return hash & ( DHCP_LEASE_BUCKETS - 1 );
+}
+
+static int lease_expired( const dhcp_lease_t* lease, TickType_t now )
+{
+    return ( lease->state == DHCP_LEASE_FREE ) || ( (int32_t)( now - lease->expiry ) >= 0 );
+}
+
+/* Address of a lease, in network order */
+static uint32_t lease_ip_addr( const dhcp_lease_t* lease )
+{
+    uint16_t host = DHCP_POOL_FIRST_ADDR + ( lease - dhcp_leases );
+    uint8_t  addr[4];
+    uint32_t ip;
+
+    addr[0] = new_ip_addr[0];
+    addr[1] = new_ip_addr[1];
+    addr[2] = host >> 8;
+    addr[3] = host & 0xff;
+    memcpy( &ip, addr, 4 );
+
+    return ip;
+}
+
+static void reset_leases( void )
+{
+    memset( dhcp_leases, 0, sizeof( dhcp_leases ) );
+    memset( dhcp_lease_buckets, -1, sizeof( dhcp_lease_buckets ) );
+}
+
+/**
+ *  Finds the lease of a client
+ *
+ * @param mac : client hardware address
+ *
+ * @return The lease attached to the client, expired or not, or NULL if none
+ */
+static dhcp_lease_t* find_lease( const uint8_t* mac )
+{
+    int8_t index = dhcp_lease_buckets[lease_bucket( mac )];
+
+    while ( index >= 0 )
+    {
+        if ( memcmp( dhcp_leases[index].mac, mac, 6 ) == 0 )
+        {
+            return &dhcp_leases[index];
+        }
+        index = dhcp_leases[index].next;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Attaches a lease to a new client
+ *
+ *  Takes a lease never given first, then the one expired for the longest time, detached from its
+ *  previous client.
+ *
+ * @param mac : client hardware address
+ * @param now : current tick
+ *
+ * @return The lease, or NULL if all the addresses of the pool are in use
+ */
+static dhcp_lease_t* alloc_lease( const uint8_t* mac, TickType_t now )
+{
+    dhcp_lease_t* lease = NULL;
+    int8_t*       link;
+    int8_t        index;
+    uint32_t      bucket;
+    int           i;
+
+    for ( i = 0; i < DHCP_MAX_LEASES; i++ )
+    {
+        dhcp_lease_t* candidate = &dhcp_leases[i];
+
+        if ( candidate->state == DHCP_LEASE_FREE )
+        {
+            lease = candidate;
+            break;
+        }
+        if ( lease_expired( candidate, now ) &&
+             ( ( lease == NULL ) || ( (int32_t)( candidate->expiry - lease->expiry ) < 0 ) ) )
+        {
+            lease = candidate;
+        }
+    }
+
+    if ( lease == NULL )
+    {
+        return NULL;
+    }
+
+    if ( lease->state != DHCP_LEASE_FREE )
+    {
+        /* Detach from the previous client */
+        index = lease - dhcp_leases;
+        link  = &dhcp_lease_buckets[lease_bucket( lease->mac )];
+        while ( *link != index )
+        {
+            link = &dhcp_leases[*link].next;
+        }
+        *link = lease->next;
+    }
+
+    bucket = lease_bucket( mac );
+    memcpy( lease->mac, mac, 6 );
+    lease->next                = dhcp_lease_buckets[bucket];
+    dhcp_lease_buckets[bucket] = lease - dhcp_leases;
+
+    return lease;
+}
+
+/**
+ *  Adds the options of a reply
+ *
+ * @param option_ptr   : start of the options area
+ * @param message_type : DHCP message type option
+ * @param full         : add the lease and network configuration options, for an OFFER or ACK
+ *
+ * @return End of the options written
+ */
+static char* add_reply_options( char* option_ptr, const char* message_type, int full )
+{
+    memcpy( option_ptr, message_type, 3 );               /* DHCP message type */
+    option_ptr += 3;
+    memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Server identifier */
+    option_ptr += 6;
+
+    if ( full )
+    {
+        memcpy( option_ptr, lease_time_option_buff, 6 );     /* Lease Time */
+        option_ptr += 6;
+        memcpy( option_ptr, subnet_option_buff, 6 );         /* Subnet Mask */
+        option_ptr += 6;
+        memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Router (gateway) */
+        option_ptr[0] = 3; /* Router id */
+        option_ptr += 6;
+        memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* DNS server */
+        option_ptr[0] = 6; /* DNS server id */
+        option_ptr += 6;
+        memcpy( option_ptr, mtu_option_buff, 4 );            /* Interface MTU */
+        option_ptr += 4;
+    }
+
+    option_ptr[0] = 0xff; /* end options */
+    option_ptr++;
+
+    return option_ptr;
+}
+
+/**
+ *  Turns the request in dhcp_header_buff into a reply and broadcasts it
+ *
+ *  The reply is sent from dhcp_header_buff by reference, without a copy into the lwIP heap.
+ *
+ * @param conn         : DHCP server connection
+ * @param your_ip      : address given to the client, network order, 0 for a NAK
+ * @param message_type : DHCP message type option
+ */
+static void send_reply( struct netconn* conn, uint32_t your_ip, const char* message_type )
+{
+    static const ip_addr_t dst_ip = IPADDR4_INIT( 0xffffffff );
+    dhcp_header_t*         dhcp_header_ptr = &dhcp_header_buff;
+    struct netbuf          buf;
+    char*                  option_ptr;
+    err_t                  err;
+
+    dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
+    memcpy( &dhcp_header_ptr->your_ip_addr, &your_ip, 4 );
+
+    /* Copy the magic DHCP number and blank the options list */
+    memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
+    memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
+
+    option_ptr = add_reply_options( (char *) &dhcp_header_ptr->options, message_type, ( your_ip != 0 ) );
+
+    memset( &buf, 0, sizeof( buf ) );
+    err = netbuf_ref( &buf, dhcp_header_ptr, (u16_t)( option_ptr - (char*)dhcp_header_ptr ) );
+    if ( err == ERR_OK )
+    {
+        err = netconn_sendto( conn, &buf, &dst_ip, IPPORT_DHCPC );
+    }
+    netbuf_free( &buf );
+
+    if ( err != ERR_OK )
+    {
+        WWD_LOG(("dhcp srv: sending is failed\r\n"));
+    }
+}
+
+/**
+ *  Answers the request received in dhcp_header_buff
+ *
+ *  DISCOVER: offers the address of the lease of the client, a new lease if it has none.
+ *  REQUEST: ACKs the address of the lease of the client, NAKs any other address.
+ *  RELEASE: ends the lease, the address stays attached to the client until given to another.
+ *
+ * @param conn : DHCP server connection
+ * @param len  : length of the request
+ */
+static void handle_request( struct netconn* conn, uint32_t len )
+{
+    dhcp_header_t* dhcp_header_ptr = &dhcp_header_buff;
+    dhcp_options_t options;
+    dhcp_lease_t*  lease;
+    uint32_t       requested_ip;
+    uint32_t       lease_ip;
+    TickType_t     now = xTaskGetTickCount( );
+
+    if ( ( dhcp_header_ptr->opcode != BOOTP_OP_REQUEST ) || ( dhcp_header_ptr->hardware_addr_len != 6 ) ||
+         ( parse_options( dhcp_header_ptr, len, &options ) != 0 ) )
+    {
+        return;
+    }
+
+    SLN_METRICS_Add( &dhcp_requests_metric, 1 );
+
+    lease = find_lease( dhcp_header_ptr->client_hardware_addr );
+
+    switch ( options.message_type[0] )
+    {
+        case DHCPDISCOVER:
+            WWD_LOG(("Rcvd DHCP DISCOVER\n"));
+
+            if ( lease == NULL )
+            {
+                lease = alloc_lease( dhcp_header_ptr->client_hardware_addr, now );
+            }
+            if ( lease == NULL )
+            {
+                WWD_LOG(("dhcp srv: no address left\n"));
+                SLN_METRICS_Add( &dhcp_no_address_metric, 1 );
+                break;
+            }
+
+            /* A bound lease is offered again as is */
+            if ( ( lease->state != DHCP_LEASE_BOUND ) || lease_expired( lease, now ) )
+            {
+                lease->state  = DHCP_LEASE_OFFERED;
+                lease->expiry = now + pdMS_TO_TICKS( DHCP_OFFER_TIMEOUT_MS );
+            }
+
+            send_reply( conn, lease_ip_addr( lease ), dhcp_offer_option_buff );
+            break;
+
+        case DHCPREQUEST:
+            WWD_LOG(("Rcvd DHCP REQUEST\n"));
+
+            if ( ( options.server_id != NULL ) &&
+                 ( memcmp( options.server_id, &server_ip_addr_option_buff[2], 4 ) != 0 ) )
+            {
+                /* The client took the offer of another server */
+                if ( ( lease != NULL ) && ( lease->state == DHCP_LEASE_OFFERED ) )
+                {
+                    lease->expiry = now;
+                }
+                break;
+            }
+
+            /* Requested address in the options when selecting or rebooting, 'client address' when renewing */
+            if ( options.requested_ip != NULL )
+            {
+                memcpy( &requested_ip, options.requested_ip, 4 );
+            }
+            else
+            {
+                memcpy( &requested_ip, dhcp_header_ptr->client_ip_addr, 4 );
+            }
+
+            if ( ( lease != NULL ) && ( requested_ip == lease_ip_addr( lease ) ) )
+            {
+                lease->state  = DHCP_LEASE_BOUND;
+                lease->expiry = now + ( DHCP_LEASE_TIME_S * configTICK_RATE_HZ );
+
+                send_reply( conn, requested_ip, dhcp_ack_option_buff );
+            }
+            else
+            {
+                /* Not an address of this client - force it to start over with a DISCOVER */
+                SLN_METRICS_Add( &dhcp_naks_metric, 1 );
+                send_reply( conn, 0, dhcp_nak_option_buff );
+            }
+            break;
+
+        case DHCPRELEASE:
+            WWD_LOG(("Rcvd DHCP RELEASE\n"));
+
+            if ( lease != NULL )
+            {
+                lease_ip = lease_ip_addr( lease );
+                if ( memcmp( dhcp_header_ptr->client_ip_addr, &lease_ip, 4 ) == 0 )
+                {
+                    lease->expiry = now;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
 }
 
 /**
  *  Implements a very simple DHCP server.
  *
- *  Server will always offer next available address to a DISCOVER command
- *  Server will NAK any REQUEST command which is not requesting the next available address
- *  Server will ACK any REQUEST command which is for the next available address, and then increment the next available address
+ *  Each client gets an address of the pool, kept in a lease table hashed on its MAC: a client
+ *  reconnecting gets its address back.
+ *
+ *  The thread sleeps until the connection callback reports a request, then answers all the requests
+ *  queued before sleeping again.
  *
  * @param my_addr : local IP address for binding of server port.
  */
 
 static void dhcp_thread( void * thread_input )
 {
-    char*                 option_ptr;
-    static dhcp_header_t* dhcp_header_ptr = &dhcp_header_buff;
     struct netconn *conn;
     struct netbuf *buf;
     err_t err;
-    int   slen;
-    char  *mem;
-    //uint16_t rxlen;
-    ip_addr_t dst_ip = IPADDR4_INIT(0xffffffff);
+    uint32_t len;
 
     WWD_LOG(("DHCP server start\n"));
-    conn = netconn_new(NETCONN_UDP);
+    conn = netconn_new_with_callback(NETCONN_UDP, dhcp_netconn_callback);
     if( conn == NULL)
     {
         WWD_LOG(("udpecho: invalid conn\n"));
-        return;
+        dhcp_thread_handle = NULL;
+        xSemaphoreGive( dhcp_exit_sem );
+        vTaskDelete( NULL );
     }
     netconn_bind(conn, IP_ADDR_ANY, IPPORT_DHCPS);
-    conn->recv_timeout = DHCP_SOCKET_TIMEOUT;
+    netconn_set_nonblocking(conn, 1);
 
 #if LWIP_IGMP /* Only for testing of multicast join*/
     {
@@ -208,181 +606,28 @@ static void dhcp_thread( void * thread_input )
     }
 #endif
 
+    reset_leases( );
+
     /* Loop endlessly */
-    dhcp_quit_flag = 0;
     while ( dhcp_quit_flag == 0 )
     {
-        err = netconn_recv(conn, &buf);
-        if (err == ERR_OK)
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        /* Answer every request queued, the next ones notify again */
+        while ( dhcp_quit_flag == 0 )
         {
+            err = netconn_recv(conn, &buf);
+            if (err != ERR_OK)
+            {
+                break;
+            }
+
             /*  no need netconn_connect here, since the netbuf contains the address */
             WWD_LOG(("Rx Packet\r\n"));
-            netbuf_copy(buf,(char *) dhcp_header_ptr, sizeof(dhcp_header_buff));
+            len = netbuf_copy(buf, (char *) &dhcp_header_buff, sizeof(dhcp_header_buff));
             netbuf_delete(buf);
-            //netbuf_data(buf, &dhcp_header_ptr, &rxlen);
-            //WWD_LOG(("rxlen: %d\n", rxlen));
 
-            switch ( dhcp_header_ptr->options[2] )
-            {
-                case DHCPDISCOVER:
-                    {
-                        WWD_LOG(("Rcvd DHCP DISCOVER\n"));
-
-                        /* Discover command - send back OFFER response */
-                        dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
-
-                        /* Clear the DHCP options list */
-                        memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
-
-                        /* Create the IP address for the Offer */
-                        new_ip_addr[2] = next_available_ip_addr >> 8;
-                        new_ip_addr[3] = next_available_ip_addr & 0xff;
-                        memcpy( &dhcp_header_ptr->your_ip_addr, new_ip_addr, 4 );
-
-                        /* Copy the magic DHCP number */
-                        memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
-
-                        /* Add options */
-                        option_ptr = (char *) &dhcp_header_ptr->options;
-                        memcpy( option_ptr, dhcp_offer_option_buff, 3 );       /* DHCP message type */
-                        option_ptr += 3;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Server identifier */
-                        option_ptr += 6;
-                        memcpy( option_ptr, lease_time_option_buff, 6 );       /* Lease Time */
-                        option_ptr += 6;
-                        memcpy( option_ptr, subnet_option_buff, 6 );           /* Subnet Mask */
-                        option_ptr += 6;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Router (gateway) */
-                        option_ptr[0] = 3; /* Router id */
-                        option_ptr += 6;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* DNS server */
-                        option_ptr[0] = 6; /* DNS server id */
-                        option_ptr += 6;
-                        memcpy( option_ptr, mtu_option_buff, 4 );              /* Interface MTU */
-                        option_ptr += 4;
-                        option_ptr[0] = 0xff; /* end options */
-                        option_ptr++;
-
-                        /* Send packet */
-                        slen = (option_ptr - (char*)&dhcp_header_buff);
-                        buf = netbuf_new();
-                        mem = (char *)netbuf_alloc(buf, slen);
-                        if(mem == NULL)
-                        {
-                            WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
-                        }
-                        memcpy(mem, dhcp_header_ptr, slen);
-                        err = netconn_sendto(conn, buf,&dst_ip, IPPORT_DHCPC );
-                        if( err != ERR_OK )
-                        {
-                            WWD_LOG(("dhcp srv: sending is failed"));
-                        }
-                        netbuf_delete(buf);
-                        WWD_LOG(("Sending discover response\r\n"));
-                    }
-                    break;
-
-                case DHCPREQUEST:
-                    {
-                        /* REQUEST command - send back ACK or NAK */
-                        unsigned char* requested_address;
-                        uint32_t*      req_addr_ptr;
-                        uint32_t*      newip_ptr;
-                        //uint32_t*      server_id_req;
-
-                        WWD_LOG(("Rcvd DHCP REQUEST\n"));
-                        /* Check that the REQUEST is for this server */
-
-                        dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
-
-                        /* Locate the requested address in the options */
-                        requested_address = find_option( dhcp_header_ptr, 50 );
-
-                        /* Copy requested address */
-                        memcpy( &dhcp_header_ptr->your_ip_addr, requested_address, 4 );
-
-                        /* Blank options list */
-                        memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
-
-                        /* Copy DHCP magic number into packet */
-                        memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
-
-                        option_ptr = (char *) &dhcp_header_ptr->options;
-
-                        /* Check if Request if for next available IP address */
-                        req_addr_ptr = (uint32_t*) dhcp_header_ptr->your_ip_addr;
-                        newip_ptr = (uint32_t*) new_ip_addr;
-                        if ( *req_addr_ptr != ( ( *newip_ptr & 0x0000ffff ) | ( ( next_available_ip_addr & 0xff ) << 24 ) |
-                                                ( ( next_available_ip_addr & 0xff00 ) << 8 ) ) )
-                        {
-                            /* Request is not for next available IP - force client to take next available IP by sending NAK */
-                            /* Add appropriate options */
-                            memcpy( option_ptr, dhcp_nak_option_buff, 3 );  /* DHCP message type */
-                            option_ptr += 3;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Server identifier */
-                            option_ptr += 6;
-                            memset( &dhcp_header_ptr->your_ip_addr, 0, sizeof( dhcp_header_ptr->your_ip_addr ) ); /* Clear 'your address' field */
-                        }
-                        else
-                        {
-                            /* Request is not for next available IP - force client to take next available IP by sending NAK
-                             * Add appropriate options
-                             */
-                            memcpy( option_ptr, dhcp_ack_option_buff, 3 );       /* DHCP message type */
-                            option_ptr += 3;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Server identifier */
-                            option_ptr += 6;
-                            memcpy( option_ptr, lease_time_option_buff, 6 );     /* Lease Time */
-                            option_ptr += 6;
-                            memcpy( option_ptr, subnet_option_buff, 6 );         /* Subnet Mask */
-                            option_ptr += 6;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Router (gateway) */
-                            option_ptr[0] = 3; /* Router id */
-                            option_ptr += 6;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* DNS server */
-                            option_ptr[0] = 6; /* DNS server id */
-                            option_ptr += 6;
-                            memcpy( option_ptr, mtu_option_buff, 4 );            /* Interface MTU */
-                            option_ptr += 4;
-                            /* WPRINT_APP_INFO(("Assigned new IP address %d.%d.%d.%d\n",
-                                                (uint8_t)new_ip_addr[0], (uint8_t)new_ip_addr[1], 
-                                                next_available_ip_addr>>8, next_available_ip_addr&0xff )); */
-                            /* Increment IP address */
-                            next_available_ip_addr++;
-                            if ( ( next_available_ip_addr & 0xff ) == 0xff ) /* Handle low byte rollover */
-                            {
-                                next_available_ip_addr += 101;
-                            }
-                            if ( ( next_available_ip_addr >> 8 ) == 0xff ) /* Handle high byte rollover */
-                            {
-                                next_available_ip_addr += ( 2 << 8 );
-                            }
-                        }
-                        option_ptr[0] = 0xff; /* end options */
-                        option_ptr++;
-
-                        /* Send packet */
-                        slen = (option_ptr - (char*)&dhcp_header_buff);
-                        buf = netbuf_new();
-                        mem = (char *)netbuf_alloc(buf, slen);
-                        if(mem == NULL)
-                        {
-                            WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
-                        }
-                        memcpy(mem, dhcp_header_ptr, slen);
-                        err = netconn_sendto(conn, buf,&dst_ip, IPPORT_DHCPC );
-                        if( err != ERR_OK )
-                        {
-                            WWD_LOG(("dhcp srv: sending is failed\r\n"));
-                        }
-                        WWD_LOG(("Sent request response\r\n"));
-                        netbuf_delete(buf);
-                    }
-                    break;
-
-                default:
-                    break;
-            }
+            handle_request( conn, len );
         }
     }
 
@@ -390,37 +635,68 @@ static void dhcp_thread( void * thread_input )
     /* Delete DHCP socket */
     netconn_delete(conn);
 
-    /* Clean up this startup thread */
-    vTaskDelete( dhcp_thread_handle );
+    /* Clean up this startup thread, quit_dhcp_server waits for it */
+    dhcp_thread_handle = NULL;
+    xSemaphoreGive( dhcp_exit_sem );
+    vTaskDelete( NULL );
 }
 
 
 /**
- *  Finds a specified DHCP option
+ *  Parses the DHCP options of a request
  *
- *  Searches the given DHCP request and returns a pointer to the
- *  specified DHCP option data, or NULL if not found
+ *  Walks the options once, checking each length against the received data, and keeps the
+ *  options the server uses.
  *
- * @param request :    The DHCP request structure
- * @param option_num : Which DHCP option number to find
+ * @param request : The DHCP request structure
+ * @param len     : Length of the request received
+ * @param options : Options found
  *
- * @return Pointer to the DHCP option data, or NULL if not found
+ * @return 0 if the options are well formed and hold a message type, -1 otherwise
  */
 
-static unsigned char * find_option( dhcp_header_t* request, unsigned char option_num )
+static int parse_options( const dhcp_header_t* request, uint32_t len, dhcp_options_t* options )
 {
-    unsigned char* option_ptr = (unsigned char*) request->options;
-    while ( ( option_ptr[0] != 0xff ) &&
-            ( option_ptr[0] != option_num ) &&
-            ( option_ptr < ( (unsigned char*) request ) + sizeof( dhcp_header_t ) ) )
+    const uint8_t* option_ptr = request->options;
+    const uint8_t* end        = (const uint8_t*) request + len;
+
+    memset( options, 0, sizeof( *options ) );
+
+    if ( ( len < offsetof( dhcp_header_t, options ) ) || ( memcmp( request->magic, dhcp_magic_cookie, 4 ) != 0 ) )
     {
-        option_ptr += option_ptr[1] + 2;
+        return -1;
     }
-    if ( option_ptr[0] == option_num )
+
+    while ( ( option_ptr < end ) && ( option_ptr[0] != DHCP_OPTION_END ) )
     {
-        return &option_ptr[2];
+        if ( option_ptr[0] == DHCP_OPTION_PAD )
+        {
+            option_ptr++;
+            continue;
+        }
+
+        if ( ( end - option_ptr < 2 ) || ( end - option_ptr < option_ptr[1] + 2 ) )
+        {
+            return -1;
+        }
+
+        switch ( option_ptr[0] )
+        {
+            case DHCP_OPTION_MESSAGE_TYPE:
+                options->message_type = ( option_ptr[1] == 1 ) ? &option_ptr[2] : NULL;
+                break;
+            case DHCP_OPTION_REQUESTED_IP:
+                options->requested_ip = ( option_ptr[1] == 4 ) ? &option_ptr[2] : NULL;
+                break;
+            case DHCP_OPTION_SERVER_ID:
+                options->server_id = ( option_ptr[1] == 4 ) ? &option_ptr[2] : NULL;
+                break;
+            default:
+                break;
+        }
+
+        option_ptr += option_ptr[1] + 2;
     }
-    return NULL;
 
+    return ( options->message_type != NULL ) ? 0 : -1;
 }
-
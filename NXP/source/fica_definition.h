@@ -112,6 +112,8 @@
 /* Flash memory between FICA_FREE_MEM_START_ADDR and FICA_FREE_MEM_END_ADDR is considered not mapped
  * and may be used by the application. EX:
  * - Alexa2 QSPI maps first 128KB as KVS.
+ * - The first sector is the spare sector of the file system, see SLN_FLASH_MGMT_SPARE_ADDR.
+ * - The second one holds the new FICA table during a switch of the boot image, see FWUPDATE_FICA_COPY_ADDR.
  *
  * Perform a memory sufficiency/overlapping check.
  */
@@ -31,6 +31,7 @@
 
 /* Network includes */
 #include "sln_tcp_server.h"
+#include "sln_tls_server.h"
 
 /* Application headers */
 #include "sln_local_voice.h"
@@ -39,6 +40,12 @@
 /* Flash includes */
 #include "sln_flash.h"
 #include "sln_file_table.h"
+#include "sln_flash_writer.h"
+#include "sln_app_fwupdate.h"
+#include "sln_dcp_queue.h"
+#include "sln_settings_cache.h"
+#include "sln_asr_events.h"
+#include "sln_audio_tap.h"
 
 /* Crypto includes */
 #include "ksdk_mbedtls.h"
@@ -61,8 +68,6 @@
 #define audio_play_task_NAME     "AudioPlay"
 #define audio_play_task_PRIORITY 4
 #define audio_play_task_STACK    512
-
-#define STREAMER_PACKET_SIZE PCM_AMP_DATA_SIZE_20_MS
 #endif
 
 /*******************************************************************************
@@ -82,13 +87,8 @@ uint8_t isRecording;
 bool g_SW1Pressed                   = false;
 oob_demo_control_t oob_demo_control = {0};
 extern app_asr_shell_commands_t appAsrShellCommands;
-int g_bypass_voice_engine = 0;
 
 #if defined(SLN_LOCAL2_RD)
-static uint8_t s_streamerPoolIdx          = 0;
-static volatile uint8_t s_streamerPoolCnt = AMP_WRITE_SLOTS;
-static uint8_t s_streamerPools[STREAMER_PACKET_SIZE * AMP_WRITE_SLOTS];
-
 static SemaphoreHandle_t s_audioPlayMutex;
 static uint8_t s_audioIsPlaying;
 #endif
@@ -131,44 +131,27 @@ void SysTick_DelayTicks(uint32_t n)
 #if defined(SLN_LOCAL2_RD)
 static void audio_play_task(void *arg)
 {
-    uint8_t *sound           = ((audio_file_t *)arg)->fileAddr;
-    uint32_t soundSize       = ((audio_file_t *)arg)->fileSize;
-    uint32_t soundDataPlayed = 0;
-    uint32_t packetSize      = 0;
+    uint8_t *sound     = ((audio_file_t *)arg)->fileAddr;
+    uint32_t soundSize = ((audio_file_t *)arg)->fileSize;
+    amp_stream_stats_t streamStats;
 
-    s_streamerPoolCnt = AMP_WRITE_SLOTS;
-    s_streamerPoolIdx = 0;
-
-    while ((soundSize - soundDataPlayed) >= STREAMER_PACKET_SIZE)
+    if (SLN_AMP_StreamStart() != kStatus_Success)
+    {
+        configPRINTF(("[WARNING] The sound could not be played. AMP busy.\r\n"));
+    }
+    else
     {
-        /* In case there is an empty slot, send a new packet to the Amplifier */
-        if (s_streamerPoolCnt > 0)
+        if (SLN_AMP_StreamWrite(sound, soundSize, portMAX_DELAY) != soundSize)
         {
-            if (soundSize - soundDataPlayed >= STREAMER_PACKET_SIZE)
-            {
-                packetSize = STREAMER_PACKET_SIZE;
-            }
-            else
-            {
-                packetSize = soundSize - soundDataPlayed;
-            }
-
-            memcpy(&s_streamerPools[s_streamerPoolIdx * STREAMER_PACKET_SIZE], &sound[soundDataPlayed], packetSize);
-
-            if (SLN_AMP_WriteNoWait(&s_streamerPools[s_streamerPoolIdx * STREAMER_PACKET_SIZE], packetSize) !=
-                kStatus_Success)
-            {
-                configPRINTF(("[WARNING] The sound could not be played. AMP error.\r\n"));
-            }
-
-            s_streamerPoolCnt--;
+            configPRINTF(("[WARNING] The sound could not be played. AMP error.\r\n"));
+        }
 
-            // to prevent false positive while playing audio when Speaker and mics are close. 2 for 16bit, 3 for 48Khz
-            // to 16KHz
-            g_bypass_voice_engine += packetSize / (2 * 3);
+        SLN_AMP_StreamStop(true);
 
-            s_streamerPoolIdx = (s_streamerPoolIdx + 1) % AMP_WRITE_SLOTS;
-            soundDataPlayed += packetSize;
+        SLN_AMP_StreamGetStats(&streamStats);
+        if (streamStats.underruns > 0)
+        {
+            configPRINTF(("[WARNING] Audio stream had %d underruns.\r\n", streamStats.underruns));
         }
     }
 
@@ -238,10 +221,6 @@ static status_t audio_play_clip(const char *file)
         {
             configPRINTF(("[WARNING] The sound could not be played. AMP error.\r\n"));
         }
-
-        // to prevent false positive while playing audio when Speaker and mics are close. 2 for 16bit, 3 for 48Khz to
-        // 16KHz
-        g_bypass_voice_engine += audio_len / (2 * 3);
     }
 
     return status;
@@ -275,6 +254,7 @@ static void next_demo()
                 break;
         }
 
+        // Called from the switch interrupt: the app task hands the change to the settings cache
         appAsrShellCommands.status = WRITE_READY;
         appAsrShellCommands.asrCfg |= ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED | ASR_CFG_DEMO_LANGUAGE_CHANGED;
 
@@ -358,16 +338,13 @@ static void led_state_timeout(void)
 void appTask(void *arg)
 {
     amplifier_status_t ret;
-    uint32_t statusFlash  = 0;
 
     sln_shell_set_app_init_task_handle(&appInitDummyNullHandle);
 #if defined(SLN_LOCAL2_RD)
     s_audioPlayMutex = xSemaphoreCreateMutex();
+#endif
 
-    ret = SLN_AMP_Init(&s_streamerPoolCnt);
-#elif defined(SLN_LOCAL2_IOT)
     ret = SLN_AMP_Init(NULL);
-#endif
     if (ret != kStatus_Success)
     {
         PRINTF("SLN_AMP_Init failed!\r\n");
@@ -402,10 +379,9 @@ void appTask(void *arg)
     config.feedbackInit   = SLN_AMP_Read;
     config.feedbackBuffer = (int16_t *)SLN_AMP_GetLoopBackBuffer();
 #elif USE_MQS
-    config.loopbackRingBuffer = SLN_AMP_GetRingBuffer();
-    config.loopbackMutex      = SLN_AMP_GetLoopBackMutex();
-    config.updateTimestamp    = SLN_AMP_UpdateTimestamp;
-    config.getTimestamp       = SLN_AMP_GetTimestamp;
+    config.loopbackRing     = SLN_AMP_GetLoopbackRing();
+    config.getTimestamp     = SLN_AMP_GetTimestamp;
+    config.getLoopbackDelay = SLN_AMP_GetLoopbackDelayBytes;
 #endif
 
     pcm_to_pcm_set_config(&config);
@@ -772,37 +748,17 @@ void appTask(void *arg)
             RGB_LED_SetColor(LED_COLOR_CYAN);
         }
 
-        if (appAsrShellCommands.asrCfg & ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED)
-        {
-            announce_demo(appAsrShellCommands.demo);
-            appAsrShellCommands.asrCfg &= ~ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
-        }
-
-        // check the status of shell commands and flash file system
+        // Demo switched by the button, the settings cache cannot be used from its interrupt
         if (appAsrShellCommands.status == WRITE_READY)
         {
             appAsrShellCommands.status = WRITE_SUCCESS;
-            statusFlash = SLN_FLASH_MGMT_Save(ASR_SHELL_COMMANDS_FILE_NAME, (uint8_t *)&appAsrShellCommands,
-                                              sizeof(app_asr_shell_commands_t));
-            if ((statusFlash == SLN_FLASH_MGMT_EOVERFLOW) || (statusFlash == SLN_FLASH_MGMT_EOVERFLOW2))
-            {
-                statusFlash = SLN_FLASH_MGMT_Erase(ASR_SHELL_COMMANDS_FILE_NAME);
-                statusFlash = SLN_FLASH_MGMT_Save(ASR_SHELL_COMMANDS_FILE_NAME, (uint8_t *)&appAsrShellCommands,
-                                                  sizeof(app_asr_shell_commands_t));
-                if (statusFlash != SLN_FLASH_MGMT_OK)
-                {
-                    configPRINTF(("Failed to write in flash memory.\r\n"));
-                }
-            }
-            else if (statusFlash != SLN_FLASH_MGMT_OK)
-            {
-                configPRINTF(("Failed to write in flash memory.\r\n"));
-            }
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
+        }
 
-            if (statusFlash == SLN_FLASH_MGMT_OK)
-            {
-                configPRINTF(("Updated Shell command parameter in flash memory.\r\n"));
-            }
+        if (appAsrShellCommands.asrCfg & ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED)
+        {
+            announce_demo(appAsrShellCommands.demo);
+            appAsrShellCommands.asrCfg &= ~ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
         }
 
         taskNotification = 0;
@@ -830,7 +786,13 @@ void main(void)
     /* Setup Crypto HW */
     CRYPTO_InitHardware();
 
-    /* Set flash management callbacks */
+    /* Share the DCP between the file system and the OTA jobs */
+    if (SLN_DCP_QUEUE_Init() != kStatus_Success)
+    {
+        PRINTF("DCP queue init failed!\r\n");
+    }
+
+    /* Set flash management callbacks, used for the erases done before the flash writer runs */
     sln_flash_mgmt_cbs_t flash_mgmt_cbs = {pdm_to_pcm_mics_off, pdm_to_pcm_mics_on};
     SLN_FLASH_MGMT_SetCbs(&flash_mgmt_cbs);
 
@@ -840,6 +802,24 @@ void main(void)
     /* Initialize flash management */
     SLN_FLASH_MGMT_Init((sln_flash_entry_t *)g_fileTable, false);
 
+    /* Run the sector erases in the background, the microphones stay on while a setting is saved */
+    if (SLN_FLASH_WRITER_Init() != kStatus_Success)
+    {
+        PRINTF("Flash writer init failed!\r\n");
+    }
+
+    /* Finish a switch of the boot image cut by a reset, the bootloader then starts the image the FICA points at */
+    if (FWUpdate_recover_boot_image() > 0)
+    {
+        NVIC_SystemReset();
+    }
+
+    /* Save the settings changed by the shell once they stop changing */
+    if (SLN_SETTINGS_CACHE_Init() != SLN_FLASH_MGMT_OK)
+    {
+        PRINTF("Settings cache init failed!\r\n");
+    }
+
     /*
      * AUDIO PLL setting: Frequency = Fref * (DIV_SELECT + NUM / DENOM)
      *                              = 24 * (32 + 77/100)
@@ -876,6 +856,18 @@ void main(void)
 
     sln_shell_init();
 
+    /* ASR results are sent over UDP and printed by the event publisher */
+    if (!SLN_ASR_EVENTS_Init())
+    {
+        PRINTF("ASR event publisher init failed!\r\n");
+    }
+
+    /* Raw microphones, AFE output and amplifier reference streamed to a TCP client */
+    if (!SLN_AUDIO_TAP_Init())
+    {
+        PRINTF("Audio tap init failed!\r\n");
+    }
+
     TCP_OTA_Server_Start();
 
     xTaskCreate(appTask, "APP_Task", 512, NULL, configMAX_PRIORITIES - 4, &appTaskHandle);
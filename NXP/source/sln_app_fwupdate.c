@@ -7,14 +7,85 @@
  * applicable license terms, then you may not retain, install, activate or otherwise use the software.
  */
 
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
 #include "sln_app_fwupdate.h"
 #include "fsl_common.h"
+#include "sln_dcp_queue.h"
 #include "sln_flash.h"
 #include "sln_flash_config.h"
+#include "sln_flash_writer.h"
 #include "fica_definition.h"
-#include "cJSON.h"
+#include "sln_json.h"
+#if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
+#include "fsl_cache.h"
+#endif
+
+#define FWUPDATE_MESSAGETYPE_START  (2)
+#define FWUPDATE_MESSAGETYPE_STREAM (3)
+
+/* Tokens of a control message: the object and its key-value pairs */
+#define FWUPDATE_JSON_TOKENS (16)
+
+/* Fields of the stream command, see s_streamFields */
+#define STREAM_FIELD_SIZE      (1U << 0)
+#define STREAM_FIELD_SHA256    (1U << 1)
+#define STREAM_FIELD_SIGNATURE (1U << 2)
+#define STREAM_FIELDS_REQUIRED (STREAM_FIELD_SIZE | STREAM_FIELD_SHA256)
 
-#define FWUPDATE_MESSAGETYPE_START (2)
+/* Longest wait for the flash writer to free a stream buffer */
+#define FWUPDATE_STREAM_TIMEOUT_MS (10000U)
+
+/* The FICA table, in whole pages */
+#define FICA_TABLE_PAGES ((sizeof(fica_t) + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE)
+
+#if (FWUPDATE_FICA_COPY_ADDR + SECTOR_SIZE) > FICA_FREE_MEM_END_ADDR
+#error "No free sector for the copy of the FICA table"
+#endif
+
+/* Descriptor programmed over a table before its sector is erased, it only clears bits */
+#define FICA_DESC_DROPPED (0x00000000U)
+
+/*! @brief Image streamed into the application bank not running */
+typedef struct _fwupdate_stream
+{
+    bool active;                 /*!< active: An image is being streamed. */
+    fica_img_type_t imgType;     /*!< imgType: Bank the image is written to. */
+    uint32_t imgAddr;            /*!< imgAddr: Flash offset of the bank. */
+    uint32_t received;           /*!< received: Bytes of the image received. */
+    uint32_t queued;             /*!< queued: Bytes of the image given to the flash writer. */
+    uint32_t nextErase;          /*!< nextErase: Next sector of the bank to erase. */
+    uint32_t fill;               /*!< fill: Bytes in the buffer being filled. */
+    uint32_t bufIdx;             /*!< bufIdx: Buffer being filled. */
+    uint32_t owned;              /*!< owned: Buffers not lent to the flash writer. */
+    volatile status_t writeStat; /*!< writeStat: First error of the flash writer. */
+    TickType_t startTick;        /*!< startTick: Tick the stream started. */
+    fwupdate_stream_info_t info; /*!< info: The image announced. */
+} fwupdate_stream_t;
+
+static fwupdate_stream_t s_stream;
+
+static const sln_json_field_t s_streamFields[] = {
+    SLN_JSON_FIELD("size", kSLN_JSON_Uint32, fwupdate_stream_info_t, imageLen),
+    SLN_JSON_FIELD("sha256", kSLN_JSON_Hex, fwupdate_stream_info_t, sha256),
+    SLN_JSON_FIELD("signature", kSLN_JSON_Hex, fwupdate_stream_info_t, signature),
+};
+
+/* The flash writer programs one buffer while the other one is filled */
+static uint8_t s_streamBuf[2][FWUPDATE_STREAM_CHUNK_SIZE];
+static uint32_t s_streamBufAddr[2];
+static uint32_t s_streamBufLen[2];
+static SemaphoreHandle_t s_streamBufFree = NULL;
+static StaticSemaphore_t s_streamBufFreeCtrl;
+
+static dcp_hash_ctx_t s_streamHash;
+static uint8_t s_ficaTable[FICA_TABLE_PAGES * FLASH_PAGE_SIZE];
+static uint8_t s_ficaBackup[FICA_TABLE_PAGES * FLASH_PAGE_SIZE];
+static uint8_t s_ficaPage[FLASH_PAGE_SIZE];
 
 /*!
  * @brief Clear the bit from FICA header in order to indicate a fwupdate
@@ -66,44 +137,575 @@ int32_t FWUpdate_set_SLN_OTW(void)
     return FICA_clr_bits(FICA_COMM_FWUPDATE_BIT);
 }
 
+/*!
+ * @brief Split a control message into tokens and read its message type
+ */
+static fwupdate_check_status_t parse_command(uint8_t *buffer, sln_json_token_t *tokens, int32_t *count, int64_t *type)
+{
+    int32_t value = -1;
+
+    if (buffer == NULL)
+    {
+        return FWUPDATE_JSON_ERROR;
+    }
+
+    *count = SLN_JSON_Parse((const char *)buffer, strlen((const char *)buffer), tokens, FWUPDATE_JSON_TOKENS);
+    if (*count <= 0)
+    {
+        return FWUPDATE_JSON_ERROR;
+    }
+
+    /* Check if it contains messagetype JSON Object */
+    value = SLN_JSON_ObjectGet((const char *)buffer, tokens, *count, 0, "messageType");
+    if ((value < 0) || !SLN_JSON_GetInt((const char *)buffer, &tokens[value], type))
+    {
+        return FWUPDATE_JSON_ERROR;
+    }
+
+    return FWUPDATE_OK;
+}
+
 /*!
  * @brief Receive a buffer, check if the buffer received is an ota start command
  */
 fwupdate_check_status_t FWUpdate_check_start_command(uint8_t *buffer)
 {
     fwupdate_check_status_t status = FWUPDATE_OK;
-    cJSON *json                    = NULL;
-    cJSON *messageType             = NULL;
+    sln_json_token_t tokens[FWUPDATE_JSON_TOKENS];
+    int32_t count       = 0;
+    int64_t messageType = 0;
 
-    if (buffer == NULL)
+    status = parse_command(buffer, tokens, &count, &messageType);
+
+    /* Check if messagetype is the one used for start fwupdate command  */
+    if ((FWUPDATE_OK == status) && (messageType != FWUPDATE_MESSAGETYPE_START))
+    {
+        status = FWUPDATE_WRONG_MESSAGETYPE;
+    }
+
+    return status;
+}
+
+/*!
+ * @brief Receive a buffer, check if the buffer received is an ota stream command
+ */
+fwupdate_check_status_t FWUpdate_check_stream_command(uint8_t *buffer, fwupdate_stream_info_t *info)
+{
+    fwupdate_check_status_t status = FWUPDATE_OK;
+    sln_json_token_t tokens[FWUPDATE_JSON_TOKENS];
+    int32_t count       = 0;
+    int64_t messageType = 0;
+    uint32_t fields     = 0;
+
+    if (info == NULL)
     {
         return FWUPDATE_JSON_ERROR;
     }
-    json = cJSON_Parse((const char *)buffer);
-    if (!json)
+
+    status = parse_command(buffer, tokens, &count, &messageType);
+
+    if ((FWUPDATE_OK == status) && (messageType != FWUPDATE_MESSAGETYPE_STREAM))
     {
-        status = FWUPDATE_JSON_ERROR;
+        status = FWUPDATE_WRONG_MESSAGETYPE;
     }
+
     if (FWUPDATE_OK == status)
     {
-        /* Check if it contains messagetype JSON Object */
-        messageType = cJSON_GetObjectItemCaseSensitive(json, "messageType");
-        if (!cJSON_IsNumber(messageType))
+        fields = SLN_JSON_ReadObject((const char *)buffer, tokens, count, s_streamFields, ARRAY_SIZE(s_streamFields),
+                                     info);
+
+        /* Size and hash are required, the signature may be left to the bootloader */
+        if (((fields & STREAM_FIELDS_REQUIRED) != STREAM_FIELDS_REQUIRED) || (0 == info->imageLen))
         {
             status = FWUPDATE_JSON_ERROR;
         }
-        else
+
+        info->hasSignature = (0 != (fields & STREAM_FIELD_SIGNATURE));
+    }
+
+    return status;
+}
+
+/*!
+ * @brief The bank not running, found from the address of the reset handler
+ */
+static fica_img_type_t get_inactive_bank(void)
+{
+    uint32_t resetIsr = *(uint32_t *)(APPLICATION_RESET_ISR_ADDRESS);
+    uint32_t bankB    = SLN_Flash_Get_Read_Address(FICA_IMG_APP_B_ADDR);
+
+    return ((resetIsr >= bankB) && (resetIsr < (bankB + FICA_IMG_APP_B_SIZE))) ? FICA_IMG_TYPE_APP_A
+                                                                                : FICA_IMG_TYPE_APP_B;
+}
+
+/*!
+ * @brief Descriptor of the table at an address, FICA_ICA_DESC once the table is whole
+ */
+static uint32_t FICA_read_descriptor(uint32_t address)
+{
+    uint32_t descriptor = FICA_DESC_DROPPED;
+
+    SLN_Read_Flash_At_Address(address, (uint8_t *)&descriptor, sizeof(descriptor));
+
+    return descriptor;
+}
+
+/*!
+ * @brief Check that the pages of a table are erased
+ */
+static bool FICA_is_erased(uint32_t address)
+{
+    const uint8_t *table = (const uint8_t *)SLN_Flash_Get_Read_Address(address);
+
+    for (uint32_t idx = 0; idx < sizeof(s_ficaTable); idx++)
+    {
+        if (0xFF != table[idx])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Erase the sector of a table, through the flash writer
+ *        A whole table has its descriptor cleared first, so an erase cut by a reset never leaves a valid
+ *        descriptor over a partly erased table.
+ */
+static status_t FICA_erase_table(uint32_t address)
+{
+    uint32_t dropped = FICA_DESC_DROPPED;
+    status_t status  = kStatus_Success;
+
+    if (FICA_ICA_DESC == FICA_read_descriptor(address))
+    {
+        status = SLN_FLASH_WRITER_ProgramSync(address, (const uint8_t *)&dropped, sizeof(dropped));
+    }
+
+    if (kStatus_Success == status)
+    {
+        status = SLN_FLASH_WRITER_EraseSync(address);
+    }
+
+    return status;
+}
+
+/*!
+ * @brief Erase a sector and program a table in it, through the flash writer, then read it back
+ *        The pages are programmed with the descriptor left erased, then the descriptor alone, which only clears
+ *        bits as FICA_clr_bits does: a table cut by a reset has no valid descriptor.
+ */
+static status_t FICA_write_table(uint32_t address, const uint8_t *table)
+{
+    uint32_t descriptor = FICA_ICA_DESC;
+    status_t status     = FICA_erase_table(address);
+
+    memcpy(s_ficaPage, table, sizeof(s_ficaPage));
+    memset(s_ficaPage, 0xFF, sizeof(descriptor));
+
+    if (kStatus_Success == status)
+    {
+        status = SLN_FLASH_WRITER_ProgramSync(address, s_ficaPage, sizeof(s_ficaPage));
+    }
+
+    if (kStatus_Success == status)
+    {
+        status = SLN_FLASH_WRITER_ProgramSync(address + FLASH_PAGE_SIZE, &table[FLASH_PAGE_SIZE],
+                                              sizeof(s_ficaTable) - FLASH_PAGE_SIZE);
+    }
+
+    if (kStatus_Success == status)
+    {
+        status = SLN_FLASH_WRITER_ProgramSync(address, (const uint8_t *)&descriptor, sizeof(descriptor));
+    }
+
+    if ((kStatus_Success == status) &&
+        (0 != memcmp((const void *)SLN_Flash_Get_Read_Address(address), table, sizeof(s_ficaTable))))
+    {
+        status = kStatus_Fail;
+    }
+
+    return status;
+}
+
+/*!
+ * @brief Set the image of a bank as the one started by the bootloader
+ *        The bootloader reads the FICA at a fixed place, so the sector is erased and programmed again, through
+ *        the flash writer so an erase it has suspended is not disturbed. The new table is committed to the copy
+ *        sector first: a reset while the FICA sector has no whole table is finished from it at the next start,
+ *        see FWUpdate_recover_boot_image. The new table is read back; if it does not match, the previous table
+ *        is written back, and the boot bank is left unchanged.
+ */
+static int32_t FICA_set_boot_image(fica_img_type_t imgType, uint32_t imgAddr, const fwupdate_stream_info_t *info)
+{
+    fica_t *fica          = (fica_t *)s_ficaTable;
+    fica_record_t *record = &fica->records[imgType];
+    status_t status       = kStatus_Success;
+
+    SLN_Read_Flash_At_Address(FICA_START_ADDR, s_ficaBackup, sizeof(s_ficaBackup));
+    memcpy(s_ficaTable, s_ficaBackup, sizeof(s_ficaTable));
+
+    if (FICA_ICA_DESC != fica->header.descriptor)
+    {
+        /* FICA not initialized by the bootloader */
+        return -1;
+    }
+
+    record->descriptor = FICA_REC_START_ID;
+    record->imgType    = imgType;
+    record->imgAddr    = imgAddr;
+    record->imgLen     = info->imageLen;
+    record->imgFmt     = FICA_IMG_FMT_BIN;
+    if (info->hasSignature)
+    {
+        memcpy(record->imgPkiSig, info->signature, sizeof(record->imgPkiSig));
+    }
+
+    fica->header.currType = imgType;
+    fica->header.newType  = imgType;
+
+    status = FICA_write_table(FWUPDATE_FICA_COPY_ADDR, s_ficaTable);
+
+    if (kStatus_Success == status)
+    {
+        status = FICA_write_table(FICA_START_ADDR, s_ficaTable);
+
+        if (kStatus_Success != status)
         {
-            /* Check if messagetype is the one used for start fwupdate command  */
-            if (messageType->valueint != FWUPDATE_MESSAGETYPE_START)
+            configPRINTF(("[ERROR] FICA update failed, restoring the previous table\r\n"));
+
+            if (kStatus_Success != FICA_write_table(FICA_START_ADDR, s_ficaBackup))
             {
-                status = FWUPDATE_WRONG_MESSAGETYPE;
+                // The copy is kept, the next start writes the new table from it
+                configPRINTF(("[ERROR] FICA could not be restored\r\n"));
+                return -1;
             }
         }
     }
 
-    /* Free heap memory allocated with cJSON_Parse() */
-    cJSON_Delete(json);
+    // The FICA sector holds a whole table again, the copy is not needed anymore
+    if (kStatus_Success != FICA_erase_table(FWUPDATE_FICA_COPY_ADDR))
+    {
+        configPRINTF(("[WARNING] Copy of the FICA not erased\r\n"));
+    }
+
+    return (kStatus_Success == status) ? 0 : -1;
+}
+
+int32_t FWUpdate_recover_boot_image(void)
+{
+    int32_t ret = 0;
+
+    if (FICA_ICA_DESC == FICA_read_descriptor(FWUPDATE_FICA_COPY_ADDR))
+    {
+        // Read into RAM, the flash is not read from while it is programmed
+        SLN_Read_Flash_At_Address(FWUPDATE_FICA_COPY_ADDR, s_ficaTable, sizeof(s_ficaTable));
+        SLN_Read_Flash_At_Address(FICA_START_ADDR, s_ficaBackup, sizeof(s_ficaBackup));
+
+        if (0 != memcmp(s_ficaTable, s_ficaBackup, sizeof(s_ficaTable)))
+        {
+            configPRINTF(("Finishing the switch of the boot image cut by a reset\r\n"));
+
+            if (kStatus_Success != FICA_write_table(FICA_START_ADDR, s_ficaTable))
+            {
+                configPRINTF(("[ERROR] FICA could not be written from its copy\r\n"));
+                return -1;
+            }
+
+            ret = 1;
+        }
+    }
+
+    // A committed copy written to the FICA, or a copy cut by a reset, dropped
+    if (!FICA_is_erased(FWUPDATE_FICA_COPY_ADDR) && (kStatus_Success != FICA_erase_table(FWUPDATE_FICA_COPY_ADDR)))
+    {
+        return -1;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Flash writer callback of a sector erase
+ */
+static void stream_erase_done(status_t status, void *arg)
+{
+    if ((kStatus_Success != status) && (kStatus_Success == s_stream.writeStat))
+    {
+        s_stream.writeStat = status;
+    }
+}
+
+/*!
+ * @brief Flash writer callback of a buffer program; the buffer is read back and freed
+ */
+static void stream_program_done(status_t status, void *arg)
+{
+    uint32_t idx = (uint32_t)arg;
+
+    if ((kStatus_Success == status) &&
+        (0 != memcmp((const void *)SLN_Flash_Get_Read_Address(s_streamBufAddr[idx]), s_streamBuf[idx],
+                     s_streamBufLen[idx])))
+    {
+        status = kStatus_Fail;
+    }
+
+    stream_erase_done(status, NULL);
+
+    xSemaphoreGive(s_streamBufFree);
+}
+
+static bool stream_take_buffer(void)
+{
+    if (pdTRUE != xSemaphoreTake(s_streamBufFree, pdMS_TO_TICKS(FWUPDATE_STREAM_TIMEOUT_MS)))
+    {
+        return false;
+    }
+
+    s_stream.owned++;
+
+    return true;
+}
+
+/*!
+ * @brief Hash the buffer being filled and give it to the flash writer, then wait for the other one
+ */
+static fwupdate_stream_status_t stream_flush(void)
+{
+    uint32_t idx      = s_stream.bufIdx;
+    uint32_t addr     = s_stream.imgAddr + s_stream.queued;
+    uint32_t len      = s_stream.fill;
+    sln_dcp_job_t job = {.op = kSLN_DCP_HashUpdate, .hashCtx = &s_streamHash, .in = s_streamBuf[idx], .len = len};
+
+    if (0 == len)
+    {
+        return FWUPDATE_STREAM_OK;
+    }
+
+#if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
+    DCACHE_CleanByRange((uint32_t)s_streamBuf[idx], len);
+#endif
+    /* Hashed by the DCP while the flash writer programs the previous buffer */
+    if (kStatus_Success != SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job))
+    {
+        return FWUPDATE_STREAM_HASH_ERROR;
+    }
+
+    /* Sectors are erased as the image reaches them, the writer runs the requests in order */
+    while (s_stream.nextErase < (addr + len))
+    {
+        if (kStatus_Success != SLN_FLASH_WRITER_Erase(s_stream.nextErase, stream_erase_done, NULL))
+        {
+            return FWUPDATE_STREAM_FLASH_ERROR;
+        }
+
+        s_stream.nextErase += SECTOR_SIZE;
+    }
+
+    s_streamBufAddr[idx] = addr;
+    s_streamBufLen[idx]  = len;
+
+    if (kStatus_Success != SLN_FLASH_WRITER_Program(addr, s_streamBuf[idx], len, stream_program_done, (void *)idx))
+    {
+        return FWUPDATE_STREAM_FLASH_ERROR;
+    }
+
+    s_stream.owned--;
+    s_stream.queued += len;
+    s_stream.fill   = 0;
+    s_stream.bufIdx = idx ^ 1;
+
+    return stream_take_buffer() ? FWUPDATE_STREAM_OK : FWUPDATE_STREAM_FLASH_ERROR;
+}
+
+/*!
+ * @brief Wait for the buffers lent to the flash writer
+ */
+static bool stream_wait_idle(void)
+{
+    while (s_stream.owned < 2)
+    {
+        if (!stream_take_buffer())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * @brief End of the stream, the buffers are given back
+ */
+static void stream_release(void)
+{
+    while (s_stream.owned > 0)
+    {
+        xSemaphoreGive(s_streamBufFree);
+        s_stream.owned--;
+    }
+
+    s_stream.active = false;
+}
+
+fwupdate_stream_status_t FWUpdate_stream_start(const fwupdate_stream_info_t *info)
+{
+    uint32_t bankSize = 0;
+
+    if (s_stream.active)
+    {
+        return FWUPDATE_STREAM_BUSY;
+    }
+
+    if (NULL == s_streamBufFree)
+    {
+        s_streamBufFree = xSemaphoreCreateCountingStatic(2, 2, &s_streamBufFreeCtrl);
+    }
+
+    memset(&s_stream, 0, sizeof(s_stream));
+    s_stream.imgType = get_inactive_bank();
+    s_stream.imgAddr = (FICA_IMG_TYPE_APP_A == s_stream.imgType) ? FICA_IMG_APP_A_ADDR : FICA_IMG_APP_B_ADDR;
+    bankSize         = (FICA_IMG_TYPE_APP_A == s_stream.imgType) ? FICA_IMG_APP_A_SIZE : FICA_IMG_APP_B_SIZE;
+
+    if ((NULL == info) || (0 == info->imageLen) || (info->imageLen > bankSize))
+    {
+        return FWUPDATE_STREAM_INVALID;
+    }
+
+#if CHECK_APP_SIGN
+    /* The bootloader checks the signature of the image it starts */
+    if (!info->hasSignature)
+    {
+        return FWUPDATE_STREAM_INVALID;
+    }
+#endif
+
+    if (kStatus_Success != SLN_DCP_QUEUE_HashInit(kSLN_DCP_Client_Ota, &s_streamHash, kDCP_Sha256))
+    {
+        return FWUPDATE_STREAM_HASH_ERROR;
+    }
+
+    s_stream.info      = *info;
+    s_stream.nextErase = s_stream.imgAddr;
+    s_stream.writeStat = kStatus_Success;
+    s_stream.startTick = xTaskGetTickCount();
+
+    if (!stream_take_buffer())
+    {
+        return FWUPDATE_STREAM_FLASH_ERROR;
+    }
+
+    s_stream.active = true;
+
+    configPRINTF(("Streaming an image of %d bytes into bank %c\r\n", info->imageLen,
+                  (FICA_IMG_TYPE_APP_A == s_stream.imgType) ? 'A' : 'B'));
+
+    return FWUPDATE_STREAM_OK;
+}
+
+fwupdate_stream_status_t FWUpdate_stream_write(const uint8_t *data, uint32_t len)
+{
+    fwupdate_stream_status_t status = FWUPDATE_STREAM_OK;
+    uint32_t toCopy                 = 0;
+
+    if (!s_stream.active)
+    {
+        return FWUPDATE_STREAM_NOT_STARTED;
+    }
+
+    if (len > (s_stream.info.imageLen - s_stream.received))
+    {
+        return FWUPDATE_STREAM_INVALID;
+    }
+
+    if (kStatus_Success != s_stream.writeStat)
+    {
+        return FWUPDATE_STREAM_FLASH_ERROR;
+    }
+
+    while ((FWUPDATE_STREAM_OK == status) && (len > 0))
+    {
+        toCopy = MIN(len, FWUPDATE_STREAM_CHUNK_SIZE - s_stream.fill);
+        memcpy(&s_streamBuf[s_stream.bufIdx][s_stream.fill], data, toCopy);
+
+        s_stream.fill += toCopy;
+        s_stream.received += toCopy;
+        data += toCopy;
+        len -= toCopy;
+
+        if (FWUPDATE_STREAM_CHUNK_SIZE == s_stream.fill)
+        {
+            status = stream_flush();
+        }
+    }
+
+    return status;
+}
+
+fwupdate_stream_status_t FWUpdate_stream_finish(void)
+{
+    fwupdate_stream_status_t status             = FWUPDATE_STREAM_OK;
+    uint8_t digest[FWUPDATE_STREAM_SHA256_SIZE] = {0};
+    uint32_t elapsedMs                          = 0;
+    sln_dcp_job_t job = {.op = kSLN_DCP_HashFinish, .hashCtx = &s_streamHash, .out = digest, .len = sizeof(digest)};
+
+    if (!s_stream.active)
+    {
+        return FWUPDATE_STREAM_NOT_STARTED;
+    }
+
+    if (s_stream.received != s_stream.info.imageLen)
+    {
+        status = FWUPDATE_STREAM_INVALID;
+    }
+
+    if (FWUPDATE_STREAM_OK == status)
+    {
+        status = stream_flush();
+    }
+
+    if (!stream_wait_idle() || (kStatus_Success != s_stream.writeStat))
+    {
+        status = (FWUPDATE_STREAM_OK == status) ? FWUPDATE_STREAM_FLASH_ERROR : status;
+    }
+
+    if ((FWUPDATE_STREAM_OK == status) && (kStatus_Success != SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job)))
+    {
+        status = FWUPDATE_STREAM_HASH_ERROR;
+    }
+
+    if ((FWUPDATE_STREAM_OK == status) && (0 != memcmp(digest, s_stream.info.sha256, sizeof(digest))))
+    {
+        status = FWUPDATE_STREAM_HASH_ERROR;
+    }
+
+    if (FWUPDATE_STREAM_OK == status)
+    {
+        if (0 != FICA_set_boot_image(s_stream.imgType, s_stream.imgAddr, &s_stream.info))
+        {
+            status = FWUPDATE_STREAM_FICA_ERROR;
+        }
+    }
+
+    elapsedMs = (xTaskGetTickCount() - s_stream.startTick) * portTICK_PERIOD_MS;
+    configPRINTF(("Image of %d bytes streamed in %d ms, status %d\r\n", s_stream.received, elapsedMs, status));
+
+    stream_release();
 
     return status;
 }
+
+void FWUpdate_stream_abort(void)
+{
+    if (s_stream.active)
+    {
+        stream_wait_idle();
+        stream_release();
+    }
+}
+
+bool FWUpdate_stream_is_active(void)
+{
+    return s_stream.active;
+}
@@ -10,6 +10,7 @@
 #ifndef SLN_APP_FWUPDATE_H_
 #define SLN_APP_FWUPDATE_H_
 
+#include "stdbool.h"
 #include "stdint.h"
 
 /*******************************************************************************
@@ -23,6 +24,40 @@ typedef enum _fwupdate_check_status
     FWUPDATE_WRONG_MESSAGETYPE,
 } fwupdate_check_status_t;
 
+typedef enum _fwupdate_stream_status
+{
+    FWUPDATE_STREAM_OK = 0,
+    FWUPDATE_STREAM_BUSY,        /* An update is already streamed */
+    FWUPDATE_STREAM_NOT_STARTED, /* No update is streamed */
+    FWUPDATE_STREAM_INVALID,     /* Image size invalid or more data than announced */
+    FWUPDATE_STREAM_FLASH_ERROR, /* Erase, program or read back of the image failed */
+    FWUPDATE_STREAM_HASH_ERROR,  /* SHA-256 of the image does not match */
+    FWUPDATE_STREAM_FICA_ERROR,  /* The image could not be set as the one to boot */
+} fwupdate_stream_status_t;
+
+/*
+ * Sector holding the new FICA table while the FICA sector is rewritten, the free sector after the spare sector of
+ * the file system. A switch of the boot image cut by a reset is finished from it by FWUpdate_recover_boot_image.
+ */
+#ifndef FWUPDATE_FICA_COPY_ADDR
+#define FWUPDATE_FICA_COPY_ADDR (FICA_FREE_MEM_START_ADDR + SECTOR_SIZE)
+#endif
+
+/* Size of the buffers the image is streamed through, two of them alternate */
+#define FWUPDATE_STREAM_CHUNK_SIZE (4096U)
+
+#define FWUPDATE_STREAM_SHA256_SIZE    (32U)
+#define FWUPDATE_STREAM_SIGNATURE_SIZE (256U)
+
+/* Image announced by a stream command */
+typedef struct _fwupdate_stream_info
+{
+    uint32_t imageLen;                                 /* Size of the image in bytes */
+    uint8_t sha256[FWUPDATE_STREAM_SHA256_SIZE];       /* SHA-256 of the image */
+    uint8_t signature[FWUPDATE_STREAM_SIGNATURE_SIZE]; /* Signature checked by the bootloader */
+    bool hasSignature;                                 /* The command had a signature */
+} fwupdate_stream_info_t;
+
 /*******************************************************************************
  * Function Prototypes
  ******************************************************************************/
@@ -48,6 +83,57 @@ int32_t FWUpdate_set_SLN_OTW(void);
  */
 fwupdate_check_status_t FWUpdate_check_start_command(uint8_t *buffer);
 
+/*!
+ * @brief Receive a buffer, check if the buffer received is an ota stream command
+ *        {"messageType":3,"size":<bytes>,"sha256":"<hex>","signature":"<hex>"}
+ * @param buffer    Contains the message to be checked
+ * @param info      Filled with the image announced
+ * @return          fwupdate_check_status
+ */
+fwupdate_check_status_t FWUpdate_check_stream_command(uint8_t *buffer, fwupdate_stream_info_t *info);
+
+/*!
+ * @brief Start streaming an image into the application bank not running
+ *        The image is written by the flash writer while the application keeps running.
+ * @param info      The image announced by the stream command
+ * @return          fwupdate_stream_status
+ */
+fwupdate_stream_status_t FWUpdate_stream_start(const fwupdate_stream_info_t *info);
+
+/*!
+ * @brief Add data to the streamed image; blocks only while both stream buffers are being written
+ * @param data      Next bytes of the image
+ * @param len       Number of bytes
+ * @return          fwupdate_stream_status
+ */
+fwupdate_stream_status_t FWUpdate_stream_write(const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief End the streamed image: wait for the last writes, check its SHA-256 and set it as the one to boot
+ *        The update is done at the next reset.
+ * @return          fwupdate_stream_status
+ */
+fwupdate_stream_status_t FWUpdate_stream_finish(void);
+
+/*!
+ * @brief Drop the streamed image, the running application stays the one to boot
+ */
+void FWUpdate_stream_abort(void);
+
+/*!
+ * @brief Finish a switch of the boot image cut by a reset, to call once at start before any update
+ *        If the copy of the new FICA table was committed, the FICA sector is written from it; the copy is then
+ *        erased. The bootloader starts the image of the table at the next reset.
+ * @return          1 if the FICA was written, 0 if it was left as it was, -1 on a flash error
+ */
+int32_t FWUpdate_recover_boot_image(void);
+
+/*!
+ * @brief Check if an image is being streamed
+ * @return          true between FWUpdate_stream_start and its finish or abort
+ */
+bool FWUpdate_stream_is_active(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "fsl_debug_console.h"
+#include "lwip/api.h"
+
+#include "network_connection.h"
+#include "sln_asr_events.h"
+#include "sln_metrics.h"
+#include "sln_zerocopy.h"
+
+/*! @brief Datagram sent by the publisher */
+typedef struct _asr_events_packet
+{
+    sln_asr_events_header_t header;
+    sln_asr_event_t events[SLN_ASR_EVENTS_BATCH];
+} asr_events_packet_t;
+
+static QueueHandle_t s_eventQueue = NULL;
+static StaticQueue_t s_eventQueueCtrl;
+static uint8_t s_eventQueueStorage[SLN_ASR_EVENTS_QUEUE_LEN * sizeof(sln_asr_event_t)];
+
+static TaskHandle_t s_eventTask = NULL;
+static StaticTask_t s_eventTaskTcb;
+static StackType_t s_eventTaskStack[SLN_ASR_EVENTS_TASK_STACK];
+
+/* Datagram built in place, sent without a copy; taken until the driver released the previous one */
+SLN_ZEROCOPY_DEFINE_BUFFER(s_packetBuf, sizeof(asr_events_packet_t));
+static SemaphoreHandle_t s_packetFree = NULL;
+static StaticSemaphore_t s_packetFreeCtrl;
+static uint32_t s_seq = 0;
+
+static struct netconn *s_conn = NULL;
+static ip_addr_t s_destAddr   = SLN_ASR_EVENTS_GROUP;
+static uint16_t s_destPort    = SLN_ASR_EVENTS_PORT;
+
+SLN_METRICS_DEFINE_COUNTER(s_eventsPosted, "asr_events.posted");
+SLN_METRICS_DEFINE_COUNTER(s_eventsDropped, "asr_events.dropped");
+SLN_METRICS_DEFINE_COUNTER(s_eventsSendFailures, "asr_events.send_failures");
+SLN_METRICS_DEFINE_HISTOGRAM(s_eventsBatch, "asr_events.batch");
+
+static void print_event(const sln_asr_event_t *event)
+{
+#if SLN_ASR_EVENTS_CONSOLE
+    switch (event->type)
+    {
+        case kSLN_ASR_Event_SessionStarted:
+            configPRINTF(("2012\r\n"));
+            PRINTF("2012\r\n");
+            break;
+        case kSLN_ASR_Event_SessionEnded:
+            configPRINTF(("-10000\r\n"));
+            PRINTF("-10000\r\n");
+            break;
+        case kSLN_ASR_Event_SessionTimeout:
+            configPRINTF(("-777\r\n"));
+            PRINTF("-777\r\n");
+            break;
+        case kSLN_ASR_Event_WakeWord:
+            configPRINTF(("0\r\n"));
+            PRINTF("0\r\n");
+            break;
+        case kSLN_ASR_Event_Command:
+            configPRINTF(("%d\r\n", event->mapId));
+            PRINTF("%d \r\n", event->mapId);
+            break;
+        default:
+            break;
+    }
+#endif /* SLN_ASR_EVENTS_CONSOLE */
+}
+
+static void packet_released(void *arg)
+{
+    xSemaphoreGive(s_packetFree);
+}
+
+/* Send the events of the packet; they are dropped while the network is down */
+static void send_packet(asr_events_packet_t *packet, uint32_t count)
+{
+    uint32_t len  = sizeof(packet->header) + (count * sizeof(sln_asr_event_t));
+    err_t err     = ERR_OK;
+    uint16_t port = 0;
+    ip_addr_t addr;
+
+    packet->header.magic   = SLN_ASR_EVENTS_MAGIC;
+    packet->header.version = SLN_ASR_EVENTS_VERSION;
+    packet->header.count   = (uint8_t)count;
+    packet->header.seq     = s_seq;
+    packet->header.sendMs  = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    s_seq += count;
+
+    if (get_connect_state() && (NULL == s_conn))
+    {
+        s_conn = netconn_new(NETCONN_UDP);
+    }
+
+    if (!get_connect_state() || (NULL == s_conn))
+    {
+        xSemaphoreGive(s_packetFree);
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    ip_addr_copy(addr, s_destAddr);
+    port = s_destPort;
+    taskEXIT_CRITICAL();
+
+    /* The packet is released, sent or not, once the driver no longer holds it */
+    err = SLN_ZEROCOPY_SendTo(s_conn, &s_packetBuf.buf, (uint16_t)len, &addr, port, packet_released, NULL);
+    if (ERR_OK != err)
+    {
+        SLN_METRICS_Add(&s_eventsSendFailures, 1);
+    }
+}
+
+static void asr_events_task(void *arg)
+{
+    asr_events_packet_t *packet = SLN_ZEROCOPY_Payload(&s_packetBuf.buf);
+    uint32_t count              = 0;
+
+    while (1)
+    {
+        /* Written once the driver released the previous datagram */
+        xSemaphoreTake(s_packetFree, portMAX_DELAY);
+        xQueueReceive(s_eventQueue, &packet->events[0], portMAX_DELAY);
+        count = 1;
+
+        /* The events queued meanwhile go out in the same datagram */
+        while ((count < SLN_ASR_EVENTS_BATCH) && (pdTRUE == xQueueReceive(s_eventQueue, &packet->events[count], 0)))
+        {
+            count++;
+        }
+
+        SLN_METRICS_Observe(&s_eventsBatch, count);
+
+        /* Only read from now on, the driver may still hold it */
+        send_packet(packet, count);
+
+        for (uint32_t idx = 0; idx < count; idx++)
+        {
+            print_event(&packet->events[idx]);
+        }
+    }
+}
+
+bool SLN_ASR_EVENTS_Init(void)
+{
+    if (NULL != s_eventTask)
+    {
+        return true;
+    }
+
+    SLN_ZEROCOPY_Init();
+    SLN_METRICS_Register(&s_eventsPosted);
+    SLN_METRICS_Register(&s_eventsDropped);
+    SLN_METRICS_Register(&s_eventsSendFailures);
+    SLN_METRICS_Register(&s_eventsBatch);
+
+    s_packetFree = xSemaphoreCreateBinaryStatic(&s_packetFreeCtrl);
+    xSemaphoreGive(s_packetFree);
+
+    s_eventQueue = xQueueCreateStatic(SLN_ASR_EVENTS_QUEUE_LEN, sizeof(sln_asr_event_t), s_eventQueueStorage,
+                                      &s_eventQueueCtrl);
+    if (NULL == s_eventQueue)
+    {
+        return false;
+    }
+
+    s_eventTask = xTaskCreateStatic(asr_events_task, "ASR_Events_Task", SLN_ASR_EVENTS_TASK_STACK, NULL,
+                                    SLN_ASR_EVENTS_TASK_PRIORITY, s_eventTaskStack, &s_eventTaskTcb);
+
+    return (NULL != s_eventTask);
+}
+
+void SLN_ASR_EVENTS_SetDestination(const ip_addr_t *addr, uint16_t port)
+{
+    taskENTER_CRITICAL();
+    ip_addr_copy(s_destAddr, *addr);
+    s_destPort = port;
+    taskEXIT_CRITICAL();
+}
+
+void SLN_ASR_EVENTS_Post(sln_asr_event_t *event)
+{
+    event->reserved    = 0;
+    event->timestampMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    if (NULL == s_eventTask)
+    {
+        print_event(event);
+        return;
+    }
+
+    if (pdTRUE == xQueueSend(s_eventQueue, event, 0))
+    {
+        SLN_METRICS_Add(&s_eventsPosted, 1);
+    }
+    else
+    {
+        /* Only the datagram is lost, the UART consumers keep getting the codes */
+        SLN_METRICS_Add(&s_eventsDropped, 1);
+        print_event(event);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_ASR_EVENTS_H_
+#define _SLN_ASR_EVENTS_H_
+
+/*!
+ * SLN ASR Events
+ *
+ * Publisher of the ASR results. The ASR task posts events to a queue without waiting; the publisher
+ * task sends them in binary UDP datagrams to a multicast group or a unicast address, the events
+ * queued during a burst going out in one datagram, and prints them on the console.
+ *
+ * Datagram, little endian: sln_asr_events_header_t followed by count sln_asr_event_t.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lwip/ip_addr.h"
+
+/*! @brief Default destination of the events, a site-local multicast group */
+#ifndef SLN_ASR_EVENTS_GROUP
+#define SLN_ASR_EVENTS_GROUP IPADDR4_INIT_BYTES(239, 255, 0, 45)
+#endif
+#define SLN_ASR_EVENTS_PORT (8890)
+
+/*! @brief The events are also printed on the console, as the numeric codes of the ASR task */
+#ifndef SLN_ASR_EVENTS_CONSOLE
+#define SLN_ASR_EVENTS_CONSOLE (1)
+#endif
+
+#define SLN_ASR_EVENTS_QUEUE_LEN (16U)
+#define SLN_ASR_EVENTS_BATCH     (8U)
+
+#define SLN_ASR_EVENTS_MAGIC   (0x4541U) /* "AE" */
+#define SLN_ASR_EVENTS_VERSION (1U)
+
+#define SLN_ASR_EVENTS_TASK_STACK    (768U)
+#define SLN_ASR_EVENTS_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/*! @brief Type of an event */
+typedef enum _sln_asr_event_type
+{
+    kSLN_ASR_Event_SessionStarted = 0, /*!< Wake word detected or push-to-talk, commands are listened to */
+    kSLN_ASR_Event_SessionEnded,       /*!< Back to listening to the wake word */
+    kSLN_ASR_Event_SessionTimeout,     /*!< No command detected in time */
+    kSLN_ASR_Event_WakeWord,           /*!< Wake word, keywordId and scores set */
+    kSLN_ASR_Event_Command,            /*!< Command, keywordId, mapId and scores set */
+} sln_asr_event_type_t;
+
+/*! @brief Event, 16 bytes on the wire */
+typedef struct _sln_asr_event
+{
+    uint8_t type;         /*!< type: sln_asr_event_type_t. */
+    uint8_t language;     /*!< language: asr_language_t of the engine that detected it. */
+    int16_t keywordId;    /*!< keywordId: Keyword detected, -1 for the session events. */
+    int16_t mapId;        /*!< mapId: Command map ID, -1 if none. */
+    int16_t trustScore;   /*!< trustScore: Confidence of the detection. */
+    int16_t sgDiffScore;  /*!< sgDiffScore: Silence/Garbage difference of the detection. */
+    uint16_t reserved;    /*!< reserved: 0. */
+    uint32_t timestampMs; /*!< timestampMs: Time the event was posted, ms since boot. */
+} sln_asr_event_t;
+
+/*! @brief Header of a datagram, 12 bytes */
+typedef struct _sln_asr_events_header
+{
+    uint16_t magic;  /*!< magic: SLN_ASR_EVENTS_MAGIC. */
+    uint8_t version; /*!< version: SLN_ASR_EVENTS_VERSION. */
+    uint8_t count;   /*!< count: Events in the datagram. */
+    uint32_t seq;    /*!< seq: Sequence number of the first event, a gap means events were lost. */
+    uint32_t sendMs; /*!< sendMs: Time the datagram was sent, ms since boot. */
+} sln_asr_events_header_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Create the event queue and the publisher task, to be called before the scheduler starts
+ *
+ * @returns true if created
+ */
+bool SLN_ASR_EVENTS_Init(void);
+
+/*!
+ * @brief Send the events to another address, multicast or unicast
+ *
+ * @param addr Destination address
+ * @param port Destination port
+ */
+void SLN_ASR_EVENTS_SetDestination(const ip_addr_t *addr, uint16_t port);
+
+/*!
+ * @brief Post an event, never waits; printed by the caller if the publisher does not run or its queue is full,
+ *        the console still gets the event when the datagram is lost
+ *
+ * @param event The event, its timestamp is set
+ */
+void SLN_ASR_EVENTS_Post(sln_asr_event_t *event);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_ASR_EVENTS_H_ */
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "fsl_common.h"
+#include "lwip/api.h"
+
+#include "network_connection.h"
+#include "sln_audio_tap.h"
+#include "sln_metrics.h"
+
+#if PCM_FORMAT != BUFFER_PCM_LLRR
+#error "SLN Audio Tap expects the samples of each microphone one after the other"
+#endif
+
+#if (SLN_AUDIO_TAP_SLOTS & (SLN_AUDIO_TAP_SLOTS - 1)) != 0
+#error "SLN_AUDIO_TAP_SLOTS must be a power of two"
+#endif
+
+/* Time the client has to send the source mask */
+#define AUDIO_TAP_REQUEST_TIMEOUT_MS (2000)
+
+/* A client that does not take a block for that long is disconnected */
+#define AUDIO_TAP_SEND_TIMEOUT_MS (1000)
+
+/* The connection is checked at least that often, in case the audio stops */
+#define AUDIO_TAP_IDLE_MS (500)
+
+/*! @brief Block of the ring, the selected channels one after the other */
+typedef struct _audio_tap_block
+{
+    uint32_t seq;
+    uint32_t sources; /* Source mask the block was filled for */
+    int16_t samples[SLN_AUDIO_TAP_MAX_CHANNELS][PCM_SINGLE_CH_SMPL_COUNT];
+} audio_tap_block_t;
+
+/*! @brief Block as sent, the channels interleaved */
+typedef struct _audio_tap_frame
+{
+    uint32_t seq;
+    int16_t samples[PCM_SINGLE_CH_SMPL_COUNT * SLN_AUDIO_TAP_MAX_CHANNELS];
+} audio_tap_frame_t;
+
+/* Single producer (audio processing task) / single consumer (tap task) ring, head and tail free running */
+static audio_tap_block_t s_blocks[SLN_AUDIO_TAP_SLOTS];
+static volatile uint32_t s_head    = 0;
+static volatile uint32_t s_tail    = 0;
+static volatile uint32_t s_sources = 0;
+static uint32_t s_seq              = 0;
+
+/* Block being written by the audio processing task, NULL if not tapped */
+static audio_tap_block_t *s_writeBlock = NULL;
+
+static audio_tap_frame_t s_frame;
+
+static TaskHandle_t s_tapTask = NULL;
+static StaticTask_t s_tapTaskTcb;
+static StackType_t s_tapTaskStack[SLN_AUDIO_TAP_TASK_STACK];
+
+SLN_METRICS_DEFINE_COUNTER(s_tapClients, "audio_tap.clients");
+SLN_METRICS_DEFINE_COUNTER(s_tapBlocks, "audio_tap.blocks");
+SLN_METRICS_DEFINE_COUNTER(s_tapOverruns, "audio_tap.overruns");
+
+/* Read the source mask the client sends once connected */
+static bool read_request(struct netconn *client, uint32_t *sources)
+{
+    uint8_t request[sizeof(uint32_t)];
+    uint32_t received  = 0;
+    struct netbuf *buf = NULL;
+
+    netconn_set_recvtimeout(client, AUDIO_TAP_REQUEST_TIMEOUT_MS);
+
+    while (received < sizeof(request))
+    {
+        if (ERR_OK != netconn_recv(client, &buf))
+        {
+            return false;
+        }
+
+        received += netbuf_copy(buf, &request[received], sizeof(request) - received);
+        netbuf_delete(buf);
+    }
+
+    *sources = ((uint32_t)request[0] | ((uint32_t)request[1] << 8) | ((uint32_t)request[2] << 16) |
+                ((uint32_t)request[3] << 24)) &
+               SLN_AUDIO_TAP_SOURCE_ALL;
+
+    if (0 == *sources)
+    {
+        *sources = SLN_AUDIO_TAP_SOURCE_ALL;
+    }
+
+    return true;
+}
+
+/* Interleave and send the blocks of the ring, each slot freed once copied */
+static err_t send_blocks(struct netconn *client, uint32_t sources, uint32_t channels)
+{
+    err_t err = ERR_OK;
+
+    while ((ERR_OK == err) && (s_tail != s_head))
+    {
+        audio_tap_block_t *block = &s_blocks[s_tail % SLN_AUDIO_TAP_SLOTS];
+
+        /* The block is read only after seeing the head that published it */
+        __DMB();
+
+        /* Filled for the previous client while this one was connecting */
+        if (block->sources != sources)
+        {
+            s_tail = s_tail + 1;
+            continue;
+        }
+
+        s_frame.seq = block->seq;
+        for (uint32_t sample = 0; sample < PCM_SINGLE_CH_SMPL_COUNT; sample++)
+        {
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                s_frame.samples[(sample * channels) + channel] = block->samples[channel][sample];
+            }
+        }
+
+        __DMB();
+        s_tail = s_tail + 1;
+
+        err = netconn_write(client, &s_frame, sizeof(s_frame.seq) + (channels * sizeof(block->samples[0])),
+                            NETCONN_COPY);
+        if (ERR_OK == err)
+        {
+            SLN_METRICS_Add(&s_tapBlocks, 1);
+        }
+    }
+
+    return err;
+}
+
+static void serve_client(struct netconn *client)
+{
+    sln_audio_tap_header_t header;
+    uint32_t sources = 0;
+    err_t err        = ERR_OK;
+
+    if (!read_request(client, &sources))
+    {
+        return;
+    }
+
+    header.magic           = SLN_AUDIO_TAP_MAGIC;
+    header.version         = SLN_AUDIO_TAP_VERSION;
+    header.sampleRate      = PCM_SAMPLE_RATE_HZ;
+    header.channels        = (uint8_t)__builtin_popcount(sources);
+    header.bitsPerSample   = 16;
+    header.samplesPerBlock = PCM_SINGLE_CH_SMPL_COUNT;
+    header.sources         = sources;
+
+    netconn_set_sendtimeout(client, AUDIO_TAP_SEND_TIMEOUT_MS);
+
+    err = netconn_write(client, &header, sizeof(header), NETCONN_COPY);
+    if (ERR_OK != err)
+    {
+        return;
+    }
+
+    /* The blocks left by a previous client are dropped, send_blocks skips the one being filled */
+    s_tail = s_head;
+    __DMB();
+    s_sources = sources;
+
+    while (ERR_OK == err)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_TAP_IDLE_MS));
+
+        err = netconn_err(client);
+        if (ERR_OK == err)
+        {
+            err = send_blocks(client, sources, header.channels);
+        }
+    }
+
+    s_sources = 0;
+}
+
+static void audio_tap_task(void *arg)
+{
+    struct netconn *listener = NULL;
+    struct netconn *client   = NULL;
+
+    /* Wait for wifi/eth to connect */
+    while (0 == get_connect_state())
+    {
+        vTaskDelay(1000);
+    }
+
+    listener = netconn_new(NETCONN_TCP);
+    if ((NULL == listener) || (ERR_OK != netconn_bind(listener, IP_ADDR_ANY, SLN_AUDIO_TAP_PORT)) ||
+        (ERR_OK != netconn_listen(listener)))
+    {
+        configPRINTF(("[ERROR]Audio tap failed to listen\r\n"));
+        vTaskDelete(NULL);
+    }
+
+    while (1)
+    {
+        if (ERR_OK != netconn_accept(listener, &client))
+        {
+            vTaskDelay(pdMS_TO_TICKS(AUDIO_TAP_IDLE_MS));
+            continue;
+        }
+
+        SLN_METRICS_Add(&s_tapClients, 1);
+
+        serve_client(client);
+
+        netconn_close(client);
+        netconn_delete(client);
+    }
+}
+
+bool SLN_AUDIO_TAP_Init(void)
+{
+    if (NULL != s_tapTask)
+    {
+        return true;
+    }
+
+    SLN_METRICS_Register(&s_tapClients);
+    SLN_METRICS_Register(&s_tapBlocks);
+    SLN_METRICS_Register(&s_tapOverruns);
+
+    s_tapTask = xTaskCreateStatic(audio_tap_task, "Audio_Tap_Task", SLN_AUDIO_TAP_TASK_STACK, NULL,
+                                  SLN_AUDIO_TAP_TASK_PRIORITY, s_tapTaskStack, &s_tapTaskTcb);
+
+    return (NULL != s_tapTask);
+}
+
+void SLN_AUDIO_TAP_WriteInputs(const int16_t *mics, const int16_t *amp)
+{
+    uint32_t sources         = s_sources;
+    uint32_t head            = s_head;
+    uint32_t channel         = 0;
+    audio_tap_block_t *block = NULL;
+
+    s_writeBlock = NULL;
+
+    if (0 == sources)
+    {
+        return;
+    }
+
+    /* Counted even if dropped, the client sees the gap */
+    s_seq++;
+
+    if ((head - s_tail) >= SLN_AUDIO_TAP_SLOTS)
+    {
+        SLN_METRICS_Add(&s_tapOverruns, 1);
+        return;
+    }
+
+    block          = &s_blocks[head % SLN_AUDIO_TAP_SLOTS];
+    block->seq     = s_seq;
+    block->sources = sources;
+
+    for (uint32_t mic = 0; mic < PDM_MIC_COUNT; mic++)
+    {
+        if (sources & SLN_AUDIO_TAP_SOURCE_MIC(mic))
+        {
+            memcpy(block->samples[channel++], &mics[mic * PCM_SINGLE_CH_SMPL_COUNT], sizeof(block->samples[0]));
+        }
+    }
+
+    /* The AFE output goes between the microphones and the amplifier reference */
+    if (sources & SLN_AUDIO_TAP_SOURCE_AFE)
+    {
+        channel++;
+    }
+
+    if (sources & SLN_AUDIO_TAP_SOURCE_AMP)
+    {
+        memcpy(block->samples[channel], amp, sizeof(block->samples[0]));
+    }
+
+    s_writeBlock = block;
+}
+
+void SLN_AUDIO_TAP_WriteOutput(const int16_t *afe)
+{
+    audio_tap_block_t *block = s_writeBlock;
+    uint32_t channel         = 0;
+
+    if (NULL == block)
+    {
+        return;
+    }
+
+    s_writeBlock = NULL;
+
+    if (block->sources & SLN_AUDIO_TAP_SOURCE_AFE)
+    {
+        channel = __builtin_popcount(block->sources & (SLN_AUDIO_TAP_SOURCE_AFE - 1));
+        memcpy(block->samples[channel], afe, sizeof(block->samples[0]));
+    }
+
+    /* Publish the block once written */
+    __DMB();
+    s_head = s_head + 1;
+
+    xTaskNotifyGive(s_tapTask);
+}
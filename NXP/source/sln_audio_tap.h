@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_AUDIO_TAP_H_
+#define _SLN_AUDIO_TAP_H_
+
+/*!
+ * SLN Audio Tap
+ *
+ * Live capture of the audio the device processes: the raw microphones, the AFE output and the
+ * amplifier reference, 16 kHz 16 bit, streamed to one TCP client.
+ *
+ * The audio processing task copies the selected channels of each 10 ms block into a ring of slots
+ * and never waits: when the client does not keep up the block is dropped and counted. The tap task
+ * interleaves the blocks and sends them.
+ *
+ * Protocol, little endian: the client connects to SLN_AUDIO_TAP_PORT and sends the uint32_t mask of
+ * the sources it wants (0 for all); the device answers with sln_audio_tap_header_t, then sends
+ * each block as its uint32_t sequence number followed by the interleaved samples. A gap in the
+ * sequence numbers means blocks were dropped.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pdm_pcm_definitions.h"
+
+#define SLN_AUDIO_TAP_PORT (8891)
+
+/*! @brief Blocks of 10 ms buffered for the client */
+#ifndef SLN_AUDIO_TAP_SLOTS
+#define SLN_AUDIO_TAP_SLOTS (16U)
+#endif
+
+/*! @brief Sources, a channel each, sent in the order of their bits */
+#define SLN_AUDIO_TAP_SOURCE_MIC(n) (1U << (n))
+#define SLN_AUDIO_TAP_SOURCE_AFE    (1U << 4)
+#define SLN_AUDIO_TAP_SOURCE_AMP    (1U << 5)
+#define SLN_AUDIO_TAP_SOURCE_ALL \
+    (((1U << PDM_MIC_COUNT) - 1) | SLN_AUDIO_TAP_SOURCE_AFE | SLN_AUDIO_TAP_SOURCE_AMP)
+
+#define SLN_AUDIO_TAP_MAX_CHANNELS (PDM_MIC_COUNT + 2)
+
+#define SLN_AUDIO_TAP_MAGIC   (0x50415441U) /* "ATAP" */
+#define SLN_AUDIO_TAP_VERSION (1U)
+
+#define SLN_AUDIO_TAP_TASK_STACK    (768U)
+#define SLN_AUDIO_TAP_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/*! @brief Header of the stream, 16 bytes */
+typedef struct _sln_audio_tap_header
+{
+    uint32_t magic;           /*!< magic: SLN_AUDIO_TAP_MAGIC. */
+    uint16_t version;         /*!< version: SLN_AUDIO_TAP_VERSION. */
+    uint16_t sampleRate;      /*!< sampleRate: Samples per second of each channel. */
+    uint8_t channels;         /*!< channels: Channels interleaved in a block. */
+    uint8_t bitsPerSample;    /*!< bitsPerSample: 16, signed. */
+    uint16_t samplesPerBlock; /*!< samplesPerBlock: Samples of each channel in a block. */
+    uint32_t sources;         /*!< sources: Mask of the sources sent. */
+} sln_audio_tap_header_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Create the tap task, which waits for the network and serves one client at a time
+ *
+ * @returns true if created
+ */
+bool SLN_AUDIO_TAP_Init(void);
+
+/*!
+ * @brief Copy the AFE inputs of a block into the tap if a client is connected, never waits;
+ *        called by the audio processing task before the AFE, which may overwrite them
+ *
+ * @param mics Microphone samples, PCM_SINGLE_CH_SMPL_COUNT per microphone one after the other
+ * @param amp Amplifier reference, PCM_SINGLE_CH_SMPL_COUNT samples
+ */
+void SLN_AUDIO_TAP_WriteInputs(const int16_t *mics, const int16_t *amp);
+
+/*!
+ * @brief Copy the AFE output of the block and hand the block to the tap task
+ *
+ * @param afe AFE output, PCM_SINGLE_CH_SMPL_COUNT samples
+ */
+void SLN_AUDIO_TAP_WriteOutput(const int16_t *afe);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_AUDIO_TAP_H_ */
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "sln_cpu_crypto.h"
+
+#define AES128_ROUNDS (10U)
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32U - (n))))
+
+static const uint32_t s_sha256K[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+    0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+    0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+    0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+    0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+    0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+    0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL,
+};
+
+static const uint8_t s_aesSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9,
+    0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f,
+    0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, 0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07,
+    0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3,
+    0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58,
+    0xcf, 0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, 0x51, 0xa3,
+    0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec, 0x5f,
+    0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, 0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+    0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac,
+    0x62, 0x91, 0x95, 0xe4, 0x79, 0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a,
+    0xae, 0x08, 0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, 0x70,
+    0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11,
+    0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42,
+    0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t s_aesInvSbox[256] = {
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb, 0x7c, 0xe3, 0x39,
+    0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb, 0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2,
+    0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e, 0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76,
+    0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25, 0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc,
+    0x5d, 0x65, 0xb6, 0x92, 0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d,
+    0x84, 0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06, 0xd0, 0x2c,
+    0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b, 0x3a, 0x91, 0x11, 0x41, 0x4f,
+    0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73, 0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85,
+    0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e, 0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62,
+    0x0e, 0xaa, 0x18, 0xbe, 0x1b, 0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd,
+    0x5a, 0xf4, 0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f, 0x60,
+    0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef, 0xa0, 0xe0, 0x3b, 0x4d,
+    0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61, 0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6,
+    0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
+};
+
+static const uint8_t s_aesRcon[AES128_ROUNDS] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+static uint32_t load_be32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+}
+
+static void store_be32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+static void sha256_block(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[64];
+    uint32_t v[8];
+    uint32_t t1 = 0;
+    uint32_t t2 = 0;
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        w[i] = load_be32(&block[i * 4]);
+    }
+
+    for (uint32_t i = 16; i < 64; i++)
+    {
+        t1   = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        t2   = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        w[i] = t1 + w[i - 7] + t2 + w[i - 16];
+    }
+
+    memcpy(v, state, sizeof(v));
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        t1 = v[7] + (ROR32(v[4], 6) ^ ROR32(v[4], 11) ^ ROR32(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) +
+             s_sha256K[i] + w[i];
+        t2 = (ROR32(v[0], 2) ^ ROR32(v[0], 13) ^ ROR32(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = v[4];
+        v[4] = v[3] + t1;
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+        v[0] = t1 + t2;
+    }
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        state[i] += v[i];
+    }
+}
+
+void SLN_CPU_CRYPTO_Sha256Init(sln_cpu_sha256_t *ctx)
+{
+    static const uint32_t initState[8] = {0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+                                          0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL};
+
+    memcpy(ctx->state, initState, sizeof(ctx->state));
+    ctx->totalLen = 0;
+    ctx->blockLen = 0;
+}
+
+void SLN_CPU_CRYPTO_Sha256Update(sln_cpu_sha256_t *ctx, const uint8_t *in, size_t len)
+{
+    size_t chunk = 0;
+
+    ctx->totalLen += len;
+
+    while (len > 0)
+    {
+        chunk = MIN(len, SLN_CPU_SHA256_BLOCK_SIZE - ctx->blockLen);
+        memcpy(&ctx->block[ctx->blockLen], in, chunk);
+        ctx->blockLen += chunk;
+        in += chunk;
+        len -= chunk;
+
+        if (SLN_CPU_SHA256_BLOCK_SIZE == ctx->blockLen)
+        {
+            sha256_block(ctx->state, ctx->block);
+            ctx->blockLen = 0;
+        }
+    }
+}
+
+void SLN_CPU_CRYPTO_Sha256Finish(sln_cpu_sha256_t *ctx, uint8_t *digest)
+{
+    uint32_t bitLenHigh = ctx->totalLen >> 29;
+    uint32_t bitLenLow  = ctx->totalLen << 3;
+
+    // Padding: one bit, zeros up to the last 8 bytes of a block, then the length in bits
+    ctx->block[ctx->blockLen++] = 0x80;
+
+    if (ctx->blockLen > (SLN_CPU_SHA256_BLOCK_SIZE - 8U))
+    {
+        memset(&ctx->block[ctx->blockLen], 0, SLN_CPU_SHA256_BLOCK_SIZE - ctx->blockLen);
+        sha256_block(ctx->state, ctx->block);
+        ctx->blockLen = 0;
+    }
+
+    memset(&ctx->block[ctx->blockLen], 0, SLN_CPU_SHA256_BLOCK_SIZE - 8U - ctx->blockLen);
+    store_be32(&ctx->block[SLN_CPU_SHA256_BLOCK_SIZE - 8U], bitLenHigh);
+    store_be32(&ctx->block[SLN_CPU_SHA256_BLOCK_SIZE - 4U], bitLenLow);
+    sha256_block(ctx->state, ctx->block);
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        store_be32(&digest[i * 4], ctx->state[i]);
+    }
+}
+
+/* Multiplication by x in GF(2^8) */
+static uint8_t aes_xtime(uint8_t value)
+{
+    return (uint8_t)((value << 1) ^ ((value & 0x80U) ? 0x1bU : 0x00U));
+}
+
+static uint8_t aes_mul(uint8_t a, uint8_t b)
+{
+    uint8_t product = 0;
+
+    while (b)
+    {
+        if (b & 1U)
+        {
+            product ^= a;
+        }
+        a = aes_xtime(a);
+        b >>= 1;
+    }
+
+    return product;
+}
+
+static void aes128_expand_key(const uint8_t *key, uint8_t *roundKeys)
+{
+    uint8_t temp[4];
+
+    memcpy(roundKeys, key, SLN_CPU_AES128_KEY_SIZE);
+
+    for (uint32_t i = 4; i < 4U * (AES128_ROUNDS + 1U); i++)
+    {
+        memcpy(temp, &roundKeys[(i - 1U) * 4U], sizeof(temp));
+
+        if (0 == (i % 4U))
+        {
+            uint8_t first = temp[0];
+
+            temp[0] = (uint8_t)(s_aesSbox[temp[1]] ^ s_aesRcon[(i / 4U) - 1U]);
+            temp[1] = s_aesSbox[temp[2]];
+            temp[2] = s_aesSbox[temp[3]];
+            temp[3] = s_aesSbox[first];
+        }
+
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            roundKeys[i * 4U + j] = roundKeys[(i - 4U) * 4U + j] ^ temp[j];
+        }
+    }
+}
+
+static void aes_add_round_key(uint8_t *state, const uint8_t *roundKey)
+{
+    for (uint32_t i = 0; i < SLN_CPU_AES_BLOCK_SIZE; i++)
+    {
+        state[i] ^= roundKey[i];
+    }
+}
+
+/* SubBytes and ShiftRows of the cipher, or their inverses; the state is in columns of 4 bytes */
+static void aes_sub_shift(uint8_t *state, bool inverse)
+{
+    uint8_t temp[SLN_CPU_AES_BLOCK_SIZE];
+    uint32_t from = 0;
+
+    for (uint32_t col = 0; col < 4; col++)
+    {
+        for (uint32_t row = 0; row < 4; row++)
+        {
+            from = inverse ? ((col + 4U - row) % 4U) : ((col + row) % 4U);
+
+            temp[col * 4U + row] = inverse ? s_aesInvSbox[state[from * 4U + row]] : s_aesSbox[state[from * 4U + row]];
+        }
+    }
+
+    memcpy(state, temp, sizeof(temp));
+}
+
+static void aes_mix_columns(uint8_t *state, bool inverse)
+{
+    // Coefficients of the first row of the matrix, the other rows are its rotations
+    static const uint8_t mix[4]    = {0x02, 0x03, 0x01, 0x01};
+    static const uint8_t invMix[4] = {0x0e, 0x0b, 0x0d, 0x09};
+    const uint8_t *coef            = inverse ? invMix : mix;
+    uint8_t col[4];
+
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        memcpy(col, &state[c * 4U], sizeof(col));
+
+        for (uint32_t row = 0; row < 4; row++)
+        {
+            state[c * 4U + row] = aes_mul(col[0], coef[(4U - row) % 4U]) ^ aes_mul(col[1], coef[(5U - row) % 4U]) ^
+                                  aes_mul(col[2], coef[(6U - row) % 4U]) ^ aes_mul(col[3], coef[(7U - row) % 4U]);
+        }
+    }
+}
+
+static void aes128_encrypt_block(const uint8_t *roundKeys, uint8_t *state)
+{
+    aes_add_round_key(state, roundKeys);
+
+    for (uint32_t round = 1; round <= AES128_ROUNDS; round++)
+    {
+        aes_sub_shift(state, false);
+        if (round < AES128_ROUNDS)
+        {
+            aes_mix_columns(state, false);
+        }
+        aes_add_round_key(state, &roundKeys[round * SLN_CPU_AES_BLOCK_SIZE]);
+    }
+}
+
+static void aes128_decrypt_block(const uint8_t *roundKeys, uint8_t *state)
+{
+    aes_add_round_key(state, &roundKeys[AES128_ROUNDS * SLN_CPU_AES_BLOCK_SIZE]);
+
+    for (uint32_t round = AES128_ROUNDS; round > 0; round--)
+    {
+        aes_sub_shift(state, true);
+        aes_add_round_key(state, &roundKeys[(round - 1U) * SLN_CPU_AES_BLOCK_SIZE]);
+        if (round > 1)
+        {
+            aes_mix_columns(state, true);
+        }
+    }
+}
+
+status_t SLN_CPU_CRYPTO_AesCbc(
+    const uint8_t *key, const uint8_t *iv, const uint8_t *in, uint8_t *out, size_t len, bool encrypt)
+{
+    uint8_t roundKeys[SLN_CPU_AES_BLOCK_SIZE * (AES128_ROUNDS + 1U)];
+    uint8_t chain[SLN_CPU_AES_BLOCK_SIZE];
+    uint8_t block[SLN_CPU_AES_BLOCK_SIZE];
+
+    if (len % SLN_CPU_AES_BLOCK_SIZE)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    aes128_expand_key(key, roundKeys);
+    memcpy(chain, iv, sizeof(chain));
+
+    for (size_t offset = 0; offset < len; offset += SLN_CPU_AES_BLOCK_SIZE)
+    {
+        // Read the whole input block first, out may be in
+        memcpy(block, &in[offset], sizeof(block));
+
+        if (encrypt)
+        {
+            aes_add_round_key(block, chain);
+            aes128_encrypt_block(roundKeys, block);
+            memcpy(chain, block, sizeof(chain));
+            memcpy(&out[offset], block, sizeof(block));
+        }
+        else
+        {
+            uint8_t cipher[SLN_CPU_AES_BLOCK_SIZE];
+
+            memcpy(cipher, block, sizeof(cipher));
+            aes128_decrypt_block(roundKeys, block);
+            aes_add_round_key(block, chain);
+            memcpy(chain, cipher, sizeof(chain));
+            memcpy(&out[offset], block, sizeof(block));
+        }
+    }
+
+    // The expanded key is secret
+    memset(roundKeys, 0, sizeof(roundKeys));
+
+    return kStatus_Success;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_CPU_CRYPTO_H_
+#define _SLN_CPU_CRYPTO_H_
+
+/*!
+ * SLN CPU Crypto
+ *
+ * SHA-256 and AES-128-CBC computed by the CPU, used by the DCP queue when the DCP fails a job.
+ * The mbedTLS AES and SHA-256 of the application are DCP ports, so they can not take over.
+ * Small code over speed: the AES works from the S-boxes, without the 4 KB of round tables.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "fsl_common.h"
+
+#define SLN_CPU_SHA256_DIGEST_SIZE (32U)
+#define SLN_CPU_SHA256_BLOCK_SIZE  (64U)
+#define SLN_CPU_AES_BLOCK_SIZE     (16U)
+#define SLN_CPU_AES128_KEY_SIZE    (16U)
+
+/*! @brief Running SHA-256 */
+typedef struct _sln_cpu_sha256
+{
+    uint32_t state[8];                        /*!< state: Hash of the blocks done. */
+    uint32_t totalLen;                        /*!< totalLen: Number of bytes hashed. */
+    uint32_t blockLen;                        /*!< blockLen: Number of bytes waiting in block. */
+    uint8_t block[SLN_CPU_SHA256_BLOCK_SIZE]; /*!< block: Partial block. */
+} sln_cpu_sha256_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Start a SHA-256
+ *
+ * @param ctx Hash to start
+ */
+void SLN_CPU_CRYPTO_Sha256Init(sln_cpu_sha256_t *ctx);
+
+/*!
+ * @brief Add data to a SHA-256
+ *
+ * @param ctx Hash started by SLN_CPU_CRYPTO_Sha256Init
+ * @param in Data to add
+ * @param len Length of in
+ */
+void SLN_CPU_CRYPTO_Sha256Update(sln_cpu_sha256_t *ctx, const uint8_t *in, size_t len);
+
+/*!
+ * @brief End a SHA-256
+ *
+ * @param ctx Hash to end
+ * @param digest Buffer of SLN_CPU_SHA256_DIGEST_SIZE bytes receiving the digest
+ */
+void SLN_CPU_CRYPTO_Sha256Finish(sln_cpu_sha256_t *ctx, uint8_t *digest);
+
+/*!
+ * @brief Encrypt or decrypt with AES-128-CBC; in and out can be the same buffer
+ *
+ * @param key Key of SLN_CPU_AES128_KEY_SIZE bytes
+ * @param iv IV of SLN_CPU_AES_BLOCK_SIZE bytes
+ * @param in Input buffer
+ * @param out Output buffer
+ * @param len Length of in, multiple of SLN_CPU_AES_BLOCK_SIZE
+ * @param encrypt true to encrypt, false to decrypt
+ *
+ * @returns kStatus_Success or kStatus_InvalidArgument if len is not a multiple of the block size
+ */
+status_t SLN_CPU_CRYPTO_AesCbc(
+    const uint8_t *key, const uint8_t *iv, const uint8_t *in, uint8_t *out, size_t len, bool encrypt);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_CPU_CRYPTO_H_ */
@@ -0,0 +1,475 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "sln_cpu_crypto.h"
+#include "sln_dcp_queue.h"
+
+/* CRC-32/MPEG-2, as computed by the DCP */
+#define CRC32_POLYNOMIAL (0x04C11DB7UL)
+#define CRC32_INIT       (0xFFFFFFFFUL)
+
+/* Last word of a hash context, past the state of the DCP driver; marks a hash run by the CPU */
+#define HASH_CTX_MARKER_WORD (DCP_HASH_CTX_SIZE - 1U)
+#define HASH_CTX_CPU_MARKER  (0x43505548UL)
+
+_Static_assert(sizeof(sln_cpu_sha256_t) <= (HASH_CTX_MARKER_WORD * sizeof(uint32_t)),
+               "CPU hash state does not fit in dcp_hash_ctx_t");
+
+/*! @brief Job of the current round, with the DCP resources it runs on */
+typedef struct _dcp_round_job
+{
+    sln_dcp_job_t job;
+    sln_dcp_client_t client;
+    status_t status;
+    dcp_handle_t handle;      /* Copy of the key handle, on the channel of the client */
+    dcp_work_packet_t packet; /* Packet of a non blocking AES job */
+    bool onCpu;               /* AES job done by the CPU, nothing to wait for */
+} dcp_round_job_t;
+
+static const dcp_channel_t s_clientChannel[kSLN_DCP_Client_Count] = {kDCP_Channel1, kDCP_Channel2};
+
+/* Handles of the hash jobs, no key; never written, HashInit runs in the client tasks while the queue task hashes */
+static dcp_handle_t s_clientHandle[kSLN_DCP_Client_Count] = {
+    {.channel = kDCP_Channel1, .keySlot = kDCP_KeySlot0, .swapConfig = kDCP_NoSwap},
+    {.channel = kDCP_Channel2, .keySlot = kDCP_KeySlot0, .swapConfig = kDCP_NoSwap},
+};
+
+/* Set once the DCP failed a hash, the hashes started afterwards run on the CPU */
+static volatile bool s_hashOnCpu = false;
+
+static TaskHandle_t s_queueTask = NULL;
+static StaticTask_t s_queueTaskTcb;
+static StackType_t s_queueTaskStack[SLN_DCP_QUEUE_TASK_STACK];
+
+static QueueHandle_t s_clientQueue[kSLN_DCP_Client_Count];
+static StaticQueue_t s_clientQueueCtrl[kSLN_DCP_Client_Count];
+static uint8_t s_clientQueueStorage[kSLN_DCP_Client_Count][SLN_DCP_QUEUE_LEN * sizeof(sln_dcp_job_t)];
+
+/* One count per job queued by any client */
+static SemaphoreHandle_t s_jobsPending = NULL;
+static StaticSemaphore_t s_jobsPendingCtrl;
+
+/* One synchronous job per client at a time, its result handed back through s_syncStatus */
+static SemaphoreHandle_t s_syncLock[kSLN_DCP_Client_Count];
+static StaticSemaphore_t s_syncLockCtrl[kSLN_DCP_Client_Count];
+static SemaphoreHandle_t s_syncDone[kSLN_DCP_Client_Count];
+static StaticSemaphore_t s_syncDoneCtrl[kSLN_DCP_Client_Count];
+static status_t s_syncStatus[kSLN_DCP_Client_Count];
+
+static dcp_round_job_t s_round[kSLN_DCP_Client_Count];
+static uint32_t s_firstClient = 0;
+
+static sln_dcp_queue_stats_t s_queueStats = {0};
+
+static uint32_t crc_32_sw(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = CRC32_INIT;
+
+    while (len--)
+    {
+        crc ^= (uint32_t)(*data++) << 24;
+
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000UL) ? ((crc << 1) ^ CRC32_POLYNOMIAL) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static bool is_aes_job(const sln_dcp_job_t *job)
+{
+    return (kSLN_DCP_AesCbcEncrypt == job->op) || (kSLN_DCP_AesCbcDecrypt == job->op);
+}
+
+static bool is_cpu_hash(const dcp_hash_ctx_t *hashCtx)
+{
+    return HASH_CTX_CPU_MARKER == hashCtx->x[HASH_CTX_MARKER_WORD];
+}
+
+static sln_cpu_sha256_t *cpu_hash_of(dcp_hash_ctx_t *hashCtx)
+{
+    return (sln_cpu_sha256_t *)hashCtx->x;
+}
+
+/* Run an AES job on the CPU; the keys of the OTP can not be read, only a key of the context can be used */
+static status_t run_aes_job_sw(dcp_round_job_t *roundJob)
+{
+    sln_dcp_job_t *job = &roundJob->job;
+    const uint8_t *iv  = (NULL != job->iv) ? job->iv : job->ctx->iv;
+
+    if ((kDCP_OtpKey == job->ctx->handle.keySlot) || (kDCP_OtpUniqueKey == job->ctx->handle.keySlot) ||
+        (SLN_CPU_AES128_KEY_SIZE != job->ctx->keySize))
+    {
+        return kStatus_Fail;
+    }
+
+    roundJob->onCpu = true;
+    s_queueStats.swFallbacks++;
+
+    return SLN_CPU_CRYPTO_AesCbc(job->ctx->key, iv, job->in, job->out, job->len, kSLN_DCP_AesCbcEncrypt == job->op);
+}
+
+/* Start an AES job without waiting for its end */
+static status_t start_aes_job(dcp_round_job_t *roundJob)
+{
+    sln_dcp_job_t *job = &roundJob->job;
+    const uint8_t *iv  = NULL;
+    status_t status    = kStatus_Fail;
+
+    roundJob->onCpu = false;
+
+    if ((NULL == job->ctx) || (job->len % DCP_AES_BLOCK_SIZE))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (SLN_ENCRYPT_STATUS_OK == SLN_Encrypt_Load_Key(job->ctx))
+    {
+        roundJob->handle         = job->ctx->handle;
+        roundJob->handle.channel = s_clientChannel[roundJob->client];
+        iv                       = (NULL != job->iv) ? job->iv : job->ctx->iv;
+
+        if (kSLN_DCP_AesCbcEncrypt == job->op)
+        {
+            status = DCP_AES_EncryptCbcNonBlocking(DCP, &roundJob->handle, &roundJob->packet, job->in, job->out,
+                                                   job->len, iv);
+        }
+        else
+        {
+            status = DCP_AES_DecryptCbcNonBlocking(DCP, &roundJob->handle, &roundJob->packet, job->in, job->out,
+                                                   job->len, iv);
+        }
+    }
+
+    // Not started, the buffers are untouched
+    if (kStatus_Success != status)
+    {
+        status = run_aes_job_sw(roundJob);
+    }
+
+    return status;
+}
+
+/* Wait for the end of an AES job, redone by the CPU if the DCP failed it and did not overwrite its input */
+static status_t wait_aes_job(dcp_round_job_t *roundJob)
+{
+    status_t status = kStatus_Success;
+
+    if (!roundJob->onCpu)
+    {
+        status = DCP_WaitForChannelComplete(DCP, &roundJob->handle);
+
+        if ((kStatus_Success != status) && (roundJob->job.in != roundJob->job.out))
+        {
+            status = run_aes_job_sw(roundJob);
+        }
+    }
+
+    return status;
+}
+
+/* Run a CRC or hash job up to its end */
+static status_t run_hash_job(dcp_round_job_t *roundJob)
+{
+    sln_dcp_job_t *job = &roundJob->job;
+    status_t status    = kStatus_Success;
+    size_t outSize     = 0;
+
+    switch (job->op)
+    {
+        case kSLN_DCP_Crc32:
+            outSize = sizeof(uint32_t);
+            status  = DCP_HASH(DCP, &s_clientHandle[roundJob->client], kDCP_Crc32, job->in, job->len,
+                              (uint8_t *)job->crc, &outSize);
+
+            if (kStatus_Success != status)
+            {
+                *job->crc = crc_32_sw(job->in, job->len);
+                s_queueStats.swFallbacks++;
+                status = kStatus_Success;
+            }
+            break;
+
+        case kSLN_DCP_HashUpdate:
+            if (is_cpu_hash(job->hashCtx))
+            {
+                SLN_CPU_CRYPTO_Sha256Update(cpu_hash_of(job->hashCtx), job->in, job->len);
+                s_queueStats.swFallbacks++;
+            }
+            else
+            {
+                status = DCP_HASH_Update(DCP, job->hashCtx, job->in, job->len);
+            }
+            break;
+
+        case kSLN_DCP_HashFinish:
+            if (is_cpu_hash(job->hashCtx))
+            {
+                if (job->len < SLN_CPU_SHA256_DIGEST_SIZE)
+                {
+                    status = kStatus_InvalidArgument;
+                    break;
+                }
+
+                SLN_CPU_CRYPTO_Sha256Finish(cpu_hash_of(job->hashCtx), job->out);
+                s_queueStats.swFallbacks++;
+            }
+            else
+            {
+                outSize = job->len;
+                status  = DCP_HASH_Finish(DCP, job->hashCtx, job->out, &outSize);
+            }
+            break;
+
+        default:
+            status = kStatus_InvalidArgument;
+            break;
+    }
+
+    // The state of the DCP hash can not be carried to the CPU: this stream fails, the next ones run on the CPU
+    if ((kSLN_DCP_Crc32 != job->op) && (kStatus_Success != status) && (kStatus_InvalidArgument != status) &&
+        !is_cpu_hash(job->hashCtx))
+    {
+        s_hashOnCpu = true;
+    }
+
+    return status;
+}
+
+/* Run the jobs of a round: the AES jobs are started first and run while the hash jobs are done */
+static void run_round(uint32_t jobCount)
+{
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        if (is_aes_job(&s_round[i].job))
+        {
+            s_round[i].status = start_aes_job(&s_round[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        if (!is_aes_job(&s_round[i].job))
+        {
+            s_round[i].status = run_hash_job(&s_round[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < jobCount; i++)
+    {
+        if (is_aes_job(&s_round[i].job) && (kStatus_Success == s_round[i].status))
+        {
+            s_round[i].status = wait_aes_job(&s_round[i]);
+        }
+    }
+}
+
+static void queue_task(void *arg)
+{
+    uint32_t jobCount = 0;
+    uint32_t client   = 0;
+
+    while (1)
+    {
+        xSemaphoreTake(s_jobsPending, portMAX_DELAY);
+
+        // At most one job per client, the first client served changes each round
+        jobCount = 0;
+        for (uint32_t i = 0; i < kSLN_DCP_Client_Count; i++)
+        {
+            client = (s_firstClient + i) % kSLN_DCP_Client_Count;
+
+            if (pdTRUE == xQueueReceive(s_clientQueue[client], &s_round[jobCount].job, 0))
+            {
+                s_round[jobCount].client = (sln_dcp_client_t)client;
+                jobCount++;
+            }
+        }
+        s_firstClient = (s_firstClient + 1) % kSLN_DCP_Client_Count;
+
+        // One count was taken above for the whole round
+        for (uint32_t i = 1; i < jobCount; i++)
+        {
+            xSemaphoreTake(s_jobsPending, 0);
+        }
+
+        if (jobCount > s_queueStats.maxRoundJobs)
+        {
+            s_queueStats.maxRoundJobs = jobCount;
+        }
+
+        run_round(jobCount);
+
+        for (uint32_t i = 0; i < jobCount; i++)
+        {
+            s_queueStats.jobs[s_round[i].client]++;
+            if (kStatus_Success != s_round[i].status)
+            {
+                s_queueStats.failures++;
+                configPRINTF(("[WARNING] DCP job %d failed, status %d\r\n", s_round[i].job.op, s_round[i].status));
+            }
+
+            if (NULL != s_round[i].job.cb)
+            {
+                s_round[i].job.cb(s_round[i].status, s_round[i].job.arg);
+            }
+        }
+    }
+}
+
+static void queue_sync_done(status_t status, void *arg)
+{
+    sln_dcp_client_t client = (sln_dcp_client_t)(uintptr_t)arg;
+
+    s_syncStatus[client] = status;
+    xSemaphoreGive(s_syncDone[client]);
+}
+
+status_t SLN_DCP_QUEUE_Init(void)
+{
+    if (NULL != s_queueTask)
+    {
+        return kStatus_Success;
+    }
+
+    s_jobsPending = xSemaphoreCreateCountingStatic(kSLN_DCP_Client_Count * SLN_DCP_QUEUE_LEN, 0, &s_jobsPendingCtrl);
+
+    if (NULL == s_jobsPending)
+    {
+        return kStatus_Fail;
+    }
+
+    for (uint32_t client = 0; client < kSLN_DCP_Client_Count; client++)
+    {
+        s_clientQueue[client] = xQueueCreateStatic(SLN_DCP_QUEUE_LEN, sizeof(sln_dcp_job_t),
+                                                   s_clientQueueStorage[client], &s_clientQueueCtrl[client]);
+        s_syncLock[client]    = xSemaphoreCreateMutexStatic(&s_syncLockCtrl[client]);
+        s_syncDone[client]    = xSemaphoreCreateBinaryStatic(&s_syncDoneCtrl[client]);
+
+        if ((NULL == s_clientQueue[client]) || (NULL == s_syncLock[client]) || (NULL == s_syncDone[client]))
+        {
+            return kStatus_Fail;
+        }
+    }
+
+    s_queueTask = xTaskCreateStatic(queue_task, "DCP_Queue_Task", SLN_DCP_QUEUE_TASK_STACK, NULL,
+                                    SLN_DCP_QUEUE_TASK_PRIORITY, s_queueTaskStack, &s_queueTaskTcb);
+
+    return (NULL != s_queueTask) ? kStatus_Success : kStatus_Fail;
+}
+
+bool SLN_DCP_QUEUE_IsRunning(void)
+{
+    return (NULL != s_queueTask) && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+}
+
+status_t SLN_DCP_QUEUE_HashInit(sln_dcp_client_t client, dcp_hash_ctx_t *hashCtx, dcp_hash_algo_t algo)
+{
+    status_t status = kStatus_Fail;
+
+    if ((client >= kSLN_DCP_Client_Count) || (NULL == hashCtx))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    // Clears the marker word, the DCP driver does not write it
+    memset(hashCtx, 0, sizeof(dcp_hash_ctx_t));
+
+    if (!s_hashOnCpu)
+    {
+        status = DCP_HASH_Init(DCP, &s_clientHandle[client], hashCtx, algo);
+    }
+
+    if ((kStatus_Success != status) && (kDCP_Sha256 == algo))
+    {
+        SLN_CPU_CRYPTO_Sha256Init(cpu_hash_of(hashCtx));
+        hashCtx->x[HASH_CTX_MARKER_WORD] = HASH_CTX_CPU_MARKER;
+        status                           = kStatus_Success;
+    }
+
+    return status;
+}
+
+status_t SLN_DCP_QUEUE_Submit(sln_dcp_client_t client, const sln_dcp_job_t *job)
+{
+    if ((client >= kSLN_DCP_Client_Count) || (NULL == s_clientQueue[client]) ||
+        (pdTRUE != xQueueSend(s_clientQueue[client], job, 0)))
+    {
+        return kStatus_Fail;
+    }
+
+    xSemaphoreGive(s_jobsPending);
+
+    return kStatus_Success;
+}
+
+status_t SLN_DCP_QUEUE_Run(sln_dcp_client_t client, const sln_dcp_job_t *job)
+{
+    status_t status       = kStatus_Success;
+    sln_dcp_job_t syncJob = *job;
+
+    if (client >= kSLN_DCP_Client_Count)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    // Nobody to wait for before the scheduler starts, and the queue task can not wait for itself
+    if (!SLN_DCP_QUEUE_IsRunning() || (xTaskGetCurrentTaskHandle() == s_queueTask))
+    {
+        dcp_round_job_t inlineJob = {.job = *job, .client = client};
+
+        if (!is_aes_job(job))
+        {
+            return run_hash_job(&inlineJob);
+        }
+
+        status = start_aes_job(&inlineJob);
+        if (kStatus_Success == status)
+        {
+            status = wait_aes_job(&inlineJob);
+        }
+
+        return status;
+    }
+
+    syncJob.cb  = queue_sync_done;
+    syncJob.arg = (void *)(uintptr_t)client;
+
+    xSemaphoreTake(s_syncLock[client], portMAX_DELAY);
+
+    while (kStatus_Success != SLN_DCP_QUEUE_Submit(client, &syncJob))
+    {
+        // Queue of the client full of asynchronous jobs
+        vTaskDelay(1);
+    }
+
+    xSemaphoreTake(s_syncDone[client], portMAX_DELAY);
+    status = s_syncStatus[client];
+
+    xSemaphoreGive(s_syncLock[client]);
+
+    return status;
+}
+
+void SLN_DCP_QUEUE_GetStats(sln_dcp_queue_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        *stats = s_queueStats;
+    }
+}
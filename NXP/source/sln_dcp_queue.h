@@ -0,0 +1,148 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_DCP_QUEUE_
+#define _SLN_DCP_QUEUE_
+
+/*!
+ * SLN DCP Queue
+ *
+ * Task running the DCP jobs (CRC, SHA, AES-CBC) of the application, with one job queue per client.
+ * The clients are served in turn, one job each per round, so a long OTA hash does not hold back a
+ * file read. Each client has its own DCP channel: the AES jobs of a round are started together and
+ * run alongside the hash jobs, the DCP arbitrating between its channels.
+ *
+ * The mbedTLS port is not a client: it keeps DCP channel 0 for the AES and SHA it runs in the calling task.
+ * The jobs the DCP fails are computed by the CPU (sln_cpu_crypto): a CRC or an AES job with a key of its
+ * context is redone, the OTP keys can not be read. A hash can not be moved off the DCP halfway, the stream
+ * the DCP fails ends with the error and the SHA-256 streams started afterwards run on the CPU.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_common.h"
+#include "fsl_dcp.h"
+#include "sln_encrypt.h"
+
+/*! @brief Number of jobs each client can queue */
+#ifndef SLN_DCP_QUEUE_LEN
+#define SLN_DCP_QUEUE_LEN (4U)
+#endif
+
+#define SLN_DCP_QUEUE_TASK_STACK    (512U)
+#define SLN_DCP_QUEUE_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+
+/*! @brief Users of the queue, each with its own DCP channel */
+typedef enum _sln_dcp_client
+{
+    kSLN_DCP_Client_FileSystem = 0, /*!< Flash management, DCP channel 1 */
+    kSLN_DCP_Client_Ota,            /*!< Firmware update, DCP channel 2 */
+    kSLN_DCP_Client_Count,
+} sln_dcp_client_t;
+
+/*! @brief Job operations */
+typedef enum _sln_dcp_op
+{
+    kSLN_DCP_Crc32 = 0,     /*!< CRC32 of in, result in crc */
+    kSLN_DCP_HashUpdate,    /*!< Add in to hashCtx, see SLN_DCP_QUEUE_HashInit */
+    kSLN_DCP_HashFinish,    /*!< End hashCtx, digest of len bytes in out */
+    kSLN_DCP_AesCbcEncrypt, /*!< Encrypt in to out with the key of ctx */
+    kSLN_DCP_AesCbcDecrypt, /*!< Decrypt in to out with the key of ctx */
+} sln_dcp_op_t;
+
+/*! @brief Called by the queue task when a job is done, with kStatus_Success or the error */
+typedef void (*sln_dcp_cb_t)(status_t status, void *arg);
+
+/*! @brief Job queued to the DCP; the buffers must stay valid until the callback */
+typedef struct _sln_dcp_job
+{
+    sln_dcp_op_t op;         /*!< op: Operation to run. */
+    sln_encrypt_ctx_t *ctx;  /*!< ctx: Key of the AES operations. */
+    dcp_hash_ctx_t *hashCtx; /*!< hashCtx: Hash of the hash operations. */
+    const uint8_t *in;       /*!< in: Input buffer. */
+    uint8_t *out;            /*!< out: Output buffer. */
+    uint32_t len;            /*!< len: Length of in, multiple of 16 bytes for AES; of out for a hash finish. */
+    const uint8_t *iv;       /*!< iv: IV of the AES operations, the one of ctx if NULL. */
+    uint32_t *crc;           /*!< crc: Result of a CRC32. */
+    sln_dcp_cb_t cb;         /*!< cb: Called when the job is done, can be NULL. */
+    void *arg;               /*!< arg: Argument of the callback. */
+} sln_dcp_job_t;
+
+/*! @brief Statistics of the queue */
+typedef struct _sln_dcp_queue_stats
+{
+    uint32_t jobs[kSLN_DCP_Client_Count]; /*! Number of jobs done per client */
+    uint32_t failures;                    /*! Number of jobs that failed */
+    uint32_t swFallbacks;                 /*! Number of jobs computed by the CPU */
+    uint32_t maxRoundJobs;                /*! Highest number of jobs run in one round */
+} sln_dcp_queue_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Create the queue task and the client queues, to be called after CRYPTO_InitHardware
+ *
+ * @returns kStatus_Success or kStatus_Fail if the task or a queue could not be created
+ */
+status_t SLN_DCP_QUEUE_Init(void);
+
+/*!
+ * @brief Check if the jobs are run by the queue task
+ *
+ * @returns true once the scheduler runs the queue task
+ */
+bool SLN_DCP_QUEUE_IsRunning(void);
+
+/*!
+ * @brief Initialize a hash run by jobs of a client; no DCP access, done in the calling task
+ *     Once the DCP failed a hash, or if its driver refuses the hash, a SHA-256 runs on the CPU.
+ *
+ * @param client Client the hash jobs will be queued by
+ * @param hashCtx Hash to initialize
+ * @param algo Hash algorithm
+ *
+ * @returns Status of the initialization
+ */
+status_t SLN_DCP_QUEUE_HashInit(sln_dcp_client_t client, dcp_hash_ctx_t *hashCtx, dcp_hash_algo_t algo);
+
+/*!
+ * @brief Queue a job, the callback is called from the queue task
+ *
+ * @param client Client queuing the job
+ * @param job The job, copied into the queue
+ *
+ * @returns kStatus_Success if queued, kStatus_Fail if the queue of the client is full or not created
+ */
+status_t SLN_DCP_QUEUE_Submit(sln_dcp_client_t client, const sln_dcp_job_t *job);
+
+/*!
+ * @brief Run a job through the queue and wait for its end, the callback of the job is not used
+ *     Before the scheduler starts, the job is run in the calling task.
+ *
+ * @param client Client running the job
+ * @param job The job
+ *
+ * @returns Status of the job
+ */
+status_t SLN_DCP_QUEUE_Run(sln_dcp_client_t client, const sln_dcp_job_t *job);
+
+/*!
+ * @brief Get the statistics of the queue
+ *
+ * @param stats Pointer to the statistics to fill, nothing done if NULL
+ */
+void SLN_DCP_QUEUE_GetStats(sln_dcp_queue_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_DCP_QUEUE_ */
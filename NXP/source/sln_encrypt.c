@@ -13,6 +13,9 @@
 
 #define SLN_ENCRYPT_SLOTS 4
 
+/* Polynomial of the DCP CRC32 (CRC-32/MPEG-2) */
+#define SLN_CRC32_POLYNOMIAL (0x04C11DB7UL)
+
 static const void *s_SNL_EncryptCtx[SLN_ENCRYPT_SLOTS] = {0};
 static uint16_t s_dcpUsers                             = 0;
 
@@ -97,6 +100,27 @@ int32_t SLN_Encrypt_Init_Slot(sln_encrypt_ctx_t *ctx)
     return SLN_ENCRYPT_STATUS_OK;
 }
 
+int32_t SLN_Encrypt_Load_Key(sln_encrypt_ctx_t *ctx)
+{
+    if (NULL == ctx)
+    {
+        return SLN_ENCRYPT_NULL_CTX;
+    }
+
+    if (!SLN_Encrypt_Key_Loaded(ctx))
+    {
+        // A key the DCP refused is not attached, the next load retries it
+        if (kStatus_Success != DCP_AES_SetKey(DCP, &ctx->handle, ctx->key, ctx->keySize))
+        {
+            return SLN_ENCRYPT_DCP_KEY_ERROR;
+        }
+
+        SLN_Encrypt_Attach_Key(ctx, ctx->handle.keySlot);
+    }
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
 int32_t SLN_Encrypt_Deinit_Slot(sln_encrypt_ctx_t *ctx)
 {
     if (s_dcpUsers == 0)
@@ -119,6 +143,33 @@ int32_t SLN_Encrypt_Deinit_Slot(sln_encrypt_ctx_t *ctx)
     return SLN_ENCRYPT_STATUS_OK;
 }
 
+/* Plain length of the last block, from its PKCS#7 padding of 1 to maxPad bytes; false if it has none */
+static bool SLN_Encrypt_Unpad(const uint8_t *block, uint8_t maxPad, uint32_t *plainLen)
+{
+    uint8_t pad = block[AES_BLOCK_SIZE - 1];
+
+    *plainLen = AES_BLOCK_SIZE;
+
+    if ((0 == pad) || (pad > maxPad))
+    {
+        return false;
+    }
+
+    /* Verify padding makes sense */
+    for (uint32_t idx = AES_BLOCK_SIZE - pad; idx < AES_BLOCK_SIZE; idx++)
+    {
+        if (block[idx] != pad)
+        {
+            // Not valid padding, assume input length is output length
+            return false;
+        }
+    }
+
+    *plainLen = AES_BLOCK_SIZE - pad;
+
+    return true;
+}
+
 int32_t SLN_Encrypt_AES_CBC_PKCS7(
     sln_encrypt_ctx_t *ctx, const uint8_t *in, size_t inSize, uint8_t *out, size_t outSize)
 {
@@ -133,7 +184,7 @@ int32_t SLN_Encrypt_AES_CBC_PKCS7(
     handle  = &ctx->handle;
     keySize = ctx->keySize;
 
-    if (outSize % AES_BLOCK_SIZE)
+    if ((outSize % AES_BLOCK_SIZE) || (outSize < SLN_Encrypt_Get_Crypt_Length(inSize)))
     {
         ret = SLN_ENCRYPT_WRONG_OUT_BUFSIZE;
         goto exit;
@@ -159,20 +210,15 @@ int32_t SLN_Encrypt_AES_CBC_PKCS7(
         }
     }
 
-    /* And the rest copy in a 16-byte buffer */
-    if (lastSize)
+    /* And the rest copy in a 16-byte buffer, a whole block of padding for block aligned input */
     {
         uint8_t pad = AES_BLOCK_SIZE - lastSize;
         uint8_t alignedInBuf[AES_BLOCK_SIZE];
 
-        memset(alignedInBuf, 0, AES_BLOCK_SIZE);
         memcpy(alignedInBuf, in + alignedSize, lastSize);
 
         /* Implement PKCS#7 padding so we can recover plain text length later */
-        if (pad)
-        {
-            memset(alignedInBuf + lastSize, pad, pad);
-        }
+        memset(alignedInBuf + lastSize, pad, pad);
 
         ret = DCP_AES_EncryptCbc(DCP, handle, alignedInBuf, out + alignedSize, AES_BLOCK_SIZE, iv);
         if (SLN_ENCRYPT_STATUS_OK != ret)
@@ -197,7 +243,6 @@ int32_t SLN_Decrypt_AES_CBC_PKCS7(
     uint32_t alignedSize = 0;
     uint32_t lastSize    = 0;
     int32_t ret          = SLN_ENCRYPT_STATUS_OK;
-    uint8_t pad          = 0;
 
     iv      = (uint8_t *)ctx->iv;
     decKey  = (uint8_t *)ctx->key;
@@ -241,36 +286,283 @@ int32_t SLN_Decrypt_AES_CBC_PKCS7(
     }
 
     /* Work out plain length from PKCS#7 padding */
-    pad = alignedOutBuf[AES_BLOCK_SIZE - 1];
+    SLN_Encrypt_Unpad(alignedOutBuf, AES_BLOCK_SIZE, &lastSize);
+
+    /* Copy final data into output buffer */
+    memcpy(out + alignedSize, alignedOutBuf, lastSize);
 
-    if (pad < AES_BLOCK_SIZE)
+    /* Update output size */
+    *outSize = alignedSize + lastSize;
+
+exit:
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Encrypt_Stream_Init(sln_encrypt_stream_t *stream, sln_encrypt_ctx_t *ctx, uint32_t cryptLen, bool legacy)
+{
+    if (NULL == ctx)
     {
-        /* Verify padding makes sense */
-        uint32_t startIdx = AES_BLOCK_SIZE - 1;
-        uint32_t endIdx   = startIdx - pad;
-        for (uint32_t idx = startIdx; idx > endIdx; idx--)
+        return SLN_ENCRYPT_NULL_CTX;
+    }
+
+    if ((NULL == stream) || (cryptLen % AES_BLOCK_SIZE))
+    {
+        return SLN_ENCRYPT_NULL_PARAM;
+    }
+
+    SLN_Encrypt_Load_Key(ctx);
+
+    stream->ctx      = ctx;
+    stream->cryptLen = cryptLen;
+    stream->offset   = 0;
+    stream->legacy   = legacy;
+    memcpy(stream->chain, ctx->iv, AES_BLOCK_SIZE);
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Encrypt_Stream_Update(sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out)
+{
+    sln_encrypt_ctx_t *ctx = stream->ctx;
+
+    if ((inSize % AES_BLOCK_SIZE) || (stream->offset + inSize > stream->cryptLen))
+    {
+        return SLN_ENCRYPT_WRONG_IN_BUFSIZE;
+    }
+
+    if (inSize)
+    {
+        if (kStatus_Success != DCP_AES_EncryptCbc(DCP, &ctx->handle, in, out, inSize, stream->chain))
+        {
+            return SLN_ENCRYPT_DCP_ENCRYPT_ERROR_1;
+        }
+
+        memcpy(stream->chain, out + inSize - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+    }
+
+    stream->offset += inSize;
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Encrypt_Stream_Finish(sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out)
+{
+    sln_encrypt_ctx_t *ctx = stream->ctx;
+    uint32_t lastSize      = inSize % AES_BLOCK_SIZE;
+    uint32_t chainedSize   = inSize - lastSize;
+    uint32_t cryptSize =
+        stream->legacy ? SLN_Encrypt_Get_Legacy_Crypt_Length(inSize) : SLN_Encrypt_Get_Crypt_Length(inSize);
+    int32_t ret = SLN_ENCRYPT_STATUS_OK;
+
+    if ((stream->offset + cryptSize) != stream->cryptLen)
+    {
+        return SLN_ENCRYPT_WRONG_IN_BUFSIZE;
+    }
+
+    ret = SLN_Encrypt_Stream_Update(stream, in, chainedSize, out);
+
+    if (SLN_ENCRYPT_STATUS_OK != ret)
+    {
+        return ret;
+    }
+
+    /* The padded last block, none for the block aligned input of the legacy layout */
+    if (chainedSize < cryptSize)
+    {
+        uint8_t pad = AES_BLOCK_SIZE - lastSize;
+        uint8_t alignedInBuf[AES_BLOCK_SIZE];
+
+        memcpy(alignedInBuf, in + chainedSize, lastSize);
+        memset(alignedInBuf + lastSize, pad, pad);
+
+        if (kStatus_Success != DCP_AES_EncryptCbc(DCP, &ctx->handle, alignedInBuf, out + chainedSize, AES_BLOCK_SIZE,
+                                                  ctx->iv))
         {
-            if (alignedOutBuf[idx] != pad)
+            return SLN_ENCRYPT_DCP_ENCRYPT_ERROR_2;
+        }
+
+        stream->offset += AES_BLOCK_SIZE;
+    }
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Decrypt_Stream_Seek(sln_encrypt_stream_t *stream, const uint8_t *cypher, uint32_t offset)
+{
+    if ((offset % AES_BLOCK_SIZE) || (offset > stream->cryptLen))
+    {
+        return SLN_ENCRYPT_WRONG_OFFSET;
+    }
+
+    /* CBC decryption only needs the previous cypher block */
+    if (0 == offset)
+    {
+        memcpy(stream->chain, stream->ctx->iv, AES_BLOCK_SIZE);
+    }
+    else
+    {
+        memcpy(stream->chain, cypher + offset - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+    }
+
+    stream->offset = offset;
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Decrypt_Stream_Update(
+    sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out, size_t *outSize)
+{
+    sln_encrypt_ctx_t *ctx = stream->ctx;
+    uint32_t chainedSize   = inSize;
+    uint8_t nextChain[AES_BLOCK_SIZE];
+
+    if ((inSize % AES_BLOCK_SIZE) || (stream->offset + inSize > stream->cryptLen))
+    {
+        return SLN_ENCRYPT_WRONG_IN_BUFSIZE;
+    }
+
+    if (inSize && ((stream->offset + inSize) == stream->cryptLen))
+    {
+        chainedSize -= AES_BLOCK_SIZE;
+    }
+
+    *outSize = chainedSize;
+
+    if (chainedSize)
+    {
+        memcpy(nextChain, in + chainedSize - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+
+        if (kStatus_Success != DCP_AES_DecryptCbc(DCP, &ctx->handle, in, out, chainedSize, stream->chain))
+        {
+            return SLN_ENCRYPT_DCP_DECRYPT_ERROR_1;
+        }
+
+        memcpy(stream->chain, nextChain, AES_BLOCK_SIZE);
+    }
+
+    if (chainedSize < inSize)
+    {
+        uint8_t alignedOutBuf[AES_BLOCK_SIZE];
+        uint32_t lastSize = 0;
+        bool padded       = false;
+
+        if (kStatus_Success !=
+            DCP_AES_DecryptCbc(DCP, &ctx->handle, in + chainedSize, alignedOutBuf, AES_BLOCK_SIZE, ctx->iv))
+        {
+            return SLN_ENCRYPT_DCP_DECRYPT_ERROR_2;
+        }
+
+        /* Work out plain length from PKCS#7 padding */
+        padded = SLN_Encrypt_Unpad(alignedOutBuf, stream->legacy ? (AES_BLOCK_SIZE - 1) : AES_BLOCK_SIZE, &lastSize);
+
+        /* Not padded in the legacy layout: block aligned input, the last block is chained as the others */
+        if (stream->legacy && !padded)
+        {
+            if (kStatus_Success !=
+                DCP_AES_DecryptCbc(DCP, &ctx->handle, in + chainedSize, alignedOutBuf, AES_BLOCK_SIZE, stream->chain))
             {
-                // Not valid padding, assume input lengt is output length
-                pad = 0;
-                break;
+                return SLN_ENCRYPT_DCP_DECRYPT_ERROR_2;
             }
         }
 
-        lastSize -= pad;
+        memcpy(out + chainedSize, alignedOutBuf, lastSize);
+        *outSize += lastSize;
     }
 
-    /* Copy final data into output buffer */
-    memcpy(out + alignedSize, alignedOutBuf, lastSize);
+    stream->offset += inSize;
 
-    /* Update output size */
-    *outSize = alignedSize + lastSize;
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Crc_Init(sln_encrypt_ctx_t *ctx, dcp_hash_ctx_t *hashCtx)
+{
+    if (NULL == ctx)
+    {
+        return SLN_ENCRYPT_NULL_CTX;
+    }
+
+    if (kStatus_Success != DCP_HASH_Init(DCP, &ctx->handle, hashCtx, kDCP_Crc32))
+    {
+        return SLN_ENCRYPT_DCP_CRC_ERROR;
+    }
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+int32_t SLN_Crc_Update(dcp_hash_ctx_t *hashCtx, const uint8_t *in, size_t inSize)
+{
+    if (kStatus_Success != DCP_HASH_Update(DCP, hashCtx, in, inSize))
+    {
+        return SLN_ENCRYPT_DCP_CRC_ERROR;
+    }
 
-exit:
     return SLN_ENCRYPT_STATUS_OK;
 }
 
+int32_t SLN_Crc_Finish(dcp_hash_ctx_t *hashCtx, uint32_t *out)
+{
+    size_t outSize = sizeof(uint32_t);
+
+    if (kStatus_Success != DCP_HASH_Finish(DCP, hashCtx, (uint8_t *)out, &outSize))
+    {
+        return SLN_ENCRYPT_DCP_CRC_ERROR;
+    }
+
+    return SLN_ENCRYPT_STATUS_OK;
+}
+
+/* Product of two polynomials modulo the CRC polynomial */
+static uint32_t SLN_Crc_Mul(uint32_t a, uint32_t b)
+{
+    uint32_t prod = 0;
+
+    for (uint32_t bit = 0x80000000UL; bit != 0; bit >>= 1)
+    {
+        prod = (prod & 0x80000000UL) ? ((prod << 1) ^ SLN_CRC32_POLYNOMIAL) : (prod << 1);
+
+        if (b & bit)
+        {
+            prod ^= a;
+        }
+    }
+
+    return prod;
+}
+
+uint32_t SLN_Crc_Patch(
+    uint32_t crc, const uint8_t *oldRange, const uint8_t *newRange, size_t rangeSize, size_t tailSize)
+{
+    uint32_t delta = 0;
+    uint32_t shift = 1;
+    uint32_t base  = 0x100; /* x^8, one byte */
+
+    /* The CRC is affine: the CRCs of two messages of the same length differ by the linear CRC
+     * (no initial value) of their XOR, the bytes before the range adding nothing */
+    for (size_t idx = 0; idx < rangeSize; idx++)
+    {
+        delta ^= (uint32_t)(oldRange[idx] ^ newRange[idx]) << 24;
+
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            delta = (delta & 0x80000000UL) ? ((delta << 1) ^ SLN_CRC32_POLYNOMIAL) : (delta << 1);
+        }
+    }
+
+    /* The bytes after the range multiply it by x^(8 * tailSize) */
+    while (tailSize)
+    {
+        if (tailSize & 1)
+        {
+            shift = SLN_Crc_Mul(shift, base);
+        }
+
+        base = SLN_Crc_Mul(base, base);
+        tailSize >>= 1;
+    }
+
+    return crc ^ SLN_Crc_Mul(delta, shift);
+}
+
 int32_t SLN_Crc(sln_encrypt_ctx_t *ctx, const uint8_t *in, size_t inSize, uint32_t *out, size_t *outSize)
 {
     dcp_handle_t *handle;
@@ -33,6 +33,8 @@ typedef enum _sln_encrypt_status
     SLN_ENCRYPT_DCP_CRC_ERROR       = -10,
     SLN_ENCRYPT_WRONG_IN_BUFSIZE    = -11,
     SLN_ENCRYPT_WRONG_OUT_BUFSIZE   = -12,
+    SLN_ENCRYPT_WRONG_OFFSET        = -13,
+    SLN_ENCRYPT_DCP_KEY_ERROR       = -14,
 } sln_encrypt_status_t;
 
 typedef struct _sln_encrypt_ctx
@@ -45,6 +47,23 @@ typedef struct _sln_encrypt_ctx
     dcp_handle_t handle;
 } sln_encrypt_ctx_t;
 
+/*!
+ * @brief State of an encryption or decryption done in chunks.
+ *
+ * The layout is the one of SLN_Encrypt_AES_CBC_PKCS7: the whole blocks of the plain text are chained
+ * from the context IV, the last block, always padded, is encrypted on its own with the context IV.
+ * The legacy layout, of older firmware, has no padding block for block aligned plain text: all its
+ * blocks are chained.
+ */
+typedef struct _sln_encrypt_stream
+{
+    sln_encrypt_ctx_t *ctx;
+    ALIGN16 uint8_t chain[AES_BLOCK_SIZE]; /*!< chain: IV of the next block */
+    uint32_t cryptLen;                     /*!< cryptLen: Total encrypted length */
+    uint32_t offset;                       /*!< offset: Encrypted bytes processed so far */
+    bool legacy;                           /*!< legacy: Legacy layout */
+} sln_encrypt_stream_t;
+
 /*!
  * @brief Return encrypted length from a given plaintext length.
  *
@@ -54,6 +73,19 @@ typedef struct _sln_encrypt_ctx
  *
  */
 static inline uint32_t SLN_Encrypt_Get_Crypt_Length(uint32_t plainLen)
+{
+    return (uint32_t)(((plainLen / AES_BLOCK_SIZE) + 1) * AES_BLOCK_SIZE);
+}
+
+/*!
+ * @brief Return encrypted length from a given plaintext length, in the legacy layout of older firmware.
+ *
+ * @param plainLen Plaintext length of data.
+ *
+ * @returns Encrypted data length in bytes.
+ *
+ */
+static inline uint32_t SLN_Encrypt_Get_Legacy_Crypt_Length(uint32_t plainLen)
 {
     return (uint32_t)((plainLen / AES_BLOCK_SIZE) * AES_BLOCK_SIZE +
                       ((plainLen % AES_BLOCK_SIZE) ? AES_BLOCK_SIZE : 0));
@@ -79,6 +111,15 @@ int32_t SLN_Encrypt_Init_Slot(sln_encrypt_ctx_t *ctx);
  */
 int32_t SLN_Encrypt_Deinit_Slot(sln_encrypt_ctx_t *ctx);
 
+/*!
+ * @brief Load the key of a context into its DCP key slot, if not already loaded
+ *
+ * @param ctx         Pointer to an encryption session context
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Encrypt_Load_Key(sln_encrypt_ctx_t *ctx);
+
 /*!
  * @brief Encrypts a plain message, with PKCS#7 padding
  *
@@ -86,7 +127,8 @@ int32_t SLN_Encrypt_Deinit_Slot(sln_encrypt_ctx_t *ctx);
  * @param in          Pointer to the plain (unencrypted) buffer
  * @param inSize      Size of the input buffer
  * @param out         Pointer to the cypher (encrypted) buffer.
- * @param outSize    The size of the output buffer. MUST be a multiple of 16-bytes.
+ * @param outSize    The size of the output buffer. MUST be a multiple of 16-bytes, at least
+ *                    SLN_Encrypt_Get_Crypt_Length(inSize).
  *
  * @returns 0 in case of success or a negative value in case of error
  */
@@ -107,6 +149,115 @@ int32_t SLN_Encrypt_AES_CBC_PKCS7(
 int32_t SLN_Decrypt_AES_CBC_PKCS7(
     sln_encrypt_ctx_t *ctx, const uint8_t *in, size_t inSize, uint8_t *out, size_t *outSize);
 
+/*!
+ * @brief Start an encryption or a decryption in chunks
+ *
+ * @param stream      Pointer to the stream state
+ * @param ctx         Pointer to an encryption session context
+ * @param cryptLen    Total encrypted length, see SLN_Encrypt_Get_Crypt_Length
+ * @param legacy      Legacy layout, see SLN_Encrypt_Get_Legacy_Crypt_Length. The decryption tells a block
+ *                    aligned message from the padding of its last block.
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Encrypt_Stream_Init(sln_encrypt_stream_t *stream, sln_encrypt_ctx_t *ctx, uint32_t cryptLen, bool legacy);
+
+/*!
+ * @brief Encrypts the next chunk of a plain message
+ *
+ * @param stream      Pointer to the stream state
+ * @param in          Pointer to the plain chunk
+ * @param inSize      Size of the chunk. MUST be a multiple of 16-bytes.
+ * @param out         Pointer to the cypher chunk, inSize bytes, not overlapping in
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Encrypt_Stream_Update(sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out);
+
+/*!
+ * @brief Encrypts the last chunk of a plain message, with its padding
+ *
+ * @param stream      Pointer to the stream state
+ * @param in          Pointer to the plain chunk
+ * @param inSize      Size of the chunk, the rest of the message
+ * @param out         Pointer to the cypher chunk, SLN_Encrypt_Get_Crypt_Length(inSize) bytes (see
+ *                    SLN_Encrypt_Get_Legacy_Crypt_Length in the legacy layout), not overlapping in
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Encrypt_Stream_Finish(sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out);
+
+/*!
+ * @brief Move a decryption to a block of the encrypted message, for random access reads
+ *
+ * @param stream      Pointer to the stream state
+ * @param cypher      Pointer to the start of the whole encrypted message
+ * @param offset      Offset of the next chunk to decrypt. MUST be a multiple of 16-bytes.
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Decrypt_Stream_Seek(sln_encrypt_stream_t *stream, const uint8_t *cypher, uint32_t offset);
+
+/*!
+ * @brief Decrypts the next chunk of an encrypted message
+ *
+ * @param stream      Pointer to the stream state
+ * @param in          Pointer to the cypher chunk
+ * @param inSize      Size of the chunk. MUST be a multiple of 16-bytes.
+ * @param out         Pointer to the plain chunk, inSize bytes, not overlapping in
+ * @param outSize     Ouput pointer updated with the plain length, PKCS#7 padding removed from the last chunk
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Decrypt_Stream_Update(
+    sln_encrypt_stream_t *stream, const uint8_t *in, size_t inSize, uint8_t *out, size_t *outSize);
+
+/*!
+ * @brief Start a 32-bit CRC computed in chunks, same result as SLN_Crc over the whole input
+ *
+ * @param ctx         Pointer to an encryption session context
+ * @param hashCtx     Pointer to the CRC state
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Crc_Init(sln_encrypt_ctx_t *ctx, dcp_hash_ctx_t *hashCtx);
+
+/*!
+ * @brief Add a chunk to a 32-bit CRC
+ *
+ * @param hashCtx     Pointer to the CRC state
+ * @param in          Pointer to the input chunk
+ * @param inSize      The size of the input chunk
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Crc_Update(dcp_hash_ctx_t *hashCtx, const uint8_t *in, size_t inSize);
+
+/*!
+ * @brief End a 32-bit CRC computed in chunks
+ *
+ * @param hashCtx     Pointer to the CRC state
+ * @param out         Pointer to the output buffer (32-bit CRC)
+ *
+ * @returns 0 in case of success or a negative value in case of error
+ */
+int32_t SLN_Crc_Finish(dcp_hash_ctx_t *hashCtx, uint32_t *out);
+
+/*!
+ * @brief Get the 32-bit CRC of data after a range of it changed, from the old CRC and the range only
+ *     Computed by the CPU: the cost depends on the range size, not on the size of the data.
+ *
+ * @param crc         CRC of the data before the change
+ * @param oldRange    Pointer to the range before the change
+ * @param newRange    Pointer to the range after the change
+ * @param rangeSize   The size of the range
+ * @param tailSize    The number of bytes of the data after the range
+ *
+ * @returns The CRC of the data after the change
+ */
+uint32_t SLN_Crc_Patch(
+    uint32_t crc, const uint8_t *oldRange, const uint8_t *newRange, size_t rangeSize, size_t tailSize);
+
 /*!
  * @brief Performs 32-bit CRC on input data
  *
@@ -26,6 +26,12 @@
         name, SLN_FLASH_MGMT_FILE_ADDR(index), encrypt \
     }
 
+/*! Small, often saved files go to the key/value store; the sector is kept to migrate older saves */
+#define SLN_FLASH_LOG_ENTRY(name, index, encrypt)                        \
+    {                                                                    \
+        name, SLN_FLASH_MGMT_FILE_ADDR(index), encrypt, SLN_FLASH_LOGGED \
+    }
+
 const sln_flash_entry_t g_fileTable[] = {
 
     SLN_FLASH_ENTRY(
@@ -161,7 +167,7 @@ const sln_flash_entry_t g_fileTable[] = {
 #define SLN_FLASH_INDEX 14
 
 #ifdef ASR_SHELL_COMMANDS_FILE_NAME
-    SLN_FLASH_ENTRY(ASR_SHELL_COMMANDS_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+    SLN_FLASH_LOG_ENTRY(ASR_SHELL_COMMANDS_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
 #else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
@@ -170,14 +176,22 @@ const sln_flash_entry_t g_fileTable[] = {
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 15
 
+#ifdef SLN_TLS_SERVER_CERT_FILE_NAME
+    SLN_FLASH_ENTRY(SLN_TLS_SERVER_CERT_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#endif
 
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 16
 
+#ifdef SLN_TLS_SERVER_KEY_FILE_NAME
+    SLN_FLASH_ENTRY(SLN_TLS_SERVER_KEY_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
+#else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#endif
 
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 17
@@ -189,7 +203,7 @@ const sln_flash_entry_t g_fileTable[] = {
 #define SLN_FLASH_INDEX 18
 
 #ifdef DEVICE_CONFIG_FILE_NAME
-    SLN_FLASH_ENTRY(DEVICE_CONFIG_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+    SLN_FLASH_LOG_ENTRY(DEVICE_CONFIG_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
 #else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
@@ -199,7 +213,7 @@ const sln_flash_entry_t g_fileTable[] = {
 #define SLN_FLASH_INDEX 19
 
 #ifdef WIFI_CRED_FILE_NAME
-    SLN_FLASH_ENTRY(WIFI_CRED_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
+    SLN_FLASH_LOG_ENTRY(WIFI_CRED_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
 #else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
@@ -279,13 +293,14 @@ const sln_flash_entry_t g_fileTable[] = {
 #define SLN_FLASH_INDEX 27
 
 #ifdef BLE_LTK_FILE
-    SLN_FLASH_ENTRY(BLE_LTK_FILE, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
+    SLN_FLASH_LOG_ENTRY(BLE_LTK_FILE, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
 #else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
 #endif
 // End of NXP defined files
 
+// Sectors 28 to 31 hold the key/value store, see SLN_FLASH_KVS_FIRST_SECTOR
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 28
 
@@ -9,10 +9,15 @@
 
 #include "sln_flash.h"
 #include "sln_flash_ops.h"
-#include "fsl_flexspi.h"
 
 extern const uint32_t customLUT[CUSTOM_LUT_LENGTH];
 
+/* Longest section run with the IRQs off, in core cycles */
+static volatile uint32_t s_maxIrqOffCycles = 0;
+
+/* Page programs that wanted a bit at 0 set to 1 */
+static volatile uint32_t s_norViolations = 0;
+
 #ifdef __REDLIB__
 size_t safe_strlen(const char *ptr, size_t max)
 {
@@ -139,36 +144,85 @@ void SLN_ram_enable_d_cache(void)
 #endif
 }
 
-void SLN_Flash_Init(void)
+#if SLN_FLASH_CHECK_NOR
+/* NOR flash only clears bits: data must not have a 1 where the flash already holds a 0 */
+static void SLN_Flash_Check_Nor(uint32_t address, const uint8_t *data, uint32_t len)
+{
+    const uint8_t *flash = (const uint8_t *)sln_flash_ops_read_address(address);
+
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        if ((flash[idx] & data[idx]) != data[idx])
+        {
+            s_norViolations++;
+            break;
+        }
+    }
+}
+#endif
+
+/* Start of a flash access: IRQs and D-cache off, the section is timed */
+static uint32_t SLN_Flash_Enter(uint32_t *start)
 {
     uint32_t irqState;
 
     irqState = SLN_ram_disable_irq();
+    *start   = DWT->CYCCNT;
 
     SLN_ram_disable_d_cache();
 
-    /* Update LUT table. */
-    FLEXSPI_UpdateLUT(FLEXSPI, 0, customLUT, CUSTOM_LUT_LENGTH);
+    return irqState;
+}
 
-    /* Do software reset. */
-    FLEXSPI_SoftwareReset(FLEXSPI);
+static void SLN_Flash_Exit(uint32_t irqState, uint32_t start)
+{
+    uint32_t elapsed;
 
     SLN_ram_enable_d_cache();
 
+    elapsed = DWT->CYCCNT - start;
+    if (elapsed > s_maxIrqOffCycles)
+    {
+        s_maxIrqOffCycles = elapsed;
+    }
+
     SLN_ram_enable_irq(irqState);
     /* Flush pipeline to allow pending interrupts take place
      * before starting next loop */
     __ASM volatile("isb 0xF" ::: "memory");
 }
 
+void SLN_Flash_Init(void)
+{
+    uint32_t irqState;
+    uint32_t start;
+
+    /* Cycle counter used to time the sections run with the IRQs off */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    irqState = SLN_Flash_Enter(&start);
+
+    /* Update LUT table. */
+    sln_flash_ops_update_lut(FLEXSPI, 0, customLUT, CUSTOM_LUT_LENGTH);
+
+    /* Do software reset. */
+    sln_flash_ops_reset(FLEXSPI);
+
+    SLN_Flash_Exit(irqState, start);
+}
+
 status_t SLN_Write_Flash_Page(uint32_t address, uint8_t *data, uint32_t len)
 {
     status_t status = 0;
     uint32_t irqState;
+    uint32_t start;
 
-    irqState = SLN_ram_disable_irq();
+#if SLN_FLASH_CHECK_NOR
+    SLN_Flash_Check_Nor(address, data, len);
+#endif
 
-    SLN_ram_disable_d_cache();
+    irqState = SLN_Flash_Enter(&start);
 
     /* Setup page size write buffer */
     uint8_t tempPage[FLASH_PAGE_SIZE];
@@ -180,12 +234,7 @@ status_t SLN_Write_Flash_Page(uint32_t address, uint8_t *data, uint32_t len)
     /* Program page. */
     status = sln_flash_ops_page_program(FLEXSPI, address, (void *)tempPage);
 
-    SLN_ram_enable_d_cache();
-
-    SLN_ram_enable_irq(irqState);
-    /* Flush pipeline to allow pending interrupts take place
-     * before starting next loop */
-    __ASM volatile("isb 0xF" ::: "memory");
+    SLN_Flash_Exit(irqState, start);
 
     return status;
 }
@@ -212,10 +261,10 @@ static status_t SLN_Erase_Sector2(uint32_t address)
     status_t status = 0;
 
     /* Erase sectors. */
-    status = flexspi_nor_flash_erase_sector(FLEXSPI, address);
+    status = sln_flash_ops_erase_sector(FLEXSPI, address);
 
     /* Do software reset. */
-    FLEXSPI_SoftwareReset(FLEXSPI);
+    sln_flash_ops_reset(FLEXSPI);
 
     return status;
 }
@@ -227,10 +276,9 @@ int32_t SLN_Write_Sector(uint32_t address, uint8_t *buf, uint32_t len)
     uint32_t pageMod   = 0;
     uint32_t toCopy    = 0;
     uint32_t irqState;
+    uint32_t start;
 
-    irqState = SLN_ram_disable_irq();
-
-    SLN_ram_disable_d_cache();
+    irqState = SLN_Flash_Enter(&start);
 
     status = SLN_Erase_Sector2(address);
 
@@ -266,12 +314,7 @@ int32_t SLN_Write_Sector(uint32_t address, uint8_t *buf, uint32_t len)
         } while (--pageCount);
     }
 
-    SLN_ram_enable_d_cache();
-
-    SLN_ram_enable_irq(irqState);
-    /* Flush pipeline to allow pending interrupts take place
-     * before starting next loop */
-    __ASM volatile("isb 0xF" ::: "memory");
+    SLN_Flash_Exit(irqState, start);
 
     return status;
 }
@@ -280,27 +323,149 @@ status_t SLN_Erase_Sector(uint32_t address)
 {
     status_t status = 0;
     uint32_t irqState;
+    uint32_t start;
 
-    irqState = SLN_ram_disable_irq();
-
-    SLN_ram_disable_d_cache();
+    irqState = SLN_Flash_Enter(&start);
 
     /* Erase sectors. */
-    status = flexspi_nor_flash_erase_sector(FLEXSPI, address);
+    status = sln_flash_ops_erase_sector(FLEXSPI, address);
 
     /* Do software reset. */
-    FLEXSPI_SoftwareReset(FLEXSPI);
+    sln_flash_ops_reset(FLEXSPI);
 
-    SLN_ram_enable_d_cache();
+    SLN_Flash_Exit(irqState, start);
 
-    SLN_ram_enable_irq(irqState);
-    /* Flush pipeline to allow pending interrupts take place
-     * before starting next loop */
-    __ASM volatile("isb 0xF" ::: "memory");
+    return status;
+}
+
+/* Resume an erase left by a failed step and wait for its end, the flash takes no other erase before */
+static status_t SLN_Erase_Sector_Finish(uint32_t address)
+{
+    uint32_t timeout = SLN_FLASH_ERASE_MAX_MS * (SystemCoreClock / 1000U);
+    uint32_t start   = DWT->CYCCNT;
+    uint32_t value   = 0;
+    status_t status  = sln_flash_ops_erase_resume(FLEXSPI, address);
+
+    while (kStatus_Success == status)
+    {
+        status = sln_flash_ops_read_status(FLEXSPI, &value);
+
+        if ((kStatus_Success == status) && (value & HYPERFLASH_STATUS_READY) &&
+            !(value & HYPERFLASH_STATUS_ERASE_SUSPEND))
+        {
+            break;
+        }
+
+        if ((DWT->CYCCNT - start) >= timeout)
+        {
+            status = kStatus_Timeout;
+        }
+    }
+
+    return status;
+}
+
+status_t SLN_Erase_Sector_Step(sln_flash_erase_t *erase, uint32_t budgetUs)
+{
+    status_t status = kStatus_Success;
+    uint32_t budget = budgetUs * (SystemCoreClock / 1000000U);
+    uint32_t value  = 0;
+    bool done       = false;
+    uint32_t irqState;
+    uint32_t start;
+
+    irqState = SLN_Flash_Enter(&start);
+
+    if (erase->started)
+    {
+        status = sln_flash_ops_erase_resume(FLEXSPI, erase->address);
+    }
+    else
+    {
+        status         = sln_flash_ops_erase_sector_start(FLEXSPI, erase->address);
+        erase->started = (kStatus_Success == status);
+    }
+
+    while (kStatus_Success == status)
+    {
+        status = sln_flash_ops_read_status(FLEXSPI, &value);
+
+        if (kStatus_Success != status)
+        {
+            break;
+        }
+
+        if (value & HYPERFLASH_STATUS_ERROR)
+        {
+            status = kStatus_Fail;
+            break;
+        }
+
+        if ((value & HYPERFLASH_STATUS_READY) && !(value & HYPERFLASH_STATUS_ERASE_SUSPEND))
+        {
+            done = true;
+            break;
+        }
+
+        if ((DWT->CYCCNT - start) >= budget)
+        {
+            /* Out of time, park the erase; the flash can be read again once the suspend is taken */
+            status = sln_flash_ops_erase_suspend(FLEXSPI, erase->address);
+
+            if (kStatus_Success == status)
+            {
+                status = sln_flash_ops_wait_bus_busy(FLEXSPI);
+            }
+
+            if (kStatus_Success == status)
+            {
+                status = sln_flash_ops_read_status(FLEXSPI, &value);
+            }
+
+            /* The erase may have completed before the suspend was taken */
+            done = (kStatus_Success == status) && !(value & HYPERFLASH_STATUS_ERASE_SUSPEND);
+            break;
+        }
+    }
+
+    if ((kStatus_Success != status) && erase->started)
+    {
+        /* The flash may still be erasing or suspended, an erase dropped here would block all the next ones */
+        SLN_Erase_Sector_Finish(erase->address);
+    }
+
+    /* Drop what the AHB buffers fetched while the flash was busy */
+    sln_flash_ops_reset(FLEXSPI);
+
+    SLN_Flash_Exit(irqState, start);
+
+    if ((kStatus_Success == status) && !done)
+    {
+        status = kStatus_SLN_Flash_EraseSuspended;
+    }
+    else
+    {
+        erase->started = false;
+    }
 
     return status;
 }
 
+uint32_t SLN_Flash_Get_Max_Irq_Off_Us(void)
+{
+    return s_maxIrqOffCycles / (SystemCoreClock / 1000000U);
+}
+
+void SLN_Flash_Reset_Max_Irq_Off(void)
+{
+    s_maxIrqOffCycles = 0;
+}
+
+uint32_t SLN_Flash_Get_Nor_Violations(void)
+{
+    return s_norViolations;
+}
+
 /* NOTE: SLN_Erase_Sector must be called prior to writing pages in a sector
  *       Afterwards, multiple pages can be written in that sector
  * NOTE: This function must always be used for writing full write pages (512 bytes) */
@@ -308,35 +473,33 @@ status_t SLN_Write_Flash_At_Address(uint32_t address, uint8_t *data)
 {
     status_t status = 0;
     uint32_t irqState;
+    uint32_t start;
 
-    irqState = SLN_ram_disable_irq();
+#if SLN_FLASH_CHECK_NOR
+    SLN_Flash_Check_Nor(address, data, FLASH_PAGE_SIZE);
+#endif
 
-    SLN_ram_disable_d_cache();
+    irqState = SLN_Flash_Enter(&start);
 
     /* Do software reset. */
-    FLEXSPI_SoftwareReset(FLEXSPI);
+    sln_flash_ops_reset(FLEXSPI);
 
     /*Program page. */
     status = sln_flash_ops_page_program(FLEXSPI, address, (void *)data);
 
-    SLN_ram_enable_d_cache();
-
-    SLN_ram_enable_irq(irqState);
-    /* Flush pipeline to allow pending interrupts take place
-     * before starting next loop */
-    __ASM volatile("isb 0xF" ::: "memory");
+    SLN_Flash_Exit(irqState, start);
 
     return status;
 }
 
 status_t SLN_Read_Flash_At_Address(uint32_t address, uint8_t *data, uint32_t size)
 {
-    SLN_ram_memcpy(data, (void *)(FlexSPI_AMBA_BASE + address), size);
+    SLN_ram_memcpy(data, (void *)sln_flash_ops_read_address(address), size);
 
     return kStatus_Success;
 }
 
 uint32_t SLN_Flash_Get_Read_Address(uint32_t address)
 {
-    return FlexSPI_AMBA_BASE + address;
+    return sln_flash_ops_read_address(address);
 }
@@ -10,9 +10,30 @@
 #ifndef _SLN_FLASH_H_
 #define _SLN_FLASH_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "fsl_common.h"
 
+/*! @brief Returned by SLN_Erase_Sector_Step while the erase is not finished */
+#define kStatus_SLN_Flash_EraseSuspended MAKE_STATUS(kStatusGroup_ApplicationRangeStart, 0)
+
+/*! @brief Set to 1 to count the page programs needing a bit set back to 1, see SLN_Flash_Get_Nor_Violations */
+#ifndef SLN_FLASH_CHECK_NOR
+#define SLN_FLASH_CHECK_NOR 0
+#endif
+
+/*! @brief Longest sector erase of the flash, waited for when a step fails to leave the flash idle */
+#ifndef SLN_FLASH_ERASE_MAX_MS
+#define SLN_FLASH_ERASE_MAX_MS (3000U)
+#endif
+
+/*! @brief Sector erase run in steps by SLN_Erase_Sector_Step */
+typedef struct _sln_flash_erase
+{
+    uint32_t address; /*!< address: The offset of the sector from the start of the flash */
+    bool started;     /*!< started: The erase was started and is suspended between the steps */
+} sln_flash_erase_t;
+
 #ifdef __REDLIB__
 size_t safe_strlen(const char *ptr, size_t max);
 #else
@@ -93,6 +114,40 @@ status_t SLN_Write_Flash_Page(uint32_t address, uint8_t *data, uint32_t len);
  */
 status_t SLN_Erase_Sector(uint32_t address);
 
+/*!
+ * @brief Run a sector erase for up to budgetUs with the IRQs off, then suspend it
+ *     The IRQs stay enabled between the steps, while the flash can be read again.
+ *     No other erase can be started before this one is finished.
+ *
+ * @param erase The erase to run, address set and started false for the first step
+ * @param budgetUs Time to let the erase run during this step, in microseconds
+ *
+ * @returns kStatus_Success once the sector is erased, kStatus_SLN_Flash_EraseSuspended if another step
+ *     is needed, or an error; after an error the erase is resumed and waited for, up to
+ *     SLN_FLASH_ERASE_MAX_MS, so the flash is not left erasing or suspended
+ */
+status_t SLN_Erase_Sector_Step(sln_flash_erase_t *erase, uint32_t budgetUs);
+
+/*!
+ * @brief Get the longest time the IRQs were disabled by a flash operation since the last reset
+ *
+ * @returns Time in microseconds
+ */
+uint32_t SLN_Flash_Get_Max_Irq_Off_Us(void);
+
+/*!
+ * @brief Restart the measure of the longest time the IRQs were disabled
+ */
+void SLN_Flash_Reset_Max_Irq_Off(void);
+
+/*!
+ * @brief Get the number of page programs that wanted a bit at 0 in the flash set to 1
+ *     NOR flash only clears bits, such a page must be erased first. Counted if SLN_FLASH_CHECK_NOR is 1.
+ *
+ * @returns Number of violations since boot
+ */
+uint32_t SLN_Flash_Get_Nor_Violations(void);
+
 /*!
  * @brief Write a buffer to Flash, buffer is written page by page [WARNING: erases sector before write]
  *
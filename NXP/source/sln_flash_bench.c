@@ -0,0 +1,172 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#if defined(SLN_FLASH_SIM)
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+#include "sln_flash_bench.h"
+#include "sln_flash_mgmt.h"
+
+static uint8_t s_data[SLN_FLASH_BENCH_MAX_SIZE];
+static uint8_t s_read[SLN_FLASH_BENCH_MAX_SIZE];
+
+static const char *const s_ops[] = {"Save", "Update", "Read", "ReadDataPtr"};
+
+static int32_t bench_save(const char *name, uint32_t size)
+{
+    int32_t ret = SLN_FLASH_MGMT_Save(name, s_data, size);
+
+    // Same recovery as the users of the file system when the sector is full
+    if ((SLN_FLASH_MGMT_EOVERFLOW == ret) || (SLN_FLASH_MGMT_EOVERFLOW2 == ret))
+    {
+        ret = SLN_FLASH_MGMT_Erase(name);
+
+        if (SLN_FLASH_MGMT_OK == ret)
+        {
+            ret = SLN_FLASH_MGMT_Save(name, s_data, size);
+        }
+    }
+
+    return ret;
+}
+
+static int32_t bench_call(const char *name, const char *op, uint32_t size)
+{
+    const uint8_t *ptr = NULL;
+    uint32_t len       = size;
+
+    if (0 == strcmp(op, "Save"))
+    {
+        return bench_save(name, size);
+    }
+
+    if (0 == strcmp(op, "Update"))
+    {
+        return SLN_FLASH_MGMT_Update(name, s_data, &len);
+    }
+
+    if (0 == strcmp(op, "Read"))
+    {
+        return SLN_FLASH_MGMT_Read(name, s_read, &len);
+    }
+
+    if (0 == strcmp(op, "ReadDataPtr"))
+    {
+        return SLN_FLASH_MGMT_ReadDataPtr(name, &ptr, &len);
+    }
+
+    return SLN_FLASH_MGMT_EINVAL;
+}
+
+int32_t SLN_FLASH_BENCH_RunOp(const char *name, const char *op, uint32_t size, sln_flash_bench_result_t *result)
+{
+    sln_flash_sim_stats_t before = {0};
+    sln_flash_sim_stats_t after  = {0};
+    uint64_t totalUs             = 0;
+    uint64_t start               = 0;
+    uint32_t callUs              = 0;
+    int32_t ret                  = SLN_FLASH_MGMT_OK;
+
+    if (NULL == result)
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    memset(result, 0, sizeof(sln_flash_bench_result_t));
+    result->op   = op;
+    result->size = size;
+
+    if ((NULL == name) || (NULL == op) || (0 == size) || (size > SLN_FLASH_BENCH_MAX_SIZE))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    // Start from an empty file, holding the data for the operations that need one
+    SLN_FLASH_MGMT_Erase(name);
+    memset(s_data, 0xFF, size);
+
+    if (0 != strcmp(op, "Save"))
+    {
+        ret = bench_save(name, size);
+    }
+
+    SLN_FLASH_SIM_GetStats(&before);
+
+    for (uint32_t iter = 0; (SLN_FLASH_MGMT_OK == ret) && (iter < SLN_FLASH_BENCH_ITERATIONS); iter++)
+    {
+        // New content each time, as a real save; only clearing bits, as an Update in place must on the NOR flash
+        s_data[iter % size] &= (uint8_t)~(1U << (iter % 8U));
+
+        start  = SLN_FLASH_SIM_GetTimeUs();
+        ret    = bench_call(name, op, size);
+        callUs = (uint32_t)(SLN_FLASH_SIM_GetTimeUs() - start);
+
+        if (SLN_FLASH_MGMT_OK == ret)
+        {
+            totalUs += callUs;
+            result->calls++;
+            result->maxUs = (callUs > result->maxUs) ? callUs : result->maxUs;
+        }
+    }
+
+    SLN_FLASH_SIM_GetStats(&after);
+
+    result->erases = after.erases - before.erases;
+
+    if (0 != result->calls)
+    {
+        result->avgUs     = (uint32_t)(totalUs / result->calls);
+        result->opsPerSec = (0 != totalUs) ? (uint32_t)((result->calls * 1000000ULL) / totalUs) : 0;
+        result->writeAmpX100 =
+            (uint32_t)(((after.bytesProgrammed - before.bytesProgrammed) * 100U) / ((uint64_t)result->calls * size));
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_BENCH_Run(const char *name)
+{
+    const uint32_t sizes[] = SLN_FLASH_BENCH_SIZES;
+    sln_flash_bench_result_t result;
+    int32_t status = SLN_FLASH_MGMT_OK;
+    int32_t ret    = SLN_FLASH_MGMT_OK;
+
+    configPRINTF(("Flash benchmarks on %s, %d calls each\r\n", name, SLN_FLASH_BENCH_ITERATIONS));
+    configPRINTF(("%-12s %6s %8s %8s %8s %6s %6s\r\n", "op", "size", "ops/s", "avg us", "max us", "erases", "wa"));
+
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(sizes); idx++)
+    {
+        for (uint32_t op = 0; op < ARRAY_SIZE(s_ops); op++)
+        {
+            ret = SLN_FLASH_BENCH_RunOp(name, s_ops[op], sizes[idx], &result);
+
+            configPRINTF(("%-12s %6d %8d %8d %8d %6d %3d.%02d\r\n", result.op, result.size, result.opsPerSec,
+                          result.avgUs, result.maxUs, result.erases, result.writeAmpX100 / 100,
+                          result.writeAmpX100 % 100));
+
+            if (SLN_FLASH_MGMT_OK != ret)
+            {
+                configPRINTF(("[WARNING] %s of %d bytes stopped after %d calls, error %d\r\n", s_ops[op], sizes[idx],
+                              result.calls, ret));
+
+                if (SLN_FLASH_MGMT_OK == status)
+                {
+                    status = ret;
+                }
+            }
+        }
+    }
+
+    return status;
+}
+
+#endif /* SLN_FLASH_SIM */
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_FLASH_BENCH_
+#define _SLN_FLASH_BENCH_
+
+/*!
+ * SLN Flash Benchmarks
+ *
+ * Benchmarks of the file system run on the flash simulator, see sln_flash_sim.h. For each file
+ * size, Save, Update, Read and ReadDataPtr are timed and the bytes programmed in the flash are
+ * compared with the bytes of the files to give the write amplification.
+ */
+
+#include <stdint.h>
+#include "sln_flash_sim.h"
+
+/*! @brief Calls of each operation per file size */
+#ifndef SLN_FLASH_BENCH_ITERATIONS
+#define SLN_FLASH_BENCH_ITERATIONS (50U)
+#endif
+
+/*! @brief File sizes benchmarked, in bytes */
+#ifndef SLN_FLASH_BENCH_SIZES
+#define SLN_FLASH_BENCH_SIZES \
+    {                         \
+        64, 512, 4096, 16384  \
+    }
+#endif
+
+/*! @brief Largest file size benchmarked */
+#ifndef SLN_FLASH_BENCH_MAX_SIZE
+#define SLN_FLASH_BENCH_MAX_SIZE (16384U)
+#endif
+
+/*! @brief Results of one operation for one file size */
+typedef struct _sln_flash_bench_result
+{
+    const char *op;        /*!< op: Name of the operation. */
+    uint32_t size;         /*!< size: File size. */
+    uint32_t calls;        /*!< calls: Calls done, each failure stops the operation. */
+    uint32_t opsPerSec;    /*!< opsPerSec: Calls per second. */
+    uint32_t avgUs;        /*!< avgUs: Average time of a call. */
+    uint32_t maxUs;        /*!< maxUs: Longest call. */
+    uint32_t erases;       /*!< erases: Sectors erased by the calls. */
+    uint32_t writeAmpX100; /*!< writeAmpX100: Bytes programmed per byte of file, times 100. */
+} sln_flash_bench_result_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Runs the benchmarks on a file and prints the results
+ *
+ * The file is erased and rewritten; the flash management must be initialized.
+ *
+ * @param name Plain file of the file table used, not holding data to keep; Update programs over the
+ *             file in place, which an encrypted file does not support
+ *
+ * @returns SLN_FLASH_MGMT_OK or the error of the first operation that failed
+ */
+int32_t SLN_FLASH_BENCH_Run(const char *name);
+
+/*!
+ * @brief Benchmarks one operation
+ *
+ * @param name File used, see SLN_FLASH_BENCH_Run
+ * @param op "Save", "Update", "Read" or "ReadDataPtr"
+ * @param size File size
+ * @param result Filled with the results
+ *
+ * @returns SLN_FLASH_MGMT_OK or the error of the call that failed
+ */
+int32_t SLN_FLASH_BENCH_RunOp(const char *name, const char *op, uint32_t size, sln_flash_bench_result_t *result);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_FLASH_BENCH_ */
@@ -0,0 +1,988 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "fsl_common.h"
+#include "sln_flash.h"
+#include "sln_flash_kvs.h"
+
+#define KVS_SECTOR_MAGIC (0x5353564BUL) /* "KVSS" */
+#define KVS_RECORD_MAGIC (0x5253564BUL) /* "KVSR" */
+#define KVS_COMMIT_MAGIC (0x4353564BUL) /* "KVSC" */
+#define KVS_ERASED_WORD  (0xFFFFFFFFUL)
+
+#define KVS_FLAG_DELETED (0x0001U)
+#define KVS_FLAG_DELTA   (0x0002U)
+
+/* No sector holds the head of the log */
+#define KVS_NO_SECTOR (SLN_FLASH_KVS_SECTOR_COUNT)
+
+#define KVS_SECTOR_ADDR(idx) SLN_FLASH_MGMT_FILE_ADDR((SLN_FLASH_KVS_FIRST_SECTOR + (idx)))
+#define KVS_ALIGN_UP(x)      (((x) + SLN_FLASH_KVS_ALIGN - 1) & ~(SLN_FLASH_KVS_ALIGN - 1))
+#define KVS_RECORD_SIZE(len) (sizeof(kvs_record_t) + KVS_ALIGN_UP(len) + sizeof(kvs_commit_t))
+
+/* Each half of the sector header is programmed on its own */
+#define KVS_SECTOR_HALF (sizeof(kvs_sector_header_t) / 2)
+
+/*!
+ * @brief Header at the start of each sector. The two halves are programmed separately:
+ * the first one right after the erase, the second one when the log moves into the sector.
+ */
+typedef struct _kvs_sector_header
+{
+    uint32_t magic;        /*!< magic: KVS_SECTOR_MAGIC once the sector is erased and ready. */
+    uint32_t eraseCount;   /*!< eraseCount: Number of times the sector was erased. */
+    uint32_t reserved[2];  /*!< reserved: Left erased. */
+    uint32_t seq;          /*!< seq: Sequence number of the sector in the log, erased if the sector is free. */
+    uint32_t seqCheck;     /*!< seqCheck: Bitwise inverse of seq. */
+    uint32_t reserved2[2]; /*!< reserved2: Left erased. */
+} kvs_sector_header_t;
+
+/*! @brief Header of a record, followed by the value and the commit block */
+typedef struct _kvs_record
+{
+    uint32_t magic;  /*!< magic: KVS_RECORD_MAGIC. */
+    uint16_t key;    /*!< key: Key of the record. */
+    uint16_t flags;  /*!< flags: KVS_FLAG_DELETED for a removal. */
+    uint32_t length; /*!< length: Length in bytes of the value. */
+    uint32_t seq;    /*!< seq: Sequence number of the record, the highest one of a key is the current value. */
+} kvs_record_t;
+
+/*! @brief Commit block of a record, written after the value */
+typedef struct _kvs_commit
+{
+    uint32_t magic;    /*!< magic: KVS_COMMIT_MAGIC. */
+    uint32_t seq;      /*!< seq: Copy of the record sequence number. */
+    uint32_t seqCheck; /*!< seqCheck: Bitwise inverse of seq. */
+    uint32_t reserved; /*!< reserved: Left erased. */
+} kvs_commit_t;
+
+/*! @brief Head of the value of a delta record, followed by the new bytes of the range */
+typedef struct _kvs_delta
+{
+    uint32_t baseAddr; /*!< baseAddr: Flash address of the full value the delta applies to. */
+    uint32_t prevAddr; /*!< prevAddr: Flash address of the value of the previous delta record, 0 if none. */
+    uint32_t count;    /*!< count: Number of delta records over the full value, this one included. */
+    uint16_t offset;   /*!< offset: Offset in bytes of the range in the value. */
+    uint16_t length;   /*!< length: Length in bytes of the range. */
+} kvs_delta_t;
+
+/*! @brief RAM state of a sector */
+typedef struct _kvs_sector
+{
+    uint32_t seq;        /*!< seq: Sequence number of the sector in the log, 0 if not in the log. */
+    uint32_t eraseCount; /*!< eraseCount: Number of times the sector was erased. */
+    uint32_t used;       /*!< used: Offset of the first free byte. */
+    bool ready;          /*!< ready: Sector erased with its header, can be used without erase. */
+} kvs_sector_t;
+
+/*! @brief RAM state of a key */
+typedef struct _kvs_key
+{
+    uint32_t valueAddr;  /*!< valueAddr: Flash address of the current full value, 0 if none. */
+    uint32_t length;     /*!< length: Length in bytes of the current value. */
+    uint32_t seq;        /*!< seq: Sequence number of the latest record, 0 if none. */
+    uint32_t sector;     /*!< sector: Sector of the latest record. */
+    uint32_t deltaAddr;  /*!< deltaAddr: Flash address of the value of the latest delta record, 0 if none. */
+    uint32_t deltaCount; /*!< deltaCount: Number of delta records over the full value. */
+} kvs_key_t;
+
+static kvs_sector_t s_kvsSectors[SLN_FLASH_KVS_SECTOR_COUNT];
+static kvs_key_t s_kvsKeys[SLN_FLASH_KVS_MAX_KEYS];
+static uint32_t s_kvsHead = KVS_NO_SECTOR;
+static uint32_t s_kvsSeq  = 0;
+
+static sln_flash_kvs_erase_t s_kvsErase = NULL;
+static sln_flash_kvs_stats_t s_kvsStats;
+
+/* Page being assembled; records are packed so a page is programmed once per record at most */
+static uint8_t s_kvsPage[FLASH_PAGE_SIZE];
+static uint32_t s_kvsWriteAddr = 0;
+static bool s_kvsPageDirty     = false;
+
+/*! @brief Program the page being assembled and start a blank one */
+static int32_t kvs_program_page(uint32_t pageAddr)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if (s_kvsPageDirty)
+    {
+        // Bytes left to 0xFF don't change what is already programmed in the page
+        if (kStatus_Success != SLN_Write_Flash_Page(pageAddr, s_kvsPage, FLASH_PAGE_SIZE))
+        {
+            ret = SLN_FLASH_MGMT_EIO;
+        }
+    }
+
+    memset(s_kvsPage, 0xFF, sizeof(s_kvsPage));
+    s_kvsPageDirty = false;
+
+    return ret;
+}
+
+/*! @brief Start writing at a flash address */
+static void kvs_stream_start(uint32_t address)
+{
+    s_kvsWriteAddr = address;
+    s_kvsPageDirty = false;
+    memset(s_kvsPage, 0xFF, sizeof(s_kvsPage));
+}
+
+/*! @brief Write bytes at the current address, pages are programmed as they get full */
+static int32_t kvs_stream_write(const uint8_t *src, uint32_t len)
+{
+    int32_t ret     = SLN_FLASH_MGMT_OK;
+    uint32_t offset = 0;
+    uint32_t chunk  = 0;
+
+    while ((len > 0) && (SLN_FLASH_MGMT_OK == ret))
+    {
+        offset = s_kvsWriteAddr % FLASH_PAGE_SIZE;
+        chunk  = MIN(len, FLASH_PAGE_SIZE - offset);
+
+        memcpy(&s_kvsPage[offset], src, chunk);
+        s_kvsPageDirty = true;
+
+        if ((offset + chunk) == FLASH_PAGE_SIZE)
+        {
+            ret = kvs_program_page(s_kvsWriteAddr - offset);
+        }
+
+        s_kvsWriteAddr += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+
+    return ret;
+}
+
+/*! @brief Program the last partial page, if any */
+static int32_t kvs_stream_flush(void)
+{
+    return kvs_program_page(s_kvsWriteAddr - (s_kvsWriteAddr % FLASH_PAGE_SIZE));
+}
+
+/*! @brief Record the current value of a key, if the record is newer than the known one */
+static void kvs_index_record(uint32_t sector, uint32_t offset, const kvs_record_t *record)
+{
+    kvs_key_t *entry = NULL;
+
+    if (SLN_FLASH_KVS_MAX_KEYS <= record->key)
+    {
+        // Written by a build with a bigger file table, ignore it
+        return;
+    }
+
+    entry = &s_kvsKeys[record->key];
+
+    if ((0 != entry->seq) && (entry->seq > record->seq))
+    {
+        return;
+    }
+
+    entry->seq        = record->seq;
+    entry->sector     = sector;
+    entry->deltaAddr  = 0;
+    entry->deltaCount = 0;
+
+    if (record->flags & KVS_FLAG_DELETED)
+    {
+        entry->valueAddr = 0;
+        entry->length    = 0;
+    }
+    else if (record->flags & KVS_FLAG_DELTA)
+    {
+        kvs_delta_t delta       = {0};
+        kvs_record_t baseRecord = {0};
+
+        // The full value stays where the delta found it: compaction folds the deltas before moving it
+        entry->deltaAddr = KVS_SECTOR_ADDR(sector) + offset + sizeof(kvs_record_t);
+        SLN_Read_Flash_At_Address(entry->deltaAddr, (uint8_t *)&delta, sizeof(kvs_delta_t));
+        SLN_Read_Flash_At_Address(delta.baseAddr - sizeof(kvs_record_t), (uint8_t *)&baseRecord,
+                                  sizeof(kvs_record_t));
+
+        entry->valueAddr  = delta.baseAddr;
+        entry->length     = baseRecord.length;
+        entry->deltaCount = delta.count;
+    }
+    else
+    {
+        entry->valueAddr = KVS_SECTOR_ADDR(sector) + offset + sizeof(kvs_record_t);
+        entry->length    = record->length;
+    }
+}
+
+/*!
+ * @brief Read the record at an offset of a sector.
+ *
+ * @returns Offset of the next record; offset itself if there is no record, SECTOR_SIZE if the
+ * rest of the sector can't be used (torn header)
+ */
+static uint32_t kvs_read_record(uint32_t sector, uint32_t offset, kvs_record_t *record, bool *committed)
+{
+    uint32_t base       = KVS_SECTOR_ADDR(sector);
+    kvs_commit_t commit = {0};
+
+    *committed = false;
+
+    if ((offset + KVS_RECORD_SIZE(0)) > SECTOR_SIZE)
+    {
+        return SECTOR_SIZE;
+    }
+
+    SLN_Read_Flash_At_Address(base + offset, (uint8_t *)record, sizeof(kvs_record_t));
+
+    if ((KVS_ERASED_WORD == record->magic) && (0xFFFFU == record->key) && (0xFFFFU == record->flags) &&
+        (KVS_ERASED_WORD == record->length) && (KVS_ERASED_WORD == record->seq))
+    {
+        // Free space starts here
+        return offset;
+    }
+
+    if ((KVS_RECORD_MAGIC != record->magic) || (SLN_FLASH_KVS_MAX_VALUE < record->length) ||
+        ((offset + KVS_RECORD_SIZE(record->length)) > SECTOR_SIZE))
+    {
+        // Power cut while the header was written; nothing after it can be trusted
+        return SECTOR_SIZE;
+    }
+
+    SLN_Read_Flash_At_Address(base + offset + sizeof(kvs_record_t) + KVS_ALIGN_UP(record->length), (uint8_t *)&commit,
+                              sizeof(kvs_commit_t));
+
+    *committed = (KVS_COMMIT_MAGIC == commit.magic) && (record->seq == commit.seq) && (~record->seq == commit.seqCheck);
+
+    return offset + KVS_RECORD_SIZE(record->length);
+}
+
+/*! @brief Rebuild the RAM state of a sector and of the keys it holds */
+static void kvs_scan_sector(uint32_t sector)
+{
+    kvs_sector_header_t header = {0};
+    kvs_record_t record        = {0};
+    bool committed             = false;
+    uint32_t offset            = sizeof(kvs_sector_header_t);
+    uint32_t next              = 0;
+
+    SLN_Read_Flash_At_Address(KVS_SECTOR_ADDR(sector), (uint8_t *)&header, sizeof(kvs_sector_header_t));
+
+    if (KVS_SECTOR_MAGIC != header.magic)
+    {
+        // Never used or erase interrupted, to be erased before use
+        return;
+    }
+
+    s_kvsSectors[sector].eraseCount = header.eraseCount;
+    s_kvsSectors[sector].used       = sizeof(kvs_sector_header_t);
+
+    if ((KVS_ERASED_WORD == header.seq) && (KVS_ERASED_WORD == header.seqCheck))
+    {
+        s_kvsSectors[sector].ready = true;
+        return;
+    }
+
+    if (~header.seq != header.seqCheck)
+    {
+        return;
+    }
+
+    s_kvsSectors[sector].seq = header.seq;
+    s_kvsSeq                 = MAX(s_kvsSeq, header.seq);
+
+    while (offset < SECTOR_SIZE)
+    {
+        next = kvs_read_record(sector, offset, &record, &committed);
+
+        if (next == offset)
+        {
+            break;
+        }
+
+        if (committed)
+        {
+            kvs_index_record(sector, offset, &record);
+            s_kvsSeq = MAX(s_kvsSeq, record.seq);
+        }
+
+        offset = next;
+    }
+
+    s_kvsSectors[sector].used = offset;
+}
+
+/*! @brief Erase a sector and write the first half of its header */
+static int32_t kvs_erase_sector(uint32_t sector)
+{
+    int32_t ret                = SLN_FLASH_MGMT_OK;
+    kvs_sector_header_t header = {0};
+
+    if (kStatus_Success != s_kvsErase(KVS_SECTOR_ADDR(sector)))
+    {
+        return SLN_FLASH_MGMT_EIO;
+    }
+
+    s_kvsStats.erases++;
+
+    s_kvsSectors[sector].seq = 0;
+    s_kvsSectors[sector].eraseCount++;
+    s_kvsSectors[sector].used  = sizeof(kvs_sector_header_t);
+    s_kvsSectors[sector].ready = false;
+
+    memset(&header, 0xFF, sizeof(kvs_sector_header_t));
+    header.magic      = KVS_SECTOR_MAGIC;
+    header.eraseCount = s_kvsSectors[sector].eraseCount;
+
+    kvs_stream_start(KVS_SECTOR_ADDR(sector));
+    ret = kvs_stream_write((const uint8_t *)&header, KVS_SECTOR_HALF);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_stream_flush();
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_kvsSectors[sector].ready = true;
+    }
+
+    return ret;
+}
+
+/*! @brief Move the head of the log to the least erased sector not in the log */
+static int32_t kvs_open_sector(void)
+{
+    int32_t ret                = SLN_FLASH_MGMT_OK;
+    uint32_t sector            = KVS_NO_SECTOR;
+    kvs_sector_header_t header = {0};
+
+    for (uint32_t idx = 0; idx < SLN_FLASH_KVS_SECTOR_COUNT; idx++)
+    {
+        if ((0 == s_kvsSectors[idx].seq) &&
+            ((KVS_NO_SECTOR == sector) || (s_kvsSectors[idx].eraseCount < s_kvsSectors[sector].eraseCount)))
+        {
+            sector = idx;
+        }
+    }
+
+    if (KVS_NO_SECTOR == sector)
+    {
+        return SLN_FLASH_MGMT_EOVERFLOW;
+    }
+
+    if (!s_kvsSectors[sector].ready)
+    {
+        ret = kvs_erase_sector(sector);
+
+        if (SLN_FLASH_MGMT_OK != ret)
+        {
+            return ret;
+        }
+    }
+
+    memset(&header, 0xFF, sizeof(kvs_sector_header_t));
+    header.seq      = ++s_kvsSeq;
+    header.seqCheck = ~header.seq;
+
+    kvs_stream_start(KVS_SECTOR_ADDR(sector) + KVS_SECTOR_HALF);
+    ret = kvs_stream_write((const uint8_t *)&header.seq, KVS_SECTOR_HALF);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_stream_flush();
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_kvsSectors[sector].seq   = header.seq;
+        s_kvsSectors[sector].ready = false;
+        s_kvsHead                  = sector;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Start a record at the head of the log and write its header, the value is then written with
+ * kvs_stream_write. The caller makes sure it fits.
+ */
+static int32_t kvs_start_record(kvs_record_t *record, uint16_t key, uint16_t flags, uint32_t length, uint32_t *offset)
+{
+    *offset = s_kvsSectors[s_kvsHead].used;
+
+    record->magic  = KVS_RECORD_MAGIC;
+    record->key    = key;
+    record->flags  = flags;
+    record->length = length;
+    record->seq    = ++s_kvsSeq;
+
+    // From here the space is used, even if the write fails
+    s_kvsSectors[s_kvsHead].used += KVS_RECORD_SIZE(record->length);
+    s_kvsStats.flashBytes += KVS_RECORD_SIZE(record->length);
+
+    kvs_stream_start(KVS_SECTOR_ADDR(s_kvsHead) + *offset);
+
+    return kvs_stream_write((const uint8_t *)record, sizeof(kvs_record_t));
+}
+
+/*! @brief Commit a record started by kvs_start_record at offset of the head sector, once its value is written */
+static int32_t kvs_commit_record(const kvs_record_t *record, uint32_t offset)
+{
+    int32_t ret         = SLN_FLASH_MGMT_OK;
+    uint32_t address    = KVS_SECTOR_ADDR(s_kvsHead) + offset;
+    kvs_commit_t commit = {0};
+
+    commit.magic    = KVS_COMMIT_MAGIC;
+    commit.seq      = record->seq;
+    commit.seqCheck = ~record->seq;
+    commit.reserved = KVS_ERASED_WORD;
+
+    ret = kvs_stream_flush();
+
+    // The commit block is programmed only once the whole value is in flash
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        kvs_stream_start(address + sizeof(kvs_record_t) + KVS_ALIGN_UP(record->length));
+        ret = kvs_stream_write((const uint8_t *)&commit, sizeof(kvs_commit_t));
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_stream_flush();
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        kvs_index_record(s_kvsHead, offset, record);
+    }
+
+    return ret;
+}
+
+/*! @brief Append a record at the head of the log; the caller makes sure it fits */
+static int32_t kvs_append_record(
+    uint16_t key, uint16_t flags, const uint8_t *prefix, uint32_t prefixLen, const uint8_t *data, uint32_t dataLen)
+{
+    int32_t ret         = SLN_FLASH_MGMT_OK;
+    kvs_record_t record = {0};
+    uint32_t offset     = 0;
+
+    ret = kvs_start_record(&record, key, flags, prefixLen + dataLen, &offset);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_stream_write(prefix, prefixLen);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_stream_write(data, dataLen);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_commit_record(&record, offset);
+    }
+
+    return ret;
+}
+
+/*! @brief Read a range of the current value of a key: the full value with its delta records applied in order */
+static void kvs_read_value(uint16_t key, uint32_t offset, uint8_t *data, uint32_t len)
+{
+    kvs_key_t *entry                              = &s_kvsKeys[key];
+    uint32_t deltaAddrs[SLN_FLASH_KVS_MAX_DELTAS] = {0};
+    uint32_t deltaCount                           = 0;
+    uint32_t deltaAddr                            = entry->deltaAddr;
+    kvs_delta_t delta                             = {0};
+    uint32_t start                                = 0;
+    uint32_t end                                  = 0;
+
+    SLN_Read_Flash_At_Address(entry->valueAddr + offset, data, len);
+
+    // The chain goes from the latest delta back to the first one
+    while ((0 != deltaAddr) && (deltaCount < SLN_FLASH_KVS_MAX_DELTAS))
+    {
+        deltaAddrs[deltaCount++] = deltaAddr;
+        SLN_Read_Flash_At_Address(deltaAddr, (uint8_t *)&delta, sizeof(kvs_delta_t));
+        deltaAddr = delta.prevAddr;
+    }
+
+    while (deltaCount > 0)
+    {
+        deltaAddr = deltaAddrs[--deltaCount];
+        SLN_Read_Flash_At_Address(deltaAddr, (uint8_t *)&delta, sizeof(kvs_delta_t));
+
+        start = MAX(offset, delta.offset);
+        end   = MIN(offset + len, (uint32_t)delta.offset + delta.length);
+
+        if (start < end)
+        {
+            SLN_Read_Flash_At_Address(deltaAddr + sizeof(kvs_delta_t) + start - delta.offset, &data[start - offset],
+                                      end - start);
+        }
+    }
+}
+
+/*!
+ * @brief Write the current value of a key as a new full record, with a range changed on the way.
+ * The caller makes sure it fits.
+ */
+static int32_t kvs_fold_record(uint16_t key, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret                            = SLN_FLASH_MGMT_OK;
+    kvs_key_t *entry                       = &s_kvsKeys[key];
+    kvs_record_t record                    = {0};
+    uint8_t chunk[4 * SLN_FLASH_KVS_ALIGN] = {0};
+    uint32_t chunkLen                      = 0;
+    uint32_t start                         = 0;
+    uint32_t end                           = 0;
+    uint32_t recordOffset                  = 0;
+
+    ret = kvs_start_record(&record, key, 0, entry->length, &recordOffset);
+
+    for (uint32_t pos = 0; (SLN_FLASH_MGMT_OK == ret) && (pos < record.length); pos += chunkLen)
+    {
+        chunkLen = MIN(sizeof(chunk), record.length - pos);
+        kvs_read_value(key, pos, chunk, chunkLen);
+
+        start = MAX(pos, offset);
+        end   = MIN(pos + chunkLen, offset + len);
+
+        if (start < end)
+        {
+            memcpy(&chunk[start - pos], &data[start - offset], end - start);
+        }
+
+        ret = kvs_stream_write(chunk, chunkLen);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_commit_record(&record, recordOffset);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_kvsStats.folds++;
+    }
+
+    return ret;
+}
+
+/*! @brief Check if the full value or a delta record of a key is in a sector */
+static bool kvs_deltas_in_sector(uint16_t key, uint32_t sector)
+{
+    kvs_key_t *entry   = &s_kvsKeys[key];
+    uint32_t start     = KVS_SECTOR_ADDR(sector);
+    uint32_t deltaAddr = entry->deltaAddr;
+    kvs_delta_t delta  = {0};
+    bool inSector      = (entry->valueAddr >= start) && (entry->valueAddr < start + SECTOR_SIZE);
+
+    for (uint32_t count = 0; !inSector && (0 != deltaAddr) && (count < SLN_FLASH_KVS_MAX_DELTAS); count++)
+    {
+        inSector = (deltaAddr >= start) && (deltaAddr < start + SECTOR_SIZE);
+        SLN_Read_Flash_At_Address(deltaAddr, (uint8_t *)&delta, sizeof(kvs_delta_t));
+        deltaAddr = delta.prevAddr;
+    }
+
+    return inSector;
+}
+
+/*! @brief Copy the live records of a sector to the head of the log and erase it */
+static int32_t kvs_compact_sector(uint32_t sector)
+{
+    int32_t ret         = SLN_FLASH_MGMT_OK;
+    kvs_record_t record = {0};
+    bool committed      = false;
+    uint32_t offset     = sizeof(kvs_sector_header_t);
+    uint32_t next       = 0;
+    uint32_t valueAddr  = 0;
+
+    // A delta record only applies over its full value, neither can move on its own: the key is folded instead
+    for (uint16_t key = 0; (key < SLN_FLASH_KVS_MAX_KEYS) && (SLN_FLASH_MGMT_OK == ret); key++)
+    {
+        if ((0 != s_kvsKeys[key].deltaCount) && kvs_deltas_in_sector(key, sector))
+        {
+            if ((s_kvsSectors[s_kvsHead].used + KVS_RECORD_SIZE(s_kvsKeys[key].length)) > SECTOR_SIZE)
+            {
+                ret = SLN_FLASH_MGMT_EOVERFLOW;
+            }
+            else
+            {
+                ret = kvs_fold_record(key, 0, NULL, 0);
+            }
+        }
+    }
+
+    while ((offset < s_kvsSectors[sector].used) && (SLN_FLASH_MGMT_OK == ret))
+    {
+        next = kvs_read_record(sector, offset, &record, &committed);
+
+        if (next == offset)
+        {
+            break;
+        }
+
+        valueAddr = KVS_SECTOR_ADDR(sector) + offset + sizeof(kvs_record_t);
+
+        // Removals are dropped: this is the oldest sector, older values of the key are in it too
+        if (committed && !(record.flags & KVS_FLAG_DELTA) && (SLN_FLASH_KVS_MAX_KEYS > record.key) &&
+            (s_kvsKeys[record.key].valueAddr == valueAddr))
+        {
+            if ((s_kvsSectors[s_kvsHead].used + KVS_RECORD_SIZE(record.length)) > SECTOR_SIZE)
+            {
+                ret = SLN_FLASH_MGMT_EOVERFLOW;
+            }
+            else
+            {
+                ret = kvs_append_record(record.key, 0, NULL, 0,
+                                        (const uint8_t *)SLN_Flash_Get_Read_Address(valueAddr), record.length);
+            }
+        }
+
+        offset = next;
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_erase_sector(sector);
+        s_kvsStats.compactions++;
+    }
+
+    return ret;
+}
+
+/*! @brief Compact the oldest sectors until one is free for the next move of the log head */
+static int32_t kvs_reserve_sector(void)
+{
+    int32_t ret     = SLN_FLASH_MGMT_OK;
+    uint32_t oldest = KVS_NO_SECTOR;
+    bool available  = false;
+
+    while (SLN_FLASH_MGMT_OK == ret)
+    {
+        available = false;
+        oldest    = KVS_NO_SECTOR;
+
+        for (uint32_t idx = 0; idx < SLN_FLASH_KVS_SECTOR_COUNT; idx++)
+        {
+            if (0 == s_kvsSectors[idx].seq)
+            {
+                available = true;
+            }
+            else if ((idx != s_kvsHead) &&
+                     ((KVS_NO_SECTOR == oldest) || (s_kvsSectors[idx].seq < s_kvsSectors[oldest].seq)))
+            {
+                oldest = idx;
+            }
+        }
+
+        if (available || (KVS_NO_SECTOR == oldest))
+        {
+            break;
+        }
+
+        ret = kvs_compact_sector(oldest);
+    }
+
+    return ret;
+}
+
+/*! @brief Make sure a record of size bytes fits at the head of the log */
+static int32_t kvs_make_room(uint32_t size)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if ((KVS_NO_SECTOR != s_kvsHead) && ((s_kvsSectors[s_kvsHead].used + size) <= SECTOR_SIZE))
+    {
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    ret = kvs_open_sector();
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_reserve_sector();
+    }
+
+    if ((SLN_FLASH_MGMT_OK == ret) && ((s_kvsSectors[s_kvsHead].used + size) > SECTOR_SIZE))
+    {
+        // The live records fill the new head
+        ret = SLN_FLASH_MGMT_EOVERFLOW2;
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_KVS_Init(sln_flash_kvs_erase_t eraseSector, uint8_t erase)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if (NULL == eraseSector)
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    s_kvsErase = eraseSector;
+    s_kvsHead  = KVS_NO_SECTOR;
+    s_kvsSeq   = 0;
+
+    memset(s_kvsSectors, 0, sizeof(s_kvsSectors));
+    memset(s_kvsKeys, 0, sizeof(s_kvsKeys));
+    memset(&s_kvsStats, 0, sizeof(s_kvsStats));
+
+    for (uint32_t idx = 0; idx < SLN_FLASH_KVS_SECTOR_COUNT; idx++)
+    {
+        kvs_scan_sector(idx);
+
+        if (erase && (0 != s_kvsSectors[idx].seq))
+        {
+            ret = kvs_erase_sector(idx);
+
+            if (SLN_FLASH_MGMT_OK != ret)
+            {
+                break;
+            }
+        }
+    }
+
+    if (erase)
+    {
+        memset(s_kvsKeys, 0, sizeof(s_kvsKeys));
+    }
+
+    // The head of the log is the newest sector
+    for (uint32_t idx = 0; idx < SLN_FLASH_KVS_SECTOR_COUNT; idx++)
+    {
+        if ((0 != s_kvsSectors[idx].seq) &&
+            ((KVS_NO_SECTOR == s_kvsHead) || (s_kvsSectors[idx].seq > s_kvsSectors[s_kvsHead].seq)))
+        {
+            s_kvsHead = idx;
+        }
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_KVS_Find(uint16_t key, uint32_t *valueAddr, uint32_t *len)
+{
+    if ((SLN_FLASH_KVS_MAX_KEYS <= key) || (NULL == valueAddr) || (NULL == len))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    if (0 == s_kvsKeys[key].valueAddr)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY;
+    }
+
+    *valueAddr = s_kvsKeys[key].valueAddr;
+    *len       = s_kvsKeys[key].length;
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_KVS_Write(uint16_t key,
+                            const uint8_t *prefix,
+                            uint32_t prefixLen,
+                            const uint8_t *data,
+                            uint32_t dataLen,
+                            uint32_t *valueAddr)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if ((NULL == s_kvsErase) || (SLN_FLASH_KVS_MAX_KEYS <= key) || ((NULL == prefix) && (0 != prefixLen)) ||
+        ((NULL == data) && (0 != dataLen)))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    if (SLN_FLASH_KVS_MAX_VALUE < (prefixLen + dataLen))
+    {
+        return SLN_FLASH_MGMT_EOVERFLOW2;
+    }
+
+    ret = kvs_make_room(KVS_RECORD_SIZE(prefixLen + dataLen));
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_append_record(key, 0, prefix, prefixLen, data, dataLen);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_kvsStats.userBytes += prefixLen + dataLen;
+
+        if (NULL != valueAddr)
+        {
+            *valueAddr = s_kvsKeys[key].valueAddr;
+        }
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_KVS_WriteDelta(uint16_t key, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret       = SLN_FLASH_MGMT_OK;
+    kvs_key_t *entry  = NULL;
+    kvs_delta_t delta = {0};
+
+    if ((NULL == s_kvsErase) || (SLN_FLASH_KVS_MAX_KEYS <= key) || (NULL == data) || (0 == len) ||
+        (UINT16_MAX < (offset + len)))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    entry = &s_kvsKeys[key];
+
+    if (0 == entry->valueAddr)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY;
+    }
+
+    if (entry->length < (offset + len))
+    {
+        return SLN_FLASH_MGMT_EINVAL2;
+    }
+
+    if (SLN_FLASH_KVS_MAX_DELTAS <= entry->deltaCount)
+    {
+        // The chain is full, the change goes in a new full value
+        ret = kvs_make_room(KVS_RECORD_SIZE(entry->length));
+
+        if (SLN_FLASH_MGMT_OK == ret)
+        {
+            ret = kvs_fold_record(key, offset, data, len);
+        }
+    }
+    else
+    {
+        ret = kvs_make_room(KVS_RECORD_SIZE(sizeof(kvs_delta_t) + len));
+
+        // Taken after the room is made, a compaction may have folded the key
+        delta.baseAddr = entry->valueAddr;
+        delta.prevAddr = entry->deltaAddr;
+        delta.count    = entry->deltaCount + 1;
+        delta.offset   = (uint16_t)offset;
+        delta.length   = (uint16_t)len;
+
+        if (SLN_FLASH_MGMT_OK == ret)
+        {
+            ret = kvs_append_record(key, KVS_FLAG_DELTA, (const uint8_t *)&delta, sizeof(kvs_delta_t), data, len);
+        }
+
+        if (SLN_FLASH_MGMT_OK == ret)
+        {
+            s_kvsStats.deltas++;
+        }
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_kvsStats.userBytes += len;
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_KVS_Read(uint16_t key, uint32_t offset, uint8_t *data, uint32_t len)
+{
+    if ((SLN_FLASH_KVS_MAX_KEYS <= key) || (NULL == data))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    if (0 == s_kvsKeys[key].valueAddr)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY;
+    }
+
+    if ((offset > s_kvsKeys[key].length) || (len > s_kvsKeys[key].length - offset))
+    {
+        return SLN_FLASH_MGMT_EINVAL2;
+    }
+
+    kvs_read_value(key, offset, data, len);
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_KVS_Fold(uint16_t key, uint32_t *valueAddr)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if ((NULL == s_kvsErase) || (SLN_FLASH_KVS_MAX_KEYS <= key) || (NULL == valueAddr))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    if (0 == s_kvsKeys[key].valueAddr)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY;
+    }
+
+    if (0 != s_kvsKeys[key].deltaCount)
+    {
+        ret = kvs_make_room(KVS_RECORD_SIZE(s_kvsKeys[key].length));
+
+        // A compaction may have folded the key
+        if ((SLN_FLASH_MGMT_OK == ret) && (0 != s_kvsKeys[key].deltaCount))
+        {
+            ret = kvs_fold_record(key, 0, NULL, 0);
+        }
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        *valueAddr = s_kvsKeys[key].valueAddr;
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_KVS_Delete(uint16_t key)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if ((NULL == s_kvsErase) || (SLN_FLASH_KVS_MAX_KEYS <= key))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    if (0 == s_kvsKeys[key].valueAddr)
+    {
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    ret = kvs_make_room(KVS_RECORD_SIZE(0));
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = kvs_append_record(key, KVS_FLAG_DELETED, NULL, 0, NULL, 0);
+    }
+
+    return ret;
+}
+
+void SLN_FLASH_KVS_GetStats(sln_flash_kvs_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        *stats           = s_kvsStats;
+        stats->maxErases = 0;
+        stats->minErases = KVS_ERASED_WORD;
+
+        for (uint32_t idx = 0; idx < SLN_FLASH_KVS_SECTOR_COUNT; idx++)
+        {
+            stats->maxErases = MAX(stats->maxErases, s_kvsSectors[idx].eraseCount);
+            stats->minErases = MIN(stats->minErases, s_kvsSectors[idx].eraseCount);
+        }
+    }
+}
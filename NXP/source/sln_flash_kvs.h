@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_FLASH_KVS_
+#define _SLN_FLASH_KVS_
+
+/*!
+ * SLN Flash Key/Value Store
+ *
+ * Log of records spread over a pool of sectors, used by the flash management for the small files
+ * flagged as logged in the file table, instead of one sector per file.
+ *
+ * Sector Layout:
+ *
+ * Offset   | Usage
+ * ---------|------------------
+ *    0     | Sector Header {magic, erase count}
+ *    16    | Sector Header {sequence}, written when the log moves into the sector
+ *    32    | Record {Header, Value, Commit}
+ *    ...   | Record {Header, Value, Commit}
+ *
+ *  Records are 16 bytes aligned and packed, several records share a flash page.
+ *  A record is valid only once its commit block is written, after its value; a power cut
+ *  during a write leaves the previous record of the key as the current one.
+ *
+ *  A delta record holds only a changed range of the value, applied over the latest full value of
+ *  the key. Up to SLN_FLASH_KVS_MAX_DELTAS of them follow a full value, then the value with all
+ *  its changes is written again as a full record (folded). The deltas are folded as well before
+ *  the full value or one of them is moved by a compaction.
+ *
+ *  The log moves to the least erased free sector when the current one is full. The oldest
+ *  sector is compacted (live records copied to the log head, sector erased) as soon as no
+ *  free sector is left, so one is always available for the next move.
+ */
+
+#include <stdint.h>
+#include "sln_flash_config.h"
+#include "sln_flash_mgmt.h"
+
+/*! @brief First file table index of the sectors used by the store; these entries stay RESERVED in the table */
+#define SLN_FLASH_KVS_FIRST_SECTOR (28U)
+
+/*! @brief Number of sectors used by the store */
+#define SLN_FLASH_KVS_SECTOR_COUNT (4U)
+
+/*! @brief Number of keys, one per file of the file table */
+#define SLN_FLASH_KVS_MAX_KEYS (FICA_FILE_SYS_FILE_COUNT)
+
+/*! @brief Alignment of the records in flash */
+#define SLN_FLASH_KVS_ALIGN (16U)
+
+/*! @brief Biggest value that can be stored */
+#define SLN_FLASH_KVS_MAX_VALUE (SECTOR_SIZE - (4 * SLN_FLASH_KVS_ALIGN))
+
+/*! @brief Number of delta records over a full value before they are folded into a new one */
+#ifndef SLN_FLASH_KVS_MAX_DELTAS
+#define SLN_FLASH_KVS_MAX_DELTAS (8U)
+#endif
+
+/*! @brief Function used to erase a sector of the store */
+typedef int32_t (*sln_flash_kvs_erase_t)(uint32_t address);
+
+/*! @brief Statistics of the store, flashBytes / userBytes is the write amplification */
+typedef struct _sln_flash_kvs_stats
+{
+    uint32_t userBytes;   /*! Bytes of values written by the users */
+    uint32_t flashBytes;  /*! Bytes programmed, including record overhead and compaction copies */
+    uint32_t compactions; /*! Number of sectors compacted */
+    uint32_t deltas;      /*! Number of delta records written */
+    uint32_t folds;       /*! Number of values written again with their delta records */
+    uint32_t erases;      /*! Number of sectors erased */
+    uint32_t maxErases;   /*! Highest erase count of the sectors */
+    uint32_t minErases;   /*! Lowest erase count of the sectors */
+} sln_flash_kvs_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Scan the sectors of the store and build the RAM table of the current records
+ *
+ * The store has no lock of its own, the calls are serialized by the flash management lock.
+ *
+ * @param eraseSector Function used to erase a sector
+ * @param erase Flag to erase all the sectors of the store
+ *
+ * @returns Status of initialization
+ */
+int32_t SLN_FLASH_KVS_Init(sln_flash_kvs_erase_t eraseSector, uint8_t erase);
+
+/*!
+ * @brief Find the current full value of a key; the delta records written since are not in it, see SLN_FLASH_KVS_Fold
+ *
+ * @param key Key to look for
+ * @param valueAddr Flash address of the value
+ * @param len Length in bytes of the value
+ *
+ * @returns SLN_FLASH_MGMT_OK, SLN_FLASH_MGMT_ENOENTRY if the key has no value
+ */
+int32_t SLN_FLASH_KVS_Find(uint16_t key, uint32_t *valueAddr, uint32_t *len);
+
+/*!
+ * @brief Append a new value for a key; the value is the concatenation of prefix and data
+ *
+ * @param key Key to write
+ * @param prefix Pointer to the first part of the value, may reside in flash
+ * @param prefixLen Length in bytes of the first part
+ * @param data Pointer to the second part of the value, may reside in flash
+ * @param dataLen Length in bytes of the second part
+ * @param valueAddr Flash address of the new value, can be NULL
+ *
+ * @returns Status of the write, the previous value stays current on failure
+ */
+int32_t SLN_FLASH_KVS_Write(uint16_t key,
+                            const uint8_t *prefix,
+                            uint32_t prefixLen,
+                            const uint8_t *data,
+                            uint32_t dataLen,
+                            uint32_t *valueAddr);
+
+/*!
+ * @brief Change a range of the value of a key with a delta record, the value size stays the same
+ *
+ * @param key Key to change
+ * @param offset Offset in bytes of the range in the value
+ * @param data Pointer to the new bytes of the range
+ * @param len Length in bytes of the range
+ *
+ * @returns Status of the write, SLN_FLASH_MGMT_ENOENTRY if the key has no value
+ */
+int32_t SLN_FLASH_KVS_WriteDelta(uint16_t key, uint32_t offset, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Read a range of the current value of a key, with its delta records
+ *
+ * @param key Key to read
+ * @param offset Offset in bytes of the range in the value
+ * @param data Pointer to the buffer receiving the range
+ * @param len Length in bytes of the range
+ *
+ * @returns SLN_FLASH_MGMT_OK, SLN_FLASH_MGMT_ENOENTRY if the key has no value
+ */
+int32_t SLN_FLASH_KVS_Read(uint16_t key, uint32_t offset, uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Get the current value of a key in one piece: its delta records, if any, are folded into a full value
+ *
+ * @param key Key to look for
+ * @param valueAddr Flash address of the value
+ *
+ * @returns Status of the fold, SLN_FLASH_MGMT_ENOENTRY if the key has no value
+ */
+int32_t SLN_FLASH_KVS_Fold(uint16_t key, uint32_t *valueAddr);
+
+/*!
+ * @brief Remove the value of a key
+ *
+ * @param key Key to remove
+ *
+ * @returns Status of the removal, SLN_FLASH_MGMT_OK if the key had no value
+ */
+int32_t SLN_FLASH_KVS_Delete(uint16_t key);
+
+/*!
+ * @brief Get the statistics of the store
+ *
+ * @param stats Pointer to the statistics to fill
+ */
+void SLN_FLASH_KVS_GetStats(sln_flash_kvs_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_FLASH_KVS_ */
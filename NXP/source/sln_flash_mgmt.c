@@ -11,20 +11,63 @@
 #include "semphr.h"
 #include "task.h"
 
+#include "sln_dcp_queue.h"
 #include "sln_encrypt.h"
 #include "sln_flash.h"
 #include "sln_flash_mgmt.h"
+#include "sln_flash_kvs.h"
+#include "sln_flash_writer.h"
 #if defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL
 #include "fsl_cache.h"
 #endif
 
 #define GC_THRESHOLD (SLN_FLASH_MAX_MAP_ENTRIES / 2)
 
+/* Reserved byte of the spare sector map: the sector index of a copy not yet written back is kept with the
+ * pending bit, which is cleared once it is */
+#define SPARE_COPY_EMPTY   (0xFF)
+#define SPARE_COPY_PENDING (0x80)
+
+/* Hash table of the file names, twice the maximum number of files to keep the probe sequences short */
+#define FILE_INDEX_BUCKETS    (2 * FICA_FILE_SYS_FILE_COUNT)
+#define FILE_INDEX_EMPTY_SLOT (0xFF)
+
+/* Offset of the CRC in the file header; a delta record of a logged file runs from it to the end of the range */
+#define LOG_DELTA_OFFSET (sizeof(sln_file_header_t) - sizeof(uint32_t))
+
+/* FNV-1a 32 bits parameters */
+#define FILE_NAME_HASH_BASIS (2166136261UL)
+#define FILE_NAME_HASH_PRIME (16777619UL)
+
+/*! @brief RAM copy of the file information in NVM, kept coherent by each write */
+typedef struct _file_index
+{
+    uint32_t nameHash;  /*!< nameHash: FNV-1a hash of the file name. */
+    uint32_t headAddr;  /*!< headAddr: Flash address of the current file header, 0 if the file is not saved. */
+    uint32_t mapIdx;    /*!< mapIdx: Index of the current file header page in sector map. */
+    uint32_t sizeBytes; /*!< sizeBytes: Size in bytes of the file data on NVM. */
+    uint32_t crc;       /*!< crc: Expected CRC32 MPEG2 value of data on NVM. */
+    bool crcValid;      /*!< crcValid: crc is set; for files updated in place it is computed on first read. */
+    bool clean;         /*!< clean: Copy of the header clean bit. */
+} file_index_t;
+
 static SemaphoreHandle_t s_fileLock;
 
 static sln_flash_entry_t *s_flashEntries = NULL;
 static uint32_t s_fileCount              = 0;
-static uint32_t *s_flashCrcList          = NULL;
+
+static file_index_t s_fileIndex[FICA_FILE_SYS_FILE_COUNT];
+static uint8_t s_fileIndexBuckets[FILE_INDEX_BUCKETS];
+
+/* Scratch buffers used instead of the heap; only touched with s_fileLock taken */
+static sln_flash_map_t s_scratchMap;
+ALIGN16 static uint8_t s_scratchPage[FLASH_PAGE_SIZE];
+ALIGN16 static uint8_t s_scratchFile[SLN_FLASH_MGMT_SCRATCH_SIZE];
+
+/* Encrypted data goes through DCP one chunk at a time */
+ALIGN16 static uint8_t s_scratchCrypt[FLASH_PAGE_SIZE];
+static sln_encrypt_stream_t s_cryptStream;
+static dcp_hash_ctx_t s_crcCtx;
 
 static sln_encrypt_ctx_t s_flashMgmtEncCtx = {
     .key = {0x2c, 0x7d, 0x13, 0x18, 0x26, 0xb0, 0xd0, 0xaa, 0xab, 0xf7, 0x16, 0x88, 0x09, 0xcf, 0x4f, 0x3e},
@@ -53,8 +96,70 @@ typedef struct _file_meta
     uint32_t dataCryptLen;  /*!< dataCryptLen: Encrypted length of data. */
     uint32_t flashTableIdx; /*!< flashTableIdx: Global index of file. */
     bool useEncryption;     /*!< useEncryption: Boolean field to indicate if file is encrypted. */
+    bool legacyCrypt;       /*!< legacyCrypt: Encrypted in the format of older firmware. */
 } file_meta_t;
 
+/*! @brief Hash a file name, up to SLN_FLASH_MGMT_FILE_NAME_LEN characters */
+static uint32_t hash_file_name(const char *fileName)
+{
+    uint32_t hash = FILE_NAME_HASH_BASIS;
+
+    for (uint32_t idx = 0; (idx < SLN_FLASH_MGMT_FILE_NAME_LEN) && (fileName[idx] != '\0'); idx++)
+    {
+        hash ^= (uint8_t)fileName[idx];
+        hash *= FILE_NAME_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/*! @brief Add a file of the global file table to the name hash table */
+static void add_file_to_index(uint32_t flashTableIdx)
+{
+    uint32_t bucket = 0;
+
+    s_fileIndex[flashTableIdx].nameHash = hash_file_name(s_flashEntries[flashTableIdx].name);
+
+    bucket = s_fileIndex[flashTableIdx].nameHash % FILE_INDEX_BUCKETS;
+
+    // Linear probing; there are more buckets than files, a free one is always found
+    while (FILE_INDEX_EMPTY_SLOT != s_fileIndexBuckets[bucket])
+    {
+        bucket = (bucket + 1) % FILE_INDEX_BUCKETS;
+    }
+
+    s_fileIndexBuckets[bucket] = (uint8_t)flashTableIdx;
+}
+
+/*! @brief Find the global file table index of a file name; the name must match exactly */
+static int32_t find_file_in_index(const char *fileName, uint32_t *flashTableIdx)
+{
+    uint32_t hash   = hash_file_name(fileName);
+    uint32_t bucket = hash % FILE_INDEX_BUCKETS;
+    uint32_t idx    = 0;
+
+    for (uint32_t probe = 0; probe < FILE_INDEX_BUCKETS; probe++)
+    {
+        idx = s_fileIndexBuckets[bucket];
+
+        if (FILE_INDEX_EMPTY_SLOT == idx)
+        {
+            break;
+        }
+
+        if ((s_fileIndex[idx].nameHash == hash) &&
+            (0 == strncmp(s_flashEntries[idx].name, fileName, SLN_FLASH_MGMT_FILE_NAME_LEN)))
+        {
+            *flashTableIdx = idx;
+            return SLN_FLASH_MGMT_OK;
+        }
+
+        bucket = (bucket + 1) % FILE_INDEX_BUCKETS;
+    }
+
+    return SLN_FLASH_MGMT_ENOENTRY;
+}
+
 /*! @brief Get file meta info from global file table, set initial file header address */
 static int32_t get_file_info_from_name(file_meta_t *meta, const char *fileName)
 {
@@ -66,31 +171,57 @@ static int32_t get_file_info_from_name(file_meta_t *meta, const char *fileName)
     }
     else
     {
-        uint32_t fileNameLen = safe_strlen(fileName, SLN_FLASH_MGMT_FILE_NAME_LEN);
+        // Search the file index for the file name
+        ret = find_file_in_index(fileName, &meta->flashTableIdx);
 
-        // Search global file table for the file name
-        for (meta->flashTableIdx = 0; meta->flashTableIdx < s_fileCount; meta->flashTableIdx++)
+        if (SLN_FLASH_MGMT_OK == ret)
         {
-            if (0 == memcmp(s_flashEntries[meta->flashTableIdx].name, fileName, fileNameLen))
-            {
-                meta->fileBaseAddr  = s_flashEntries[meta->flashTableIdx].address;
-                meta->useEncryption = s_flashEntries[meta->flashTableIdx].isEncrypted;
-                break;
-            }
+            meta->fileBaseAddr  = s_flashEntries[meta->flashTableIdx].address;
+            meta->useEncryption = s_flashEntries[meta->flashTableIdx].isEncrypted;
+
+            // Set file header address to first potential address (just after sector map)
+            meta->fileHeadAddr = meta->fileBaseAddr + SLN_FLASH_MAP_SIZE;
         }
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Set the current file header address from the file index.
+ * A logged file is read from the key/value store, which moves its records; its delta records are folded first.
+ */
+static int32_t get_current_file_from_index(file_meta_t *meta)
+{
+    int32_t ret        = SLN_FLASH_MGMT_OK;
+    uint32_t valueAddr = 0;
+
+    if (0 == s_fileIndex[meta->flashTableIdx].headAddr)
+    {
+        // Indicate to caller that this hasn't been written to, yet
+        ret = SLN_FLASH_MGMT_ENOENTRY2;
+    }
+    else if (s_flashEntries[meta->flashTableIdx].isLogged)
+    {
+        ret = SLN_FLASH_KVS_Fold(meta->flashTableIdx, &valueAddr);
 
-        if (s_fileCount == meta->flashTableIdx)
+        if (SLN_FLASH_MGMT_OK == ret)
         {
-            // Return error code if no entry found
-            ret = SLN_FLASH_MGMT_ENOENTRY;
+            s_fileIndex[meta->flashTableIdx].headAddr = valueAddr;
         }
-        else
+        else if (SLN_FLASH_MGMT_ENOENTRY == ret)
         {
-            // Set file header address to first potential address (just after sector map)
-            meta->fileHeadAddr = meta->fileBaseAddr + SLN_FLASH_MAP_SIZE;
+            // Not moved to the store yet, read from its sector
+            ret = SLN_FLASH_MGMT_OK;
         }
     }
 
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        meta->fileHeadAddr = s_fileIndex[meta->flashTableIdx].headAddr;
+        meta->mapIdx       = s_fileIndex[meta->flashTableIdx].mapIdx;
+    }
+
     return ret;
 }
 
@@ -113,7 +244,8 @@ static int32_t set_file_size_info(file_meta_t *meta, uint32_t len)
         if (meta->useEncryption)
         {
             // Encryption requires 16-byte divisible fileSize
-            meta->dataCryptLen = SLN_Encrypt_Get_Crypt_Length(meta->dataPlainLen);
+            meta->dataCryptLen = meta->legacyCrypt ? SLN_Encrypt_Get_Legacy_Crypt_Length(meta->dataPlainLen)
+                                                   : SLN_Encrypt_Get_Crypt_Length(meta->dataPlainLen);
             meta->fileSize     = sizeof(sln_file_header_t) + meta->dataCryptLen;
         }
         else
@@ -226,12 +358,16 @@ static int32_t calc_crc_32(file_meta_t *meta, uint8_t *data, uint32_t len)
     }
     else
     {
-        size_t crcCount = 4;
+        // Run by the DCP queue, in turn with the other DCP users
+        sln_dcp_job_t job = {.op = kSLN_DCP_Crc32, .in = data, .len = len, .crc = &(meta->crcValue)};
 
         /* NOTE: compute CRC twice because DCP gives back different hashes
          * for some buffer sizes which are multiple of 64. */
-        SLN_Crc(&s_flashMgmtEncCtx, data, len, &(meta->crcValue), &crcCount);
-        ret = SLN_Crc(&s_flashMgmtEncCtx, data, len, &(meta->crcValue), &crcCount);
+        if (0 == (len % 64))
+        {
+            SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job);
+        }
+        ret = SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job);
 
         if (kStatus_Success != ret)
         {
@@ -243,251 +379,785 @@ static int32_t calc_crc_32(file_meta_t *meta, uint8_t *data, uint32_t len)
 }
 #pragma GCC pop_options
 
-/*! @brief Get file data from NVM into RAM */
-static int32_t get_file_data(file_meta_t *meta, uint8_t *data)
+/*!
+ * @brief Check the CRC of the current file data against the RAM mirror.
+ * A mirror not set yet (file updated in place by a previous boot) is set from the data.
+ */
+static int32_t check_file_crc(file_meta_t *meta)
 {
-    int32_t ret = SLN_FLASH_MGMT_OK;
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    file_index_t *fileIndex = &s_fileIndex[meta->flashTableIdx];
 
-    meta->fileDataAddr = meta->fileHeadAddr + sizeof(sln_file_header_t);
+    ret = calc_crc_32(meta, (uint8_t *)meta->fileDataAddr, fileIndex->sizeBytes);
 
-    if (meta->useEncryption)
+    if (kStatus_Success != ret)
     {
-        meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileDataAddr);
-#if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
-        DCACHE_CleanByRange((uint32_t)data, meta->dataPlainLen);
-#endif
-        // Decrypt the message and store it in data
-        ret = SLN_Decrypt_AES_CBC_PKCS7(&s_flashMgmtEncCtx, (uint8_t *)meta->fileDataAddr, meta->dataCryptLen, data,
-                                        (size_t *)&(meta->dataPlainLen));
+        return ret;
+    }
+
+    if (!fileIndex->crcValid)
+    {
+        fileIndex->crc      = meta->crcValue;
+        fileIndex->crcValid = true;
+    }
+    else if (fileIndex->crc != meta->crcValue)
+    {
+        /* Return the data to the calling function to decide what to do in CRC failure */
+        ret = SLN_FLASH_MGMT_EENCRYPT2;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Run a chunk of the file data through DCP, in and out of the crypt scratch buffer.
+ * The last chunk of an encryption is padded.
+ */
+static int32_t crypt_chunk(const uint8_t *in, uint32_t inLen, size_t *outLen, bool encrypt, bool last)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
 
 #if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
-        DCACHE_InvalidateByRange((uint32_t)data, meta->dataPlainLen);
+    DCACHE_CleanByRange((uint32_t)s_scratchCrypt, sizeof(s_scratchCrypt));
 #endif
-        if (SLN_FLASH_MGMT_OK != ret)
-        {
-            ret = SLN_FLASH_MGMT_EENCRYPT;
-        }
+    if (encrypt)
+    {
+        *outLen = s_cryptStream.offset;
+        ret     = last ? SLN_Encrypt_Stream_Finish(&s_cryptStream, in, inLen, s_scratchCrypt)
+                       : SLN_Encrypt_Stream_Update(&s_cryptStream, in, inLen, s_scratchCrypt);
+        *outLen = s_cryptStream.offset - *outLen;
     }
     else
     {
-        ret = SLN_Read_Flash_At_Address(meta->fileDataAddr, data, meta->dataPlainLen);
+        ret = SLN_Decrypt_Stream_Update(&s_cryptStream, in, inLen, s_scratchCrypt, outLen);
+    }
+#if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
+    DCACHE_InvalidateByRange((uint32_t)s_scratchCrypt, sizeof(s_scratchCrypt));
+#endif
+
+    return (SLN_ENCRYPT_STATUS_OK == ret) ? SLN_FLASH_MGMT_OK : SLN_FLASH_MGMT_EENCRYPT;
+}
+
+/*! @brief Recover the plain text length of an encrypted file, only the last block is decrypted */
+static int32_t get_file_plain_len(file_meta_t *meta)
+{
+    int32_t ret       = SLN_FLASH_MGMT_OK;
+    size_t lastLen    = 0;
+    uint32_t lastAddr = 0;
+
+    meta->dataPlainLen = 0;
+
+    if (meta->dataCryptLen < AES_BLOCK_SIZE)
+    {
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileHeadAddr + sizeof(sln_file_header_t));
+    lastAddr           = meta->dataCryptLen - AES_BLOCK_SIZE;
+
+    if ((SLN_ENCRYPT_STATUS_OK !=
+         SLN_Encrypt_Stream_Init(&s_cryptStream, &s_flashMgmtEncCtx, meta->dataCryptLen, meta->legacyCrypt)) ||
+        (SLN_ENCRYPT_STATUS_OK != SLN_Decrypt_Stream_Seek(&s_cryptStream, (uint8_t *)meta->fileDataAddr, lastAddr)))
+    {
+        return SLN_FLASH_MGMT_EENCRYPT;
+    }
+
+    ret = crypt_chunk((uint8_t *)meta->fileDataAddr + lastAddr, AES_BLOCK_SIZE, &lastLen, false, true);
+
+    meta->dataPlainLen = lastAddr + lastLen;
+
+    return ret;
+}
+
+/*! @brief Decrypt a range of an encrypted file into a caller buffer, starting from the block holding offset */
+static int32_t get_file_data(file_meta_t *meta, uint32_t offset, uint8_t *data, uint32_t len)
+{
+    int32_t ret         = SLN_FLASH_MGMT_OK;
+    uint32_t cryptAddr  = offset - (offset % AES_BLOCK_SIZE);
+    uint32_t skip       = offset % AES_BLOCK_SIZE;
+    uint32_t toDecrypt  = 0;
+    uint32_t toCopy     = 0;
+    size_t plainLen     = 0;
+    const uint8_t *file = (const uint8_t *)meta->fileDataAddr;
+
+    if ((SLN_ENCRYPT_STATUS_OK !=
+         SLN_Encrypt_Stream_Init(&s_cryptStream, &s_flashMgmtEncCtx, meta->dataCryptLen, meta->legacyCrypt)) ||
+        (SLN_ENCRYPT_STATUS_OK != SLN_Decrypt_Stream_Seek(&s_cryptStream, file, cryptAddr)))
+    {
+        return SLN_FLASH_MGMT_EENCRYPT;
+    }
+
+    while (len > 0)
+    {
+        toDecrypt = MIN(meta->dataCryptLen - cryptAddr, sizeof(s_scratchCrypt));
+
+        ret = crypt_chunk(&file[cryptAddr], toDecrypt, &plainLen, false, false);
+
+        if ((SLN_FLASH_MGMT_OK != ret) || (plainLen <= skip))
+        {
+            break;
+        }
+
+        toCopy = MIN(plainLen - skip, len);
+        memcpy(data, &s_scratchCrypt[skip], toCopy);
+
+        cryptAddr += toDecrypt;
+        data += toCopy;
+        len -= toCopy;
+        skip = 0;
     }
 
     return ret;
 }
 
-/*! @brief Set file data to save into NVM */
-static int32_t set_file_data(file_meta_t *meta, uint8_t *flashFile, uint8_t *data)
+/*! @brief Get the logged file data to save into NVM; encrypted into the file scratch buffer if necessary */
+static int32_t set_file_data(file_meta_t *meta, const uint8_t *data, const uint8_t **fileData)
 {
     int32_t ret = SLN_FLASH_MGMT_OK;
 
     if (meta->useEncryption)
     {
+        if (meta->dataCryptLen > sizeof(s_scratchFile))
+        {
+            return SLN_FLASH_MGMT_ENOMEM2;
+        }
+
 #if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
-        DCACHE_CleanByRange((uint32_t)(flashFile + sizeof(sln_file_header_t)), meta->dataCryptLen);
+        DCACHE_CleanByRange((uint32_t)s_scratchFile, meta->dataCryptLen);
 #endif
-        // Encrypt the message and store it in flashFile
-        ret = SLN_Encrypt_AES_CBC_PKCS7(&s_flashMgmtEncCtx, data, meta->dataPlainLen,
-                                        flashFile + sizeof(sln_file_header_t), meta->dataCryptLen);
+        // Encrypt the message and store it in the scratch buffer
+        ret = SLN_Encrypt_AES_CBC_PKCS7(&s_flashMgmtEncCtx, (uint8_t *)data, meta->dataPlainLen, s_scratchFile,
+                                        meta->dataCryptLen);
 
 #if defined(SLN_ENABLE_DRIVER_CACHE_CONTROL) && SLN_ENABLE_DRIVER_CACHE_CONTROL
-        DCACHE_InvalidateByRange((uint32_t)(flashFile + sizeof(sln_file_header_t)), meta->dataCryptLen);
+        DCACHE_InvalidateByRange((uint32_t)s_scratchFile, meta->dataCryptLen);
 #endif
         if (ret != kStatus_Success)
         {
             ret = SLN_FLASH_MGMT_EENCRYPT;
         }
+
+        *fileData = s_scratchFile;
     }
     else
     {
-        memcpy(flashFile + sizeof(sln_file_header_t), data, meta->dataPlainLen);
+        // Plain data is written straight from the caller's buffer
+        *fileData = data;
     }
 
     return ret;
 }
 
-/*! @brief Write file data into NVM page by page */
-static int32_t write_file(file_meta_t *meta, uint8_t *flashFile)
+/*! @brief Append bytes to the page scratch buffer, each full page is written to NVM */
+static int32_t write_page_data(file_meta_t *meta, uint32_t *pageOffset, const uint8_t *data, uint32_t len)
 {
-    int32_t ret              = SLN_FLASH_MGMT_OK;
-    uint32_t flashFileOffset = 0;
-    uint32_t toCopy          = 0;
+    int32_t ret     = SLN_FLASH_MGMT_OK;
+    uint32_t toCopy = 0;
 
-    // Update fileDataAddr
-    meta->fileDataAddr = meta->fileHeadAddr + sizeof(sln_file_header_t);
-
-    do
+    while ((SLN_FLASH_MGMT_OK == ret) && (len > 0))
     {
-        toCopy = (meta->fileSize > FLASH_PAGE_SIZE) ? FLASH_PAGE_SIZE : meta->fileSize;
+        toCopy = MIN(len, FLASH_PAGE_SIZE - *pageOffset);
+        memcpy(&s_scratchPage[*pageOffset], data, toCopy);
 
-        ret = SLN_Write_Flash_Page(meta->fileHeadAddr, (uint8_t *)flashFile + flashFileOffset, toCopy);
+        *pageOffset += toCopy;
+        data += toCopy;
+        len -= toCopy;
 
-        if (kStatus_Success != ret)
+        if (FLASH_PAGE_SIZE == *pageOffset)
         {
-            break;
-        }
+            ret = SLN_Write_Flash_Page(meta->fileHeadAddr, s_scratchPage, FLASH_PAGE_SIZE);
 
-        meta->fileSize -= FLASH_PAGE_SIZE;
-        meta->fileHeadAddr += FLASH_PAGE_SIZE;
-        flashFileOffset += toCopy;
-    } while (--(meta->pageCount));
+            meta->fileHeadAddr += FLASH_PAGE_SIZE;
+            meta->pageCount--;
+            *pageOffset = 0;
+        }
+    }
 
     return ret;
 }
 
-/*! @brief Initialize RAM CRC mirror for all files in global table. */
-static int32_t init_ram_crc_mirror(uint32_t flashEntryIdx)
+/*!
+ * @brief Encrypt the file data chunk by chunk through the crypt scratch buffer.
+ * Each encrypted chunk is added to the CRC if hashCtx is set, written to NVM otherwise.
+ */
+static int32_t encrypt_file_data(file_meta_t *meta, const uint8_t *data, dcp_hash_ctx_t *hashCtx, uint32_t *pageOffset)
 {
-    int32_t ret                 = SLN_FLASH_MGMT_ENOLOCK;
-    file_meta_t meta            = {0};
-    sln_flash_map_t *currMap    = NULL;
-    uint8_t *flashFile          = NULL;
-    sln_file_header_t *flashHdr = NULL;
+    int32_t ret          = SLN_FLASH_MGMT_OK;
+    uint32_t plainOffset = 0;
+    uint32_t toEncrypt   = 0;
+    size_t cryptLen      = 0;
 
-    if (NULL != s_fileLock)
+    if (SLN_ENCRYPT_STATUS_OK !=
+        SLN_Encrypt_Stream_Init(&s_cryptStream, &s_flashMgmtEncCtx, meta->dataCryptLen, meta->legacyCrypt))
     {
-        ret = SLN_FLASH_MGMT_ERETRY;
-
-        if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
-        {
-            int32_t temp = 0;
-            ret          = SLN_FLASH_MGMT_OK;
-
-            temp = strncmp(s_flashEntries[flashEntryIdx].name, "RESERVED", strlen("RESERVED"));
-            if (0 == temp)
-            {
-                // No need to touch this file from this application, exit with OK status
-                goto exit;
-            }
-
-            meta.flashTableIdx = flashEntryIdx;
+        return SLN_FLASH_MGMT_EENCRYPT;
+    }
 
-            meta.fileBaseAddr = s_flashEntries[meta.flashTableIdx].address;
+    while ((SLN_FLASH_MGMT_OK == ret) && (plainOffset < meta->dataPlainLen))
+    {
+        // Room left for the padding block after the last chunk
+        toEncrypt = MIN(meta->dataPlainLen - plainOffset, sizeof(s_scratchCrypt) - AES_BLOCK_SIZE);
 
-            meta.fileHeadAddr = meta.fileBaseAddr + SLN_FLASH_MAP_SIZE;
+        ret = crypt_chunk(&data[plainOffset], toEncrypt, &cryptLen, true,
+                          (plainOffset + toEncrypt) == meta->dataPlainLen);
 
-            // Get current flash address from map
-            currMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
+        if (SLN_FLASH_MGMT_OK != ret)
+        {
+            break;
+        }
 
-            if (NULL == currMap)
+        if (NULL != hashCtx)
+        {
+            if (SLN_ENCRYPT_STATUS_OK != SLN_Crc_Update(hashCtx, s_scratchCrypt, cryptLen))
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
-                goto exit;
+                ret = SLN_FLASH_MGMT_EENCRYPT;
             }
+        }
+        else
+        {
+            ret = write_page_data(meta, pageOffset, s_scratchCrypt, cryptLen);
+        }
 
-            ret = get_sector_file_map(&meta, currMap);
+        plainOffset += toEncrypt;
+    }
 
-            if (SLN_FLASH_MGMT_OK != ret)
-            {
-                goto exit;
-            }
+    return ret;
+}
 
-            // Get the file header
-            flashHdr = (sln_file_header_t *)pvPortMalloc(sizeof(sln_file_header_t));
+/*!
+ * @brief Calculate the CRC of the file data as it will be in NVM.
+ * Encrypted data is not kept: it is encrypted again by write_file, AES-CBC with a fixed IV giving the same result.
+ */
+static int32_t calc_file_crc(file_meta_t *meta, const uint8_t *data)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
 
-            if (NULL == flashHdr)
-            {
-                ret = SLN_FLASH_MGMT_ENOMEM2;
-                goto exit;
-            }
+    if (!meta->useEncryption)
+    {
+        return calc_crc_32(meta, (uint8_t *)data, meta->dataPlainLen);
+    }
 
-            SLN_Read_Flash_At_Address(meta.fileHeadAddr, (uint8_t *)flashHdr, sizeof(sln_file_header_t));
+    if (SLN_ENCRYPT_STATUS_OK != SLN_Crc_Init(&s_flashMgmtEncCtx, &s_crcCtx))
+    {
+        return SLN_FLASH_MGMT_EENCRYPT;
+    }
 
-            meta.fileDataAddr = meta.fileHeadAddr + sizeof(sln_file_header_t);
+    ret = encrypt_file_data(meta, data, &s_crcCtx, NULL);
 
-            meta.fileDataAddr = SLN_Flash_Get_Read_Address(meta.fileDataAddr);
+    if ((SLN_FLASH_MGMT_OK == ret) && (SLN_ENCRYPT_STATUS_OK != SLN_Crc_Finish(&s_crcCtx, &meta->crcValue)))
+    {
+        ret = SLN_FLASH_MGMT_EENCRYPT;
+    }
 
-            // Calculate CRC
-            ret = calc_crc_32(&meta, (uint8_t *)(meta.fileDataAddr), get_entry_file_size(flashHdr));
+    return ret;
+}
 
-            if (kStatus_Success != ret)
-            {
-                goto exit;
-            }
+/*! @brief Write file header and data into NVM page by page, encrypting the data on the fly if necessary */
+static int32_t write_file(file_meta_t *meta, const sln_file_header_t *header, const uint8_t *data)
+{
+    int32_t ret         = SLN_FLASH_MGMT_OK;
+    uint32_t pageOffset = 0;
 
-            s_flashCrcList[flashEntryIdx] = meta.crcValue;
-        }
-    }
+    // Update fileDataAddr
+    meta->fileDataAddr = meta->fileHeadAddr + sizeof(sln_file_header_t);
 
-exit:
-    vPortFree(flashFile);
-    flashFile = NULL;
+    // First page starts with the header
+    ret = write_page_data(meta, &pageOffset, (const uint8_t *)header, sizeof(sln_file_header_t));
 
-    vPortFree(currMap);
-    currMap = NULL;
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
 
-    vPortFree(flashHdr);
-    flashHdr = NULL;
+    if (meta->useEncryption)
+    {
+        ret = encrypt_file_data(meta, data, NULL, &pageOffset);
+    }
+    else
+    {
+        ret = write_page_data(meta, &pageOffset, data, meta->dataPlainLen);
+    }
 
-    if (NULL != s_fileLock)
+    // Last page, partly filled
+    if ((SLN_FLASH_MGMT_OK == ret) && (pageOffset > 0))
     {
-        xSemaphoreGive(s_fileLock);
+        ret = SLN_Write_Flash_Page(meta->fileHeadAddr, s_scratchPage, pageOffset);
+
+        meta->fileHeadAddr += FLASH_PAGE_SIZE;
+        meta->pageCount--;
     }
 
     return ret;
 }
 
 /*!
- * @brief The garbage collector function runs at each boot and checks how many
- * entries from the map are occupied.
- *
- * If the occupied entries exceed the threshold then the current file is
- * copied to RAM, the sector is erased and the file is copied back in
- * the first block.
+ * @brief Read a range of the current file data into a caller buffer; the file must be in the index.
+ * len is clipped to the data available after offset, 0 reads up to the end of the file.
+ * The CRC of the whole file is checked only if checkCrc is set.
  */
-static int32_t garbage_collector(uint32_t flashEntryIdx)
+static int32_t read_file_data(file_meta_t *meta, uint32_t offset, uint8_t *data, uint32_t *len, bool checkCrc)
 {
-    int32_t ret              = SLN_FLASH_MGMT_OK;
-    uint32_t mapIdx          = 0;
-    uint32_t fileBaseAddr    = s_flashEntries[flashEntryIdx].address;
-    sln_flash_map_t *currMap = NULL;
-    uint8_t *flashFile       = NULL;
-    uint32_t fileHeadAddr    = 0;
-    uint32_t pageCount       = 0;
-    uint32_t flashFileOffset = 0;
+    int32_t ret          = SLN_FLASH_MGMT_OK;
+    uint32_t sizeBytes   = s_fileIndex[meta->flashTableIdx].sizeBytes;
+    uint32_t available   = 0;
+    uint32_t flashOffset = meta->fileHeadAddr + sizeof(sln_file_header_t);
 
-    if (NULL == s_fileLock)
-    {
-        return SLN_FLASH_MGMT_ENOLOCK;
-    }
+    ret = set_file_size_info(meta, sizeBytes);
 
-    if (pdTRUE != xSemaphoreTake(s_fileLock, portMAX_DELAY))
+    if (SLN_FLASH_MGMT_OK != ret)
     {
-        return SLN_FLASH_MGMT_ERETRY;
+        return ret;
     }
 
-    if (0 == strncmp(s_flashEntries[flashEntryIdx].name, "RESERVED", strlen("RESERVED")))
+    if (meta->useEncryption)
     {
-        // No need to touch this file from this application, exit with OK status
-        goto exit;
-    }
+        sln_file_header_t hdr = {0};
 
-    fileHeadAddr = fileBaseAddr + SLN_FLASH_MAP_SIZE;
+        // The size in NVM is the encrypted one, laid out as the header format says
+        SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)&hdr, sizeof(sln_file_header_t));
+        meta->legacyCrypt  = (SLN_FLASH_FILE_FORMAT_LEGACY == hdr.format);
+        meta->dataCryptLen = sizeBytes;
 
-    // Get current flash address from map
-    currMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
-    if (NULL == currMap)
+        // Decryption of the last block will recover true plain text length
+        ret = get_file_plain_len(meta);
+
+        if (SLN_FLASH_MGMT_OK != ret)
+        {
+            return ret;
+        }
+    }
+
+    if (NULL == data)
     {
-        ret = SLN_FLASH_MGMT_ENOMEM;
-        goto exit;
+        // Make sure we send back file size; the caller just wanted size of file on NVM
+        *len = meta->dataPlainLen;
+        return SLN_FLASH_MGMT_OK;
     }
 
-    SLN_Read_Flash_At_Address(fileBaseAddr, (uint8_t *)currMap, sizeof(sln_flash_map_t));
-    for (mapIdx = 0; mapIdx < SLN_FLASH_MAX_MAP_ENTRIES; mapIdx++)
+    if (checkCrc)
     {
-        if (currMap->map[mapIdx] == SLN_FLASH_MGMT_MAP_CURRENT || currMap->map[mapIdx] == SLN_FLASH_MGMT_MAP_FREE)
+        meta->fileDataAddr = SLN_Flash_Get_Read_Address(flashOffset);
+
+        ret = check_file_crc(meta);
+
+        if ((SLN_FLASH_MGMT_OK != ret) && (SLN_FLASH_MGMT_EENCRYPT2 != ret))
         {
-            break;
+            return ret;
         }
     }
 
-    if ((SLN_FLASH_MAX_MAP_ENTRIES <= mapIdx) ||
+    available = (offset < meta->dataPlainLen) ? (meta->dataPlainLen - offset) : 0;
+
+    if ((0 == *len) || (*len > available))
+    {
+        // Calling function is copying too much data or wants the rest of the file
+        *len = available;
+    }
+
+    // Copy to caller's data buffer, decrypting only the blocks of the range
+    if (meta->useEncryption)
+    {
+        meta->fileDataAddr = SLN_Flash_Get_Read_Address(flashOffset);
+
+        ret = get_file_data(meta, offset, data, *len);
+    }
+    else if (kStatus_Success != SLN_Read_Flash_At_Address(flashOffset + offset, data, *len))
+    {
+        ret = SLN_FLASH_MGMT_EIO;
+    }
+
+    return ret;
+}
+
+/*! @brief Erase a sector, always through the flash writer so it never starts while the writer has one
+ *         suspended. The writer keeps the IRQs running during the erase; before it runs, the erase is
+ *         blocking and the application is told before and after it */
+static int32_t erase_sector(uint32_t address)
+{
+    int32_t ret   = SLN_FLASH_MGMT_OK;
+    bool blocking = !SLN_FLASH_WRITER_IsRunning();
+
+    if (blocking && (NULL != s_flashMgmtCbs.pre_sector_erase_cb))
+    {
+        s_flashMgmtCbs.pre_sector_erase_cb();
+    }
+
+    ret = SLN_FLASH_WRITER_EraseSync(address);
+
+    if (blocking && (NULL != s_flashMgmtCbs.post_sector_erase_cb))
+    {
+        s_flashMgmtCbs.post_sector_erase_cb();
+    }
+
+    return ret;
+}
+
+/*! @brief Copy whole pages from flash to flash, through the page scratch buffer */
+static int32_t copy_flash_pages(uint32_t dstAddr, uint32_t srcAddr, uint32_t pageCount)
+{
+    for (uint32_t page = 0; page < pageCount; page++)
+    {
+        SLN_Read_Flash_At_Address(srcAddr, s_scratchPage, FLASH_PAGE_SIZE);
+
+        if (kStatus_Success != SLN_Write_Flash_Page(dstAddr, s_scratchPage, FLASH_PAGE_SIZE))
+        {
+            return SLN_FLASH_MGMT_EIO;
+        }
+
+        srcAddr += FLASH_PAGE_SIZE;
+        dstAddr += FLASH_PAGE_SIZE;
+    }
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+static int32_t restore_spare_copy(void);
+
+/*!
+ * @brief Erase the spare sector, the compacted copy of a file is then written from its first page.
+ * A copy still pending is written back first, the spare sector may be the only complete one.
+ */
+static int32_t start_spare_copy(void)
+{
+    int32_t ret = restore_spare_copy();
+
+    if ((SLN_FLASH_MGMT_OK == ret) && (SLN_FLASH_MGMT_OK != erase_sector(SLN_FLASH_MGMT_SPARE_ADDR)))
+    {
+        ret = SLN_FLASH_MGMT_EIO;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Write the pending copy of the spare sector back over its sector, then mark it done.
+ * Run by SLN_FLASH_MGMT_Init too: the copy is complete once pending, whatever the state of its sector.
+ */
+static int32_t restore_spare_copy(void)
+{
+    int32_t ret               = SLN_FLASH_MGMT_OK;
+    sln_flash_map_t *spareMap = &s_scratchMap;
+    uint8_t copyState         = SPARE_COPY_EMPTY;
+    uint32_t sectorAddr       = 0;
+    uint32_t pageCount        = 0;
+
+    SLN_Read_Flash_At_Address(SLN_FLASH_MGMT_SPARE_ADDR, (uint8_t *)spareMap, sizeof(sln_flash_map_t));
+    copyState = spareMap->reserved;
+
+    if ((SPARE_COPY_EMPTY == copyState) || !(copyState & SPARE_COPY_PENDING))
+    {
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    sectorAddr = SLN_FLASH_MGMT_BASE_ADDR + ((copyState & ~SPARE_COPY_PENDING) * SECTOR_SIZE);
+
+    while ((pageCount < SLN_FLASH_MAX_MAP_ENTRIES) && (SLN_FLASH_MGMT_MAP_CURRENT == spareMap->map[pageCount]))
+    {
+        pageCount++;
+    }
+
+    ret = erase_sector(sectorAddr);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = copy_flash_pages(sectorAddr + SLN_FLASH_MAP_SIZE, SLN_FLASH_MGMT_SPARE_ADDR + SLN_FLASH_MAP_SIZE,
+                               pageCount);
+    }
+
+    // The map of the sector last, its file is current only once complete
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        spareMap->reserved = SPARE_COPY_EMPTY;
+        ret = SLN_Write_Flash_Page(sectorAddr, (uint8_t *)spareMap, sizeof(sln_flash_map_t));
+    }
+
+    if (kStatus_Success == ret)
+    {
+        spareMap->reserved = copyState & ~SPARE_COPY_PENDING;
+        ret = SLN_Write_Flash_Page(SLN_FLASH_MGMT_SPARE_ADDR, (uint8_t *)spareMap, sizeof(sln_flash_map_t));
+    }
+
+    return (kStatus_Success == ret) ? SLN_FLASH_MGMT_OK : SLN_FLASH_MGMT_EIO;
+}
+
+/*!
+ * @brief Compact a file sector: the spare sector holds the pageCount pages of the file, written since
+ * start_spare_copy. The copy is marked pending, then written back over the erased sector.
+ */
+static int32_t commit_spare_copy(uint32_t sectorAddr, uint32_t pageCount)
+{
+    sln_flash_map_t *spareMap = &s_scratchMap;
+
+    memset(spareMap, SLN_FLASH_MGMT_MAP_FREE, sizeof(sln_flash_map_t));
+    memset(spareMap->map, SLN_FLASH_MGMT_MAP_CURRENT, pageCount);
+    spareMap->reserved = SPARE_COPY_PENDING | ((sectorAddr - SLN_FLASH_MGMT_BASE_ADDR) / SECTOR_SIZE);
+
+    if (kStatus_Success !=
+        SLN_Write_Flash_Page(SLN_FLASH_MGMT_SPARE_ADDR, (uint8_t *)spareMap, sizeof(sln_flash_map_t)))
+    {
+        return SLN_FLASH_MGMT_EIO;
+    }
+
+    return restore_spare_copy();
+}
+
+/*! @brief Save a logged file as a new record of the key/value store; always a full save */
+static int32_t save_log_file(file_meta_t *meta, const uint8_t *data)
+{
+    int32_t ret              = SLN_FLASH_MGMT_OK;
+    sln_file_header_t newHdr = {0};
+    const uint8_t *fileData  = NULL;
+    uint32_t valueAddr       = 0;
+
+    // Set data, will enrypt if necessary
+    ret = set_file_data(meta, data, &fileData);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    newHdr.valid    = 1;
+    newHdr.clean    = 1;
+    newHdr.format   = SLN_FLASH_FILE_FORMAT_PADDED;
+    newHdr.reserved = 0x7;
+    save_entry_file_size(&newHdr, meta->useEncryption ? meta->dataCryptLen : meta->dataPlainLen);
+
+    // Run crc on file data
+    ret = calc_crc_32(meta, (uint8_t *)fileData, get_entry_file_size(&newHdr));
+
+    if (kStatus_Success != ret)
+    {
+        return ret;
+    }
+
+    newHdr.crc = meta->crcValue;
+
+    // The record value is the file header and data, so reads are the same as for a sector file
+    ret = SLN_FLASH_KVS_Write(meta->flashTableIdx, (const uint8_t *)&newHdr, sizeof(sln_file_header_t), fileData,
+                              get_entry_file_size(&newHdr), &valueAddr);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_fileIndex[meta->flashTableIdx].headAddr  = valueAddr;
+        s_fileIndex[meta->flashTableIdx].mapIdx    = 0;
+        s_fileIndex[meta->flashTableIdx].sizeBytes = get_entry_file_size(&newHdr);
+        s_fileIndex[meta->flashTableIdx].clean     = true;
+        s_fileIndex[meta->flashTableIdx].crc       = meta->crcValue;
+        s_fileIndex[meta->flashTableIdx].crcValid  = true;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Initialize the RAM index of a logged file from the key/value store, its delta records folded.
+ * A file still in its own sector (saved by an older firmware) is moved to the store and the sector erased.
+ */
+static int32_t init_log_file(uint32_t flashEntryIdx)
+{
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    sln_file_header_t hdr   = {0};
+    uint32_t valueAddr      = 0;
+    uint32_t len            = 0;
+    uint8_t mapEntry        = SLN_FLASH_MGMT_MAP_FREE;
+    file_index_t *fileIndex = &s_fileIndex[flashEntryIdx];
+    uint32_t legacyDataAddr = 0;
+
+    if (SLN_FLASH_MGMT_OK == SLN_FLASH_KVS_Find(flashEntryIdx, &valueAddr, &len))
+    {
+        // On failure the delta records are kept, the first read folds them
+        ret = SLN_FLASH_KVS_Fold(flashEntryIdx, &valueAddr);
+
+        SLN_FLASH_KVS_Read(flashEntryIdx, 0, (uint8_t *)&hdr, sizeof(sln_file_header_t));
+
+        fileIndex->headAddr  = valueAddr;
+        fileIndex->mapIdx    = 0;
+        fileIndex->sizeBytes = get_entry_file_size(&hdr);
+        fileIndex->clean     = hdr.clean;
+        fileIndex->crc       = hdr.crc;
+        fileIndex->crcValid  = true;
+    }
+    else if (0 != fileIndex->headAddr)
+    {
+        legacyDataAddr = SLN_Flash_Get_Read_Address(fileIndex->headAddr + sizeof(sln_file_header_t));
+
+        if (!fileIndex->crcValid)
+        {
+            // Updated in place, the CRC in NVM is stale
+            file_meta_t meta = {0};
+
+            ret = calc_crc_32(&meta, (uint8_t *)legacyDataAddr, fileIndex->sizeBytes);
+
+            if (SLN_FLASH_MGMT_OK != ret)
+            {
+                return ret;
+            }
+
+            fileIndex->crc      = meta.crcValue;
+            fileIndex->crcValid = true;
+        }
+
+        // Header of the sector copy, with the CRC of the data as it is now
+        SLN_Read_Flash_At_Address(fileIndex->headAddr, (uint8_t *)&hdr, sizeof(sln_file_header_t));
+        hdr.clean = 1;
+        hdr.crc   = fileIndex->crc;
+
+        ret = SLN_FLASH_KVS_Write(flashEntryIdx, (const uint8_t *)&hdr, sizeof(sln_file_header_t),
+                                  (const uint8_t *)legacyDataAddr, fileIndex->sizeBytes, &valueAddr);
+
+        if (SLN_FLASH_MGMT_OK != ret)
+        {
+            // Keep reading the sector copy
+            return ret;
+        }
+
+        configPRINTF(("Moved file %s to the key/value store\r\n", s_flashEntries[flashEntryIdx].name));
+
+        fileIndex->headAddr = valueAddr;
+        fileIndex->mapIdx   = 0;
+        fileIndex->clean    = true;
+    }
+
+    // Erase the sector if it was ever written, the store has the current copy
+    SLN_Read_Flash_At_Address(s_flashEntries[flashEntryIdx].address, &mapEntry, sizeof(mapEntry));
+
+    if (SLN_FLASH_MGMT_MAP_FREE != mapEntry)
+    {
+        if (SLN_FLASH_MGMT_OK != erase_sector(s_flashEntries[flashEntryIdx].address))
+        {
+            ret = SLN_FLASH_MGMT_EIO;
+        }
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Initialize the RAM index of a file in global table.
+ * The CRC mirror is taken from the header; for a file updated in place it is left to the first read.
+ */
+static int32_t init_file_index(uint32_t flashEntryIdx)
+{
+    int32_t ret                = SLN_FLASH_MGMT_ENOLOCK;
+    file_meta_t meta           = {0};
+    sln_file_header_t flashHdr = {0};
+
+    if (NULL != s_fileLock)
+    {
+        ret = SLN_FLASH_MGMT_ERETRY;
+
+        if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
+        {
+            int32_t temp = 0;
+            ret          = SLN_FLASH_MGMT_OK;
+
+            temp = strncmp(s_flashEntries[flashEntryIdx].name, "RESERVED", strlen("RESERVED"));
+            if (0 == temp)
+            {
+                // No need to touch this file from this application, exit with OK status
+                goto exit;
+            }
+
+            meta.flashTableIdx = flashEntryIdx;
+
+            meta.fileBaseAddr = s_flashEntries[meta.flashTableIdx].address;
+
+            meta.fileHeadAddr = meta.fileBaseAddr + SLN_FLASH_MAP_SIZE;
+
+            // Get current flash address from map
+            ret = get_sector_file_map(&meta, &s_scratchMap);
+
+            if (SLN_FLASH_MGMT_ENOENTRY2 == ret)
+            {
+                // Nothing saved yet, the file stays out of the index
+                ret = SLN_FLASH_MGMT_OK;
+                goto exit;
+            }
+            else if (SLN_FLASH_MGMT_OK != ret)
+            {
+                goto exit;
+            }
+
+            // Get the file header
+            SLN_Read_Flash_At_Address(meta.fileHeadAddr, (uint8_t *)&flashHdr, sizeof(sln_file_header_t));
+
+            s_fileIndex[flashEntryIdx].headAddr  = meta.fileHeadAddr;
+            s_fileIndex[flashEntryIdx].mapIdx    = meta.mapIdx;
+            s_fileIndex[flashEntryIdx].sizeBytes = get_entry_file_size(&flashHdr);
+            s_fileIndex[flashEntryIdx].clean     = flashHdr.clean;
+            s_fileIndex[flashEntryIdx].crc       = flashHdr.clean ? flashHdr.crc : 0;
+            s_fileIndex[flashEntryIdx].crcValid  = flashHdr.clean;
+        }
+    }
+
+exit:
+    if (NULL != s_fileLock)
+    {
+        xSemaphoreGive(s_fileLock);
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief The garbage collector function runs at each boot and checks how many
+ * entries from the map are occupied.
+ *
+ * If the next save of the current file would not fit in the free entries then
+ * the current file is copied to the spare sector, the sector is erased and the
+ * file is copied back in the first block.
+ */
+static int32_t garbage_collector(uint32_t flashEntryIdx)
+{
+    int32_t ret              = SLN_FLASH_MGMT_OK;
+    uint32_t mapIdx          = 0;
+    uint32_t fileBaseAddr    = s_flashEntries[flashEntryIdx].address;
+    sln_flash_map_t *currMap = &s_scratchMap;
+    uint32_t fileHeadAddr    = 0;
+    uint32_t pageCount       = 0;
+
+    if (NULL == s_fileLock)
+    {
+        return SLN_FLASH_MGMT_ENOLOCK;
+    }
+
+    if (pdTRUE != xSemaphoreTake(s_fileLock, portMAX_DELAY))
+    {
+        return SLN_FLASH_MGMT_ERETRY;
+    }
+
+    if (0 == strncmp(s_flashEntries[flashEntryIdx].name, "RESERVED", strlen("RESERVED")))
+    {
+        // No need to touch this file from this application, exit with OK status
+        goto exit;
+    }
+
+    if (s_flashEntries[flashEntryIdx].isLogged)
+    {
+        // The sector is only read once to move the file to the key/value store
+        goto exit;
+    }
+
+    fileHeadAddr = fileBaseAddr + SLN_FLASH_MAP_SIZE;
+
+    // Get current flash address from map
+    SLN_Read_Flash_At_Address(fileBaseAddr, (uint8_t *)currMap, sizeof(sln_flash_map_t));
+    for (mapIdx = 0; mapIdx < SLN_FLASH_MAX_MAP_ENTRIES; mapIdx++)
+    {
+        if (currMap->map[mapIdx] == SLN_FLASH_MGMT_MAP_CURRENT || currMap->map[mapIdx] == SLN_FLASH_MGMT_MAP_FREE)
+        {
+            break;
+        }
+    }
+
+    if ((SLN_FLASH_MAX_MAP_ENTRIES <= mapIdx) ||
         ((SLN_FLASH_MGMT_MAP_CURRENT != currMap->map[mapIdx]) && (GC_THRESHOLD < mapIdx)))
     {
         // Something wrong as there is no current file saved but the
         // GC threshold exceeded. Erase the sector and exit.
 
-        ret = SLN_Erase_Sector(s_flashEntries[flashEntryIdx].address);
+        ret = erase_sector(s_flashEntries[flashEntryIdx].address);
         if (SLN_FLASH_MGMT_OK != ret)
         {
             ret = SLN_FLASH_MGMT_EIO;
@@ -496,7 +1166,7 @@ static int32_t garbage_collector(uint32_t flashEntryIdx)
         goto exit;
     }
 
-    if (mapIdx > GC_THRESHOLD)
+    if (SLN_FLASH_MGMT_MAP_CURRENT == currMap->map[mapIdx])
     {
         uint32_t fileSize = 0;
         uint32_t fileAddr = fileHeadAddr + FLASH_PAGE_SIZE * mapIdx;
@@ -507,63 +1177,386 @@ static int32_t garbage_collector(uint32_t flashEntryIdx)
 
         fileSize = get_entry_file_size(&currHdr) + sizeof(sln_file_header_t);
 
-        flashFile = (uint8_t *)pvPortMalloc(fileSize);
-        if (NULL == flashFile)
+        pageCount = fileSize / FLASH_PAGE_SIZE;
+        if (fileSize % FLASH_PAGE_SIZE)
+        {
+            pageCount++;
+        }
+
+        // Nothing to do while the sector still has room for one more save of the same size
+        if ((mapIdx + 2 * pageCount) <= SLN_FLASH_MAX_MAP_ENTRIES)
         {
-            ret = SLN_FLASH_MGMT_ENOMEM;
             goto exit;
         }
 
-        // Copy the current file from flash to RAM
-        SLN_Read_Flash_At_Address(fileAddr, flashFile, fileSize);
+        // The file is kept in its sector until its copy in the spare sector is complete
+        ret = start_spare_copy();
 
-        ret = SLN_Erase_Sector(s_flashEntries[flashEntryIdx].address);
-        if (SLN_FLASH_MGMT_OK != ret)
+        if (SLN_FLASH_MGMT_OK == ret)
         {
-            ret = SLN_FLASH_MGMT_EIO;
-            goto exit;
+            ret = copy_flash_pages(SLN_FLASH_MGMT_SPARE_ADDR + SLN_FLASH_MAP_SIZE, fileAddr, pageCount);
         }
 
-        pageCount = fileSize / FLASH_PAGE_SIZE;
-        if (fileSize % FLASH_PAGE_SIZE)
+        if (SLN_FLASH_MGMT_OK == ret)
         {
-            pageCount++;
+            ret = commit_spare_copy(fileBaseAddr, pageCount);
+        }
+    }
+
+exit:
+    xSemaphoreGive(s_fileLock);
+
+    return ret;
+}
+
+/*! @brief Check that programming data over the flash only clears bits, a NOR flash cannot set them back */
+static bool only_clears_bits(const uint8_t *flash, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        if ((flash[idx] & data[idx]) != data[idx])
+        {
+            return false;
         }
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Program a range of the current file data in place, only the pages holding the range are written.
+ * The header is marked updated in place first, its CRC is not valid anymore.
+ */
+static int32_t program_file_range(file_meta_t *meta, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret               = SLN_FLASH_MGMT_OK;
+    sln_file_header_t currHdr = {0};
+    uint32_t flashAddr        = meta->fileHeadAddr + sizeof(sln_file_header_t) + offset;
+    uint32_t pageOffset       = 0;
+    uint32_t toCopy           = 0;
+
+    if (s_fileIndex[meta->flashTableIdx].clean)
+    {
+        SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
 
-        // Update the map and mark the first pageCount entries as occupied
-        memset(currMap->map, SLN_FLASH_MGMT_MAP_FREE, sizeof(currMap->map));
-        memset(currMap->map, SLN_FLASH_MGMT_MAP_CURRENT, pageCount);
-        SLN_Write_Flash_Page(fileBaseAddr, (uint8_t *)currMap, sizeof(sln_flash_map_t));
+        currHdr.clean = 0;
+        ret           = SLN_Write_Flash_Page(meta->fileHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
 
-        // Save back the file to the first block
-        do
+        if (kStatus_Success != ret)
         {
-            uint32_t toCopy = (fileSize > FLASH_PAGE_SIZE) ? FLASH_PAGE_SIZE : fileSize;
+            return SLN_FLASH_MGMT_EIO;
+        }
 
-            SLN_Write_Flash_Page(fileHeadAddr, (uint8_t *)flashFile + flashFileOffset, toCopy);
-            fileSize -= FLASH_PAGE_SIZE;
-            fileHeadAddr += FLASH_PAGE_SIZE;
-            flashFileOffset += toCopy;
-        } while (--pageCount);
+        s_fileIndex[meta->flashTableIdx].clean = false;
     }
 
-exit:
-    vPortFree(flashFile);
-    flashFile = NULL;
+    while (len > 0)
+    {
+        pageOffset = flashAddr % FLASH_PAGE_SIZE;
+        toCopy     = MIN(len, FLASH_PAGE_SIZE - pageOffset);
 
-    vPortFree(currMap);
-    currMap = NULL;
+        // Bytes left at 0xFF are not programmed
+        memset(s_scratchPage, 0xFF, FLASH_PAGE_SIZE);
+        memcpy(&s_scratchPage[pageOffset], data, toCopy);
 
-    xSemaphoreGive(s_fileLock);
+        if (kStatus_Success != SLN_Write_Flash_Page(flashAddr - pageOffset, s_scratchPage, FLASH_PAGE_SIZE))
+        {
+            return SLN_FLASH_MGMT_EIO;
+        }
+
+        flashAddr += toCopy;
+        data += toCopy;
+        len -= toCopy;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Append a copy of the current file, with a range of its data changed, after it in its sector.
+ * The new pages are marked in the map before the old ones are dropped: until the copy is complete,
+ * the map search still finds the old copy first.
+ */
+static int32_t copy_file_range(file_meta_t *meta, uint32_t offset, const uint8_t *data, uint32_t len, uint32_t crc)
+{
+    int32_t ret               = SLN_FLASH_MGMT_OK;
+    sln_flash_map_t *flashMap = &s_scratchMap;
+    sln_file_header_t newHdr  = {0};
+    sln_file_header_t currHdr = {0};
+    uint32_t pageCount        = meta->pageCount;
+    uint32_t oldHeadAddr      = meta->fileHeadAddr;
+    uint32_t oldMapIdx        = meta->mapIdx;
+    uint32_t newMapIdx        = meta->mapIdx + pageCount;
+    uint32_t newHeadAddr      = meta->fileBaseAddr + SLN_FLASH_MAP_SIZE + (newMapIdx * FLASH_PAGE_SIZE);
+    uint32_t pageOffset       = 0;
+    const uint8_t *oldData    = (const uint8_t *)meta->fileDataAddr;
+
+    if (newMapIdx + pageCount > SLN_FLASH_MAX_MAP_ENTRIES)
+    {
+        return SLN_FLASH_MGMT_EOVERFLOW2;
+    }
+
+    SLN_Read_Flash_At_Address(meta->fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+
+    for (uint32_t idx = newMapIdx; idx < newMapIdx + pageCount; idx++)
+    {
+        if (SLN_FLASH_MGMT_MAP_FREE != flashMap->map[idx])
+        {
+            return SLN_FLASH_MGMT_EOVERFLOW2;
+        }
+    }
+
+    memset(&(flashMap->map[newMapIdx]), SLN_FLASH_MGMT_MAP_CURRENT, pageCount);
+    SLN_Write_Flash_Page(meta->fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+
+    newHdr.valid    = 1;
+    newHdr.clean    = 1;
+    newHdr.format   = SLN_FLASH_FILE_FORMAT_PADDED;
+    newHdr.reserved = 0x7;
+    newHdr.crc      = crc;
+    save_entry_file_size(&newHdr, meta->dataPlainLen);
+
+    meta->fileHeadAddr = newHeadAddr;
+    meta->mapIdx       = newMapIdx;
+
+    // The header, the data before the range, the range, the data after it
+    ret = write_page_data(meta, &pageOffset, (const uint8_t *)&newHdr, sizeof(sln_file_header_t));
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = write_page_data(meta, &pageOffset, oldData, offset);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = write_page_data(meta, &pageOffset, data, len);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = write_page_data(meta, &pageOffset, &oldData[offset + len], meta->dataPlainLen - offset - len);
+    }
+
+    if ((SLN_FLASH_MGMT_OK == ret) && (pageOffset > 0))
+    {
+        ret = SLN_Write_Flash_Page(meta->fileHeadAddr, s_scratchPage, pageOffset);
+    }
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        // The old copy is still the current one
+        return SLN_FLASH_MGMT_EIO;
+    }
+
+    // Drop the old copy
+    SLN_Read_Flash_At_Address(oldHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
+    currHdr.valid = 0;
+    SLN_Write_Flash_Page(oldHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
+
+    memset(&(flashMap->map[oldMapIdx]), SLN_FLASH_MGMT_MAP_OLD, pageCount);
+    SLN_Write_Flash_Page(meta->fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+
+    s_fileIndex[meta->flashTableIdx].headAddr = newHeadAddr;
+    s_fileIndex[meta->flashTableIdx].mapIdx   = newMapIdx;
+    s_fileIndex[meta->flashTableIdx].clean    = true;
+
+    return ret;
+}
+
+/*!
+ * @brief Change a range of a plain file stored in its own sector.
+ * The CRC is patched from the changed bytes; only a file updated in place by a previous boot is hashed whole.
+ */
+static int32_t update_sector_range(file_meta_t *meta, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    file_index_t *fileIndex = &s_fileIndex[meta->flashTableIdx];
+    const uint8_t *oldRange = NULL;
+    uint32_t crc            = 0;
+
+    ret = set_file_size_info(meta, fileIndex->sizeBytes);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileHeadAddr + sizeof(sln_file_header_t));
+    oldRange           = (const uint8_t *)meta->fileDataAddr + offset;
+
+    if (0 == memcmp(oldRange, data, len))
+    {
+        // Nothing to write
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    if (!fileIndex->crcValid)
+    {
+        ret = check_file_crc(meta);
+
+        if (SLN_FLASH_MGMT_OK != ret)
+        {
+            return ret;
+        }
+    }
+
+    crc = SLN_Crc_Patch(fileIndex->crc, oldRange, data, len, fileIndex->sizeBytes - offset - len);
+
+    if (only_clears_bits(oldRange, data, len))
+    {
+        ret = program_file_range(meta, offset, data, len);
+    }
+    else
+    {
+        ret = copy_file_range(meta, offset, data, len, crc);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        fileIndex->crc      = crc;
+        fileIndex->crcValid = true;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Change a range of a plain logged file with a delta record of the key/value store: the CRC of the header
+ * patched from the changed bytes, then the data up to the end of the range.
+ */
+static int32_t update_log_delta(file_meta_t *meta, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    file_index_t *fileIndex = &s_fileIndex[meta->flashTableIdx];
+    uint8_t *delta          = s_scratchFile;
+    uint8_t *range          = &s_scratchFile[sizeof(uint32_t) + offset];
+    uint32_t deltaLen       = sizeof(uint32_t) + offset + len;
+    uint32_t crc            = 0;
+
+    ret = SLN_FLASH_KVS_Read(meta->flashTableIdx, LOG_DELTA_OFFSET, delta, deltaLen);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    if (0 == memcmp(range, data, len))
+    {
+        // Nothing to write
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    crc = SLN_Crc_Patch(fileIndex->crc, range, data, len, fileIndex->sizeBytes - offset - len);
+
+    memcpy(range, data, len);
+    memcpy(delta, &crc, sizeof(uint32_t));
+
+    ret = SLN_FLASH_KVS_WriteDelta(meta->flashTableIdx, LOG_DELTA_OFFSET, delta, deltaLen);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        fileIndex->crc = crc;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Change a range of a logged file. A plain file in the key/value store gets a delta record if it fits in the
+ * scratch buffer. Otherwise the file is read into the scratch buffer, changed and saved again; an encrypted file
+ * takes twice its size of scratch buffer, the plain text after the encrypted data.
+ */
+static int32_t update_log_range(file_meta_t *meta, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    uint32_t plainLen       = 0;
+    uint8_t *plain          = s_scratchFile;
+    file_index_t *fileIndex = &s_fileIndex[meta->flashTableIdx];
+    uint32_t valueAddr      = 0;
+    uint32_t valueLen       = 0;
+
+    if (!meta->useEncryption && (offset <= fileIndex->sizeBytes) && (len <= fileIndex->sizeBytes - offset) &&
+        ((sizeof(uint32_t) + offset + len) <= sizeof(s_scratchFile)) &&
+        (SLN_FLASH_MGMT_OK == SLN_FLASH_KVS_Find(meta->flashTableIdx, &valueAddr, &valueLen)))
+    {
+        return update_log_delta(meta, offset, data, len);
+    }
+
+    // Folds the delta records
+    ret = get_current_file_from_index(meta);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    // Get the plain text length
+    ret = read_file_data(meta, 0, NULL, &plainLen, false);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    if ((offset > plainLen) || (len > plainLen - offset))
+    {
+        return SLN_FLASH_MGMT_EINVAL2;
+    }
+
+    if (meta->useEncryption)
+    {
+        if ((2 * meta->dataCryptLen) > sizeof(s_scratchFile))
+        {
+            return SLN_FLASH_MGMT_ENOMEM2;
+        }
+
+        plain = &s_scratchFile[meta->dataCryptLen];
+    }
+    else if (plainLen > sizeof(s_scratchFile))
+    {
+        return SLN_FLASH_MGMT_ENOMEM2;
+    }
+
+    // A corrupted file is not saved again with a valid CRC
+    ret = read_file_data(meta, 0, plain, &plainLen, true);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    memcpy(&plain[offset], data, len);
+
+    // Saved again in the current format
+    meta->legacyCrypt = false;
+    ret               = set_file_size_info(meta, plainLen);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        ret = save_log_file(meta, plain);
+    }
 
     return ret;
 }
 
+/*! @brief Microseconds elapsed since start, from the cycle counter enabled by SLN_Flash_Init */
+static uint32_t elapsed_us(uint32_t start)
+{
+    return (DWT->CYCCNT - start) / (SystemCoreClock / 1000000U);
+}
+
 int32_t SLN_FLASH_MGMT_Init(sln_flash_entry_t *flashEntries, uint8_t erase)
 {
-    int32_t ret          = SLN_FLASH_MGMT_OK;
-    uint32_t fileSysSize = 0;
-    uint32_t idx         = 0;
+    int32_t ret           = SLN_FLASH_MGMT_OK;
+    int32_t stepRet       = SLN_FLASH_MGMT_OK;
+    uint32_t fileSysSize  = 0;
+    uint32_t idx          = 0;
+    uint32_t start        = 0;
+    uint32_t gcUs         = 0;
+    uint32_t indexUs      = 0;
+    uint32_t storeUs      = 0;
+    uint32_t deferredCrcs = 0;
+    uint32_t skippedBytes = 0;
 
     SLN_Encrypt_Init_Slot(&s_flashMgmtEncCtx);
 
@@ -593,7 +1586,7 @@ int32_t SLN_FLASH_MGMT_Init(sln_flash_entry_t *flashEntries, uint8_t erase)
         {
             if (strncmp(flashEntries[idx].name, "RESERVED", strlen("RESERVED")))
             {
-                ret = SLN_Erase_Sector(flashEntries[idx].address);
+                ret = erase_sector(flashEntries[idx].address);
 
                 if (SLN_FLASH_MGMT_OK != ret)
                 {
@@ -618,28 +1611,62 @@ int32_t SLN_FLASH_MGMT_Init(sln_flash_entry_t *flashEntries, uint8_t erase)
     {
         s_flashEntries = flashEntries;
         s_fileCount    = idx;
-        s_flashCrcList = (uint32_t *)pvPortMalloc(s_fileCount * sizeof(uint32_t));
 
-        if (NULL == s_flashCrcList)
+        memset(s_fileIndex, 0, sizeof(s_fileIndex));
+        memset(s_fileIndexBuckets, FILE_INDEX_EMPTY_SLOT, sizeof(s_fileIndexBuckets));
+
+        for (idx = 0; idx < s_fileCount; idx++)
+        {
+            add_file_to_index(idx);
+        }
+
+        // Each step runs for every file whatever failed before, the first error is returned.
+        // An erase drops any pending copy, otherwise a compaction cut by a power loss is finished first.
+        stepRet = erase ? erase_sector(SLN_FLASH_MGMT_SPARE_ADDR) : restore_spare_copy();
+        ret     = (SLN_FLASH_MGMT_OK == stepRet) ? SLN_FLASH_MGMT_OK : SLN_FLASH_MGMT_EIO;
+
+        // Run the garbage collector for each file, only the nearly full sectors are compacted
+        start = DWT->CYCCNT;
+        for (idx = 0; idx < s_fileCount; idx++)
         {
-            ret = SLN_FLASH_MGMT_ENOMEM;
+            stepRet = garbage_collector(idx);
+            ret     = (SLN_FLASH_MGMT_OK == ret) ? stepRet : ret;
         }
-        else
+        gcUs = elapsed_us(start);
+
+        // Populate the file index, no file data is read
+        start = DWT->CYCCNT;
+        for (idx = 0; idx < s_fileCount; idx++)
         {
-            memset(s_flashCrcList, 0, s_fileCount * sizeof(uint32_t));
+            stepRet = init_file_index(idx);
+            ret     = (SLN_FLASH_MGMT_OK == ret) ? stepRet : ret;
         }
+        indexUs = elapsed_us(start);
+
+        // Logged files are looked up in the key/value store, or moved to it; without a store they are
+        // still indexed from their sector copy
+        start   = DWT->CYCCNT;
+        stepRet = SLN_FLASH_KVS_Init(erase_sector, erase);
+        ret     = (SLN_FLASH_MGMT_OK == ret) ? stepRet : ret;
 
-        // Run the garbage collector for each file
         for (idx = 0; idx < s_fileCount; idx++)
         {
-            ret = garbage_collector(idx);
+            if (s_flashEntries[idx].isLogged)
+            {
+                stepRet = init_log_file(idx);
+                ret     = (SLN_FLASH_MGMT_OK == ret) ? stepRet : ret;
+            }
         }
+        storeUs = elapsed_us(start);
 
-        // Populate RAM CRCs
         for (idx = 0; idx < s_fileCount; idx++)
         {
-            ret = init_ram_crc_mirror(idx);
+            skippedBytes += s_fileIndex[idx].sizeBytes;
+            deferredCrcs += ((0 != s_fileIndex[idx].headAddr) && !s_fileIndex[idx].crcValid) ? 1 : 0;
         }
+
+        configPRINTF(("Flash mgmt init: gc %d us, index %d us, store %d us; %d bytes not hashed, %d CRCs deferred\r\n",
+                      gcUs, indexUs, storeUs, skippedBytes, deferredCrcs));
     }
 
     return ret;
@@ -653,10 +1680,14 @@ int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len)
     {
         if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
         {
-            file_meta_t *meta         = NULL;
-            uint8_t *flashFile        = NULL;
-            sln_flash_map_t *flashMap = NULL;
-            sln_file_header_t *newHdr = NULL;
+            file_meta_t meta          = {0};
+            sln_flash_map_t *flashMap = &s_scratchMap;
+            sln_file_header_t newHdr  = {0};
+            uint32_t oldMapIdx        = 0;
+            uint32_t oldPageCount     = 0;
+            uint32_t oldHeadAddr      = 0;
+            uint32_t newMapIdx        = 0;
+            uint32_t newHeadAddr      = 0;
 
             ret = SLN_FLASH_MGMT_OK;
 
@@ -667,142 +1698,151 @@ int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len)
                 goto exit;
             }
 
-            meta = (file_meta_t *)pvPortMalloc(sizeof(file_meta_t));
+            // Get file meta info
+            ret = get_file_info_from_name(&meta, name);
 
-            if (NULL == meta)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
                 goto exit;
             }
-            else
-            {
-                // Clear out data
-                memset(meta, 0x00, sizeof(file_meta_t));
-            }
 
-            // Get file meta info
-            ret = get_file_info_from_name(meta, name);
+            // Set file meta info
+            ret = set_file_size_info(&meta, len);
 
-            if (SLN_FLASH_MGMT_ENOENTRY == ret)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            // Set file meta info
-            ret = set_file_size_info(meta, len);
+            if (s_flashEntries[meta.flashTableIdx].isLogged)
+            {
+                ret = save_log_file(&meta, data);
+                goto exit;
+            }
 
-            if (SLN_FLASH_MGMT_OK != ret)
+            if (meta.pageCount > SLN_FLASH_MAX_MAP_ENTRIES)
             {
+                ret = SLN_FLASH_MGMT_EOVERFLOW2;
                 goto exit;
             }
 
-            // Get current flash address from map
-            flashMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
+            // Run crc on file data, encrypting it if necessary; done first so a failure leaves the flash untouched
+            ret = calc_file_crc(&meta, data);
 
-            if (NULL == flashMap)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
                 goto exit;
             }
 
             // Copy sector file map to ram
-            ret = get_sector_file_map(meta, flashMap);
+            ret = get_sector_file_map(&meta, flashMap);
 
-            if ((SLN_FLASH_MGMT_OK != ret) && (SLN_FLASH_MGMT_ENOENTRY2 != ret))
+            if ((SLN_FLASH_MGMT_OK != ret) && (SLN_FLASH_MGMT_ENOENTRY2 != ret) && (SLN_FLASH_MGMT_ENOENTRY3 != ret))
             {
                 goto exit;
             }
 
-            if ((flashMap->map[meta->mapIdx] == SLN_FLASH_MGMT_MAP_CURRENT) && (SLN_FLASH_MGMT_ENOENTRY3 != ret))
-            {
-                // Invalidate current file from flash
-                sln_file_header_t currHdr;
-                SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
-
-                currHdr.valid = 0;
-                SLN_Write_Flash_Page(meta->fileHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
+            // The current file and the entries of failed saves take [oldMapIdx, oldMapIdx + oldPageCount),
+            // the new file the free entries after them
+            oldMapIdx   = meta.mapIdx;
+            oldHeadAddr = meta.fileHeadAddr;
+            newMapIdx   = meta.mapIdx;
 
-                // Invalidate previous map entries if they exist
-                while (flashMap->map[meta->mapIdx] == SLN_FLASH_MGMT_MAP_CURRENT)
-                {
-                    flashMap->map[meta->mapIdx] = SLN_FLASH_MGMT_MAP_OLD;
+            while ((newMapIdx < SLN_FLASH_MAX_MAP_ENTRIES) && (SLN_FLASH_MGMT_MAP_FREE != flashMap->map[newMapIdx]))
+            {
+                newMapIdx++;
+            }
 
-                    // Increment address to next entry
-                    meta->fileHeadAddr += FLASH_PAGE_SIZE;
+            oldPageCount = (SLN_FLASH_MGMT_OK == ret) ? (newMapIdx - oldMapIdx) : 0;
 
-                    meta->mapIdx++;
+            // Set header data for this new save
+            newHdr.valid    = 1;
+            newHdr.clean    = 1;
+            newHdr.format   = SLN_FLASH_FILE_FORMAT_PADDED;
+            newHdr.reserved = 0x7;
+            save_entry_file_size(&newHdr, meta.useEncryption ? meta.dataCryptLen : meta.dataPlainLen);
 
-                    if (meta->mapIdx >= SLN_FLASH_MAX_MAP_ENTRIES)
-                    {
-                        ret = SLN_FLASH_MGMT_EOVERFLOW;
-                        goto exit;
-                    }
-                }
-            }
+            // Update header with calculated CRC value
+            newHdr.crc = meta.crcValue;
 
-            // Check if the saved file fits in the sector
-            if (meta->mapIdx + meta->pageCount > SLN_FLASH_MAX_MAP_ENTRIES)
+            if (newMapIdx + meta.pageCount > SLN_FLASH_MAX_MAP_ENTRIES)
             {
-                ret = SLN_FLASH_MGMT_EOVERFLOW2;
-                goto exit;
-            }
+                // Sector full: the new file is written to the spare sector, which then replaces the sector
+                uint32_t pageCount = meta.pageCount;
 
-            // Mark the newly occupied pages
-            memset(&(flashMap->map[meta->mapIdx]), SLN_FLASH_MGMT_MAP_CURRENT, meta->pageCount);
+                newMapIdx   = 0;
+                newHeadAddr = meta.fileBaseAddr + SLN_FLASH_MAP_SIZE;
 
-            SLN_Write_Flash_Page(meta->fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+                ret = start_spare_copy();
 
-            // Build File
-            flashFile = (uint8_t *)pvPortMalloc(meta->fileSize);
+                if (SLN_FLASH_MGMT_OK == ret)
+                {
+                    meta.fileHeadAddr = SLN_FLASH_MGMT_SPARE_ADDR + SLN_FLASH_MAP_SIZE;
+                    ret               = write_file(&meta, &newHdr, data);
+                }
 
-            if (NULL == flashFile)
-            {
-                ret = SLN_FLASH_MGMT_ENOMEM2;
-                goto exit;
+                if (SLN_FLASH_MGMT_OK == ret)
+                {
+                    ret = commit_spare_copy(meta.fileBaseAddr, pageCount);
+                }
             }
+            else
+            {
+                // Mark the newly occupied pages, the current file stays first in the map
+                newHeadAddr = meta.fileBaseAddr + SLN_FLASH_MAP_SIZE + FLASH_PAGE_SIZE * newMapIdx;
+                memset(&(flashMap->map[newMapIdx]), SLN_FLASH_MGMT_MAP_CURRENT, meta.pageCount);
 
-            // Set header data for this new save
-            newHdr           = (sln_file_header_t *)flashFile;
-            newHdr->valid    = 1;
-            newHdr->clean    = 1;
-            newHdr->reserved = 0x1F;
-            save_entry_file_size(newHdr, meta->useEncryption ? meta->dataCryptLen : meta->dataPlainLen);
+                if (kStatus_Success !=
+                    SLN_Write_Flash_Page(meta.fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t)))
+                {
+                    ret = SLN_FLASH_MGMT_EIO;
+                    goto exit;
+                }
 
-            // Set data, will enrypt if necessary
-            ret = set_file_data(meta, flashFile, data);
+                meta.fileHeadAddr = newHeadAddr;
+                ret               = write_file(&meta, &newHdr, data);
 
-            if (SLN_FLASH_MGMT_OK != ret)
-            {
-                goto exit;
-            }
+                if ((SLN_FLASH_MGMT_OK == ret) && (oldPageCount > 0))
+                {
+                    // Invalidate the previous file now that the new one is complete
+                    sln_file_header_t currHdr;
+                    SLN_Read_Flash_At_Address(oldHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
 
-            // Run crc on file data
-            ret = calc_crc_32(meta, flashFile + sizeof(sln_file_header_t), get_entry_file_size(newHdr));
+                    currHdr.valid = 0;
+                    SLN_Write_Flash_Page(oldHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
 
-            if (kStatus_Success != ret)
-            {
-                goto exit;
-            }
+                    // Its first entry last: a map program cut half way leaves either file first, never a middle page
+                    memset(&(flashMap->map[oldMapIdx + 1]), SLN_FLASH_MGMT_MAP_OLD, oldPageCount - 1);
+                    ret = SLN_Write_Flash_Page(meta.fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
 
-            // Update header with calculated CRC value
-            newHdr->crc = meta->crcValue;
+                    if (kStatus_Success == ret)
+                    {
+                        flashMap->map[oldMapIdx] = SLN_FLASH_MGMT_MAP_OLD;
+                        ret = SLN_Write_Flash_Page(meta.fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+                    }
 
-            // Update ram list
-            if (NULL != s_flashCrcList)
-            {
-                s_flashCrcList[meta->flashTableIdx] = meta->crcValue;
+                    ret = (kStatus_Success == ret) ? SLN_FLASH_MGMT_OK : SLN_FLASH_MGMT_EIO;
+                }
+                else if (SLN_FLASH_MGMT_OK != ret)
+                {
+                    // Best effort, the entries of a failed save are skipped by the next one anyway
+                    memset(&(flashMap->map[newMapIdx]), SLN_FLASH_MGMT_MAP_OLD, meta.pageCount);
+                    SLN_Write_Flash_Page(meta.fileBaseAddr, (uint8_t *)flashMap, sizeof(sln_flash_map_t));
+                }
             }
 
-            // Write to next entry
-            ret = write_file(meta, flashFile);
+            // The file index follows the flash only once the new file is current
+            if (SLN_FLASH_MGMT_OK == ret)
+            {
+                s_fileIndex[meta.flashTableIdx].headAddr  = newHeadAddr;
+                s_fileIndex[meta.flashTableIdx].mapIdx    = newMapIdx;
+                s_fileIndex[meta.flashTableIdx].sizeBytes = get_entry_file_size(&newHdr);
+                s_fileIndex[meta.flashTableIdx].clean     = true;
+                s_fileIndex[meta.flashTableIdx].crc       = meta.crcValue;
+                s_fileIndex[meta.flashTableIdx].crcValid  = true;
+            }
 
         exit:
-            vPortFree(meta);
-            meta = NULL;
-            vPortFree(flashMap);
-            flashMap = NULL;
-            vPortFree(flashFile);
-            flashFile = NULL;
             xSemaphoreGive(s_fileLock);
         }
     }
@@ -818,10 +1858,8 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len)
     {
         if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
         {
-            file_meta_t *meta          = NULL;
-            uint8_t *flashFile         = NULL;
-            sln_flash_map_t *flashMap  = NULL;
-            sln_file_header_t *currHdr = NULL;
+            file_meta_t meta          = {0};
+            sln_file_header_t currHdr = {0};
 
             ret = SLN_FLASH_MGMT_OK;
 
@@ -832,59 +1870,29 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len)
                 goto exit;
             }
 
-            meta = (file_meta_t *)pvPortMalloc(sizeof(file_meta_t));
-
-            if (NULL == meta)
-            {
-                ret = SLN_FLASH_MGMT_ENOMEM;
-                goto exit;
-            }
-            else
-            {
-                // Clear out data
-                memset(meta, 0x00, sizeof(file_meta_t));
-            }
-
             // Get file meta info
-            ret = get_file_info_from_name(meta, name);
-
-            if (SLN_FLASH_MGMT_ENOENTRY == ret)
-            {
-                goto exit;
-            }
-
-            // Get current flash address from map
-            flashMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
-
-            if (NULL == flashMap)
-            {
-                ret = SLN_FLASH_MGMT_ENOMEM;
-                goto exit;
-            }
-
-            // Copy sector file map to ram
-            ret = get_sector_file_map(meta, flashMap);
+            ret = get_file_info_from_name(&meta, name);
 
             if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            currHdr = (sln_file_header_t *)pvPortMalloc(sizeof(sln_file_header_t));
+            // Get current flash address from the file index
+            ret = get_current_file_from_index(&meta);
 
-            if (NULL == currHdr)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM2;
                 goto exit;
             }
 
             // Get current file from flash
-            SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)currHdr, sizeof(sln_file_header_t));
+            SLN_Read_Flash_At_Address(meta.fileHeadAddr, (uint8_t *)&currHdr, sizeof(sln_file_header_t));
 
             if (NULL != len)
             {
                 // Update the reference with file size
-                *len = get_entry_file_size(currHdr);
+                *len = get_entry_file_size(&currHdr);
             }
             else
             {
@@ -893,62 +1901,60 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len)
                 goto exit;
             }
 
-            ret = set_file_size_info(meta, *len);
-
-            if (SLN_FLASH_MGMT_OK != ret)
+            if (meta.useEncryption)
             {
-                goto exit;
-            }
+                // The plain text size, encrypted again in the format of the file to take the same size
+                meta.legacyCrypt  = (SLN_FLASH_FILE_FORMAT_LEGACY == currHdr.format);
+                meta.dataCryptLen = *len;
+                ret               = get_file_plain_len(&meta);
+                *len              = meta.dataPlainLen;
 
-            // Build File
-            flashFile = (uint8_t *)pvPortMalloc(meta->fileSize);
+                if (SLN_FLASH_MGMT_OK != ret)
+                {
+                    goto exit;
+                }
+            }
 
-            if (NULL == flashFile)
+            if (s_flashEntries[meta.flashTableIdx].isLogged)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM3;
-                goto exit;
+                // Saved again in the current format
+                meta.legacyCrypt = false;
             }
 
-            // Indicate that this is updated so we won't use CRC in NVM
-            currHdr->clean = 0;
-
-            // Copy in current header data
-            memcpy(flashFile, currHdr, sizeof(sln_file_header_t));
-
-            // Set data, will enrypt if necessary
-            ret = set_file_data(meta, flashFile, data);
+            ret = set_file_size_info(&meta, *len);
 
             if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            // Run crc on file data
-            ret = calc_crc_32(meta, flashFile + sizeof(sln_file_header_t), get_entry_file_size(currHdr));
-
-            if (kStatus_Success != ret)
+            if (s_flashEntries[meta.flashTableIdx].isLogged)
             {
+                // Appending a new record costs the same as an update in place, and keeps the CRC in NVM valid
+                ret = save_log_file(&meta, data);
                 goto exit;
             }
 
-            // Update ram list
-            if (NULL != s_flashCrcList)
+            // Indicate that this is updated so we won't use CRC in NVM
+            currHdr.clean = 0;
+
+            // Run crc on file data, encrypting it if necessary
+            ret = calc_file_crc(&meta, data);
+
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                s_flashCrcList[meta->flashTableIdx] = meta->crcValue;
+                goto exit;
             }
 
+            // Update the file index; the CRC in NVM is not valid anymore
+            s_fileIndex[meta.flashTableIdx].clean    = false;
+            s_fileIndex[meta.flashTableIdx].crc      = meta.crcValue;
+            s_fileIndex[meta.flashTableIdx].crcValid = true;
+
             // Overwrite current entry
-            ret = write_file(meta, flashFile);
+            ret = write_file(&meta, &currHdr, data);
 
         exit:
-            vPortFree(flashMap);
-            flashMap = NULL;
-            vPortFree(currHdr);
-            currHdr = NULL;
-            vPortFree(flashFile);
-            flashFile = NULL;
-            vPortFree(meta);
-            meta = NULL;
             xSemaphoreGive(s_fileLock);
         }
     }
@@ -956,7 +1962,7 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len)
     return ret;
 }
 
-int32_t SLN_FLASH_MGMT_ReadDataPtr(const char *name, const uint8_t **data, uint32_t *len)
+int32_t SLN_FLASH_MGMT_UpdateRange(const char *name, uint32_t offset, const uint8_t *data, uint32_t len)
 {
     int32_t ret = SLN_FLASH_MGMT_ENOLOCK;
 
@@ -964,113 +1970,66 @@ int32_t SLN_FLASH_MGMT_ReadDataPtr(const char *name, const uint8_t **data, uint3
     {
         if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
         {
-            sln_flash_map_t *flashMap   = NULL;
-            sln_file_header_t *flashHdr = NULL;
-            file_meta_t *meta           = NULL;
+            file_meta_t meta   = {0};
+            uint32_t sizeBytes = 0;
 
             ret = SLN_FLASH_MGMT_OK;
 
-            meta = (file_meta_t *)pvPortMalloc(sizeof(file_meta_t));
-
-            if (NULL == meta)
+            if ((NULL == data) || (0 == len))
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
+                // Bail out, no valid pointer
+                ret = SLN_FLASH_MGMT_EINVAL;
                 goto exit;
             }
-            else
-            {
-                // Clear out data
-                memset(meta, 0x00, sizeof(file_meta_t));
-            }
 
             // Get file meta info
-            ret = get_file_info_from_name(meta, name);
+            ret = get_file_info_from_name(&meta, name);
 
-            if (SLN_FLASH_MGMT_ENOENTRY == ret)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            // Get current flash address from map
-            flashMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
-
-            if (NULL == flashMap)
+            if (0 == s_fileIndex[meta.flashTableIdx].headAddr)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
+                // No previous save
+                ret = SLN_FLASH_MGMT_ENOENTRY2;
                 goto exit;
             }
 
-            // Copy sector file map to ram
-            ret = get_sector_file_map(meta, flashMap);
-
-            if (SLN_FLASH_MGMT_OK != ret)
+            if (s_flashEntries[meta.flashTableIdx].isLogged)
             {
+                ret = update_log_range(&meta, offset, data, len);
                 goto exit;
             }
 
-            // Get the file header
-            flashHdr = (sln_file_header_t *)pvPortMalloc(sizeof(sln_file_header_t));
+            // Get current flash address from the file index
+            ret = get_current_file_from_index(&meta);
 
-            if (NULL == flashHdr)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM2;
                 goto exit;
             }
 
-            SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)flashHdr, sizeof(sln_file_header_t));
-
-            meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileHeadAddr + sizeof(sln_file_header_t));
-
-            // Run crc on file data
-            ret = calc_crc_32(meta, (uint8_t *)meta->fileDataAddr, get_entry_file_size(flashHdr));
-
-            if (kStatus_Success != ret)
+            if (meta.useEncryption)
             {
+                // CBC chaining, the data after the range changes too
+                ret = SLN_FLASH_MGMT_EINVAL3;
                 goto exit;
             }
 
-            // Compare CRC
-            if (flashHdr->clean)
-            {
-                if (flashHdr->crc != meta->crcValue)
-                {
-                    /* Return the data to the calling function to decide what to do in CRC failure */
-                    ret = SLN_FLASH_MGMT_EENCRYPT2;
-                }
-            }
-            else
-            {
-                if (NULL != s_flashCrcList)
-                {
-                    if (s_flashCrcList[meta->flashTableIdx] != meta->crcValue)
-                    {
-                        /* Return the data to the calling function to decide what to do in CRC failure */
-                        ret = SLN_FLASH_MGMT_EENCRYPT2;
-                    }
-                }
-                else
-                {
-                    ret = SLN_FLASH_MGMT_ENOMEM;
-                    goto exit;
-                }
-            }
+            sizeBytes = s_fileIndex[meta.flashTableIdx].sizeBytes;
 
-            if (len != NULL)
-            {
-                *len = get_entry_file_size(flashHdr);
-            }
-            if (data != NULL)
+            if ((offset > sizeBytes) || (len > sizeBytes - offset))
             {
-                *data = (const uint8_t *)meta->fileDataAddr;
+                // The file size can't change
+                ret = SLN_FLASH_MGMT_EINVAL2;
+                goto exit;
             }
 
+            ret = update_sector_range(&meta, offset, data, len);
+
         exit:
-            vPortFree(flashHdr);
-            flashHdr = NULL;
-            vPortFree(flashMap);
-            flashMap = NULL;
-            vPortFree(meta);
-            meta = NULL;
             xSemaphoreGive(s_fileLock);
         }
     }
@@ -1078,7 +2037,7 @@ int32_t SLN_FLASH_MGMT_ReadDataPtr(const char *name, const uint8_t **data, uint3
     return ret;
 }
 
-int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
+int32_t SLN_FLASH_MGMT_ReadDataPtr(const char *name, const uint8_t **data, uint32_t *len)
 {
     int32_t ret = SLN_FLASH_MGMT_ENOLOCK;
 
@@ -1086,180 +2045,131 @@ int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
     {
         if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
         {
-            sln_flash_map_t *flashMap   = NULL;
-            sln_file_header_t *flashHdr = NULL;
-            file_meta_t *meta           = NULL;
-            uint8_t *msgDec             = NULL;
-
-            ret = SLN_FLASH_MGMT_OK;
+            file_meta_t meta = {0};
 
-            meta = (file_meta_t *)pvPortMalloc(sizeof(file_meta_t));
+            // Get file meta info
+            ret = get_file_info_from_name(&meta, name);
 
-            if (NULL == meta)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
                 goto exit;
             }
-            else
-            {
-                // Clear out data
-                memset(meta, 0x00, sizeof(file_meta_t));
-            }
 
-            // Get file meta info
-            ret = get_file_info_from_name(meta, name);
+            // Get current flash address from the file index
+            ret = get_current_file_from_index(&meta);
 
-            if (SLN_FLASH_MGMT_ENOENTRY == ret)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            // Get current flash address from map
-            flashMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
+            meta.fileDataAddr = SLN_Flash_Get_Read_Address(meta.fileHeadAddr + sizeof(sln_file_header_t));
+
+            ret = check_file_crc(&meta);
 
-            if (NULL == flashMap)
+            if ((SLN_FLASH_MGMT_OK != ret) && (SLN_FLASH_MGMT_EENCRYPT2 != ret))
             {
-                ret = SLN_FLASH_MGMT_ENOMEM;
                 goto exit;
             }
 
-            // Copy sector file map to ram
-            ret = get_sector_file_map(meta, flashMap);
-
-            if (SLN_FLASH_MGMT_OK != ret)
+            if (len != NULL)
             {
-                goto exit;
+                *len = s_fileIndex[meta.flashTableIdx].sizeBytes;
             }
-
-            // Get the file header
-            flashHdr = (sln_file_header_t *)pvPortMalloc(sizeof(sln_file_header_t));
-
-            if (NULL == flashHdr)
+            if (data != NULL)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM2;
-                goto exit;
+                *data = (const uint8_t *)meta.fileDataAddr;
             }
 
-            SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)flashHdr, sizeof(sln_file_header_t));
+        exit:
+            xSemaphoreGive(s_fileLock);
+        }
+    }
 
-            // Set size info based on header information;
-            // at this point dataPlainLen and dataCryptLen will be equal if using encryption
-            ret = set_file_size_info(meta, get_entry_file_size(flashHdr));
+    return ret;
+}
 
-            if (SLN_FLASH_MGMT_OK != ret)
-            {
-                goto exit;
-            }
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
+{
+    int32_t ret = SLN_FLASH_MGMT_ENOLOCK;
+
+    if (NULL != s_fileLock)
+    {
+        if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
+        {
+            file_meta_t meta = {0};
 
-            // Allocate enough space for what is in NVM
-            msgDec = (uint8_t *)pvPortMalloc(get_entry_file_size(flashHdr));
+            // Get file meta info
+            ret = get_file_info_from_name(&meta, name);
 
-            if (NULL == msgDec)
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                ret = SLN_FLASH_MGMT_ENOMEM3;
                 goto exit;
             }
 
-            // Copy data into temporary buffer; decryption will recover true plain text length
-            ret = get_file_data(meta, msgDec);
+            // Get current flash address from the file index
+            ret = get_current_file_from_index(&meta);
 
             if (SLN_FLASH_MGMT_OK != ret)
             {
                 goto exit;
             }
 
-            // Make sure we have a good address for CRC
-            if (FlexSPI_AMBA_BASE > meta->fileDataAddr)
-            {
-                meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileDataAddr);
-            }
-
-            // Run crc on file data
-            ret = calc_crc_32(meta, (uint8_t *)meta->fileDataAddr, get_entry_file_size(flashHdr));
-
-            if (kStatus_Success != ret)
+            if (NULL == len)
             {
+                // Return an invalid input
+                ret = SLN_FLASH_MGMT_EINVAL;
                 goto exit;
             }
 
-            // Compare CRC
-            if (flashHdr->clean)
-            {
-                if (flashHdr->crc != meta->crcValue)
-                {
-                    /* Return the data to the calling function to decide what to do in CRC failure */
-                    ret = SLN_FLASH_MGMT_EENCRYPT2;
-                }
-            }
-            else
-            {
-                if (NULL != s_flashCrcList)
-                {
-                    if (s_flashCrcList[meta->flashTableIdx] != meta->crcValue)
-                    {
-                        /* Return the data to the calling function to decide what to do in CRC failure */
-                        ret = SLN_FLASH_MGMT_EENCRYPT2;
-                    }
-                }
-                else
-                {
-                    ret = SLN_FLASH_MGMT_ENOMEM;
-                    goto exit;
-                }
-            }
+            // Read the whole file straight into the caller's buffer
+            ret = read_file_data(&meta, 0, data, len, true);
 
-            // Update len reference
-            if (NULL != len)
-            {
-                // Valid reference passed from calling function
+        exit:
+            xSemaphoreGive(s_fileLock);
+        }
+    }
 
-                if (NULL == data)
-                {
-                    // Make sure we send back file size
-                    *len = meta->dataPlainLen;
+    return ret;
+}
 
-                    // Bail out assuming user just wanted size of file on NVM
-                    ret = SLN_FLASH_MGMT_OK;
-                    goto exit;
-                }
+int32_t SLN_FLASH_MGMT_ReadChunk(const char *name, uint32_t offset, uint8_t *data, uint32_t *len)
+{
+    int32_t ret = SLN_FLASH_MGMT_ENOLOCK;
 
-                if (0 < *len)
-                {
-                    // Calling function has specified a length to copy
-                    if (*len > meta->dataPlainLen)
-                    {
-                        // Calling function is copying too much data
-                        *len = meta->dataPlainLen;
-                    }
-                }
-                else
-                {
-                    // Update the reference with file size
-                    *len = meta->dataPlainLen;
-                }
-            }
-            else
+    if (NULL != s_fileLock)
+    {
+        if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
+        {
+            file_meta_t meta = {0};
+
+            if ((NULL == data) || (NULL == len))
             {
                 // Return an invalid input
                 ret = SLN_FLASH_MGMT_EINVAL;
                 goto exit;
             }
 
-            // Copy to caller's data buffer
-            if (NULL != data)
+            // Get file meta info
+            ret = get_file_info_from_name(&meta, name);
+
+            if (SLN_FLASH_MGMT_OK != ret)
+            {
+                goto exit;
+            }
+
+            // Get current flash address from the file index
+            ret = get_current_file_from_index(&meta);
+
+            if (SLN_FLASH_MGMT_OK != ret)
             {
-                memcpy(data, msgDec, *len);
+                goto exit;
             }
 
+            // The CRC covers the whole file, check it once with the first chunk
+            ret = read_file_data(&meta, offset, data, len, (0 == offset));
+
         exit:
-            vPortFree(msgDec);
-            msgDec = NULL;
-            vPortFree(flashHdr);
-            flashHdr = NULL;
-            vPortFree(flashMap);
-            flashMap = NULL;
-            vPortFree(meta);
-            meta = NULL;
             xSemaphoreGive(s_fileLock);
         }
     }
@@ -1269,45 +2179,59 @@ int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
 
 int32_t SLN_FLASH_MGMT_Erase(const char *name)
 {
-    int32_t ret           = SLN_FLASH_MGMT_OK;
-    uint32_t fileNameLen  = safe_strlen(name, SLN_FLASH_MGMT_FILE_NAME_LEN);
-    uint32_t fileBaseAddr = 0;
+    int32_t ret            = SLN_FLASH_MGMT_OK;
+    uint32_t flashTableIdx = 0;
 
-    // Get file address
-    for (uint32_t idx = 0; idx < s_fileCount; idx++)
+    if (NULL == s_fileLock)
     {
-        if (0 == memcmp(s_flashEntries[idx].name, name, fileNameLen))
-        {
-            fileBaseAddr = s_flashEntries[idx].address;
-            break;
-        }
+        return SLN_FLASH_MGMT_ENOLOCK;
     }
 
-    // Exit if the entry is not found
-    if (0 == fileBaseAddr)
+    if (pdTRUE != xSemaphoreTake(s_fileLock, portMAX_DELAY))
     {
-        ret = SLN_FLASH_MGMT_ENOENTRY;
-        goto exit;
+        return SLN_FLASH_MGMT_ERETRY;
     }
 
-    if (NULL != s_flashMgmtCbs.pre_sector_erase_cb)
+    if (NULL == name)
     {
-        configPRINTF(("Erasing file %s ... \r\n", name));
-        s_flashMgmtCbs.pre_sector_erase_cb();
+        ret = SLN_FLASH_MGMT_EINVAL;
+        goto exit;
     }
 
-    ret = SLN_Erase_Sector(fileBaseAddr);
+    // Get file address; exit if the entry is not found
+    ret = find_file_in_index(name, &flashTableIdx);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        goto exit;
+    }
 
-    if (NULL != s_flashMgmtCbs.post_sector_erase_cb)
+    if (s_flashEntries[flashTableIdx].isLogged)
+    {
+        // A removal record, the sector erase is left to the store compaction
+        ret = SLN_FLASH_KVS_Delete(flashTableIdx);
+    }
+    else
     {
+        configPRINTF(("Erasing file %s ... \r\n", name));
+
+        ret = erase_sector(s_flashEntries[flashTableIdx].address);
+
         configPRINTF(("Erase operation for file %s finished, return code %d\r\n", name, ret));
-        s_flashMgmtCbs.post_sector_erase_cb();
     }
 
+    // The file is gone from NVM
+    s_fileIndex[flashTableIdx].headAddr  = 0;
+    s_fileIndex[flashTableIdx].mapIdx    = 0;
+    s_fileIndex[flashTableIdx].sizeBytes = 0;
+    s_fileIndex[flashTableIdx].crc       = 0;
+    s_fileIndex[flashTableIdx].crcValid  = false;
+
 exit:
+    xSemaphoreGive(s_fileLock);
+
     return ret;
 }
-
 int32_t SLN_FLASH_MGMT_Deinit(sln_flash_entry_t *flashEntries, uint8_t erase)
 {
     int32_t ret          = SLN_FLASH_MGMT_OK;
@@ -1338,7 +2262,7 @@ int32_t SLN_FLASH_MGMT_Deinit(sln_flash_entry_t *flashEntries, uint8_t erase)
 
         if (erase)
         {
-            ret = SLN_Erase_Sector(flashEntries[idx].address);
+            ret = erase_sector(flashEntries[idx].address);
 
             if (SLN_FLASH_MGMT_OK != ret)
             {
@@ -1350,8 +2274,13 @@ int32_t SLN_FLASH_MGMT_Deinit(sln_flash_entry_t *flashEntries, uint8_t erase)
         idx++;
     }
 
-    vPortFree(s_flashCrcList);
-    s_flashCrcList = NULL;
+    if (erase && (SLN_FLASH_MGMT_OK == ret) && (SLN_FLASH_MGMT_OK != erase_sector(SLN_FLASH_MGMT_SPARE_ADDR)))
+    {
+        ret = SLN_FLASH_MGMT_EIO;
+    }
+
+    memset(s_fileIndexBuckets, FILE_INDEX_EMPTY_SLOT, sizeof(s_fileIndexBuckets));
+    s_fileCount = 0;
 
     /* Create a lock with priority inheritance */
     vSemaphoreDelete(s_fileLock);
@@ -46,6 +46,26 @@
 #define SLN_FLASH_MAP_SIZE           (FLASH_PAGE_SIZE)
 #define SLN_FLASH_MAX_MAP_ENTRIES    ((SECTOR_SIZE / FLASH_PAGE_SIZE) - 1)
 
+/*!
+ * Sector a full file sector is compacted into before it is erased, then copied back from.
+ * A compaction cut by a power loss is finished by the next SLN_FLASH_MGMT_Init from this copy.
+ */
+#ifndef SLN_FLASH_MGMT_SPARE_ADDR
+#define SLN_FLASH_MGMT_SPARE_ADDR (FICA_FREE_MEM_START_ADDR)
+#if (FICA_FREE_MEM_START_ADDR + SECTOR_SIZE) > FICA_FREE_MEM_END_ADDR
+#error "No free sector for the spare sector of the file system"
+#endif
+#endif
+
+/*!
+ * Size of the RAM scratch buffer used instead of the heap.
+ * Encrypted logged files go through it, bigger ones fail with SLN_FLASH_MGMT_ENOMEM2.
+ * Other encrypted files are encrypted and decrypted one page at a time, whatever their size.
+ */
+#ifndef SLN_FLASH_MGMT_SCRATCH_SIZE
+#define SLN_FLASH_MGMT_SCRATCH_SIZE (2 * FLASH_PAGE_SIZE)
+#endif
+
 #define SLN_FLASH_MGMT_MAP_OLD     (0x00)
 #define SLN_FLASH_MGMT_MAP_CURRENT (0xAA)
 #define SLN_FLASH_MGMT_MAP_FREE    (0xFF)
@@ -79,11 +99,16 @@ typedef enum _sln_flash_mgmt_status
 #define SLN_FLASH_PLAIN     (false)
 #define SLN_FLASH_ENCRYPTED (true)
 
+/* Store a file in its own sector or in the key/value store log, shared by the small files */
+#define SLN_FLASH_SECTOR (false)
+#define SLN_FLASH_LOGGED (true)
+
 typedef struct _sln_flash_entry
 {
     char name[SLN_FLASH_MGMT_FILE_NAME_LEN + 1];
     uint32_t address;
     bool isEncrypted;
+    bool isLogged; /*! File stored in the key/value store; its sector only holds data of older firmwares */
 } sln_flash_entry_t;
 
 typedef struct _sln_flash_map
@@ -99,13 +124,19 @@ typedef struct _sln_flash_map
     (24UL) /*! Extended number of bits used for file size in the SLN flash entry header */
 #define SLN_FLASH_FILE_HEADER_EXT_MAX_SIZE (0x1000000UL) /*! Extended maximum file size per flash entry */
 
+/* Formats of the file data in the header, each one clears a bit of the previous one */
+#define SLN_FLASH_FILE_FORMAT_LEGACY \
+    (3U) /*! Older firmware: block aligned encrypted data has no padding block, see SLN_Encrypt_Stream_Init */
+#define SLN_FLASH_FILE_FORMAT_PADDED (2U) /*! Encrypted data always ends with a padded block */
+
 typedef struct _sln_file_header
 {
     uint32_t valid : 1;         /*! Indicates this file is valid to read */
     uint32_t clean : 1;         /*! Indicates this file has been updated in place, if 0 CRC is invalid in NVM */
     uint32_t sizeBytes : 14;    /*! Bits 13:0 for file size */
     uint32_t isSize14bits : 1;  /*! Limits to 16 KB file size or extends to 16 MB */
-    uint32_t reserved : 5;      /*! Padding */
+    uint32_t format : 2;        /*! Format of the file data, SLN_FLASH_FILE_FORMAT_PADDED for new files */
+    uint32_t reserved : 3;      /*! Padding */
     uint32_t extSizeBytes : 10; /*! Bits 23:14 for extended file size */
     uint32_t crc : 32;          /*! 32 bits of CRC */
 } sln_file_header_t;
@@ -133,6 +164,8 @@ int32_t SLN_FLASH_MGMT_Init(sln_flash_entry_t *flashEntries, uint8_t erase);
 
 /*!
  * @brief Save to a named entry
+ *     The new copy is complete in the flash before the current one is dropped: a failed save, or a power
+ *     cut during the save, leaves the current copy.
  *
  * @param name String name of entry/file to save data into
  * @param data Pointer to data to save to file
@@ -153,6 +186,27 @@ int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len);
  */
 int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len);
 
+/*!
+ * @brief Change a range of bytes of a named entry, the file size stays the same
+ *
+ * If the new bytes only clear bits of the flash, only the pages holding the range are programmed and the
+ * file is marked updated in place, as with SLN_FLASH_MGMT_Update. Otherwise a copy of the file with the range
+ * changed is appended in its sector. The CRC is patched from the changed bytes, not computed over the file.
+ * A plain logged file gets a delta record of the key/value store, holding the patched CRC and the data up to the
+ * end of the range, folded into a full record by the next read. Other logged files are saved again as a new record
+ * through the scratch buffer. Encrypted files stored in their own sector are not supported: with CBC chaining the
+ * encrypted data after the range changes too.
+ *
+ * @param name String name of entry/file to update
+ * @param offset Offset in bytes of the range in the file data
+ * @param data Pointer to the new bytes of the range
+ * @param len Length in bytes of the range
+ *
+ * @returns Status of the update; SLN_FLASH_MGMT_EOVERFLOW2 if the sector has no room left for the copy,
+ *          the file must then be saved with SLN_FLASH_MGMT_Save
+ */
+int32_t SLN_FLASH_MGMT_UpdateRange(const char *name, uint32_t offset, const uint8_t *data, uint32_t len);
+
 /*!
  * @brief Read from a named entry
  *
@@ -202,6 +256,22 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len);
  */
 int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len);
 
+/*!
+ * @brief Read part of a named entry, to read a file in chunks without a buffer for the whole file
+ *
+ * The CRC of the whole file is checked when offset is 0, and SLN_FLASH_MGMT_EENCRYPT2 returned on mismatch
+ * (the data is still copied). Encrypted files are decrypted in the scratch buffer at each call.
+ *
+ * @param name String name of entry/file to read from
+ * @param offset Offset in bytes of the chunk in the file data
+ * @param data Pointer to data to copy data into
+ * @param len Pointer for length in bytes to read, 0 to read up to the end of the file;
+ *            reduced to the number of bytes copied, 0 past the end of the file
+ *
+ * @returns Status of read
+ */
+int32_t SLN_FLASH_MGMT_ReadChunk(const char *name, uint32_t offset, uint8_t *data, uint32_t *len);
+
 /*!
  * @brief Read from a named entry and return pointer to constant data buffer in flash
  *
@@ -9,13 +9,37 @@
 #ifndef _SLN_FLASH_OPS_
 #define _SLN_FLASH_OPS_
 
+/*
+ * Flash operations used by sln_flash.c. A build defining SLN_FLASH_OPS_PORT to the name of a header
+ * replaces the FlexSPI HyperFlash ones with its own, e.g. sln_flash_sim.h for a Linux host; that header
+ * must define all the macros below and the HYPERFLASH_STATUS_* bits of the status register.
+ */
+#if defined(SLN_FLASH_OPS_PORT)
+
+#include SLN_FLASH_OPS_PORT
+
+#else
+
+#include "fsl_flexspi.h"
 #include "flexspi_hyper_flash_ops.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-#define sln_flash_ops_get_flash_id(a, b)    flexspi_nor_hyperflash_id(a, b)
-#define sln_flash_ops_page_program(a, b, c) flexspi_nor_flash_page_program_with_buffer(a, b, c)
+#define sln_flash_ops_get_flash_id(a, b)       flexspi_nor_hyperflash_id(a, b)
+#define sln_flash_ops_page_program(a, b, c)    flexspi_nor_flash_page_program_with_buffer(a, b, c)
+#define sln_flash_ops_erase_sector(a, b)       flexspi_nor_flash_erase_sector(a, b)
+#define sln_flash_ops_erase_sector_start(a, b) flexspi_nor_flash_erase_sector_start(a, b)
+#define sln_flash_ops_erase_suspend(a, b)      flexspi_nor_flash_erase_suspend(a, b)
+#define sln_flash_ops_erase_resume(a, b)       flexspi_nor_flash_erase_resume(a, b)
+#define sln_flash_ops_read_status(a, b)        flexspi_nor_read_status(a, b)
+#define sln_flash_ops_wait_bus_busy(a)         flexspi_nor_wait_bus_busy(a)
+#define sln_flash_ops_update_lut(a, b, c, d)   FLEXSPI_UpdateLUT(a, b, c, d)
+#define sln_flash_ops_reset(a)                 FLEXSPI_SoftwareReset(a)
+#define sln_flash_ops_read_address(a)          (FlexSPI_AMBA_BASE + (a))
+
+#endif /* SLN_FLASH_OPS_PORT */
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
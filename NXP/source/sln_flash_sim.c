@@ -0,0 +1,428 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#if defined(SLN_FLASH_SIM)
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sln_flash_sim.h"
+
+#define SECTOR_MASK (~((uint32_t)SECTOR_SIZE - 1U))
+
+/* Sector erase run in steps, only one at a time as on the HyperFlash */
+typedef struct _sim_erase
+{
+    bool active;        /* Started and not finished */
+    bool suspended;     /* Parked by SLN_FLASH_SIM_EraseSuspend */
+    uint32_t address;   /* Start of the sector */
+    uint64_t resumedAt; /* Time the erase last ran from */
+    uint32_t leftUs;    /* Erase time left when it last ran */
+} sim_erase_t;
+
+static uint8_t *s_flash = NULL;
+
+static sln_flash_sim_config_t s_config = {0};
+static sln_flash_sim_stats_t s_stats   = {0};
+static sim_erase_t s_erase             = {0};
+
+static uint32_t s_random     = 1;
+static uint32_t s_operations = 0;
+static bool s_poweredOff     = false;
+
+/* xorshift32, enough for the fault draws and reproducible with the seed */
+static uint32_t sim_random(void)
+{
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+
+    return s_random;
+}
+
+static void sim_wait(uint32_t us)
+{
+    uint64_t end = SLN_FLASH_SIM_GetTimeUs() + us;
+
+    // Busy wait, the flash driver blocks the core for the same time
+    while (SLN_FLASH_SIM_GetTimeUs() < end)
+    {
+    }
+}
+
+static bool sim_in_range(uint32_t address, uint32_t len)
+{
+    return (NULL != s_flash) && (address < SLN_FLASH_SIM_SIZE) && (len <= (SLN_FLASH_SIM_SIZE - address));
+}
+
+/*
+ * Everything is refused once the power is cut or while an erase runs. While an erase is suspended, the
+ * other sectors can be programmed but no other erase can start, as on the HyperFlash.
+ */
+static bool sim_busy(uint32_t address, bool isErase)
+{
+    bool busy = s_poweredOff || (s_erase.active && (isErase || !s_erase.suspended)) ||
+                (s_erase.active && ((address & SECTOR_MASK) == s_erase.address));
+
+    if (busy)
+    {
+        s_stats.busyErrors++;
+    }
+
+    return busy;
+}
+
+/* Counts the program or erase and tells whether the power is cut during it */
+static bool sim_power_cut(void)
+{
+    if ((0 == s_config.powerCutAfter) || (++s_operations <= s_config.powerCutAfter))
+    {
+        return false;
+    }
+
+    s_operations   = 0;
+    s_poweredOff   = true;
+    s_erase.active = false;
+    s_stats.powerCuts++;
+
+    return true;
+}
+
+static void sim_erase_done(uint32_t address, uint32_t len)
+{
+    memset(&s_flash[address], 0xFF, len);
+
+    if (SECTOR_SIZE == len)
+    {
+        s_stats.erases++;
+    }
+}
+
+status_t SLN_FLASH_SIM_Init(void)
+{
+    struct stat st;
+    void *flash  = MAP_FAILED;
+    bool created = false;
+    int fd       = -1;
+
+    if (NULL != s_flash)
+    {
+        return kStatus_Success;
+    }
+
+    fd = open(SLN_FLASH_SIM_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        return kStatus_Fail;
+    }
+
+    if ((0 == fstat(fd, &st)) && (st.st_size < SLN_FLASH_SIM_SIZE))
+    {
+        created = (0 == ftruncate(fd, SLN_FLASH_SIM_SIZE));
+    }
+
+    // The file system keeps the flash addresses in 32 bits, as the target does
+#if defined(MAP_32BIT)
+    flash = mmap(NULL, SLN_FLASH_SIM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_32BIT, fd, 0);
+#else
+    flash = mmap(NULL, SLN_FLASH_SIM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    close(fd);
+
+    if ((MAP_FAILED == flash) || ((uintptr_t)flash + SLN_FLASH_SIM_SIZE > UINT32_MAX))
+    {
+        if (MAP_FAILED != flash)
+        {
+            munmap(flash, SLN_FLASH_SIM_SIZE);
+        }
+
+        return kStatus_Fail;
+    }
+
+    s_flash = (uint8_t *)flash;
+
+    if (created)
+    {
+        // A new flash comes erased
+        memset(s_flash, 0xFF, SLN_FLASH_SIM_SIZE);
+    }
+
+    return kStatus_Success;
+}
+
+void SLN_FLASH_SIM_SetConfig(const sln_flash_sim_config_t *config)
+{
+    if (NULL == config)
+    {
+        return;
+    }
+
+    s_config     = *config;
+    s_random     = (0 != config->seed) ? config->seed : 1;
+    s_operations = 0;
+}
+
+void SLN_FLASH_SIM_PowerOn(void)
+{
+    s_poweredOff = false;
+    s_erase      = (sim_erase_t){0};
+}
+
+bool SLN_FLASH_SIM_IsPoweredOff(void)
+{
+    return s_poweredOff;
+}
+
+void SLN_FLASH_SIM_FlipBit(uint32_t address, uint8_t bit)
+{
+    if (sim_in_range(address, 1) && (bit < 8))
+    {
+        s_flash[address] ^= (uint8_t)(1U << bit);
+        s_stats.bitFlips++;
+    }
+}
+
+void SLN_FLASH_SIM_GetStats(sln_flash_sim_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        *stats = s_stats;
+    }
+}
+
+void SLN_FLASH_SIM_ResetStats(void)
+{
+    s_stats = (sln_flash_sim_stats_t){0};
+}
+
+uint64_t SLN_FLASH_SIM_GetTimeUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000U) + ((uint64_t)now.tv_nsec / 1000U);
+}
+
+status_t SLN_FLASH_SIM_GetId(uint8_t *pid)
+{
+    *pid = SLN_FLASH_SIM_ID;
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_PageProgram(uint32_t address, const uint8_t *src)
+{
+    uint32_t len = FLASH_PAGE_SIZE;
+    bool setsBit = false;
+
+    if ((address % FLASH_PAGE_SIZE) || !sim_in_range(address, FLASH_PAGE_SIZE) || (NULL == src))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (sim_busy(address, false))
+    {
+        return kStatus_Fail;
+    }
+
+    // The 0xFF bytes are the padding of the partial page writes, leaving the flash as it is
+    for (uint32_t idx = 0; idx < FLASH_PAGE_SIZE; idx++)
+    {
+        if ((0xFFU != src[idx]) && ((s_flash[address + idx] & src[idx]) != src[idx]))
+        {
+            setsBit = true;
+            break;
+        }
+    }
+
+    if (setsBit)
+    {
+        s_stats.norViolations++;
+
+        if (s_config.strictNor)
+        {
+            return kStatus_Fail;
+        }
+    }
+
+    sim_wait(s_config.programUs);
+
+    if (sim_power_cut())
+    {
+        // Only the start of the page made it
+        len = sim_random() % FLASH_PAGE_SIZE;
+    }
+
+    // A program can only clear bits
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        s_flash[address + idx] &= src[idx];
+    }
+
+    if (s_poweredOff)
+    {
+        return kStatus_Fail;
+    }
+
+    s_stats.programs++;
+    s_stats.bytesProgrammed += FLASH_PAGE_SIZE;
+
+    if ((0 != s_config.bitRotPpm) && ((sim_random() % 1000000U) < s_config.bitRotPpm))
+    {
+        SLN_FLASH_SIM_FlipBit(address + (sim_random() % FLASH_PAGE_SIZE), (uint8_t)(sim_random() % 8));
+    }
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_EraseSector(uint32_t address)
+{
+    address &= SECTOR_MASK;
+
+    if (!sim_in_range(address, SECTOR_SIZE))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (sim_busy(address, true))
+    {
+        return kStatus_Fail;
+    }
+
+    sim_wait(s_config.eraseUs);
+
+    if (sim_power_cut())
+    {
+        // Part of the sector erased, the rest left as it was
+        sim_erase_done(address, sim_random() % SECTOR_SIZE);
+        return kStatus_Fail;
+    }
+
+    sim_erase_done(address, SECTOR_SIZE);
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_EraseSectorStart(uint32_t address)
+{
+    address &= SECTOR_MASK;
+
+    if (!sim_in_range(address, SECTOR_SIZE))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (sim_busy(address, true))
+    {
+        return kStatus_Fail;
+    }
+
+    s_erase.active    = true;
+    s_erase.suspended = false;
+    s_erase.address   = address;
+    s_erase.resumedAt = SLN_FLASH_SIM_GetTimeUs();
+    s_erase.leftUs    = s_config.eraseUs;
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_EraseSuspend(uint32_t address)
+{
+    uint64_t ranUs = 0;
+
+    if (!s_erase.active || s_erase.suspended || ((address & SECTOR_MASK) != s_erase.address))
+    {
+        return kStatus_Success;
+    }
+
+    if (s_config.suspendFails)
+    {
+        return kStatus_Fail;
+    }
+
+    ranUs = SLN_FLASH_SIM_GetTimeUs() - s_erase.resumedAt;
+
+    // The erase may have completed before the suspend, SLN_FLASH_SIM_ReadStatus ends it
+    if (ranUs < s_erase.leftUs)
+    {
+        s_erase.leftUs -= (uint32_t)ranUs;
+        s_erase.suspended = true;
+        s_stats.suspends++;
+    }
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_EraseResume(uint32_t address)
+{
+    if (s_poweredOff)
+    {
+        s_stats.busyErrors++;
+        return kStatus_Fail;
+    }
+
+    if (s_erase.active && s_erase.suspended && ((address & SECTOR_MASK) == s_erase.address))
+    {
+        s_erase.suspended = false;
+        s_erase.resumedAt = SLN_FLASH_SIM_GetTimeUs();
+    }
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_SIM_ReadStatus(uint32_t *value)
+{
+    if (s_poweredOff)
+    {
+        *value = HYPERFLASH_STATUS_READY | HYPERFLASH_STATUS_ERROR;
+        return kStatus_Success;
+    }
+
+    if (!s_erase.active)
+    {
+        *value = HYPERFLASH_STATUS_READY;
+    }
+    else if (s_erase.suspended)
+    {
+        *value = HYPERFLASH_STATUS_READY | HYPERFLASH_STATUS_ERASE_SUSPEND;
+    }
+    else if ((SLN_FLASH_SIM_GetTimeUs() - s_erase.resumedAt) >= s_erase.leftUs)
+    {
+        s_erase.active = false;
+
+        if (sim_power_cut())
+        {
+            sim_erase_done(s_erase.address, sim_random() % SECTOR_SIZE);
+            *value = HYPERFLASH_STATUS_READY | HYPERFLASH_STATUS_ERROR;
+        }
+        else
+        {
+            sim_erase_done(s_erase.address, SECTOR_SIZE);
+            *value = HYPERFLASH_STATUS_READY;
+        }
+    }
+    else
+    {
+        *value = 0;
+    }
+
+    return kStatus_Success;
+}
+
+uint32_t SLN_FLASH_SIM_GetReadAddress(uint32_t address)
+{
+    return (uint32_t)(uintptr_t)(s_flash + address);
+}
+
+#endif /* SLN_FLASH_SIM */
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_FLASH_SIM_
+#define _SLN_FLASH_SIM_
+
+/*!
+ * SLN Flash Simulator
+ *
+ * NOR flash simulated in a file mapped in memory, for running sln_flash_mgmt.c on a Linux host.
+ * A build selects it with -DSLN_FLASH_SIM -DSLN_FLASH_OPS_PORT=\"sln_flash_sim.h\".
+ *
+ * Like the HyperFlash, a page program can only clear bits and an erase sets a whole sector back to
+ * 0xFF. The programs and erases can take the time of the real flash, the erase run in steps by
+ * SLN_Erase_Sector_Step can be suspended, bits can rot after a program and the power can be cut in
+ * the middle of a program or an erase. The counters of the simulator give the write amplification.
+ *
+ * The flash content is kept in SLN_FLASH_SIM_FILE between two runs, as the real flash is across a
+ * power cut.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_common.h"
+#include "sln_flash_config.h"
+
+/*! @brief File holding the content of the simulated flash */
+#ifndef SLN_FLASH_SIM_FILE
+#define SLN_FLASH_SIM_FILE "sln_flash_sim.bin"
+#endif
+
+/*! @brief Size of the simulated flash, the addresses are offsets from its start as on the target */
+#ifndef SLN_FLASH_SIM_SIZE
+#define SLN_FLASH_SIM_SIZE FLASH_SIZE
+#endif
+
+/*! @brief ID returned by sln_flash_ops_get_flash_id */
+#define SLN_FLASH_SIM_ID (0x51U)
+
+/* Status register bits, same as the HyperFlash ones */
+#define HYPERFLASH_STATUS_READY         (0x8000U)
+#define HYPERFLASH_STATUS_ERASE_SUSPEND (0x0040U)
+#define HYPERFLASH_STATUS_ERROR         (0x3200U)
+
+/* Flash operations of sln_flash_ops.h, the FlexSPI base address is not used */
+#define sln_flash_ops_get_flash_id(a, b)       SLN_FLASH_SIM_GetId(b)
+#define sln_flash_ops_page_program(a, b, c)    SLN_FLASH_SIM_PageProgram(b, (const uint8_t *)(c))
+#define sln_flash_ops_erase_sector(a, b)       SLN_FLASH_SIM_EraseSector(b)
+#define sln_flash_ops_erase_sector_start(a, b) SLN_FLASH_SIM_EraseSectorStart(b)
+#define sln_flash_ops_erase_suspend(a, b)      SLN_FLASH_SIM_EraseSuspend(b)
+#define sln_flash_ops_erase_resume(a, b)       SLN_FLASH_SIM_EraseResume(b)
+#define sln_flash_ops_read_status(a, b)        SLN_FLASH_SIM_ReadStatus(b)
+#define sln_flash_ops_wait_bus_busy(a)         (kStatus_Success)
+#define sln_flash_ops_update_lut(a, b, c, d)   SLN_FLASH_SIM_Init()
+#define sln_flash_ops_reset(a)                 ((void)0)
+#define sln_flash_ops_read_address(a)          SLN_FLASH_SIM_GetReadAddress(a)
+
+/*! @brief Behavior of the simulator, all off when zeroed */
+typedef struct _sln_flash_sim_config
+{
+    uint32_t programUs;     /*!< programUs: Time taken by a page program. */
+    uint32_t eraseUs;       /*!< eraseUs: Time taken by a sector erase. */
+    bool strictNor;         /*!< strictNor: Fail the programs setting a bit back to 1, else the bit stays 0; the
+                                 0xFF bytes, padding of the partial pages, are not checked. */
+    uint32_t bitRotPpm;     /*!< bitRotPpm: Chance, per million programmed pages, of a bit flipped in the page. */
+    uint32_t powerCutAfter; /*!< powerCutAfter: The power is cut during the program or erase after this many. */
+    uint32_t seed;          /*!< seed: Seed of the bit rot and power cut draws, 1 if 0. */
+    bool suspendFails;      /*!< suspendFails: Fail the erase suspends, the erase keeps running. */
+} sln_flash_sim_config_t;
+
+/*! @brief Counters of the simulator */
+typedef struct _sln_flash_sim_stats
+{
+    uint32_t programs;        /*!< programs: Page programs done. */
+    uint32_t erases;          /*!< erases: Sector erases done. */
+    uint64_t bytesProgrammed; /*!< bytesProgrammed: Bytes of the programmed pages. */
+    uint32_t suspends;        /*!< suspends: Erases suspended. */
+    uint32_t norViolations;   /*!< norViolations: Programs that wanted a bit at 0 set to 1. */
+    uint32_t busyErrors;      /*!< busyErrors: Operations refused during an erase or after a power cut. */
+    uint32_t bitFlips;        /*!< bitFlips: Bits flipped by the bit rot. */
+    uint32_t powerCuts;       /*!< powerCuts: Power cuts injected. */
+} sln_flash_sim_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Maps SLN_FLASH_SIM_FILE, filled with 0xFF when created; called by SLN_Flash_Init
+ *
+ * @returns kStatus_Success, or kStatus_Fail if the file can not be mapped below 4 GB
+ */
+status_t SLN_FLASH_SIM_Init(void);
+
+/*!
+ * @brief Sets the behavior of the simulator; can be changed at any time, e.g. between two benchmarks
+ *
+ * @param config Behavior to use, copied
+ */
+void SLN_FLASH_SIM_SetConfig(const sln_flash_sim_config_t *config);
+
+/*!
+ * @brief Restores the power after a cut; the content of the flash is kept and a pending erase is lost
+ */
+void SLN_FLASH_SIM_PowerOn(void);
+
+/*!
+ * @brief Tells whether the power was cut; until SLN_FLASH_SIM_PowerOn, the programs and erases fail
+ */
+bool SLN_FLASH_SIM_IsPoweredOff(void);
+
+/*!
+ * @brief Flips one bit of the flash, for tests of the data checks
+ *
+ * @param address Offset of the byte from the start of the flash
+ * @param bit Bit of the byte, 0 to 7
+ */
+void SLN_FLASH_SIM_FlipBit(uint32_t address, uint8_t bit);
+
+/*!
+ * @brief Copies the counters of the simulator
+ *
+ * @param stats Filled with the counters
+ */
+void SLN_FLASH_SIM_GetStats(sln_flash_sim_stats_t *stats);
+
+/*!
+ * @brief Sets the counters of the simulator back to 0
+ */
+void SLN_FLASH_SIM_ResetStats(void);
+
+/*!
+ * @brief Monotonic time of the host, used for the flash timings and by the benchmarks
+ */
+uint64_t SLN_FLASH_SIM_GetTimeUs(void);
+
+/* Flash operations, see sln_flash_ops.h */
+status_t SLN_FLASH_SIM_GetId(uint8_t *pid);
+status_t SLN_FLASH_SIM_PageProgram(uint32_t address, const uint8_t *src);
+status_t SLN_FLASH_SIM_EraseSector(uint32_t address);
+status_t SLN_FLASH_SIM_EraseSectorStart(uint32_t address);
+status_t SLN_FLASH_SIM_EraseSuspend(uint32_t address);
+status_t SLN_FLASH_SIM_EraseResume(uint32_t address);
+status_t SLN_FLASH_SIM_ReadStatus(uint32_t *value);
+uint32_t SLN_FLASH_SIM_GetReadAddress(uint32_t address);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_FLASH_SIM_ */
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "sln_flash.h"
+#include "sln_flash_config.h"
+#include "sln_flash_writer.h"
+
+typedef enum _flash_writer_op
+{
+    kFlashWriter_Erase = 0,
+    kFlashWriter_Program,
+} flash_writer_op_t;
+
+/*! @brief Request queued to the writer task */
+typedef struct _flash_writer_req
+{
+    flash_writer_op_t op;     /*!< op: Operation to run. */
+    uint32_t address;         /*!< address: Offset from the start of the flash. */
+    const uint8_t *data;      /*!< data: Buffer to program. */
+    uint32_t len;             /*!< len: Length in bytes of the buffer to program. */
+    sln_flash_writer_cb_t cb; /*!< cb: Called when the request is done. */
+    void *arg;                /*!< arg: Argument of the callback. */
+} flash_writer_req_t;
+
+static TaskHandle_t s_writerTask = NULL;
+static StaticTask_t s_writerTaskTcb;
+static StackType_t s_writerTaskStack[SLN_FLASH_WRITER_TASK_STACK];
+
+static QueueHandle_t s_writerQueue = NULL;
+static StaticQueue_t s_writerQueueCtrl;
+static uint8_t s_writerQueueStorage[SLN_FLASH_WRITER_QUEUE_LEN * sizeof(flash_writer_req_t)];
+
+/* One synchronous request at a time, its result handed back through s_syncStatus */
+static SemaphoreHandle_t s_syncLock = NULL;
+static StaticSemaphore_t s_syncLockCtrl;
+static SemaphoreHandle_t s_syncDone = NULL;
+static StaticSemaphore_t s_syncDoneCtrl;
+static status_t s_syncStatus = kStatus_Success;
+
+static sln_flash_writer_stats_t s_writerStats = {0};
+
+static status_t writer_erase(uint32_t address)
+{
+    status_t status         = kStatus_Success;
+    sln_flash_erase_t erase = {.address = address, .started = false};
+    TickType_t start        = xTaskGetTickCount();
+    uint32_t elapsedMs      = 0;
+
+    do
+    {
+        status = SLN_Erase_Sector_Step(&erase, SLN_FLASH_WRITER_SLICE_US);
+        s_writerStats.eraseSteps++;
+
+        if (kStatus_SLN_Flash_EraseSuspended == status)
+        {
+            // The sector stays suspended while the other tasks run
+            vTaskDelay(SLN_FLASH_WRITER_YIELD_TICKS);
+        }
+    } while (kStatus_SLN_Flash_EraseSuspended == status);
+
+    elapsedMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+    if (elapsedMs > s_writerStats.maxEraseMs)
+    {
+        s_writerStats.maxEraseMs = elapsedMs;
+    }
+
+    return status;
+}
+
+static status_t writer_program(uint32_t address, const uint8_t *data, uint32_t len)
+{
+    status_t status = kStatus_Success;
+    uint32_t toCopy = 0;
+
+    while ((kStatus_Success == status) && (len > 0))
+    {
+        toCopy = (len > FLASH_PAGE_SIZE) ? FLASH_PAGE_SIZE : len;
+
+        status = SLN_Write_Flash_Page(address, (uint8_t *)data, toCopy);
+
+        address += FLASH_PAGE_SIZE;
+        data += toCopy;
+        len -= toCopy;
+
+        // Let the other tasks run between the pages, once there are some
+        if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+        {
+            taskYIELD();
+        }
+    }
+
+    return status;
+}
+
+static void writer_task(void *arg)
+{
+    flash_writer_req_t req;
+    status_t status      = kStatus_Success;
+    uint32_t maxIrqOffUs = 0;
+
+    while (1)
+    {
+        xQueueReceive(s_writerQueue, &req, portMAX_DELAY);
+
+        if (kFlashWriter_Erase == req.op)
+        {
+            status = writer_erase(req.address);
+        }
+        else
+        {
+            status = writer_program(req.address, req.data, req.len);
+        }
+
+        s_writerStats.requests++;
+        if (kStatus_Success != status)
+        {
+            s_writerStats.failures++;
+            configPRINTF(("[WARNING] Flash writer failed at 0x%x, status %d\r\n", req.address, status));
+        }
+
+        maxIrqOffUs = SLN_Flash_Get_Max_Irq_Off_Us();
+        if (maxIrqOffUs > s_writerStats.maxIrqOffUs)
+        {
+            s_writerStats.maxIrqOffUs = maxIrqOffUs;
+            configPRINTF(("Flash writer: IRQs off for up to %d us\r\n", maxIrqOffUs));
+        }
+
+        if (NULL != req.cb)
+        {
+            req.cb(status, req.arg);
+        }
+    }
+}
+
+static void writer_sync_done(status_t status, void *arg)
+{
+    s_syncStatus = status;
+    xSemaphoreGive(s_syncDone);
+}
+
+static status_t writer_queue(flash_writer_req_t *req, TickType_t timeout)
+{
+    if ((NULL == s_writerQueue) || (pdTRUE != xQueueSend(s_writerQueue, req, timeout)))
+    {
+        return kStatus_Fail;
+    }
+
+    return kStatus_Success;
+}
+
+status_t SLN_FLASH_WRITER_Init(void)
+{
+    if (NULL != s_writerTask)
+    {
+        return kStatus_Success;
+    }
+
+    s_writerQueue = xQueueCreateStatic(SLN_FLASH_WRITER_QUEUE_LEN, sizeof(flash_writer_req_t), s_writerQueueStorage,
+                                       &s_writerQueueCtrl);
+    s_syncLock    = xSemaphoreCreateMutexStatic(&s_syncLockCtrl);
+    s_syncDone    = xSemaphoreCreateBinaryStatic(&s_syncDoneCtrl);
+
+    if ((NULL == s_writerQueue) || (NULL == s_syncLock) || (NULL == s_syncDone))
+    {
+        return kStatus_Fail;
+    }
+
+    s_writerTask = xTaskCreateStatic(writer_task, "Flash_Writer_Task", SLN_FLASH_WRITER_TASK_STACK, NULL,
+                                     SLN_FLASH_WRITER_TASK_PRIORITY, s_writerTaskStack, &s_writerTaskTcb);
+
+    return (NULL != s_writerTask) ? kStatus_Success : kStatus_Fail;
+}
+
+bool SLN_FLASH_WRITER_IsRunning(void)
+{
+    return (NULL != s_writerTask) && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
+}
+
+status_t SLN_FLASH_WRITER_Erase(uint32_t address, sln_flash_writer_cb_t cb, void *arg)
+{
+    flash_writer_req_t req = {.op = kFlashWriter_Erase, .address = address, .cb = cb, .arg = arg};
+
+    return writer_queue(&req, 0);
+}
+
+status_t SLN_FLASH_WRITER_Program(
+    uint32_t address, const uint8_t *data, uint32_t len, sln_flash_writer_cb_t cb, void *arg)
+{
+    flash_writer_req_t req = {
+        .op = kFlashWriter_Program, .address = address, .data = data, .len = len, .cb = cb, .arg = arg};
+
+    if (NULL == data)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    return writer_queue(&req, 0);
+}
+
+/* Queue the request and wait for the writer task to run it */
+static status_t writer_sync(flash_writer_req_t *req)
+{
+    status_t status = kStatus_Success;
+
+    req->cb = writer_sync_done;
+
+    xSemaphoreTake(s_syncLock, portMAX_DELAY);
+
+    status = writer_queue(req, portMAX_DELAY);
+
+    if (kStatus_Success == status)
+    {
+        xSemaphoreTake(s_syncDone, portMAX_DELAY);
+        status = s_syncStatus;
+    }
+
+    xSemaphoreGive(s_syncLock);
+
+    return status;
+}
+
+status_t SLN_FLASH_WRITER_EraseSync(uint32_t address)
+{
+    flash_writer_req_t req = {.op = kFlashWriter_Erase, .address = address};
+
+    // Nobody to wait for before the scheduler starts, and the writer can not wait for itself
+    if (!SLN_FLASH_WRITER_IsRunning() || (xTaskGetCurrentTaskHandle() == s_writerTask))
+    {
+        return SLN_Erase_Sector(address);
+    }
+
+    return writer_sync(&req);
+}
+
+status_t SLN_FLASH_WRITER_ProgramSync(uint32_t address, const uint8_t *data, uint32_t len)
+{
+    flash_writer_req_t req = {.op = kFlashWriter_Program, .address = address, .data = data, .len = len};
+
+    if (NULL == data)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (!SLN_FLASH_WRITER_IsRunning() || (xTaskGetCurrentTaskHandle() == s_writerTask))
+    {
+        return writer_program(address, data, len);
+    }
+
+    return writer_sync(&req);
+}
+
+void SLN_FLASH_WRITER_GetStats(sln_flash_writer_stats_t *stats)
+{
+    if (NULL == stats)
+    {
+        return;
+    }
+
+    *stats             = s_writerStats;
+    stats->maxIrqOffUs = SLN_Flash_Get_Max_Irq_Off_Us();
+}
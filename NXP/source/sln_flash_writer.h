@@ -0,0 +1,134 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_FLASH_WRITER_
+#define _SLN_FLASH_WRITER_
+
+/*!
+ * SLN Flash Writer
+ *
+ * Background task running the flash erase and program requests of the other tasks.
+ * A sector erase is run in steps of SLN_FLASH_WRITER_SLICE_US with the IRQs off, suspended between
+ * the steps, so the audio capture keeps running while a setting is saved. A page program is a
+ * single step.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_common.h"
+
+/*! @brief Time the erase runs with the IRQs off in each step, kept under a tick so no tick is lost */
+#ifndef SLN_FLASH_WRITER_SLICE_US
+#define SLN_FLASH_WRITER_SLICE_US (500U)
+#endif
+
+/*! @brief Ticks given to the other tasks between two erase steps */
+#ifndef SLN_FLASH_WRITER_YIELD_TICKS
+#define SLN_FLASH_WRITER_YIELD_TICKS (1U)
+#endif
+
+/*! @brief Number of requests that can be queued */
+#ifndef SLN_FLASH_WRITER_QUEUE_LEN
+#define SLN_FLASH_WRITER_QUEUE_LEN (8U)
+#endif
+
+#define SLN_FLASH_WRITER_TASK_STACK    (512U)
+#define SLN_FLASH_WRITER_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/*! @brief Called by the writer task when a request is done, with kStatus_Success or the error */
+typedef void (*sln_flash_writer_cb_t)(status_t status, void *arg);
+
+/*! @brief Statistics of the writer */
+typedef struct _sln_flash_writer_stats
+{
+    uint32_t requests;    /*! Number of requests done */
+    uint32_t failures;    /*! Number of requests that failed */
+    uint32_t eraseSteps;  /*! Number of erase steps run */
+    uint32_t maxEraseMs;  /*! Longest sector erase, suspended time included */
+    uint32_t maxIrqOffUs; /*! Longest time the IRQs were disabled by a flash operation */
+} sln_flash_writer_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Create the writer task and its queue, to be called before the scheduler starts
+ *
+ * @returns kStatus_Success or kStatus_Fail if the task or the queue could not be created
+ */
+status_t SLN_FLASH_WRITER_Init(void);
+
+/*!
+ * @brief Check if the requests are run by the writer task
+ *
+ * @returns true once the scheduler runs the writer task
+ */
+bool SLN_FLASH_WRITER_IsRunning(void);
+
+/*!
+ * @brief Queue the erase of a sector
+ *
+ * @param address The offset of the sector from the start of the flash
+ * @param cb Called when the sector is erased, can be NULL
+ * @param arg Argument of the callback
+ *
+ * @returns kStatus_Success if queued, kStatus_Fail if the queue is full
+ */
+status_t SLN_FLASH_WRITER_Erase(uint32_t address, sln_flash_writer_cb_t cb, void *arg);
+
+/*!
+ * @brief Queue the program of a buffer, page by page; the end of the last page is filled with ones
+ *
+ * @param address The offset from the start of the flash, page aligned, in an erased area
+ * @param data The buffer to write, must stay valid until the callback
+ * @param len Length of the buffer in bytes
+ * @param cb Called when the buffer is written, can be NULL
+ * @param arg Argument of the callback
+ *
+ * @returns kStatus_Success if queued, kStatus_Fail if the queue is full, kStatus_InvalidArgument if data is NULL
+ */
+status_t SLN_FLASH_WRITER_Program(
+    uint32_t address, const uint8_t *data, uint32_t len, sln_flash_writer_cb_t cb, void *arg);
+
+/*!
+ * @brief Erase a sector through the writer task and wait for the end of the erase
+ *     The calling task is blocked, the other tasks and the IRQs keep running.
+ *     Before the scheduler starts, the sector is erased in one go.
+ *
+ * @param address The offset of the sector from the start of the flash
+ *
+ * @returns Status of the erase
+ */
+status_t SLN_FLASH_WRITER_EraseSync(uint32_t address);
+
+/*!
+ * @brief Program a buffer through the writer task and wait for the end of the program
+ *     Before the scheduler starts, the buffer is programmed in the calling task.
+ *
+ * @param address The offset from the start of the flash, page aligned, in an erased area
+ * @param data The buffer to write
+ * @param len Length of the buffer in bytes
+ *
+ * @returns Status of the program, kStatus_InvalidArgument if data is NULL
+ */
+status_t SLN_FLASH_WRITER_ProgramSync(uint32_t address, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Get the statistics of the writer
+ *
+ * @param stats Pointer to the statistics to fill
+ */
+void SLN_FLASH_WRITER_GetStats(sln_flash_writer_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_FLASH_WRITER_ */
@@ -0,0 +1,778 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "sln_json.h"
+
+/* Offset of the end of a container not closed yet */
+#define TOKEN_OPEN (0U)
+
+/* Longest integer read, fits into an int64_t */
+#define INT_MAX_DIGITS (18U)
+
+static const char s_hexDigits[] = "0123456789abcdef";
+
+static int32_t hex_value(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return c - 'a' + 10;
+    }
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/*******************************************************************************
+ * Parser
+ ******************************************************************************/
+
+/* Add a token under the current container or key */
+static sln_json_token_t *add_token(
+    sln_json_token_t *tokens, uint32_t maxTokens, uint32_t *next, int32_t super, sln_json_token_type_t type)
+{
+    sln_json_token_t *token = NULL;
+
+    if (*next >= maxTokens)
+    {
+        return NULL;
+    }
+
+    token         = &tokens[(*next)++];
+    token->type   = type;
+    token->start  = 0;
+    token->end    = TOKEN_OPEN;
+    token->size   = 0;
+    token->parent = (int16_t)super;
+
+    if (super >= 0)
+    {
+        tokens[super].size++;
+    }
+
+    return token;
+}
+
+/* A value can start at the root, in an array or after a key; a key must be a string */
+static bool value_allowed(const sln_json_token_t *tokens, uint32_t next, int32_t super, bool afterValue, bool isString)
+{
+    if (afterValue)
+    {
+        /* Separator missing */
+        return false;
+    }
+
+    if (super < 0)
+    {
+        /* Single root value */
+        return (0 == next);
+    }
+
+    if (kSLN_JSON_TokenObject == tokens[super].type)
+    {
+        return isString;
+    }
+
+    if (kSLN_JSON_TokenString == tokens[super].type)
+    {
+        /* One value per key */
+        return (0 == tokens[super].size);
+    }
+
+    return true;
+}
+
+static int32_t parse_string(const char *json, uint32_t len, uint32_t *pos)
+{
+    uint32_t start = *pos + 1;
+
+    for (uint32_t idx = start; idx < len; idx++)
+    {
+        char c = json[idx];
+
+        if ('"' == c)
+        {
+            *pos = idx;
+            return 0;
+        }
+
+        if ((uint8_t)c < 0x20)
+        {
+            return SLN_JSON_EINVAL;
+        }
+
+        if ('\\' == c)
+        {
+            if (++idx >= len)
+            {
+                return SLN_JSON_EPART;
+            }
+
+            switch (json[idx])
+            {
+                case '"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    break;
+
+                case 'u':
+                    for (uint32_t hex = 0; hex < 4; hex++)
+                    {
+                        if (++idx >= len)
+                        {
+                            return SLN_JSON_EPART;
+                        }
+                        if (hex_value(json[idx]) < 0)
+                        {
+                            return SLN_JSON_EINVAL;
+                        }
+                    }
+                    break;
+
+                default:
+                    return SLN_JSON_EINVAL;
+            }
+        }
+    }
+
+    return SLN_JSON_EPART;
+}
+
+/* Primitives end at a delimiter, the caller checks what they hold */
+static uint32_t primitive_end(const char *json, uint32_t len, uint32_t pos)
+{
+    while ((pos < len) && (NULL == strchr(" \t\r\n,:]}", json[pos])))
+    {
+        pos++;
+    }
+
+    return pos;
+}
+
+int32_t SLN_JSON_Parse(const char *json, uint32_t len, sln_json_token_t *tokens, uint32_t maxTokens)
+{
+    uint32_t next           = 0;
+    int32_t super           = -1;
+    int32_t ret             = 0;
+    uint32_t end            = 0;
+    bool afterValue         = false;
+    sln_json_token_t *token = NULL;
+    sln_json_token_type_t type;
+
+    if ((NULL == json) || (NULL == tokens) || (len > UINT16_MAX))
+    {
+        return SLN_JSON_EINVAL;
+    }
+
+    for (uint32_t pos = 0; pos < len; pos++)
+    {
+        char c = json[pos];
+
+        switch (c)
+        {
+            case '{':
+            case '[':
+                if (!value_allowed(tokens, next, super, afterValue, false))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                type  = ('{' == c) ? kSLN_JSON_TokenObject : kSLN_JSON_TokenArray;
+                token = add_token(tokens, maxTokens, &next, super, type);
+                if (NULL == token)
+                {
+                    return SLN_JSON_ENOMEM;
+                }
+
+                token->start = (uint16_t)pos;
+                super        = (int32_t)next - 1;
+                afterValue   = false;
+                break;
+
+            case '}':
+            case ']':
+                type = ('}' == c) ? kSLN_JSON_TokenObject : kSLN_JSON_TokenArray;
+
+                /* Empty, or after a value: no trailing comma */
+                if (!afterValue && ((super < 0) || (super != (int32_t)next - 1)))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                /* A key closes along with its value */
+                if ((super >= 0) && (kSLN_JSON_TokenString == tokens[super].type))
+                {
+                    if (0 == tokens[super].size)
+                    {
+                        return SLN_JSON_EINVAL;
+                    }
+                    super = tokens[super].parent;
+                }
+
+                if ((super < 0) || (type != tokens[super].type))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                if ((kSLN_JSON_TokenObject == type) && (kSLN_JSON_TokenString == tokens[next - 1].type) &&
+                    (tokens[next - 1].parent == super))
+                {
+                    /* Key without a value */
+                    return SLN_JSON_EINVAL;
+                }
+
+                tokens[super].end = (uint16_t)(pos + 1);
+                super             = tokens[super].parent;
+                afterValue        = true;
+                break;
+
+            case '"':
+                if (!value_allowed(tokens, next, super, afterValue, true))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                end = pos;
+                ret = parse_string(json, len, &end);
+                if (0 != ret)
+                {
+                    return ret;
+                }
+
+                token = add_token(tokens, maxTokens, &next, super, kSLN_JSON_TokenString);
+                if (NULL == token)
+                {
+                    return SLN_JSON_ENOMEM;
+                }
+
+                token->start = (uint16_t)(pos + 1);
+                token->end   = (uint16_t)end;
+                pos          = end;
+                afterValue   = true;
+                break;
+
+            case ':':
+                /* The last token is the key of the next value */
+                if (!afterValue || (super < 0) || (kSLN_JSON_TokenObject != tokens[super].type) ||
+                    (kSLN_JSON_TokenString != tokens[next - 1].type) || (tokens[next - 1].parent != super))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                super      = (int32_t)next - 1;
+                afterValue = false;
+                break;
+
+            case ',':
+                if ((super >= 0) && (kSLN_JSON_TokenString == tokens[super].type))
+                {
+                    super = tokens[super].parent;
+                }
+                else if ((super >= 0) && (kSLN_JSON_TokenObject == tokens[super].type))
+                {
+                    /* Key without a value */
+                    return SLN_JSON_EINVAL;
+                }
+                if (!afterValue || (super < 0))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+                afterValue = false;
+                break;
+
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                break;
+
+            default:
+                if (!value_allowed(tokens, next, super, afterValue, false) || (NULL == strchr("-0123456789tfn", c)))
+                {
+                    return SLN_JSON_EINVAL;
+                }
+
+                token = add_token(tokens, maxTokens, &next, super, kSLN_JSON_TokenPrimitive);
+                if (NULL == token)
+                {
+                    return SLN_JSON_ENOMEM;
+                }
+
+                end          = primitive_end(json, len, pos);
+                token->start = (uint16_t)pos;
+                token->end   = (uint16_t)end;
+                pos          = end - 1;
+                afterValue   = true;
+                break;
+        }
+    }
+
+    /* Containers still open, or a key without its value */
+    if ((super >= 0) || (0 == next))
+    {
+        return SLN_JSON_EPART;
+    }
+
+    return (int32_t)next;
+}
+
+/* Index of the token after a value and everything it holds */
+static uint32_t skip_value(const sln_json_token_t *tokens, uint32_t count, uint32_t idx)
+{
+    uint32_t end = tokens[idx].end;
+
+    for (idx++; (idx < count) && (tokens[idx].start < end); idx++)
+    {
+    }
+
+    return idx;
+}
+
+int32_t SLN_JSON_ObjectGet(
+    const char *json, const sln_json_token_t *tokens, uint32_t count, uint32_t object, const char *key)
+{
+    uint32_t keyLen = strlen(key);
+    uint32_t idx    = object + 1;
+
+    if ((object >= count) || (kSLN_JSON_TokenObject != tokens[object].type))
+    {
+        return -1;
+    }
+
+    for (uint32_t pair = 0; (pair < tokens[object].size) && (idx + 1 < count); pair++)
+    {
+        if (((uint32_t)(tokens[idx].end - tokens[idx].start) == keyLen) &&
+            (0 == memcmp(&json[tokens[idx].start], key, keyLen)))
+        {
+            return (int32_t)idx + 1;
+        }
+
+        idx = skip_value(tokens, count, idx + 1);
+    }
+
+    return -1;
+}
+
+bool SLN_JSON_GetInt(const char *json, const sln_json_token_t *token, int64_t *value)
+{
+    uint32_t pos    = token->start;
+    bool negative   = false;
+    uint64_t result = 0;
+
+    if (kSLN_JSON_TokenPrimitive != token->type)
+    {
+        return false;
+    }
+
+    if ('-' == json[pos])
+    {
+        negative = true;
+        pos++;
+    }
+
+    if ((pos == token->end) || ((token->end - pos) > INT_MAX_DIGITS))
+    {
+        return false;
+    }
+
+    for (; pos < token->end; pos++)
+    {
+        if ((json[pos] < '0') || (json[pos] > '9'))
+        {
+            return false;
+        }
+
+        result = (result * 10) + (uint64_t)(json[pos] - '0');
+    }
+
+    *value = negative ? -(int64_t)result : (int64_t)result;
+
+    return true;
+}
+
+/* Copy a string token, unescaped and NUL terminated; \u escapes are only taken for ASCII */
+static bool read_string(const char *json, const sln_json_token_t *token, char *out, uint32_t size)
+{
+    uint32_t len = 0;
+    char c;
+
+    for (uint32_t pos = token->start; pos < token->end; pos++)
+    {
+        c = json[pos];
+
+        if ('\\' == c)
+        {
+            c = json[++pos];
+
+            switch (c)
+            {
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u':
+                    if ((json[pos + 1] != '0') || (json[pos + 2] != '0') || (hex_value(json[pos + 3]) > 7))
+                    {
+                        return false;
+                    }
+                    c = (char)((hex_value(json[pos + 3]) << 4) | hex_value(json[pos + 4]));
+                    pos += 4;
+                    break;
+                default:
+                    /* Quote, backslash and slash stand for themselves */
+                    break;
+            }
+        }
+
+        if (len + 1 >= size)
+        {
+            return false;
+        }
+
+        out[len++] = c;
+    }
+
+    out[len] = '\0';
+
+    return true;
+}
+
+static bool read_hex(const char *json, const sln_json_token_t *token, uint8_t *out, uint32_t size)
+{
+    int32_t high;
+    int32_t low;
+
+    if ((uint32_t)(token->end - token->start) != (2 * size))
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < size; idx++)
+    {
+        high = hex_value(json[token->start + 2 * idx]);
+        low  = hex_value(json[token->start + 2 * idx + 1]);
+
+        if ((high < 0) || (low < 0))
+        {
+            return false;
+        }
+
+        out[idx] = (uint8_t)((high << 4) | low);
+    }
+
+    return true;
+}
+
+static bool read_field(const char *json, const sln_json_token_t *token, const sln_json_field_t *field, uint8_t *out)
+{
+    int64_t value = 0;
+    uint32_t len  = token->end - token->start;
+
+    switch (field->type)
+    {
+        case kSLN_JSON_Int32:
+            if (!SLN_JSON_GetInt(json, token, &value) || (value < INT32_MIN) || (value > INT32_MAX))
+            {
+                return false;
+            }
+            *(int32_t *)out = (int32_t)value;
+            return true;
+
+        case kSLN_JSON_Uint32:
+            if (!SLN_JSON_GetInt(json, token, &value) || (value < 0) || (value > UINT32_MAX))
+            {
+                return false;
+            }
+            *(uint32_t *)out = (uint32_t)value;
+            return true;
+
+        case kSLN_JSON_Bool:
+            if ((kSLN_JSON_TokenPrimitive != token->type) || ((4 != len) && (5 != len)))
+            {
+                return false;
+            }
+            if ((4 == len) && (0 == memcmp(&json[token->start], "true", 4)))
+            {
+                *(bool *)out = true;
+                return true;
+            }
+            if ((5 == len) && (0 == memcmp(&json[token->start], "false", 5)))
+            {
+                *(bool *)out = false;
+                return true;
+            }
+            return false;
+
+        case kSLN_JSON_String:
+            return (kSLN_JSON_TokenString == token->type) && read_string(json, token, (char *)out, field->size);
+
+        case kSLN_JSON_Hex:
+            return (kSLN_JSON_TokenString == token->type) && read_hex(json, token, out, field->size);
+
+        default:
+            return false;
+    }
+}
+
+uint32_t SLN_JSON_ReadObject(const char *json,
+                             const sln_json_token_t *tokens,
+                             uint32_t count,
+                             const sln_json_field_t *fields,
+                             uint32_t fieldCount,
+                             void *object)
+{
+    uint32_t mask = 0;
+    int32_t value = 0;
+
+    for (uint32_t idx = 0; (idx < fieldCount) && (idx < 32); idx++)
+    {
+        value = SLN_JSON_ObjectGet(json, tokens, count, 0, fields[idx].key);
+
+        if ((value >= 0) && read_field(json, &tokens[value], &fields[idx], (uint8_t *)object + fields[idx].offset))
+        {
+            mask |= (1U << idx);
+        }
+    }
+
+    return mask;
+}
+
+/*******************************************************************************
+ * Writer
+ ******************************************************************************/
+
+static void put_char(sln_json_writer_t *writer, char c)
+{
+    /* Room is kept for the NUL terminator */
+    if (writer->overflow || ((writer->len + 1) >= writer->size))
+    {
+        writer->overflow = true;
+        return;
+    }
+
+    writer->buf[writer->len++] = c;
+}
+
+static void put_string(sln_json_writer_t *writer, const char *str)
+{
+    while ('\0' != *str)
+    {
+        put_char(writer, *str++);
+    }
+}
+
+/* Values are separated at the level of an object or an array */
+static void begin_value(sln_json_writer_t *writer)
+{
+    if (writer->needComma)
+    {
+        put_char(writer, ',');
+    }
+}
+
+void SLN_JSON_WriterInit(sln_json_writer_t *writer, char *buf, uint32_t size)
+{
+    writer->buf       = buf;
+    writer->size      = size;
+    writer->len       = 0;
+    writer->overflow  = (NULL == buf) || (0 == size);
+    writer->needComma = false;
+}
+
+int32_t SLN_JSON_WriterEnd(sln_json_writer_t *writer)
+{
+    if (writer->overflow)
+    {
+        return -1;
+    }
+
+    writer->buf[writer->len] = '\0';
+
+    return (int32_t)writer->len;
+}
+
+void SLN_JSON_BeginObject(sln_json_writer_t *writer)
+{
+    begin_value(writer);
+    put_char(writer, '{');
+    writer->needComma = false;
+}
+
+void SLN_JSON_EndObject(sln_json_writer_t *writer)
+{
+    put_char(writer, '}');
+    writer->needComma = true;
+}
+
+void SLN_JSON_BeginArray(sln_json_writer_t *writer)
+{
+    begin_value(writer);
+    put_char(writer, '[');
+    writer->needComma = false;
+}
+
+void SLN_JSON_EndArray(sln_json_writer_t *writer)
+{
+    put_char(writer, ']');
+    writer->needComma = true;
+}
+
+void SLN_JSON_Key(sln_json_writer_t *writer, const char *key)
+{
+    begin_value(writer);
+    put_char(writer, '"');
+    put_string(writer, key);
+    put_string(writer, "\":");
+    writer->needComma = false;
+}
+
+void SLN_JSON_Int(sln_json_writer_t *writer, int64_t value)
+{
+    char digits[20];
+    uint32_t count    = 0;
+    uint64_t absValue = (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value;
+
+    begin_value(writer);
+
+    if (value < 0)
+    {
+        put_char(writer, '-');
+    }
+
+    do
+    {
+        digits[count++] = (char)('0' + (absValue % 10));
+        absValue /= 10;
+    } while (0 != absValue);
+
+    while (count > 0)
+    {
+        put_char(writer, digits[--count]);
+    }
+
+    writer->needComma = true;
+}
+
+void SLN_JSON_Bool(sln_json_writer_t *writer, bool value)
+{
+    begin_value(writer);
+    put_string(writer, value ? "true" : "false");
+    writer->needComma = true;
+}
+
+void SLN_JSON_String(sln_json_writer_t *writer, const char *value)
+{
+    uint8_t c;
+
+    begin_value(writer);
+    put_char(writer, '"');
+
+    for (; '\0' != *value; value++)
+    {
+        c = (uint8_t)*value;
+
+        if (('"' == c) || ('\\' == c))
+        {
+            put_char(writer, '\\');
+            put_char(writer, (char)c);
+        }
+        else if (c < 0x20)
+        {
+            put_string(writer, "\\u00");
+            put_char(writer, s_hexDigits[c >> 4]);
+            put_char(writer, s_hexDigits[c & 0xF]);
+        }
+        else
+        {
+            put_char(writer, (char)c);
+        }
+    }
+
+    put_char(writer, '"');
+    writer->needComma = true;
+}
+
+void SLN_JSON_Hex(sln_json_writer_t *writer, const uint8_t *data, uint32_t len)
+{
+    begin_value(writer);
+    put_char(writer, '"');
+
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        put_char(writer, s_hexDigits[data[idx] >> 4]);
+        put_char(writer, s_hexDigits[data[idx] & 0xF]);
+    }
+
+    put_char(writer, '"');
+    writer->needComma = true;
+}
+
+void SLN_JSON_WriteObject(sln_json_writer_t *writer,
+                          const sln_json_field_t *fields,
+                          uint32_t fieldCount,
+                          const void *object)
+{
+    const uint8_t *field = NULL;
+
+    SLN_JSON_BeginObject(writer);
+
+    for (uint32_t idx = 0; idx < fieldCount; idx++)
+    {
+        field = (const uint8_t *)object + fields[idx].offset;
+
+        SLN_JSON_Key(writer, fields[idx].key);
+
+        switch (fields[idx].type)
+        {
+            case kSLN_JSON_Int32:
+                SLN_JSON_Int(writer, *(const int32_t *)field);
+                break;
+            case kSLN_JSON_Uint32:
+                SLN_JSON_Int(writer, *(const uint32_t *)field);
+                break;
+            case kSLN_JSON_Bool:
+                SLN_JSON_Bool(writer, *(const bool *)field);
+                break;
+            case kSLN_JSON_String:
+                SLN_JSON_String(writer, (const char *)field);
+                break;
+            case kSLN_JSON_Hex:
+                SLN_JSON_Hex(writer, field, fields[idx].size);
+                break;
+            default:
+                break;
+        }
+    }
+
+    SLN_JSON_EndObject(writer);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_JSON_H_
+#define _SLN_JSON_H_
+
+/*!
+ * SLN JSON
+ *
+ * JSON of the control messages without heap memory. The writer prints into a buffer of the caller,
+ * the parser splits a message into tokens (objects, arrays, strings, primitives) held in an array of
+ * the caller, pointing into the message. Flat objects are read and written from a C structure
+ * through a table of fields.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*! @brief Parser errors */
+#define SLN_JSON_ENOMEM (-1) /* Not enough tokens */
+#define SLN_JSON_EINVAL (-2) /* Not valid JSON */
+#define SLN_JSON_EPART  (-3) /* The message ends before the JSON is complete */
+
+/*! @brief Type of a token */
+typedef enum _sln_json_token_type
+{
+    kSLN_JSON_TokenObject = 0,
+    kSLN_JSON_TokenArray,
+    kSLN_JSON_TokenString,    /*!< String, start and end exclude the quotes */
+    kSLN_JSON_TokenPrimitive, /*!< Number, true, false or null */
+} sln_json_token_type_t;
+
+/*! @brief Token of a parsed message */
+typedef struct _sln_json_token
+{
+    sln_json_token_type_t type; /*!< type: Type of the token. */
+    uint16_t start;             /*!< start: Offset of the first character in the message. */
+    uint16_t end;               /*!< end: Offset after the last character. */
+    uint16_t size;              /*!< size: Keys of an object, elements of an array, 1 for a key. */
+    int16_t parent;             /*!< parent: Token holding this one, -1 for the root. */
+} sln_json_token_t;
+
+/*! @brief Writer of a message into a buffer */
+typedef struct _sln_json_writer
+{
+    char *buf;      /*!< buf: Buffer of the message. */
+    uint32_t size;  /*!< size: Size of the buffer. */
+    uint32_t len;   /*!< len: Length of the message written. */
+    bool overflow;  /*!< overflow: The message did not fit, the writer is stopped. */
+    bool needComma; /*!< needComma: A value was written at the current level. */
+} sln_json_writer_t;
+
+/*! @brief Type of a field of a structure */
+typedef enum _sln_json_type
+{
+    kSLN_JSON_Int32 = 0, /*!< int32_t */
+    kSLN_JSON_Uint32,    /*!< uint32_t */
+    kSLN_JSON_Bool,      /*!< bool */
+    kSLN_JSON_String,    /*!< char array, NUL terminated */
+    kSLN_JSON_Hex,       /*!< uint8_t array, as a hex string of exactly the array size */
+} sln_json_type_t;
+
+/*! @brief Field of a structure, read or written as a key of a flat object */
+typedef struct _sln_json_field
+{
+    const char *key;      /*!< key: Key of the field. */
+    sln_json_type_t type; /*!< type: Type of the field. */
+    uint16_t offset;      /*!< offset: Offset of the field in the structure. */
+    uint16_t size;        /*!< size: Size of the field. */
+} sln_json_field_t;
+
+/*! @brief Describe a member of a structure */
+#define SLN_JSON_FIELD(key, type, structType, member) \
+    { (key), (type), offsetof(structType, member), sizeof(((structType *)0)->member) }
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Split a message into tokens
+ *
+ * @param json The message, does not need to be NUL terminated
+ * @param len Length of the message, up to 65535
+ * @param tokens Array filled with the tokens, the root value first
+ * @param maxTokens Size of the array
+ *
+ * @returns Number of tokens, SLN_JSON_ENOMEM, SLN_JSON_EINVAL or SLN_JSON_EPART
+ */
+int32_t SLN_JSON_Parse(const char *json, uint32_t len, sln_json_token_t *tokens, uint32_t maxTokens);
+
+/*!
+ * @brief Find the value of a key in an object
+ *
+ * @param json The message
+ * @param tokens Tokens of the message
+ * @param count Number of tokens
+ * @param object Index of the object token
+ * @param key Key to look for
+ *
+ * @returns Index of the value token, -1 if the key is not in the object
+ */
+int32_t SLN_JSON_ObjectGet(
+    const char *json, const sln_json_token_t *tokens, uint32_t count, uint32_t object, const char *key);
+
+/*!
+ * @brief Read an integer primitive
+ *
+ * @param json The message
+ * @param token The token
+ * @param value The integer read
+ *
+ * @returns true if the token is an integer that fits into an int64_t
+ */
+bool SLN_JSON_GetInt(const char *json, const sln_json_token_t *token, int64_t *value);
+
+/*!
+ * @brief Read the fields of a structure from the root object of a message
+ *
+ * @param json The message
+ * @param tokens Tokens of the message
+ * @param count Number of tokens
+ * @param fields Fields of the structure
+ * @param fieldCount Number of fields, up to 32
+ * @param object The structure
+ *
+ * @returns Mask of the fields read, bit n for fields[n]; a field missing or not valid is left untouched
+ */
+uint32_t SLN_JSON_ReadObject(const char *json,
+                             const sln_json_token_t *tokens,
+                             uint32_t count,
+                             const sln_json_field_t *fields,
+                             uint32_t fieldCount,
+                             void *object);
+
+/*!
+ * @brief Start a message
+ *
+ * @param writer The writer
+ * @param buf Buffer of the message
+ * @param size Size of the buffer, including the NUL terminator
+ */
+void SLN_JSON_WriterInit(sln_json_writer_t *writer, char *buf, uint32_t size);
+
+/*!
+ * @brief End a message, NUL terminated
+ *
+ * @param writer The writer
+ *
+ * @returns Length of the message, -1 if it did not fit into the buffer
+ */
+int32_t SLN_JSON_WriterEnd(sln_json_writer_t *writer);
+
+void SLN_JSON_BeginObject(sln_json_writer_t *writer);
+void SLN_JSON_EndObject(sln_json_writer_t *writer);
+void SLN_JSON_BeginArray(sln_json_writer_t *writer);
+void SLN_JSON_EndArray(sln_json_writer_t *writer);
+
+/*!
+ * @brief Write the key of the next value of an object
+ *
+ * @param writer The writer
+ * @param key The key, written as is: not escaped
+ */
+void SLN_JSON_Key(sln_json_writer_t *writer, const char *key);
+
+void SLN_JSON_Int(sln_json_writer_t *writer, int64_t value);
+void SLN_JSON_Bool(sln_json_writer_t *writer, bool value);
+
+/*!
+ * @brief Write a string value, quotes, backslashes and control characters escaped
+ *
+ * @param writer The writer
+ * @param value The string
+ */
+void SLN_JSON_String(sln_json_writer_t *writer, const char *value);
+
+/*!
+ * @brief Write bytes as a hex string value
+ *
+ * @param writer The writer
+ * @param data The bytes
+ * @param len Number of bytes
+ */
+void SLN_JSON_Hex(sln_json_writer_t *writer, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Write the fields of a structure as an object
+ *
+ * @param writer The writer
+ * @param fields Fields of the structure
+ * @param fieldCount Number of fields
+ * @param object The structure
+ */
+void SLN_JSON_WriteObject(sln_json_writer_t *writer,
+                          const sln_json_field_t *fields,
+                          uint32_t fieldCount,
+                          const void *object);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_JSON_H_ */
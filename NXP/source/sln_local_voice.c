@@ -18,6 +18,9 @@
 #include "sln_flash.h"
 #include "sln_flash_mgmt.h"
 #include "sln_cfg_file.h"
+#include "sln_settings_cache.h"
+#include "sln_metrics.h"
+#include "sln_asr_events.h"
 #include "sln_RT10xx_RGB_LED_driver.h"
 #include "audio_processing_task.h"
 #include "sln_amplifier.h"
@@ -32,6 +35,9 @@
  ******************************************************************************/
 #define NUM_SAMPLES_AFE_OUTPUT (480)
 
+/* ASR blocks dropped after a playback ends, they were captured while the clip was still playing */
+#define ASR_PLAYBACK_TAIL_BLOCKS (1)
+
 /*
  * For more details regarding WWs and CMDs memory space make sure to check
  * Section 5.1.2 from the Developer's Guide
@@ -59,7 +65,6 @@ extern QueueHandle_t g_xSampleQueue;
 extern TaskHandle_t appTaskHandle;
 extern oob_demo_control_t oob_demo_control;
 extern bool g_SW1Pressed;
-extern int g_bypass_voice_engine;
 
 struct asr_language_model g_asrLangModel[MAX_INSTALLED_LANGUAGES] = {0};
 struct asr_inference_engine g_asrInfWW[NUM_INFERENCES_WW]         = {0};
@@ -67,6 +72,13 @@ struct asr_inference_engine g_asrInfCMD                           = {0};
 asr_control_t g_asrControl                                        = {0};
 app_asr_shell_commands_t appAsrShellCommands                      = {};
 
+SLN_METRICS_DEFINE_COUNTER(s_asrBlocks, "asr.blocks");
+SLN_METRICS_DEFINE_COUNTER(s_asrBypassed, "asr.bypassed");
+SLN_METRICS_DEFINE_COUNTER(s_asrWakeWords, "asr.wake_words");
+SLN_METRICS_DEFINE_COUNTER(s_asrCommands, "asr.commands");
+/* Blocks still waiting in the sample queue, the backlog of the ASR */
+SLN_METRICS_DEFINE_HISTOGRAM(s_asrQueueDepth, "asr.queue_depth");
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
@@ -548,27 +560,39 @@ void initialize_asr(void)
     oob_demo_control.ledCmd = UNDEFINED_COMMAND;
 }
 
+/*!
+ * @brief Publish an ASR result; the event publisher sends it and prints it, off the ASR task
+ */
+static void publish_asr_event(sln_asr_event_type_t type, uint8_t language, int32_t keywordId, int32_t mapId)
+{
+    sln_asr_event_t event = {0};
+
+    event.type      = (uint8_t)type;
+    event.language  = language;
+    event.keywordId = (int16_t)keywordId;
+    event.mapId     = (int16_t)mapId;
+
+    if ((kSLN_ASR_Event_WakeWord == type) || (kSLN_ASR_Event_Command == type))
+    {
+        event.trustScore  = (int16_t)g_asrControl.result.trustScore;
+        event.sgDiffScore = (int16_t)g_asrControl.result.SGDiffScore;
+    }
+
+    SLN_ASR_EVENTS_Post(&event);
+}
+
 void print_asr_session(int status)
 {
     switch (status)
     {
         case ASR_SESSION_STARTED:
-            //configPRINTF(("\r\n[ASR] Session started\r\n"));
-            //PRINTF("\r\n[ASR] Session started\r\n");
-            configPRINTF(("2012\r\n"));
-            PRINTF("2012\r\n");
+            publish_asr_event(kSLN_ASR_Event_SessionStarted, oob_demo_control.language, -1, -1);
             break;
         case ASR_SESSION_ENDED:
-            //configPRINTF(("[ASR] Session ended\r\n"));
-            //PRINTF("[ASR] Session ended\r\n");
-        	configPRINTF(("-10000\r\n"));
-            PRINTF("-10000\r\n");
+            publish_asr_event(kSLN_ASR_Event_SessionEnded, oob_demo_control.language, -1, -1);
             break;
         case ASR_SESSION_TIMEOUT:
-            //configPRINTF(("[ASR] Timed out waiting for response\r\n"));
-            //PRINTF("[ASR] Timed out waiting for response\r\n");
-            configPRINTF(("-777\r\n"));
-            PRINTF("-777\r\n");
+            publish_asr_event(kSLN_ASR_Event_SessionTimeout, oob_demo_control.language, -1, -1);
             break;
     }
 }
@@ -579,9 +603,10 @@ void print_asr_session(int status)
 void local_voice_task(void *arg)
 {
     int16_t pi16Sample[NUM_SAMPLES_AFE_OUTPUT];
-    uint32_t len          = 0;
-    uint32_t statusFlash  = 0;
-    asr_events_t asrEvent = ASR_SESSION_ENDED;
+    uint32_t len             = 0;
+    uint32_t statusFlash     = 0;
+    asr_events_t asrEvent    = ASR_SESSION_ENDED;
+    uint8_t bypassTailBlocks = 0;
     struct asr_inference_engine *pInfWW;
     struct asr_inference_engine *pInfCMD;
     char **cmdString;
@@ -593,6 +618,14 @@ void local_voice_task(void *arg)
         configPRINTF(("Failed reading local demo configuration from flash memory.\r\n"));
     }
 
+    // The shell commands change the parameters in RAM, the settings cache saves them after a quiet time
+    statusFlash = SLN_SETTINGS_CACHE_Register(ASR_SHELL_COMMANDS_FILE_NAME, &appAsrShellCommands,
+                                              sizeof(app_asr_shell_commands_t));
+    if (statusFlash != SLN_FLASH_MGMT_OK)
+    {
+        configPRINTF(("Failed to cache local demo configuration.\r\n"));
+    }
+
     if (appAsrShellCommands.status != WRITE_SUCCESS)
     {
         appAsrShellCommands.demo         = ASR_CMD_LED;
@@ -604,19 +637,10 @@ void local_voice_task(void *arg)
         appAsrShellCommands.volume       = 55;
         appAsrShellCommands.status       = WRITE_SUCCESS;
         appAsrShellCommands.asrCfg       = ASR_CFG_DEMO_NO_CHANGE;
-        statusFlash = SLN_FLASH_MGMT_Save(ASR_SHELL_COMMANDS_FILE_NAME, (uint8_t *)&appAsrShellCommands,
-                                          sizeof(app_asr_shell_commands_t));
-        if ((statusFlash == SLN_FLASH_MGMT_EOVERFLOW) || (statusFlash == SLN_FLASH_MGMT_EOVERFLOW2))
-        {
-            statusFlash = SLN_FLASH_MGMT_Erase(ASR_SHELL_COMMANDS_FILE_NAME);
-            statusFlash = SLN_FLASH_MGMT_Save(ASR_SHELL_COMMANDS_FILE_NAME, (uint8_t *)&appAsrShellCommands,
-                                              sizeof(app_asr_shell_commands_t));
-            if (statusFlash != SLN_FLASH_MGMT_OK)
-            {
-                configPRINTF(("Failed writing local demo configuration in flash memory.\r\n"));
-            }
-        }
-        else if (statusFlash != SLN_FLASH_MGMT_OK)
+
+        // Defaults written at once
+        SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
+        if (SLN_SETTINGS_CACHE_Sync() != SLN_FLASH_MGMT_OK)
         {
             configPRINTF(("Failed writing local demo configuration in flash memory.\r\n"));
         }
@@ -629,6 +653,12 @@ void local_voice_task(void *arg)
     while (!g_xSampleQueue)
         vTaskDelay(10);
 
+    SLN_METRICS_Register(&s_asrBlocks);
+    SLN_METRICS_Register(&s_asrBypassed);
+    SLN_METRICS_Register(&s_asrWakeWords);
+    SLN_METRICS_Register(&s_asrCommands);
+    SLN_METRICS_Register(&s_asrQueueDepth);
+
     while (1)
     {
         if (xQueueReceive(g_xSampleQueue, pi16Sample, portMAX_DELAY) != pdPASS)
@@ -636,13 +666,24 @@ void local_voice_task(void *arg)
             configPRINTF(("Could not receive from the queue\r\n"));
         }
 
-        // bypass while playing audio clip
-        if (g_bypass_voice_engine > 0)
+        SLN_METRICS_Add(&s_asrBlocks, 1);
+        SLN_METRICS_Observe(&s_asrQueueDepth, uxQueueMessagesWaiting(g_xSampleQueue));
+
+        // bypass while playing audio clip to prevent false positives when speaker and mics are close.
+        // The block being processed was captured before it got here, so also drop the blocks that
+        // still carry the end of the clip.
+        if (SLN_AMP_IsPlaybackDone() == false)
+        {
+            bypassTailBlocks = ASR_PLAYBACK_TAIL_BLOCKS;
+            SLN_METRICS_Add(&s_asrBypassed, 1);
+            continue;
+        }
+        if (bypassTailBlocks > 0)
         {
-            g_bypass_voice_engine -= NUM_SAMPLES_AFE_OUTPUT;
+            bypassTailBlocks--;
+            SLN_METRICS_Add(&s_asrBypassed, 1);
             continue;
         }
-        g_bypass_voice_engine = 0;
 
         // push-to-talk
         if (g_SW1Pressed == true && asrEvent == ASR_SESSION_ENDED && appAsrShellCommands.ptt == ASR_PTT_ON)
@@ -673,7 +714,9 @@ void local_voice_task(void *arg)
                     {
                         asrEvent = ASR_SESSION_STARTED;
                         print_asr_session(asrEvent);
-                        configPRINTF(("0\r\n"));
+                        SLN_METRICS_Add(&s_asrWakeWords, 1);
+                        publish_asr_event(kSLN_ASR_Event_WakeWord, pInfWW->iWhoAmI_lang,
+                                          g_asrControl.result.keywordID[0], g_asrControl.result.cmdMapID);
                         /*configPRINTF(("[ASR] Wake Word: %s(%d) - MapID(%d)\r\n",
                                       asr_get_string_by_id(pInfWW, g_asrControl.result.keywordID[0]),
                                       g_asrControl.result.keywordID[0], g_asrControl.result.cmdMapID));*/
@@ -685,7 +728,6 @@ void local_voice_task(void *arg)
                         /*PRINTF("[ASR] Wake Word: %s(%d) \r\n",
                                asr_get_string_by_id(pInfWW, g_asrControl.result.keywordID[0]),
                                g_asrControl.result.keywordID[0]);*/
-                        PRINTF("0\r\n");
 
                         if (appAsrShellCommands.demo ==
                             ASR_CMD_LED) // only English CMD for LED demo, multi-lingual WW is possible.
@@ -736,7 +778,9 @@ void local_voice_task(void *arg)
             {
                 if (asr_get_string_by_id(pInfCMD, g_asrControl.result.keywordID[1]) != NULL)
                 {
-                	configPRINTF(("%d\r\n",g_asrControl.result.cmdMapID));
+                    SLN_METRICS_Add(&s_asrCommands, 1);
+                    publish_asr_event(kSLN_ASR_Event_Command, oob_demo_control.language,
+                                      g_asrControl.result.keywordID[1], g_asrControl.result.cmdMapID);
                     /*configPRINTF(("[ASR] Command: %s(%d) - MapID(%d)\r\n",
                                   asr_get_string_by_id(pInfCMD, g_asrControl.result.keywordID[1]),
                                   g_asrControl.result.keywordID[1], g_asrControl.result.cmdMapID));*/
@@ -748,7 +792,6 @@ void local_voice_task(void *arg)
                     /*PRINTF("[ASR] Command: %s(%d) \r\n",
                            asr_get_string_by_id(pInfCMD, g_asrControl.result.keywordID[1]),
                            g_asrControl.result.keywordID[1]);*/
-                    PRINTF("%d \r\n",g_asrControl.result.cmdMapID);
 
                     g_asrControl.sampleCount = 0;
 
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lwip/stats.h"
+
+#include "sln_dcp_queue.h"
+#include "sln_flash_writer.h"
+#include "sln_metrics.h"
+#include "sln_settings_cache.h"
+
+/* Room kept in a page for its end, },"next":K} */
+#define METRICS_PAGE_END_SIZE (24U)
+
+static sln_metric_t *s_metrics = NULL;
+static uint32_t s_seq          = 0;
+static bool s_systemRegistered = false;
+
+/* Snapshot being written in pages */
+static uint32_t s_pageSeq  = 0;
+static uint32_t s_pageNext = 0;
+static bool s_pageDelta    = false;
+
+/* Statistics of the system, read when a snapshot is taken */
+SLN_METRICS_DEFINE_GAUGE(s_heapFree, "heap.free");
+SLN_METRICS_DEFINE_GAUGE(s_heapMin, "heap.min");
+SLN_METRICS_DEFINE_COUNTER(s_flashRequests, "flash.requests");
+SLN_METRICS_DEFINE_COUNTER(s_flashFailures, "flash.failures");
+SLN_METRICS_DEFINE_GAUGE(s_flashMaxIrqOff, "flash.max_irq_off_us");
+SLN_METRICS_DEFINE_COUNTER(s_dcpFailures, "dcp.failures");
+SLN_METRICS_DEFINE_COUNTER(s_dcpSwFallbacks, "dcp.sw_fallbacks");
+SLN_METRICS_DEFINE_COUNTER(s_settingsCommits, "settings.commits");
+SLN_METRICS_DEFINE_COUNTER(s_settingsFailures, "settings.failures");
+#if LWIP_STATS && TCP_STATS
+SLN_METRICS_DEFINE_COUNTER(s_tcpXmit, "lwip.tcp.xmit");
+SLN_METRICS_DEFINE_COUNTER(s_tcpRecv, "lwip.tcp.recv");
+SLN_METRICS_DEFINE_COUNTER(s_tcpDrop, "lwip.tcp.drop");
+#endif
+#if LWIP_STATS && MEMP_STATS
+SLN_METRICS_DEFINE_GAUGE(s_pbufPoolUsed, "lwip.pbuf_pool.used");
+SLN_METRICS_DEFINE_COUNTER(s_pbufPoolErr, "lwip.pbuf_pool.err");
+#endif
+
+static sln_metric_t *const s_systemMetrics[] = {
+    &s_heapFree,
+    &s_heapMin,
+    &s_flashRequests,
+    &s_flashFailures,
+    &s_flashMaxIrqOff,
+    &s_dcpFailures,
+    &s_dcpSwFallbacks,
+    &s_settingsCommits,
+    &s_settingsFailures,
+#if LWIP_STATS && TCP_STATS
+    &s_tcpXmit,
+    &s_tcpRecv,
+    &s_tcpDrop,
+#endif
+#if LWIP_STATS && MEMP_STATS
+    &s_pbufPoolUsed,
+    &s_pbufPoolErr,
+#endif
+};
+
+static void collect_system(void)
+{
+    sln_flash_writer_stats_t flashStats;
+    sln_dcp_queue_stats_t dcpStats;
+    sln_settings_cache_stats_t settingsStats;
+
+    if (!s_systemRegistered)
+    {
+        for (uint32_t idx = 0; idx < ARRAY_SIZE(s_systemMetrics); idx++)
+        {
+            SLN_METRICS_Register(s_systemMetrics[idx]);
+        }
+        s_systemRegistered = true;
+    }
+
+    SLN_METRICS_Set(&s_heapFree, xPortGetFreeHeapSize());
+    SLN_METRICS_Set(&s_heapMin, xPortGetMinimumEverFreeHeapSize());
+
+    SLN_FLASH_WRITER_GetStats(&flashStats);
+    SLN_METRICS_Set(&s_flashRequests, flashStats.requests);
+    SLN_METRICS_Set(&s_flashFailures, flashStats.failures);
+    SLN_METRICS_Set(&s_flashMaxIrqOff, flashStats.maxIrqOffUs);
+
+    SLN_DCP_QUEUE_GetStats(&dcpStats);
+    SLN_METRICS_Set(&s_dcpFailures, dcpStats.failures);
+    SLN_METRICS_Set(&s_dcpSwFallbacks, dcpStats.swFallbacks);
+
+    SLN_SETTINGS_CACHE_GetStats(&settingsStats);
+    SLN_METRICS_Set(&s_settingsCommits, settingsStats.commits);
+    SLN_METRICS_Set(&s_settingsFailures, settingsStats.failures);
+
+#if LWIP_STATS && TCP_STATS
+    SLN_METRICS_Set(&s_tcpXmit, lwip_stats.tcp.xmit);
+    SLN_METRICS_Set(&s_tcpRecv, lwip_stats.tcp.recv);
+    SLN_METRICS_Set(&s_tcpDrop, lwip_stats.tcp.drop);
+#endif
+#if LWIP_STATS && MEMP_STATS
+    SLN_METRICS_Set(&s_pbufPoolUsed, lwip_stats.memp[MEMP_PBUF_POOL]->used);
+    SLN_METRICS_Set(&s_pbufPoolErr, lwip_stats.memp[MEMP_PBUF_POOL]->err);
+#endif
+}
+
+/* Write a metric, its value kept as pending until the snapshot is complete */
+static void write_metric(sln_json_writer_t *writer, sln_metric_t *metric, bool delta)
+{
+    volatile uint32_t *reported = NULL;
+    volatile uint32_t *pending  = NULL;
+    bool changed                = false;
+
+    metric->pending = __atomic_load_n(&metric->value, __ATOMIC_RELAXED);
+
+    if (kSLN_METRIC_Histogram != metric->type)
+    {
+        if (delta && (metric->pending == metric->reported))
+        {
+            return;
+        }
+
+        SLN_JSON_Key(writer, metric->name);
+        if (delta && (kSLN_METRIC_Counter == metric->type))
+        {
+            SLN_JSON_Int(writer, metric->pending - metric->reported);
+        }
+        else
+        {
+            SLN_JSON_Int(writer, metric->pending);
+        }
+        return;
+    }
+
+    reported = &metric->buckets[SLN_METRICS_HIST_BUCKETS];
+    pending  = &metric->buckets[2 * SLN_METRICS_HIST_BUCKETS];
+
+    for (uint32_t idx = 0; idx < SLN_METRICS_HIST_BUCKETS; idx++)
+    {
+        pending[idx] = __atomic_load_n(&metric->buckets[idx], __ATOMIC_RELAXED);
+        changed |= (pending[idx] != reported[idx]);
+    }
+
+    if (delta && !changed)
+    {
+        return;
+    }
+
+    /* [count, bucket 0, ..., bucket N-1] */
+    SLN_JSON_Key(writer, metric->name);
+    SLN_JSON_BeginArray(writer);
+    SLN_JSON_Int(writer, delta ? (metric->pending - metric->reported) : metric->pending);
+    for (uint32_t idx = 0; idx < SLN_METRICS_HIST_BUCKETS; idx++)
+    {
+        SLN_JSON_Int(writer, delta ? (pending[idx] - reported[idx]) : pending[idx]);
+    }
+    SLN_JSON_EndArray(writer);
+}
+
+/* The metric was written in a page, the next delta starts from it */
+static void commit_metric(sln_metric_t *metric)
+{
+    metric->reported = metric->pending;
+
+    if (kSLN_METRIC_Histogram == metric->type)
+    {
+        for (uint32_t idx = 0; idx < SLN_METRICS_HIST_BUCKETS; idx++)
+        {
+            metric->buckets[SLN_METRICS_HIST_BUCKETS + idx] = metric->buckets[2 * SLN_METRICS_HIST_BUCKETS + idx];
+        }
+    }
+}
+
+void SLN_METRICS_Register(sln_metric_t *metric)
+{
+    sln_metric_t *entry = NULL;
+
+    taskENTER_CRITICAL();
+
+    for (entry = s_metrics; (NULL != entry) && (entry != metric); entry = entry->next)
+    {
+    }
+
+    if (NULL == entry)
+    {
+        metric->next = s_metrics;
+        s_metrics    = metric;
+    }
+
+    taskEXIT_CRITICAL();
+}
+
+uint32_t SLN_METRICS_Snapshot(sln_json_writer_t *writer, uint32_t base, uint32_t cursor, uint32_t *next)
+{
+    sln_json_writer_t mark;
+    sln_metric_t *metric = NULL;
+    uint32_t index       = 0;
+    uint32_t count       = 0;
+
+    if (0 == cursor)
+    {
+        // A snapshot left unfinished committed part of its metrics, the next one can not be a delta
+        s_pageDelta = (0 != base) && (base == s_seq) && (0 == s_pageNext);
+        s_pageSeq   = (UINT32_MAX == s_seq) ? 1 : (s_seq + 1);
+
+        collect_system();
+    }
+    else if (cursor != s_pageNext)
+    {
+        return 0;
+    }
+
+    if (writer->size <= METRICS_PAGE_END_SIZE)
+    {
+        return 0;
+    }
+
+    SLN_JSON_BeginObject(writer);
+    SLN_JSON_Key(writer, "seq");
+    SLN_JSON_Int(writer, s_pageSeq);
+    SLN_JSON_Key(writer, "base");
+    SLN_JSON_Int(writer, s_pageDelta ? s_seq : 0);
+    SLN_JSON_Key(writer, "cursor");
+    SLN_JSON_Int(writer, cursor);
+    SLN_JSON_Key(writer, "metrics");
+    SLN_JSON_BeginObject(writer);
+
+    for (metric = s_metrics; (NULL != metric) && (index < cursor); metric = metric->next)
+    {
+        index++;
+    }
+
+    // The metrics that fit, with room kept for the end of the page
+    writer->size -= METRICS_PAGE_END_SIZE;
+
+    for (; NULL != metric; metric = metric->next)
+    {
+        mark = *writer;
+        write_metric(writer, metric, s_pageDelta);
+
+        if (writer->overflow)
+        {
+            *writer = mark;
+            break;
+        }
+
+        commit_metric(metric);
+        count++;
+        index++;
+    }
+
+    writer->size += METRICS_PAGE_END_SIZE;
+
+    if ((0 == count) && (NULL != metric))
+    {
+        // Not even one metric fits, the reader would never get past it
+        return 0;
+    }
+
+    s_pageNext = (NULL != metric) ? index : 0;
+
+    SLN_JSON_EndObject(writer);
+    SLN_JSON_Key(writer, "next");
+    SLN_JSON_Int(writer, s_pageNext);
+    SLN_JSON_EndObject(writer);
+
+    if (0 == s_pageNext)
+    {
+        s_seq = s_pageSeq;
+    }
+
+    *next = s_pageNext;
+
+    return writer->overflow ? 0 : s_pageSeq;
+}
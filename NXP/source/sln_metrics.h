@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_METRICS_H_
+#define _SLN_METRICS_H_
+
+/*!
+ * SLN Metrics
+ *
+ * Registry of the counters, gauges and histograms published by the application modules. A module
+ * defines its metrics statically, registers them once and updates them with atomic operations, so
+ * they can be updated from any task or interrupt without a lock. The heap, lwIP, flash writer, DCP
+ * queue and settings cache statistics are read when a snapshot is taken.
+ *
+ * A snapshot is a JSON object; counters and histograms can be sent as increments since the previous
+ * snapshot, and metrics that did not change are then left out. A snapshot larger than the buffer of the
+ * reader is written in pages, each one with the metrics that fit from a cursor in the registry.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sln_json.h"
+
+/*! @brief Buckets of a histogram: 0 counts 0, n the values in [2^(n-1), 2^n), the last one also the larger values */
+#define SLN_METRICS_HIST_BUCKETS (10U)
+
+/*! @brief Type of a metric */
+typedef enum _sln_metric_type
+{
+    kSLN_METRIC_Counter = 0, /*!< Only goes up, sent as an increment in a delta snapshot */
+    kSLN_METRIC_Gauge,       /*!< Current value, sent as is */
+    kSLN_METRIC_Histogram,   /*!< Values counted in power of two buckets */
+} sln_metric_type_t;
+
+/*! @brief Metric of the registry, defined with the SLN_METRICS_DEFINE_ macros */
+typedef struct _sln_metric
+{
+    const char *name;           /*!< name: Name of the metric, unique, not escaped in the snapshot. */
+    sln_metric_type_t type;     /*!< type: Type of the metric. */
+    volatile uint32_t value;    /*!< value: Counter or gauge value. */
+    volatile uint32_t *buckets; /*!< buckets: Histogram buckets, followed by the reported and pending copies. */
+    uint32_t reported;          /*!< reported: Value sent in the previous snapshot. */
+    uint32_t pending;           /*!< pending: Value sent in the snapshot being written. */
+    struct _sln_metric *next;   /*!< next: Next metric of the registry. */
+} sln_metric_t;
+
+/*! @brief Define a metric of a module */
+#define SLN_METRICS_DEFINE_COUNTER(var, name) static sln_metric_t var = {(name), kSLN_METRIC_Counter}
+#define SLN_METRICS_DEFINE_GAUGE(var, name)   static sln_metric_t var = {(name), kSLN_METRIC_Gauge}
+#define SLN_METRICS_DEFINE_HISTOGRAM(var, name)                           \
+    static volatile uint32_t var##Buckets[3 * SLN_METRICS_HIST_BUCKETS]; \
+    static sln_metric_t var = {(name), kSLN_METRIC_Histogram, 0, var##Buckets}
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Add a metric to the registry, once; may be called before the scheduler starts
+ *
+ * @param metric The metric
+ */
+void SLN_METRICS_Register(sln_metric_t *metric);
+
+/*!
+ * @brief Add to a counter
+ *
+ * @param metric The counter
+ * @param count Amount to add
+ */
+static inline void SLN_METRICS_Add(sln_metric_t *metric, uint32_t count)
+{
+    (void)__atomic_fetch_add(&metric->value, count, __ATOMIC_RELAXED);
+}
+
+/*!
+ * @brief Set a gauge, or a counter kept by another module
+ *
+ * @param metric The gauge
+ * @param value The value
+ */
+static inline void SLN_METRICS_Set(sln_metric_t *metric, uint32_t value)
+{
+    __atomic_store_n(&metric->value, value, __ATOMIC_RELAXED);
+}
+
+/*!
+ * @brief Count a value in a histogram
+ *
+ * @param metric The histogram
+ * @param value The value
+ */
+static inline void SLN_METRICS_Observe(sln_metric_t *metric, uint32_t value)
+{
+    uint32_t bucket = (0 == value) ? 0 : (32 - (uint32_t)__builtin_clz(value));
+
+    if (bucket >= SLN_METRICS_HIST_BUCKETS)
+    {
+        bucket = SLN_METRICS_HIST_BUCKETS - 1;
+    }
+
+    (void)__atomic_fetch_add(&metric->buckets[bucket], 1, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&metric->value, 1, __ATOMIC_RELAXED);
+}
+
+/*!
+ * @brief Write a page of a snapshot of the registry, to be called from one task at a time
+ *     {"seq":N,"base":B,"cursor":C,"metrics":{"name":value,"hist":[count,bucket0,...]},"next":K}
+ *     With base equal to the sequence number of the previous snapshot, the counters and histograms
+ *     are the increments since that snapshot and the unchanged metrics are left out; otherwise base
+ *     is 0 and all the values are written. A snapshot starts at cursor 0; its page holds the metrics
+ *     that fit into the writer buffer, the next page is written from cursor K and the last one has
+ *     K 0. The pages of a snapshot have its sequence number: a page of another one means that the
+ *     snapshot was started again by another reader.
+ *
+ * @param writer Writer of the page
+ * @param base Sequence number of the last snapshot the reader got, 0 for a full snapshot
+ * @param cursor 0 to start a snapshot, else the next cursor of the previous page
+ * @param next Cursor of the next page, 0 after the last page
+ *
+ * @returns Sequence number of the snapshot, 0 if the cursor does not follow the previous page or the
+ *          writer buffer does not hold a metric
+ */
+uint32_t SLN_METRICS_Snapshot(sln_json_writer_t *writer, uint32_t base, uint32_t cursor, uint32_t *next);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_METRICS_H_ */
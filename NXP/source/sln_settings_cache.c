@@ -0,0 +1,341 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "sln_settings_cache.h"
+
+/*! @brief Settings file of the cache */
+typedef struct _settings_entry
+{
+    const char *fileName;   /*!< fileName: Name of the settings file. */
+    uint8_t *settings;      /*!< settings: Settings structure of the application. */
+    uint8_t *shadow;        /*!< shadow: Copy of the settings last saved. */
+    uint32_t len;           /*!< len: Size of the settings structure. */
+    TickType_t firstChange; /*!< firstChange: Tick of the first change since the last save. */
+    bool dirty;             /*!< dirty: Changed since the last save. */
+    bool shadowValid;       /*!< shadowValid: shadow is the content of the flash, cleared by a failed save. */
+} settings_entry_t;
+
+static settings_entry_t s_entries[SLN_SETTINGS_CACHE_MAX_ENTRIES];
+static uint32_t s_entryCount = 0;
+
+static uint8_t s_shadowPool[SLN_SETTINGS_CACHE_SHADOW_SIZE];
+static uint32_t s_shadowUsed = 0;
+
+static SemaphoreHandle_t s_cacheLock = NULL;
+static StaticSemaphore_t s_cacheLockCtrl;
+
+/* Serializes the saves, which copy the settings to s_snapshot and write it without s_cacheLock */
+static SemaphoreHandle_t s_saveLock = NULL;
+static StaticSemaphore_t s_saveLockCtrl;
+static uint8_t s_snapshot[SLN_SETTINGS_CACHE_SHADOW_SIZE];
+
+static TaskHandle_t s_cacheTask = NULL;
+static StaticTask_t s_cacheTaskTcb;
+static StackType_t s_cacheTaskStack[SLN_SETTINGS_CACHE_TASK_STACK];
+
+static sln_settings_cache_stats_t s_cacheStats = {0};
+
+static settings_entry_t *find_entry(const void *settings)
+{
+    for (uint32_t idx = 0; idx < s_entryCount; idx++)
+    {
+        if (s_entries[idx].settings == settings)
+        {
+            return &s_entries[idx];
+        }
+    }
+
+    return NULL;
+}
+
+/* Save the settings if they differ from the last saved ones, with s_saveLock taken; s_cacheLock is only
+ * held to look at the entry, not during the flash operation. Only the range from the first to the last
+ * changed byte is written, as a delta record, if the flash holds the shadow. */
+static int32_t save_entry(settings_entry_t *entry)
+{
+    int32_t ret      = SLN_FLASH_MGMT_OK;
+    uint32_t changed = 0;
+    uint32_t first   = 0;
+    uint32_t last    = 0;
+    uint32_t written = 0;
+    bool delta       = false;
+
+    xSemaphoreTake(s_cacheLock, portMAX_DELAY);
+
+    if (!entry->dirty)
+    {
+        xSemaphoreGive(s_cacheLock);
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    for (uint32_t idx = 0; idx < entry->len; idx++)
+    {
+        if (!entry->shadowValid || (entry->shadow[idx] != entry->settings[idx]))
+        {
+            first = (0 == changed) ? idx : first;
+            last  = idx;
+            changed++;
+        }
+    }
+
+    delta = entry->shadowValid;
+
+    entry->dirty = false;
+
+    if (0 == changed)
+    {
+        s_cacheStats.skipped++;
+        xSemaphoreGive(s_cacheLock);
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    // Saved from the snapshot, the application may change the settings meanwhile
+    memcpy(s_snapshot, entry->settings, entry->len);
+
+    xSemaphoreGive(s_cacheLock);
+
+    if (delta)
+    {
+        written = last - first + 1;
+        ret     = SLN_FLASH_MGMT_UpdateRange(entry->fileName, first, &s_snapshot[first], written);
+        delta   = (SLN_FLASH_MGMT_OK == ret);
+    }
+
+    if (!delta)
+    {
+        // Saved whole when the range can't be written
+        written = entry->len;
+        ret     = SLN_FLASH_MGMT_Save(entry->fileName, s_snapshot, entry->len);
+        if ((SLN_FLASH_MGMT_EOVERFLOW == ret) || (SLN_FLASH_MGMT_EOVERFLOW2 == ret))
+        {
+            SLN_FLASH_MGMT_Erase(entry->fileName);
+            ret = SLN_FLASH_MGMT_Save(entry->fileName, s_snapshot, entry->len);
+        }
+    }
+
+    xSemaphoreTake(s_cacheLock, portMAX_DELAY);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        memcpy(entry->shadow, s_snapshot, entry->len);
+        entry->shadowValid = true;
+        s_cacheStats.commits++;
+        s_cacheStats.deltas += delta ? 1 : 0;
+        s_cacheStats.bytesChanged += changed;
+        s_cacheStats.bytesWritten += written;
+    }
+    else
+    {
+        // Retried after the quiet time
+        entry->shadowValid = false;
+        if (!entry->dirty)
+        {
+            entry->firstChange = xTaskGetTickCount();
+            entry->dirty       = true;
+        }
+        s_cacheStats.failures++;
+    }
+
+    xSemaphoreGive(s_cacheLock);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        configPRINTF(("Updated %s in flash memory.\r\n", entry->fileName));
+    }
+    else
+    {
+        configPRINTF(("Failed to write %s in flash memory, error %d.\r\n", entry->fileName, ret));
+    }
+
+    return ret;
+}
+
+/* Ticks left before the next save: the quiet time, cut by the longest delay of the oldest change */
+static TickType_t next_save_delay(void)
+{
+    TickType_t delay   = portMAX_DELAY;
+    TickType_t now     = xTaskGetTickCount();
+    TickType_t elapsed = 0;
+
+    xSemaphoreTake(s_cacheLock, portMAX_DELAY);
+
+    for (uint32_t idx = 0; idx < s_entryCount; idx++)
+    {
+        if (s_entries[idx].dirty)
+        {
+            elapsed = now - s_entries[idx].firstChange;
+
+            if (elapsed >= pdMS_TO_TICKS(SLN_SETTINGS_CACHE_MAX_DELAY_MS))
+            {
+                delay = 0;
+            }
+            else
+            {
+                delay = MIN(delay, pdMS_TO_TICKS(SLN_SETTINGS_CACHE_MAX_DELAY_MS) - elapsed);
+                delay = MIN(delay, pdMS_TO_TICKS(SLN_SETTINGS_CACHE_QUIET_MS));
+            }
+        }
+    }
+
+    xSemaphoreGive(s_cacheLock);
+
+    return delay;
+}
+
+static void cache_task(void *arg)
+{
+    TickType_t delay = portMAX_DELAY;
+
+    while (1)
+    {
+        // Each change notifies the task, which starts the quiet time over
+        if ((0 == delay) || (0 == ulTaskNotifyTake(pdTRUE, delay)))
+        {
+            SLN_SETTINGS_CACHE_Sync();
+        }
+
+        delay = next_save_delay();
+    }
+}
+
+int32_t SLN_SETTINGS_CACHE_Init(void)
+{
+    if (NULL != s_cacheTask)
+    {
+        return SLN_FLASH_MGMT_OK;
+    }
+
+    s_cacheLock = xSemaphoreCreateMutexStatic(&s_cacheLockCtrl);
+    s_saveLock  = xSemaphoreCreateMutexStatic(&s_saveLockCtrl);
+
+    if ((NULL == s_cacheLock) || (NULL == s_saveLock))
+    {
+        return SLN_FLASH_MGMT_ENOMEM;
+    }
+
+    s_cacheTask = xTaskCreateStatic(cache_task, "Settings_Task", SLN_SETTINGS_CACHE_TASK_STACK, NULL,
+                                    SLN_SETTINGS_CACHE_TASK_PRIORITY, s_cacheTaskStack, &s_cacheTaskTcb);
+
+    return (NULL != s_cacheTask) ? SLN_FLASH_MGMT_OK : SLN_FLASH_MGMT_ENOMEM;
+}
+
+int32_t SLN_SETTINGS_CACHE_Register(const char *fileName, void *settings, uint32_t len)
+{
+    int32_t ret             = SLN_FLASH_MGMT_OK;
+    settings_entry_t *entry = NULL;
+
+    if ((NULL == s_cacheLock) || (NULL == fileName) || (NULL == settings) || (0 == len))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    xSemaphoreTake(s_cacheLock, portMAX_DELAY);
+
+    if (NULL != find_entry(settings))
+    {
+        goto exit;
+    }
+
+    if ((s_entryCount >= SLN_SETTINGS_CACHE_MAX_ENTRIES) || (s_shadowUsed + len > sizeof(s_shadowPool)))
+    {
+        ret = SLN_FLASH_MGMT_ENOMEM;
+        goto exit;
+    }
+
+    entry              = &s_entries[s_entryCount++];
+    entry->fileName    = fileName;
+    entry->settings    = (uint8_t *)settings;
+    entry->shadow      = &s_shadowPool[s_shadowUsed];
+    entry->len         = len;
+    entry->dirty       = false;
+    entry->shadowValid = true;
+
+    s_shadowUsed += len;
+
+    memcpy(entry->shadow, entry->settings, len);
+
+exit:
+    xSemaphoreGive(s_cacheLock);
+
+    return ret;
+}
+
+void SLN_SETTINGS_CACHE_MarkDirty(const void *settings)
+{
+    settings_entry_t *entry = NULL;
+
+    if (NULL == s_cacheLock)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_cacheLock, portMAX_DELAY);
+
+    entry = find_entry(settings);
+
+    if (NULL != entry)
+    {
+        if (!entry->dirty)
+        {
+            entry->firstChange = xTaskGetTickCount();
+            entry->dirty       = true;
+        }
+
+        s_cacheStats.changes++;
+    }
+
+    xSemaphoreGive(s_cacheLock);
+
+    if ((NULL != entry) && (NULL != s_cacheTask))
+    {
+        xTaskNotifyGive(s_cacheTask);
+    }
+}
+
+int32_t SLN_SETTINGS_CACHE_Sync(void)
+{
+    int32_t ret    = SLN_FLASH_MGMT_OK;
+    int32_t status = SLN_FLASH_MGMT_OK;
+
+    if ((NULL == s_cacheLock) || (NULL == s_saveLock))
+    {
+        return SLN_FLASH_MGMT_ENOLOCK;
+    }
+
+    xSemaphoreTake(s_saveLock, portMAX_DELAY);
+
+    // Entries are only added, s_entryCount is read once per entry
+    for (uint32_t idx = 0; idx < s_entryCount; idx++)
+    {
+        status = save_entry(&s_entries[idx]);
+
+        if (SLN_FLASH_MGMT_OK != status)
+        {
+            ret = status;
+        }
+    }
+
+    xSemaphoreGive(s_saveLock);
+
+    return ret;
+}
+
+void SLN_SETTINGS_CACHE_GetStats(sln_settings_cache_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        *stats = s_cacheStats;
+    }
+}
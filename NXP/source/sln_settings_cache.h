@@ -0,0 +1,114 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_SETTINGS_CACHE_
+#define _SLN_SETTINGS_CACHE_
+
+/*!
+ * SLN Settings Cache
+ *
+ * Write-back cache of the settings files. The application keeps reading and writing its settings
+ * structure in RAM and marks it dirty after a change; the cache task saves it once no change came
+ * for SLN_SETTINGS_CACHE_QUIET_MS, so a burst of changes (volume steps) costs one flash record.
+ * A settings structure equal to the last saved one is not written again. Otherwise only the bytes from
+ * the first to the last change are written, with SLN_FLASH_MGMT_UpdateRange: a delta record for the
+ * logged settings files.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sln_flash_mgmt.h"
+
+/*! @brief Time without change before the dirty settings are saved */
+#ifndef SLN_SETTINGS_CACHE_QUIET_MS
+#define SLN_SETTINGS_CACHE_QUIET_MS (2000U)
+#endif
+
+/*! @brief Longest time settings changed over and over stay dirty */
+#ifndef SLN_SETTINGS_CACHE_MAX_DELAY_MS
+#define SLN_SETTINGS_CACHE_MAX_DELAY_MS (10000U)
+#endif
+
+/*! @brief Number of settings files in the cache */
+#define SLN_SETTINGS_CACHE_MAX_ENTRIES (4U)
+
+/*! @brief Bytes of RAM holding the last saved copy of all the settings */
+#define SLN_SETTINGS_CACHE_SHADOW_SIZE (256U)
+
+#define SLN_SETTINGS_CACHE_TASK_STACK    (512U)
+#define SLN_SETTINGS_CACHE_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+/*! @brief Set a field of registered settings and mark them dirty */
+#define SLN_SETTINGS_CACHE_SET(settings, field, value) \
+    do                                                 \
+    {                                                  \
+        (settings)->field = (value);                   \
+        SLN_SETTINGS_CACHE_MarkDirty(settings);        \
+    } while (0)
+
+/*! @brief Statistics of the cache */
+typedef struct _sln_settings_cache_stats
+{
+    uint32_t changes;      /*! Number of changes marked */
+    uint32_t commits;      /*! Number of settings files saved */
+    uint32_t deltas;       /*! Number of commits written as a changed range only */
+    uint32_t skipped;      /*! Number of commits skipped, settings equal to the saved ones */
+    uint32_t failures;     /*! Number of saves that failed */
+    uint32_t bytesChanged; /*! Bytes that differed from the saved settings, over all the commits */
+    uint32_t bytesWritten; /*! Bytes of settings saved, ranges or whole structures */
+} sln_settings_cache_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Create the cache task, to be called before the scheduler starts
+ *
+ * @returns SLN_FLASH_MGMT_OK or SLN_FLASH_MGMT_ENOMEM if the task or the lock could not be created
+ */
+int32_t SLN_SETTINGS_CACHE_Init(void);
+
+/*!
+ * @brief Add a settings structure to the cache; its current value is taken as the one saved in flash
+ *
+ * @param fileName Name of the settings file
+ * @param settings Settings structure in RAM, read and written by the application
+ * @param len Size of the settings structure
+ *
+ * @returns SLN_FLASH_MGMT_OK, SLN_FLASH_MGMT_ENOMEM if there is no room left in the cache
+ */
+int32_t SLN_SETTINGS_CACHE_Register(const char *fileName, void *settings, uint32_t len);
+
+/*!
+ * @brief Mark registered settings as changed, they are saved after the quiet time
+ *
+ * @param settings Settings structure given to SLN_SETTINGS_CACHE_Register
+ */
+void SLN_SETTINGS_CACHE_MarkDirty(const void *settings);
+
+/*!
+ * @brief Save all the dirty settings now, in the calling task
+ *
+ * @returns SLN_FLASH_MGMT_OK or the error of the last save that failed
+ */
+int32_t SLN_SETTINGS_CACHE_Sync(void);
+
+/*!
+ * @brief Get the statistics of the cache
+ *
+ * @param stats Pointer to the statistics to fill
+ */
+void SLN_SETTINGS_CACHE_GetStats(sln_settings_cache_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_SETTINGS_CACHE_ */
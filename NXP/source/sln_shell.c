@@ -14,6 +14,13 @@
 #include "audio_processing_task.h"
 #include "sln_local_voice.h"
 #include "sln_app_fwupdate.h"
+#include "sln_settings_cache.h"
+#include "sln_tcp_server.h"
+#if TCP_SERVER_TLS
+#include "mbedtls/platform_util.h"
+#include "sln_flash_mgmt.h"
+#include "sln_tls_server.h"
+#endif
 
 /*******************************************************************************
  * Definitions
@@ -48,6 +55,9 @@ static shell_status_t sln_cmdresults_handler(shell_handle_t shellHandle, int32_t
 static shell_status_t sln_updateotw_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
 static shell_status_t sln_updateota_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
 static shell_status_t sln_version_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#if TCP_SERVER_TLS
+static shell_status_t sln_tls_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#endif
 
 /*******************************************************************************
  * Variables
@@ -172,6 +182,19 @@ SHELL_COMMAND_DEFINE(updateota,
 
 SHELL_COMMAND_DEFINE(version, "\r\n\"version\": Print firmware version\r\n", sln_version_handler, 0);
 
+#if TCP_SERVER_TLS
+SHELL_COMMAND_DEFINE(tls,
+                     "\r\n\"tls\": Provision the certificate and private key of the TCP server\r\n"
+                     "         Usage:\r\n"
+                     "            tls cert|key LINE  Add a base64 line of the PEM body, in order\r\n"
+                     "            tls cert|key save  Store the lines added, the TCP server starts with both\r\n"
+                     "            tls cert|key clear Drop the lines added\r\n"
+                     "            tls status         Print the credentials stored\r\n"
+                     "         The BEGIN and END lines of the PEM are not entered\r\n",
+                     sln_tls_handler,
+                     SHELL_IGNORE_PARAMETER_COUNT);
+#endif
+
 extern app_asr_shell_commands_t appAsrShellCommands;
 extern TaskHandle_t appTaskHandle;
 
@@ -193,6 +216,17 @@ static wifi_cred_t s_wifi_cred = {0};
 static TaskHandle_t s_appInitTask      = NULL;
 static shell_heap_trace_t s_heap_trace = {0};
 
+#if TCP_SERVER_TLS
+/* Credential decoded from the lines of the "tls" command, stored by the shell task */
+static struct
+{
+    const char *name;
+    uint32_t len;
+    volatile bool saving;
+    uint8_t der[SLN_TLS_SERVER_CREDENTIAL_MAX_SIZE];
+} s_tlsCred = {0};
+#endif
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
@@ -312,53 +346,53 @@ static shell_status_t sln_changeto_handler(shell_handle_t shellHandle, int32_t a
         if (strcmp(str, "audio") == 0)
         {
             appAsrShellCommands.demo   = ASR_CMD_AUDIO;
-            appAsrShellCommands.status = WRITE_READY;
             appAsrShellCommands.asrCfg = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to Audio commands demo.\r\n"));
         }
         else if (strcmp(str, "iot") == 0)
         {
             appAsrShellCommands.demo   = ASR_CMD_IOT;
-            appAsrShellCommands.status = WRITE_READY;
             appAsrShellCommands.asrCfg = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to IoT commands demo.\r\n"));
         }
         else if (strcmp(str, "elevator") == 0)
         {
             appAsrShellCommands.demo   = ASR_CMD_ELEVATOR;
-            appAsrShellCommands.status = WRITE_READY;
             appAsrShellCommands.asrCfg = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to Elevator commands demo.\r\n"));
         }
         else if (strcmp(str, "wash") == 0)
         {
             appAsrShellCommands.demo   = ASR_CMD_WASH;
-            appAsrShellCommands.status = WRITE_READY;
             appAsrShellCommands.asrCfg = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to Washing Machine commands demo.\r\n"));
         }
         else if (strcmp(str, "led") == 0)
         {
             appAsrShellCommands.demo         = ASR_CMD_LED;
             appAsrShellCommands.multilingual = ASR_ENGLISH;
-            appAsrShellCommands.status       = WRITE_READY;
             appAsrShellCommands.asrCfg       = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED | ASR_CFG_DEMO_LANGUAGE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to LED commands demo. English only activated.\r\n"));
         }
         else if (strcmp(str, "dialog") == 0)
         {
             appAsrShellCommands.demo         = ASR_CMD_DIALOGIC_1;
             appAsrShellCommands.multilingual = ASR_ENGLISH;
-            appAsrShellCommands.status       = WRITE_READY;
             appAsrShellCommands.asrCfg       = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED | ASR_CFG_DEMO_LANGUAGE_CHANGED;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Changing to Dialogic commands demo. English only activated.\r\n"));
         }
         else if (strcmp(str, "cmkuan") == 0)
 		{
 			appAsrShellCommands.demo         = ASR_CMD_NORMAL;
 			appAsrShellCommands.multilingual = ASR_CHINESE;
-			appAsrShellCommands.status       = WRITE_READY;
 			appAsrShellCommands.asrCfg       = ASR_CFG_CMD_INFERENCE_ENGINE_CHANGED | ASR_CFG_DEMO_LANGUAGE_CHANGED;
+			SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
 			configPRINTF(("Changing to cmkuan commands demo. Chinese only activated.\r\n"));
 		}
         else
@@ -427,8 +461,8 @@ static shell_status_t sln_multilingual_handler(shell_handle_t shellHandle, int32
             {
                 // PTT, LED & DIALOG demos work only with English language.
                 appAsrShellCommands.multilingual = ASR_ENGLISH;
-                appAsrShellCommands.status       = WRITE_READY;
                 appAsrShellCommands.asrCfg       = ASR_CFG_DEMO_LANGUAGE_CHANGED;
+                SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
 
                 if (appAsrShellCommands.ptt == ASR_PTT_ON)
                 {
@@ -479,8 +513,8 @@ static shell_status_t sln_multilingual_handler(shell_handle_t shellHandle, int32
             if (status == kStatus_SHELL_Success)
             {
                 appAsrShellCommands.multilingual = multilingual;
-                appAsrShellCommands.status       = WRITE_READY;
                 appAsrShellCommands.asrCfg       = ASR_CFG_DEMO_LANGUAGE_CHANGED;
+                SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             }
             else
             {
@@ -519,7 +553,7 @@ static shell_status_t sln_volume_handler(shell_handle_t shellHandle, int32_t arg
                  atoi(argv[1]) <= 100)
         {
             appAsrShellCommands.volume = (uint32_t)atoi(argv[1]);
-            appAsrShellCommands.status = WRITE_READY;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting speaker volume to %d.\r\n", appAsrShellCommands.volume));
 
             // notify main task
@@ -554,13 +588,13 @@ static shell_status_t sln_followup_handler(shell_handle_t shellHandle, int32_t a
         if (strcmp(str, "on") == 0)
         {
             appAsrShellCommands.followup = ASR_FOLLOWUP_ON;
-            appAsrShellCommands.status   = WRITE_READY;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting ASR Follow-Up mode on.\r\n"));
         }
         else if (strcmp(str, "off") == 0)
         {
             appAsrShellCommands.followup = ASR_FOLLOWUP_OFF;
-            appAsrShellCommands.status   = WRITE_READY;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting ASR Follow-Up mode off.\r\n"));
         }
         else
@@ -596,7 +630,7 @@ static shell_status_t sln_timeout_handler(shell_handle_t shellHandle, int32_t ar
         else if (argc == 2 && (isNumber(argv[1]) == kStatus_SHELL_Success) && atoi(argv[1]) >= 0)
         {
             appAsrShellCommands.timeout = (uint32_t)atoi(argv[1]);
-            appAsrShellCommands.status  = WRITE_READY;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting command waiting time to %d ms.\r\n", appAsrShellCommands.timeout));
 
             // notify main task
@@ -630,8 +664,8 @@ static shell_status_t sln_mute_handler(shell_handle_t shellHandle, int32_t argc,
 
         if (strcmp(str, "on") == 0)
         {
-            appAsrShellCommands.mute   = ASR_MUTE_ON;
-            appAsrShellCommands.status = WRITE_READY;
+            appAsrShellCommands.mute = ASR_MUTE_ON;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting mute on.\r\n"));
 
             if (appAsrShellCommands.ptt == ASR_PTT_ON)
@@ -646,8 +680,8 @@ static shell_status_t sln_mute_handler(shell_handle_t shellHandle, int32_t argc,
         }
         else if (strcmp(str, "off") == 0)
         {
-            appAsrShellCommands.mute   = ASR_MUTE_OFF;
-            appAsrShellCommands.status = WRITE_READY;
+            appAsrShellCommands.mute = ASR_MUTE_OFF;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting mute off.\r\n"));
 
             // notify main task
@@ -685,8 +719,8 @@ static shell_status_t sln_ptt_handler(shell_handle_t shellHandle, int32_t argc,
             {
                 appAsrShellCommands.ptt          = ASR_PTT_ON;
                 appAsrShellCommands.multilingual = ASR_ENGLISH;
-                appAsrShellCommands.status       = WRITE_READY;
                 appAsrShellCommands.asrCfg       = ASR_CFG_DEMO_LANGUAGE_CHANGED;
+                SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
                 configPRINTF(("Setting ASR Push-To-Talk mode on. English only activated.\r\n"));
 
                 // notify main task
@@ -700,8 +734,8 @@ static shell_status_t sln_ptt_handler(shell_handle_t shellHandle, int32_t argc,
         }
         else if (strcmp(str, "off") == 0)
         {
-            appAsrShellCommands.ptt    = ASR_PTT_OFF;
-            appAsrShellCommands.status = WRITE_READY;
+            appAsrShellCommands.ptt = ASR_PTT_OFF;
+            SLN_SETTINGS_CACHE_MarkDirty(&appAsrShellCommands);
             configPRINTF(("Setting ASR Push-To-Talk mode off.\r\n"));
 
             // notify main task
@@ -870,6 +904,81 @@ static shell_status_t sln_version_handler(shell_handle_t shellHandle, int32_t ar
     return kStatus_SHELL_Success;
 }
 
+#if TCP_SERVER_TLS
+static shell_status_t sln_tls_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    const char *name                    = NULL;
+    size_t decoded                      = 0;
+
+    if ((2 == argc) && (0 == strcmp(argv[1], "status")))
+    {
+        xEventGroupSetBitsFromISR(s_ShellEventGroup, TLS_STATUS_EVT, &xHigherPriorityTaskWoken);
+        return kStatus_SHELL_Success;
+    }
+
+    if ((3 == argc) && (0 == strcmp(argv[1], "cert")))
+    {
+        name = SLN_TLS_SERVER_CERT_FILE_NAME;
+    }
+    else if ((3 == argc) && (0 == strcmp(argv[1], "key")))
+    {
+        name = SLN_TLS_SERVER_KEY_FILE_NAME;
+    }
+    else
+    {
+        SHELL_Printf(
+            s_shellHandle,
+            "\r\nIncorrect command parameter(s). Enter \"help\" to view a list of available commands.\r\n\r\n");
+        return kStatus_SHELL_Error;
+    }
+
+    if (s_tlsCred.saving)
+    {
+        SHELL_Printf(s_shellHandle, "\r\nA credential is being stored, try again\r\n");
+        return kStatus_SHELL_Error;
+    }
+
+    // The lines of the other credential are dropped
+    if (name != s_tlsCred.name)
+    {
+        mbedtls_platform_zeroize(s_tlsCred.der, sizeof(s_tlsCred.der));
+        s_tlsCred.name = name;
+        s_tlsCred.len  = 0;
+    }
+
+    if (0 == strcmp(argv[2], "clear"))
+    {
+        mbedtls_platform_zeroize(s_tlsCred.der, sizeof(s_tlsCred.der));
+        s_tlsCred.len = 0;
+    }
+    else if (0 == strcmp(argv[2], "save"))
+    {
+        if (0 == s_tlsCred.len)
+        {
+            SHELL_Printf(s_shellHandle, "\r\nNo line added\r\n");
+            return kStatus_SHELL_Error;
+        }
+
+        s_tlsCred.saving = true;
+        xEventGroupSetBitsFromISR(s_ShellEventGroup, TLS_SAVE_EVT, &xHigherPriorityTaskWoken);
+    }
+    else if (0 != mbedtls_base64_decode(&s_tlsCred.der[s_tlsCred.len], sizeof(s_tlsCred.der) - s_tlsCred.len,
+                                        &decoded, (const unsigned char *)argv[2], strlen(argv[2])))
+    {
+        SHELL_Printf(s_shellHandle, "\r\nNot a base64 line, or more than %d bytes, line ignored\r\n",
+                     SLN_TLS_SERVER_CREDENTIAL_MAX_SIZE);
+        return kStatus_SHELL_Error;
+    }
+    else
+    {
+        s_tlsCred.len += decoded;
+    }
+
+    return kStatus_SHELL_Success;
+}
+#endif
+
 int log_shell_printf(const char *formatString, ...)
 {
     va_list ap;
@@ -942,6 +1051,9 @@ int sln_shell_init(void)
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(updateotw));
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(updateota));
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(version));
+#if TCP_SERVER_TLS
+    SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(tls));
+#endif
 
     return status;
 }
@@ -998,6 +1110,7 @@ void sln_shell_task(void *arg)
             if (!status)
             {
                 SHELL_Printf(s_shellHandle, "Credentials saved\r\n");
+                SLN_SETTINGS_CACHE_Sync();
                 NVIC_SystemReset();
             }
             else
@@ -1013,6 +1126,7 @@ void sln_shell_task(void *arg)
             if (!status)
             {
                 SHELL_Printf(s_shellHandle, "Credentials erased\r\n");
+                SLN_SETTINGS_CACHE_Sync();
                 NVIC_SystemReset();
             }
             else
@@ -1029,10 +1143,54 @@ void sln_shell_task(void *arg)
             SHELL_Printf(s_shellHandle, "SHELL>> ");
         }
 
+#if TCP_SERVER_TLS
+        if (shellEvents & TLS_SAVE_EVT)
+        {
+            status = SLN_TLS_SERVER_SaveCredential(s_tlsCred.name, s_tlsCred.der, s_tlsCred.len);
+            if (SLN_FLASH_MGMT_OK == status)
+            {
+                SHELL_Printf(s_shellHandle, "%s saved, %d bytes\r\n", s_tlsCred.name, s_tlsCred.len);
+            }
+            else
+            {
+                SHELL_Printf(s_shellHandle, "Failed to save %s, error code %d\r\n", s_tlsCred.name, status);
+            }
+
+            mbedtls_platform_zeroize(s_tlsCred.der, sizeof(s_tlsCred.der));
+            s_tlsCred.len    = 0;
+            s_tlsCred.saving = false;
+            SHELL_Printf(s_shellHandle, "SHELL>> ");
+        }
+
+        if (shellEvents & TLS_STATUS_EVT)
+        {
+            const char *names[] = {SLN_TLS_SERVER_CERT_FILE_NAME, SLN_TLS_SERVER_KEY_FILE_NAME};
+
+            for (uint32_t idx = 0; idx < ARRAY_SIZE(names); idx++)
+            {
+                uint32_t len = 0;
+
+                status = SLN_FLASH_MGMT_Read(names[idx], NULL, &len);
+                if (SLN_FLASH_MGMT_OK == status)
+                {
+                    SHELL_Printf(s_shellHandle, "%s: %d bytes\r\n", names[idx], len);
+                }
+                else
+                {
+                    SHELL_Printf(s_shellHandle, "%s: not stored, error code %d\r\n", names[idx], status);
+                }
+            }
+
+            SHELL_Printf(s_shellHandle, "SHELL>> ");
+        }
+#endif
+
         if (shellEvents & RESET_EVENT)
         {
             /* this rather drastic approach is used for when one wants to use another
-             * wifi network after successfully connecting to another one previously */
+             * wifi network after successfully connecting to another one previously;
+             * the settings changed during the write-back quiet time are saved first */
+            SLN_SETTINGS_CACHE_Sync();
             NVIC_SystemReset();
         }
     }
@@ -81,6 +81,8 @@ typedef enum __shell_event
     HARDFAULT_LOGS_EVT = (1 << 11U),
     SERIAL_NUMBER_EVT  = (1 << 12U),
     VERSION_EVT        = (1 << 13U),
+    TLS_SAVE_EVT       = (1 << 14U),
+    TLS_STATUS_EVT     = (1 << 15U),
 } shell_event_t;
 
 typedef struct __shell_heap_trace
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "fsl_common.h"
+#include "sln_tcp_frame.h"
+
+/* End of a frame: the parser waits for the next length prefix */
+static tcp_connection_status_t deliver_frame(sln_tcp_frame_t *frame, const uint8_t *payload, uint32_t len)
+{
+    frame->headerLen = 0;
+    frame->received  = 0;
+
+    return frame->cb(frame->arg, payload, len);
+}
+
+void SLN_TCP_FRAME_Init(
+    sln_tcp_frame_t *frame, uint8_t *buffer, uint32_t bufferSize, sln_tcp_frame_cb_t cb, void *arg)
+{
+    memset(frame, 0, sizeof(sln_tcp_frame_t));
+
+    frame->buffer     = buffer;
+    frame->bufferSize = bufferSize;
+    frame->cb         = cb;
+    frame->arg        = arg;
+}
+
+tcp_connection_status_t SLN_TCP_FRAME_Input(sln_tcp_frame_t *frame, const uint8_t *data, uint32_t len)
+{
+    tcp_connection_status_t status = kCommon_Success;
+    uint32_t toCopy                = 0;
+
+    while ((kCommon_Success == status) && (len > 0))
+    {
+        if (frame->headerLen < SLN_TCP_FRAME_HEADER_SIZE)
+        {
+            frame->header[frame->headerLen++] = *data++;
+            len--;
+
+            if (SLN_TCP_FRAME_HEADER_SIZE == frame->headerLen)
+            {
+                frame->payloadLen = (uint32_t)frame->header[0] | ((uint32_t)frame->header[1] << 8) |
+                                    ((uint32_t)frame->header[2] << 16) | ((uint32_t)frame->header[3] << 24);
+                frame->received = 0;
+
+                if (frame->payloadLen > frame->bufferSize)
+                {
+                    // The payload can't be skipped safely, the length may be garbage
+                    status = kCommon_ToManyBytes;
+                }
+                else if (0 == frame->payloadLen)
+                {
+                    status = deliver_frame(frame, frame->buffer, 0);
+                }
+            }
+
+            continue;
+        }
+
+        toCopy = MIN(len, frame->payloadLen - frame->received);
+
+        if ((0 == frame->received) && (toCopy == frame->payloadLen))
+        {
+            // The whole frame is in this segment, no copy
+            status = deliver_frame(frame, data, toCopy);
+        }
+        else
+        {
+            memcpy(&frame->buffer[frame->received], data, toCopy);
+            frame->received += toCopy;
+
+            if (frame->received == frame->payloadLen)
+            {
+                status = deliver_frame(frame, frame->buffer, frame->payloadLen);
+            }
+        }
+
+        data += toCopy;
+        len -= toCopy;
+    }
+
+    return status;
+}
+
+tcp_connection_status_t SLN_TCP_FRAME_InputPbuf(sln_tcp_frame_t *frame, const struct pbuf *p)
+{
+    tcp_connection_status_t status = kCommon_Success;
+
+    for (const struct pbuf *q = p; (NULL != q) && (kCommon_Success == status); q = q->next)
+    {
+        status = SLN_TCP_FRAME_Input(frame, (const uint8_t *)q->payload, q->len);
+    }
+
+    return status;
+}
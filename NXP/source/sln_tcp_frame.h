@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_TCP_FRAME_H_
+#define _SLN_TCP_FRAME_H_
+
+/*!
+ * SLN TCP Frame
+ *
+ * Length-prefixed framing of the TCP server stream: each frame is a 4-byte little endian payload
+ * length followed by the payload. The stream is parsed as it comes, segment by segment; a frame
+ * held whole in one segment is passed in place, the others are gathered in a buffer of bounded size.
+ */
+
+#include <stdint.h>
+#include "lwip/pbuf.h"
+#include "sln_tcp_server.h"
+
+/*! @brief Size of the length prefix of a frame */
+#define SLN_TCP_FRAME_HEADER_SIZE (4U)
+
+/*! @brief Called for each complete frame; the payload is only valid during the call */
+typedef tcp_connection_status_t (*sln_tcp_frame_cb_t)(void *arg, const uint8_t *payload, uint32_t len);
+
+/*! @brief Parser of a frame stream */
+typedef struct _sln_tcp_frame
+{
+    uint8_t header[SLN_TCP_FRAME_HEADER_SIZE]; /*!< header: Length prefix, may be split over segments. */
+    uint32_t headerLen;                        /*!< headerLen: Bytes of the length prefix received. */
+    uint32_t payloadLen;                       /*!< payloadLen: Length of the frame being received. */
+    uint32_t received;                         /*!< received: Payload bytes gathered in buffer. */
+    uint8_t *buffer;                           /*!< buffer: Frames split over segments are gathered here. */
+    uint32_t bufferSize;                       /*!< bufferSize: Size of buffer, longest frame accepted. */
+    sln_tcp_frame_cb_t cb;                     /*!< cb: Called for each complete frame. */
+    void *arg;                                 /*!< arg: Argument of the callback. */
+} sln_tcp_frame_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Initialize a frame parser
+ *
+ * @param frame The parser
+ * @param buffer Buffer gathering the frames split over segments
+ * @param bufferSize Size of the buffer, longer frames are rejected
+ * @param cb Called for each complete frame
+ * @param arg Argument of the callback
+ */
+void SLN_TCP_FRAME_Init(
+    sln_tcp_frame_t *frame, uint8_t *buffer, uint32_t bufferSize, sln_tcp_frame_cb_t cb, void *arg);
+
+/*!
+ * @brief Parse bytes of the stream, the callback is called for each frame they complete
+ *
+ * @param frame The parser
+ * @param data Bytes of the stream
+ * @param len Number of bytes
+ *
+ * @returns kCommon_Success, kCommon_ToManyBytes for a frame longer than the buffer (the stream can't be
+ *          parsed any further) or the error returned by the callback
+ */
+tcp_connection_status_t SLN_TCP_FRAME_Input(sln_tcp_frame_t *frame, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Parse a pbuf chain of the stream, segment by segment
+ *
+ * @param frame The parser
+ * @param p The pbuf chain, still owned by the caller
+ *
+ * @returns Same as SLN_TCP_FRAME_Input
+ */
+tcp_connection_status_t SLN_TCP_FRAME_InputPbuf(sln_tcp_frame_t *frame, const struct pbuf *p);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_TCP_FRAME_H_ */
@@ -12,11 +12,17 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "event_groups.h"
-#include "cJSON.h"
 
 #include "fsl_common.h"
 #include "network_connection.h"
 #include "sln_app_fwupdate.h"
+#include "sln_json.h"
+#include "sln_metrics.h"
+#include "sln_settings_cache.h"
+#include "sln_tcp_frame.h"
+#if TCP_SERVER_TLS
+#include "sln_tls_server.h"
+#endif
 
 #include "lwip/opt.h"
 #include "lwip/debug.h"
@@ -28,43 +34,90 @@
 #define TCPTASK_PRIORITY  (configMAX_PRIORITIES - 6UL)
 #define TCPTASK_STACKSIZE 2 * 1024
 
+/* Longest status message: {"error":-2147483648} */
+#define TCP_STATUS_JSON_SIZE (32)
+
+/*
+ * Request of a page of a metrics snapshot: {"messageType":4,"base":N,"cursor":C}, base the seq of the last
+ * snapshot received, cursor 0 for the first page or the "next" of the previous page. A page fills at most a frame.
+ */
+#define TCP_MESSAGETYPE_METRICS (4)
+#define TCP_METRICS_JSON_SIZE   (TCP_MAX_BUFFER_SIZE)
+
+/* Segments read from a client before the others are served */
+#define TCP_CLIENT_RECV_BURST (4)
+
+/*! @brief Client connection of the server */
+typedef struct _tcp_client
+{
+    struct netconn *conn;                    /*!< conn: Connection, NULL if the slot is free. */
+    sln_tcp_frame_t frame;                   /*!< frame: Parser of the frames received. */
+    uint8_t buffer[TCP_MAX_BUFFER_SIZE + 1]; /*!< buffer: Frames split over segments, NUL terminated. */
+    TickType_t lastRecv;                     /*!< lastRecv: Tick of the last data received. */
+    uint32_t otaRemaining;                   /*!< otaRemaining: Image bytes still to come, 0 if not streaming. */
+#if TCP_SERVER_TLS
+    sln_tls_session_t tls;                   /*!< tls: TLS session of the connection. */
+#endif
+} tcp_client_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
-static err_t netconn_write_blocking(struct netconn *pConnection, void *message, int size);
+#if !TCP_SERVER_TLS
+static err_t netconn_write_blocking(struct netconn *pConnection, const struct netvector *vectors, u16_t count);
+#endif
 static void ota_server_callback(struct netconn *pConnection, enum netconn_evt event, uint16_t len);
-static void parse_buffer(uint8_t *buff);
-static err_t send_error_code(int statusCode);
-static tcp_connection_status_t read_connection(void);
+static void parse_buffer(tcp_client_t *client, uint8_t *buff);
+static err_t send_frame(tcp_client_t *client, const void *payload, uint32_t size);
+static err_t send_error_code(tcp_client_t *client, int statusCode);
+static tcp_connection_status_t handle_frame(void *arg, const uint8_t *payload, uint32_t len);
+static tcp_connection_status_t read_connection(tcp_client_t *client);
 static void TCP_OTA_Server(void *param);
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
 static struct netconn *conn                = NULL;
-static struct netconn *newconn             = NULL;
+static struct netconn *s_sendConn          = NULL;
 static EventGroupHandle_t s_netconn_events = NULL;
+static TaskHandle_t s_serverTask           = NULL;
+
+static tcp_client_t s_clients[TCP_MAX_CLIENTS];
+static fwupdate_stream_info_t s_streamInfo;
+static char s_metricsJson[TCP_METRICS_JSON_SIZE];
+#if TCP_SERVER_TLS
+/* Frame sent in one record; data decrypted, parsed in place so kept apart from the replies */
+static uint8_t s_tlsFrame[SLN_TCP_FRAME_HEADER_SIZE + TCP_MAX_BUFFER_SIZE];
+static uint8_t s_tlsRecv[SLN_TCP_FRAME_HEADER_SIZE + TCP_MAX_BUFFER_SIZE];
+#endif
+
+SLN_METRICS_DEFINE_COUNTER(s_tcpAccepted, "tcp.accepted");
+SLN_METRICS_DEFINE_COUNTER(s_tcpRejected, "tcp.rejected");
+SLN_METRICS_DEFINE_COUNTER(s_tcpFrames, "tcp.frames");
 
 /*******************************************************************************
  * Code
  ******************************************************************************/
+#if !TCP_SERVER_TLS
 /**
  * @brief Netconn write is an async operation. Wrapper to wait for the message to be delivered
  *
  * @param *pConnection  connection on which to send the message
- * @param *message      pointer to the message
- * @param size          size of the message
+ * @param *vectors      parts of the message, sent in one write
+ * @param count         number of parts
  */
-static err_t netconn_write_blocking(struct netconn *pConnection, void *message, int size)
+static err_t netconn_write_blocking(struct netconn *pConnection, const struct netvector *vectors, u16_t count)
 {
     EventBits_t uxBits = 0;
     err_t err          = ERR_OK;
 
     xEventGroupClearBits(s_netconn_events, 1 << NETCONN_EVT_SENDPLUS);
+    s_sendConn = pConnection;
 
-    err = netconn_write(pConnection, message, size, NETCONN_COPY);
+    err = netconn_write_vectors_partly(pConnection, (struct netvector *)vectors, count, NETCONN_COPY, NULL);
     if (err != ERR_OK)
     {
+        s_sendConn = NULL;
         return err;
     }
 
@@ -75,8 +128,11 @@ static err_t netconn_write_blocking(struct netconn *pConnection, void *message,
         err = ERR_TIMEOUT;
     }
 
+    s_sendConn = NULL;
+
     return err;
 }
+#endif
 
 /**
  * @brief Callback function called from tcp thread after a message was send
@@ -90,11 +146,19 @@ static void ota_server_callback(struct netconn *pConnection, enum netconn_evt ev
     switch (event)
     {
         case NETCONN_EVT_SENDPLUS:
-            if ((pConnection == newconn) && (len != 0))
+            if ((pConnection == s_sendConn) && (len != 0))
             {
                 xEventGroupSetBits(s_netconn_events, 1 << NETCONN_EVT_SENDPLUS);
             }
             break;
+        case NETCONN_EVT_RCVPLUS:
+        case NETCONN_EVT_ERROR:
+            /* New client, data or error: wake up the server task */
+            if (NULL != s_serverTask)
+            {
+                xTaskNotifyGive(s_serverTask);
+            }
+            break;
         default:
         {
             break;
@@ -102,74 +166,225 @@ static void ota_server_callback(struct netconn *pConnection, enum netconn_evt ev
     }
 }
 
+/**
+ * @brief Send a frame: its length prefix and payload in one write
+ *
+ * @param *client       the client
+ * @param *payload      payload of the frame
+ * @param size          size of the payload
+ */
+static err_t send_frame(tcp_client_t *client, const void *payload, uint32_t size)
+{
+#if TCP_SERVER_TLS
+    if (size > TCP_MAX_BUFFER_SIZE)
+    {
+        return ERR_VAL;
+    }
+
+    /* In one record, the client gets the frame whole */
+    memcpy(s_tlsFrame, &size, sizeof(size));
+    memcpy(&s_tlsFrame[sizeof(size)], payload, size);
+
+    return (0 == SLN_TLS_SERVER_Write(&client->tls, s_tlsFrame, sizeof(size) + size)) ? ERR_OK : ERR_CONN;
+#else
+    struct netvector frame[2];
+
+    frame[0].ptr = &size;
+    frame[0].len = sizeof(size);
+    frame[1].ptr = payload;
+    frame[1].len = size;
+
+    return netconn_write_blocking(client->conn, frame, 2);
+#endif
+}
+
 /**
  * @brief Sends error code back.
  *
+ * @param *client       the client
  * @param statusCode    The status of the operation
  */
-static err_t send_error_code(int statusCode)
+static err_t send_error_code(tcp_client_t *client, int statusCode)
 {
     /* Used if an OTA message received */
-    uint32_t size         = 0;
-    cJSON *jsonMessage    = NULL;
-    cJSON *jsonErrorState = NULL;
-    char *jsonStr         = NULL;
-    err_t err             = ERR_OK;
-
-    /* Create JSON objects */
-    jsonMessage    = cJSON_CreateObject();
-    jsonErrorState = cJSON_CreateNumber(statusCode);
-
-    if (jsonMessage == NULL || jsonErrorState == NULL)
+    err_t err = ERR_OK;
+    char jsonStr[TCP_STATUS_JSON_SIZE];
+    sln_json_writer_t writer;
+
+    /* Written on the stack, no heap allocation per message */
+    SLN_JSON_WriterInit(&writer, jsonStr, sizeof(jsonStr));
+    SLN_JSON_BeginObject(&writer);
+    SLN_JSON_Key(&writer, "error");
+    SLN_JSON_Int(&writer, statusCode);
+    SLN_JSON_EndObject(&writer);
+
+    if (SLN_JSON_WriterEnd(&writer) < 0)
     {
         configPRINTF(("[ERROR]send_error_code failed to create json objects \r\n"));
         return 1;
     }
 
-    /* Add jsonErrorState to jsonMessage */
-    cJSON_AddItemToObject(jsonMessage, "error", jsonErrorState);
+    err = send_frame(client, jsonStr, writer.len);
+    if (err != ERR_OK)
+    {
+        /* Failed to send status */
+        configPRINTF(("[ERROR]TCP failed to send status back  \r\n"));
+    }
+
+    return err;
+}
+
+/**
+ * @brief Check if the message is a metrics request
+ *
+ * @param *buff message received
+ * @param *base seq of the last snapshot the client received, 0 if not given
+ * @param *cursor cursor of the page, 0 if not given
+ */
+static bool check_metrics_command(uint8_t *buff, uint32_t *base, uint32_t *cursor)
+{
+    sln_json_token_t tokens[8];
+    int32_t count = 0;
+    int32_t value = -1;
+    int64_t num   = 0;
 
-    jsonStr = cJSON_PrintUnformatted(jsonMessage);
-    size    = (uint32_t)strlen(jsonStr);
+    count = SLN_JSON_Parse((const char *)buff, strlen((const char *)buff), tokens, ARRAY_SIZE(tokens));
+    if (count <= 0)
+    {
+        return false;
+    }
 
-    err = netconn_write_blocking(newconn, (void *)&size, 4);
-    if (err == ERR_OK)
+    value = SLN_JSON_ObjectGet((const char *)buff, tokens, count, 0, "messageType");
+    if ((value < 0) || !SLN_JSON_GetInt((const char *)buff, &tokens[value], &num) || (TCP_MESSAGETYPE_METRICS != num))
     {
-        err = netconn_write_blocking(newconn, (void *)jsonStr, size);
-        /* Failed to send status */
-        if (err != ERR_OK)
+        return false;
+    }
+
+    *base = 0;
+    value = SLN_JSON_ObjectGet((const char *)buff, tokens, count, 0, "base");
+    if ((value >= 0) && SLN_JSON_GetInt((const char *)buff, &tokens[value], &num) && (num > 0) && (num <= UINT32_MAX))
+    {
+        *base = (uint32_t)num;
+    }
+
+    *cursor = 0;
+    value   = SLN_JSON_ObjectGet((const char *)buff, tokens, count, 0, "cursor");
+    if ((value >= 0) && SLN_JSON_GetInt((const char *)buff, &tokens[value], &num) && (num > 0) && (num <= UINT32_MAX))
+    {
+        *cursor = (uint32_t)num;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Send a page of a snapshot of the metrics, the increments since base if it is the last snapshot taken
+ *        A page fits into one frame, the client asks for the next one with its "next" cursor.
+ *
+ * @param *client       the client
+ * @param base          seq of the last snapshot the client received
+ * @param cursor        cursor of the page
+ */
+static void send_metrics(tcp_client_t *client, uint32_t base, uint32_t cursor)
+{
+    sln_json_writer_t writer;
+    uint32_t next = 0;
+
+    SLN_JSON_WriterInit(&writer, s_metricsJson, sizeof(s_metricsJson));
+
+    if (0 == SLN_METRICS_Snapshot(&writer, base, cursor, &next))
+    {
+        configPRINTF(("[ERROR]TCP metrics page %d not written \r\n", cursor));
+        send_error_code(client, 1);
+        return;
+    }
+
+    send_frame(client, s_metricsJson, (uint32_t)SLN_JSON_WriterEnd(&writer));
+}
+
+/**
+ * @brief Start streaming an image into the inactive bank, the next frames of the client are the image
+ *
+ * @param *client   the client that sent the stream command
+ */
+static void start_stream(tcp_client_t *client)
+{
+    fwupdate_stream_status_t status = FWUpdate_stream_start(&s_streamInfo);
+
+    if (FWUPDATE_STREAM_OK == status)
+    {
+        client->otaRemaining = s_streamInfo.imageLen;
+    }
+    else
+    {
+        configPRINTF(("Cannot start the image stream, error %d\r\n", status));
+    }
+
+    send_error_code(client, status);
+}
+
+/**
+ * @brief Write a frame of the image streamed; the board restarts on the new image once it is verified
+ *
+ * @param *client   the client streaming the image
+ * @param *payload  frame payload
+ * @param len       length of the payload
+ */
+static tcp_connection_status_t stream_frame(tcp_client_t *client, const uint8_t *payload, uint32_t len)
+{
+    fwupdate_stream_status_t status = FWUpdate_stream_write(payload, len);
+
+    if (FWUPDATE_STREAM_OK == status)
+    {
+        client->otaRemaining -= len;
+        if (0 != client->otaRemaining)
         {
-            configPRINTF(("[ERROR]TCP failed to send status back  \r\n"));
+            return kCommon_Success;
         }
+
+        status = FWUpdate_stream_finish();
     }
     else
     {
-        /* Failed to send size */
-        configPRINTF(("[ERROR]TCP failed to send size \r\n"));
+        FWUpdate_stream_abort();
     }
 
-    /* Send was done, delete message */
-    cJSON_Delete(jsonMessage);
-    vPortFree(jsonStr);
-    return err;
+    client->otaRemaining = 0;
+    send_error_code(client, status);
+
+    if (FWUPDATE_STREAM_OK != status)
+    {
+        configPRINTF(("The image stream failed, error %d\r\n", status));
+        return kCommon_Failed;
+    }
+
+    configPRINTF(("The new firmware is verified, restarting\r\n"));
+    SLN_SETTINGS_CACHE_Sync();
+    vTaskDelay(100);
+    NVIC_SystemReset();
+
+    return kCommon_Success;
 }
 
 /**
  * @brief Parse the buffer to look for fwupdate command
  *
+ * @param *client client the message was received from
  * @param *buff message received
  */
-static void parse_buffer(uint8_t *buff)
+static void parse_buffer(tcp_client_t *client, uint8_t *buff)
 {
     /* Check if this can be a message used for fwupdate */
     err_t status     = 0;
     uint8_t err_code = 0;
+    uint32_t base    = 0;
+    uint32_t cursor  = 0;
 
     err_code = FWUpdate_check_start_command(buff);
     if (FWUPDATE_OK == err_code)
     {
         /* Right message received, signal status ok */
-        status = send_error_code(err_code);
+        status = send_error_code(client, err_code);
         if (status == ERR_OK)
         {
             /* Set the flag for update */
@@ -177,8 +392,10 @@ static void parse_buffer(uint8_t *buff)
             if (kStatus_Success == err_code)
             {
                 configPRINTF(("The firmware update with method OTA will be started\r\n"));
+                /* Save the settings still in the write-back cache, then reset the board with the FICA bit set
+                 * for OTA */
+                SLN_SETTINGS_CACHE_Sync();
                 vTaskDelay(100);
-                /* Reset the board with the FICA bit set for OTA */
                 NVIC_SystemReset();
             }
             else
@@ -187,86 +404,221 @@ static void parse_buffer(uint8_t *buff)
             }
         }
     }
+    else if (FWUPDATE_OK == FWUpdate_check_stream_command(buff, &s_streamInfo))
+    {
+        start_stream(client);
+    }
+    else if (check_metrics_command(buff, &base, &cursor))
+    {
+        send_metrics(client, base, cursor);
+    }
     else if (FWUPDATE_WRONG_MESSAGETYPE == err_code)
     {
         /*It has the format of the OTA, wrong messagetype */
         configPRINTF(("Invalid start command\r\n"));
-        send_error_code(err_code);
+        send_error_code(client, err_code);
     }
 }
 
 /**
- * @brief Read the network connection which was established
+ * @brief Handle a frame received from a client
+ *
+ * @param *arg      the client
+ * @param *payload  frame payload, in the client buffer or in place in a segment
+ * @param len       length of the payload
  */
-static tcp_connection_status_t read_connection(void)
+static tcp_connection_status_t handle_frame(void *arg, const uint8_t *payload, uint32_t len)
 {
-    tcp_connection_status_t status = kCommon_Success;
-    err_t err                      = ERR_OK;
-    struct netbuf *buf             = NULL;
-    uint8_t *rcvBuffer             = NULL;
-    uint8_t *packet_buffer         = NULL;
-    uint16_t pSize                 = 0;
-    uint16_t bytes_read            = 0;
-    uint32_t packet_size           = 0;
-
-    err = netconn_recv(newconn, &buf);
-    if (err != ERR_OK)
+    tcp_client_t *client = (tcp_client_t *)arg;
+
+    if (0 != client->otaRemaining)
     {
-        return kCommon_ConnectionLost;
+        /* Image data, the frame is not a command */
+        return stream_frame(client, payload, len);
     }
-    /* First send how much information does the packet has */
-    err = netbuf_data(buf, (void **)(&rcvBuffer), &pSize);
-    if (err != ERR_OK)
+
+    SLN_METRICS_Add(&s_tcpFrames, 1);
+
+    /* The JSON parser needs a NUL terminated string */
+    if (payload != client->buffer)
     {
-        return kCommon_NoDataRead;
+        memcpy(client->buffer, payload, len);
     }
-    memcpy(&packet_size, rcvBuffer, pSize);
-    netbuf_delete(buf);
+    client->buffer[len] = '\0';
+
+    parse_buffer(client, client->buffer);
+
+    return kCommon_Success;
+}
+
+#if TCP_SERVER_TLS
+/**
+ * @brief Continue the handshake, then read the records the client sent, without waiting;
+ *        the frames completed are handled
+ *
+ * @param *client   the client
+ */
+static tcp_connection_status_t read_connection(tcp_client_t *client)
+{
+    tcp_connection_status_t status = kCommon_Success;
+    int32_t ret                    = 0;
 
-    /* If the packet is too big, abort */
-    if (packet_size > TCP_MAX_BUFFER_SIZE)
+    if (!client->tls.established)
     {
-        /* The packet is too big, something is wrong abort */
-        return kCommon_ToManyBytes;
+        ret = SLN_TLS_SERVER_Handshake(&client->tls);
+        if (SLN_TLS_SERVER_WANT_READ == ret)
+        {
+            return kCommon_Success;
+        }
+        if (MBEDTLS_ERR_SSL_CONN_EOF == ret)
+        {
+            return kCommon_ConnectionLost;
+        }
+        if (0 != ret)
+        {
+            configPRINTF(("[ERROR]TLS handshake failed, -0x%x \r\n", -ret));
+            return kCommon_Failed;
+        }
+
+        client->lastRecv = xTaskGetTickCount();
     }
 
-    packet_buffer = (uint8_t *)pvPortMalloc(packet_size);
-    if (packet_buffer == NULL)
+    for (uint32_t burst = 0; (kCommon_Success == status) && (burst < TCP_CLIENT_RECV_BURST); burst++)
     {
-        /* Failed to allocate memory for the future packet */
-        return kCommon_Failed;
+        ret = SLN_TLS_SERVER_Read(&client->tls, s_tlsRecv, sizeof(s_tlsRecv));
+        if (SLN_TLS_SERVER_WANT_READ == ret)
+        {
+            return kCommon_Success;
+        }
+        if (ret <= 0)
+        {
+            return (0 == ret) ? kCommon_ConnectionLost : kCommon_Failed;
+        }
+
+        client->lastRecv = xTaskGetTickCount();
+
+        /* A frame held whole in the record is parsed in place */
+        status = SLN_TCP_FRAME_Input(&client->frame, s_tlsRecv, (uint32_t)ret);
     }
 
-    /* Wait to received everything */
-    do
+    if (kCommon_Success == status)
     {
-        pSize     = 0;
-        rcvBuffer = NULL;
-        err       = netconn_recv(newconn, &buf);
-        if (err != ERR_OK)
+        /* More may be waiting, come back once the other clients are served */
+        xTaskNotifyGive(s_serverTask);
+    }
+
+    return status;
+}
+#else
+/**
+ * @brief Read what a client sent, without waiting; the frames completed are handled
+ *
+ * @param *client   the client
+ */
+static tcp_connection_status_t read_connection(tcp_client_t *client)
+{
+    tcp_connection_status_t status = kCommon_Success;
+    err_t err                      = ERR_OK;
+    struct pbuf *p                 = NULL;
+
+    for (uint32_t burst = 0; (kCommon_Success == status) && (burst < TCP_CLIENT_RECV_BURST); burst++)
+    {
+        err = netconn_recv_tcp_pbuf_flags(client->conn, &p, NETCONN_DONTBLOCK);
+        if (err == ERR_WOULDBLOCK)
         {
-            /* If it fails to received all, drop the packet and free the buffer */
-            vPortFree(packet_buffer);
-            return kCommon_ConnectionLost;
+            return kCommon_Success;
         }
-        err = netbuf_data(buf, (void **)(&rcvBuffer), &pSize);
         if (err != ERR_OK)
         {
-            vPortFree(packet_buffer);
-            return kCommon_NoDataRead;
+            return kCommon_ConnectionLost;
         }
 
-        /* Copy data into a local buffer */
-        memcpy((void *)(packet_buffer + bytes_read), rcvBuffer, pSize);
-        bytes_read += pSize;
-        netbuf_delete(buf);
-    } while (bytes_read != packet_size);
+        client->lastRecv = xTaskGetTickCount();
 
-    /* Parse the received data */
-    parse_buffer(packet_buffer);
+        /* Parsed in place, segment by segment */
+        status = SLN_TCP_FRAME_InputPbuf(&client->frame, p);
+        pbuf_free(p);
+    }
+
+    if (kCommon_Success == status)
+    {
+        /* More may be waiting, come back once the other clients are served */
+        xTaskNotifyGive(s_serverTask);
+    }
 
     return status;
 }
+#endif
+
+/**
+ * @brief Accept the pending connections, while a client slot is free
+ */
+static void accept_clients(void)
+{
+    struct netconn *newconn = NULL;
+    tcp_client_t *client    = NULL;
+
+    while (ERR_OK == netconn_accept(conn, &newconn))
+    {
+        client = NULL;
+
+        for (uint32_t idx = 0; idx < TCP_MAX_CLIENTS; idx++)
+        {
+            if (NULL == s_clients[idx].conn)
+            {
+                client = &s_clients[idx];
+                break;
+            }
+        }
+
+        if (NULL == client)
+        {
+            configPRINTF(("[ERROR]TCP too many clients \r\n"));
+            SLN_METRICS_Add(&s_tcpRejected, 1);
+            netconn_delete(newconn);
+            continue;
+        }
+
+#if TCP_SERVER_TLS
+        if (0 != SLN_TLS_SERVER_Open(&client->tls, newconn))
+        {
+            configPRINTF(("[ERROR]TLS no memory left for the session \r\n"));
+            SLN_METRICS_Add(&s_tcpRejected, 1);
+            netconn_delete(newconn);
+            continue;
+        }
+#endif
+
+        SLN_METRICS_Add(&s_tcpAccepted, 1);
+
+        client->conn         = newconn;
+        client->lastRecv     = xTaskGetTickCount();
+        client->otaRemaining = 0;
+        SLN_TCP_FRAME_Init(&client->frame, client->buffer, TCP_MAX_BUFFER_SIZE, handle_frame, client);
+    }
+}
+
+/**
+ * @brief Close the connection of a client and free its slot
+ *
+ * @param *client   the client
+ */
+static void close_client(tcp_client_t *client)
+{
+    if (0 != client->otaRemaining)
+    {
+        /* The image stream of the client is left incomplete */
+        FWUpdate_stream_abort();
+        client->otaRemaining = 0;
+    }
+
+#if TCP_SERVER_TLS
+    SLN_TLS_SERVER_Close(&client->tls);
+#endif
+
+    netconn_delete(client->conn);
+    client->conn = NULL;
+}
 
 /* TCP server */
 static void TCP_OTA_Server(void *param)
@@ -310,6 +662,15 @@ static void TCP_OTA_Server(void *param)
         vTaskDelay(1000);
     }
 
+#if TCP_SERVER_TLS
+    /* The control and OTA messages are never accepted in plaintext, the server waits for valid credentials */
+    while (0 != SLN_TLS_SERVER_Init())
+    {
+        configPRINTF(("[WARNING] TCP server waiting for its TLS credentials, see the \"tls\" shell command\r\n"));
+        SLN_TLS_SERVER_WaitCredentials();
+    }
+#endif
+
     configPRINTF(("TCP server start\n"));
 
     conn = netconn_new_with_callback(NETCONN_TCP, ota_server_callback);
@@ -328,25 +689,41 @@ static void TCP_OTA_Server(void *param)
     {
         return;
     }
-    conn->recv_timeout = TCP_COMMS_TIMEOUT;
+
+    /* Accept and receive never wait, the task sleeps until the callback reports an event */
+    netconn_set_nonblocking(conn, 1);
 
     while (1)
     {
-        if (newconn != NULL)
-        {
-            netconn_delete(newconn);
-            newconn = NULL;
-        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TCP_COMMS_TIMEOUT));
 
-        err = netconn_accept(conn, &newconn);
-        if (err == ERR_OK)
+        accept_clients();
+
+        for (uint32_t idx = 0; idx < TCP_MAX_CLIENTS; idx++)
         {
+            tcp_client_t *client = &s_clients[idx];
             tcp_connection_status_t status;
-            newconn->recv_timeout = TCP_COMMS_TIMEOUT;
-            status                = read_connection();
-            if (kCommon_Success != status)
+
+            if (NULL == client->conn)
+            {
+                continue;
+            }
+
+            status = read_connection(client);
+
+            if (kCommon_ConnectionLost == status)
+            {
+                /* Closed by the client */
+                close_client(client);
+            }
+            else if (kCommon_Success != status)
             {
                 configPRINTF(("[ERROR]TCP failed to recv \r\n"));
+                close_client(client);
+            }
+            else if ((xTaskGetTickCount() - client->lastRecv) > pdMS_TO_TICKS(TCP_CLIENT_IDLE_TIMEOUT))
+            {
+                close_client(client);
             }
         }
     }
@@ -356,12 +733,9 @@ static void TCP_OTA_Server(void *param)
 
 void TCP_OTA_Server_Start()
 {
-    cJSON_Hooks hooks;
-
-    /* Initialize cJSON library to use FreeRTOS heap memory management. */
-    hooks.malloc_fn = pvPortMalloc;
-    hooks.free_fn   = vPortFree;
-    cJSON_InitHooks(&hooks);
+    SLN_METRICS_Register(&s_tcpAccepted);
+    SLN_METRICS_Register(&s_tcpRejected);
+    SLN_METRICS_Register(&s_tcpFrames);
 
     s_netconn_events = xEventGroupCreate();
     if (s_netconn_events == NULL)
@@ -370,7 +744,7 @@ void TCP_OTA_Server_Start()
         while (1)
             ;
     }
-    if (xTaskCreate(TCP_OTA_Server, "TCP_Server", TCPTASK_STACKSIZE, NULL, TCPTASK_PRIORITY, NULL) != pdPASS)
+    if (xTaskCreate(TCP_OTA_Server, "TCP_Server", TCPTASK_STACKSIZE, NULL, TCPTASK_PRIORITY, &s_serverTask) != pdPASS)
     {
         configPRINTF(("[ERROR]TCP Task created failed\r\n"));
 
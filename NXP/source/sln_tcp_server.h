@@ -14,6 +14,19 @@
 #define TCP_MAX_BUFFER_SIZE (1024)
 #define TCP_COMMS_TIMEOUT   (3000)
 
+/* Clients served at the same time, each with a TCP_MAX_BUFFER_SIZE frame buffer */
+#define TCP_MAX_CLIENTS (3)
+
+/* A client sending nothing for this long (ms) is disconnected */
+#define TCP_CLIENT_IDLE_TIMEOUT (30000)
+
+/* TLS 1.2 on the server port, the credentials provisioned in flash with the "tls" shell command (see
+ * sln_tls_server.h), the server waits for them; set to 0 only for development, the messages can restart
+ * the board into an update */
+#ifndef TCP_SERVER_TLS
+#define TCP_SERVER_TLS (1)
+#endif
+
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
@@ -0,0 +1,477 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/memory_buffer_alloc.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_internal.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/threading.h"
+#include "mbedtls/x509_crt.h"
+
+#include "sln_flash_mgmt.h"
+#include "sln_metrics.h"
+#include "sln_tls_server.h"
+
+#if !defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || !defined(MBEDTLS_SSL_SRV_C) || !defined(MBEDTLS_SSL_TICKET_C) || \
+    !defined(MBEDTLS_SSL_CACHE_C)
+#error "SLN TLS Server needs the buffer allocator, the server, ticket and cache modules of mbedTLS"
+#endif
+
+#if !defined(MBEDTLS_THREADING_C) || !defined(MBEDTLS_THREADING_ALT)
+#error "SLN TLS Server needs the FreeRTOS mutexes of threading_alt.h, the pool is shared by the tasks"
+#endif
+
+#define TLS_SERVER_PERSONALIZATION "sln_tls_server"
+
+static uint8_t s_tlsHeap[SLN_TLS_SERVER_HEAP_SIZE];
+
+static mbedtls_entropy_context s_entropy;
+static mbedtls_ctr_drbg_context s_drbg;
+static mbedtls_x509_crt s_cert;
+static mbedtls_pk_context s_key;
+static mbedtls_ssl_config s_conf;
+static mbedtls_ssl_ticket_context s_ticket;
+static mbedtls_ssl_cache_context s_cache;
+static bool s_poolReady = false;
+static bool s_ready     = false;
+
+/* Given when a credential is stored, for a server waiting for them */
+static SemaphoreHandle_t s_credSaved = NULL;
+static StaticSemaphore_t s_credSavedCtrl;
+
+SLN_METRICS_DEFINE_COUNTER(s_tlsHandshakes, "tls.handshakes");
+SLN_METRICS_DEFINE_COUNTER(s_tlsResumed, "tls.resumed");
+SLN_METRICS_DEFINE_COUNTER(s_tlsFailures, "tls.failures");
+SLN_METRICS_DEFINE_HISTOGRAM(s_tlsHandshakeMs, "tls.handshake_ms");
+
+/* Mutexes of mbedTLS, see threading_alt.h */
+static void tls_mutex_init(mbedtls_threading_mutex_t *mutex)
+{
+    mutex->handle = xSemaphoreCreateMutexStatic(&mutex->storage);
+}
+
+static void tls_mutex_free(mbedtls_threading_mutex_t *mutex)
+{
+    if (NULL != mutex->handle)
+    {
+        vSemaphoreDelete(mutex->handle);
+        mutex->handle = NULL;
+    }
+}
+
+static int tls_mutex_lock(mbedtls_threading_mutex_t *mutex)
+{
+    if (NULL == mutex->handle)
+    {
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+    }
+
+    return (pdTRUE == xSemaphoreTake(mutex->handle, portMAX_DELAY)) ? 0 : MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+}
+
+static int tls_mutex_unlock(mbedtls_threading_mutex_t *mutex)
+{
+    if (NULL == mutex->handle)
+    {
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+    }
+
+    return (pdTRUE == xSemaphoreGive(mutex->handle)) ? 0 : MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+}
+
+static SemaphoreHandle_t get_cred_saved(void)
+{
+    taskENTER_CRITICAL();
+
+    if (NULL == s_credSaved)
+    {
+        s_credSaved = xSemaphoreCreateBinaryStatic(&s_credSavedCtrl);
+    }
+
+    taskEXIT_CRITICAL();
+
+    return s_credSaved;
+}
+
+/* Received data of the client, read from the pending segment first, never waits */
+static int tls_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    sln_tls_session_t *session = (sln_tls_session_t *)ctx;
+    err_t err                  = ERR_OK;
+    u16_t copied               = 0;
+
+    if (NULL == session->rx)
+    {
+        err = netconn_recv_tcp_pbuf_flags(session->conn, &session->rx, NETCONN_DONTBLOCK);
+        if (ERR_WOULDBLOCK == err)
+        {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+        if (ERR_CLSD == err)
+        {
+            /* Closed by the client */
+            return 0;
+        }
+        if (ERR_OK != err)
+        {
+            return MBEDTLS_ERR_NET_RECV_FAILED;
+        }
+
+        session->rxOffset = 0;
+    }
+
+    copied = pbuf_copy_partial(session->rx, buf, (u16_t)LWIP_MIN(len, 0xFFFFU), session->rxOffset);
+    session->rxOffset += copied;
+
+    if (session->rxOffset >= session->rx->tot_len)
+    {
+        pbuf_free(session->rx);
+        session->rx = NULL;
+    }
+
+    return copied;
+}
+
+/* Waits for room in the send buffer, up to SLN_TLS_SERVER_SEND_TIMEOUT_MS */
+static int tls_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    sln_tls_session_t *session = (sln_tls_session_t *)ctx;
+    size_t written             = 0;
+
+    if (ERR_OK != netconn_write_partly(session->conn, buf, len, NETCONN_COPY, &written))
+    {
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return (int)written;
+}
+
+/* Certificate or key file, allocated from the pool */
+static int32_t read_file(const char *name, uint8_t **data, uint32_t *len)
+{
+    int32_t ret = SLN_FLASH_MGMT_Read(name, NULL, len);
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        return ret;
+    }
+
+    *data = mbedtls_calloc(1, *len);
+    if (NULL == *data)
+    {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    ret = SLN_FLASH_MGMT_Read(name, *data, len);
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        mbedtls_free(*data);
+        *data = NULL;
+    }
+
+    return ret;
+}
+
+static int32_t load_credentials(void)
+{
+    int32_t ret   = 0;
+    uint8_t *data = NULL;
+    uint32_t len  = 0;
+
+    ret = read_file(SLN_TLS_SERVER_CERT_FILE_NAME, &data, &len);
+    if (0 != ret)
+    {
+        configPRINTF(("[ERROR]TLS server certificate not found, %d\r\n", ret));
+        return ret;
+    }
+
+    ret = mbedtls_x509_crt_parse(&s_cert, data, len);
+    mbedtls_free(data);
+    if (0 != ret)
+    {
+        configPRINTF(("[ERROR]TLS server certificate not valid, -0x%x\r\n", -ret));
+        return ret;
+    }
+
+    ret = read_file(SLN_TLS_SERVER_KEY_FILE_NAME, &data, &len);
+    if (0 != ret)
+    {
+        configPRINTF(("[ERROR]TLS server key not found, %d\r\n", ret));
+        return ret;
+    }
+
+    ret = mbedtls_pk_parse_key(&s_key, data, len, NULL, 0);
+    mbedtls_platform_zeroize(data, len);
+    mbedtls_free(data);
+    if (0 != ret)
+    {
+        configPRINTF(("[ERROR]TLS server key not valid, -0x%x\r\n", -ret));
+        return ret;
+    }
+
+    ret = mbedtls_pk_check_pair(&s_cert.pk, &s_key);
+    if (0 != ret)
+    {
+        configPRINTF(("[ERROR]TLS server key does not match the certificate\r\n"));
+    }
+
+    return ret;
+}
+
+int32_t SLN_TLS_SERVER_Init(void)
+{
+    int32_t ret = 0;
+
+    if (s_ready)
+    {
+        return 0;
+    }
+
+    if (!s_poolReady)
+    {
+        /* The mutexes first, the pool has one; every mbedTLS allocation comes from the pool from now on */
+        mbedtls_threading_set_alt(tls_mutex_init, tls_mutex_free, tls_mutex_lock, tls_mutex_unlock);
+        mbedtls_memory_buffer_alloc_init(s_tlsHeap, sizeof(s_tlsHeap));
+        s_poolReady = true;
+    }
+
+    mbedtls_entropy_init(&s_entropy);
+    mbedtls_ctr_drbg_init(&s_drbg);
+    mbedtls_x509_crt_init(&s_cert);
+    mbedtls_pk_init(&s_key);
+    mbedtls_ssl_config_init(&s_conf);
+    mbedtls_ssl_ticket_init(&s_ticket);
+    mbedtls_ssl_cache_init(&s_cache);
+
+    /* Seeded from the TRNG, the entropy source of the ksdk port */
+    ret = mbedtls_ctr_drbg_seed(&s_drbg, mbedtls_entropy_func, &s_entropy,
+                                (const unsigned char *)TLS_SERVER_PERSONALIZATION,
+                                sizeof(TLS_SERVER_PERSONALIZATION) - 1);
+    if (0 != ret)
+    {
+        goto exit;
+    }
+
+    ret = load_credentials();
+    if (0 != ret)
+    {
+        goto exit;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&s_conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (0 != ret)
+    {
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_rng(&s_conf, mbedtls_ctr_drbg_random, &s_drbg);
+    mbedtls_ssl_conf_min_version(&s_conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+
+    ret = mbedtls_ssl_conf_own_cert(&s_conf, &s_cert, &s_key);
+    if (0 != ret)
+    {
+        goto exit;
+    }
+
+    /* Resumption: tickets for the clients supporting them, the cache for the others */
+    ret = mbedtls_ssl_ticket_setup(&s_ticket, mbedtls_ctr_drbg_random, &s_drbg, MBEDTLS_CIPHER_AES_128_GCM,
+                                   SLN_TLS_SERVER_TICKET_LIFETIME);
+    if (0 != ret)
+    {
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_session_tickets_cb(&s_conf, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, &s_ticket);
+    mbedtls_ssl_conf_session_cache(&s_conf, &s_cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+
+    SLN_METRICS_Register(&s_tlsHandshakes);
+    SLN_METRICS_Register(&s_tlsResumed);
+    SLN_METRICS_Register(&s_tlsFailures);
+    SLN_METRICS_Register(&s_tlsHandshakeMs);
+
+    s_ready = true;
+
+exit:
+    if (0 != ret)
+    {
+        mbedtls_ssl_cache_free(&s_cache);
+        mbedtls_ssl_ticket_free(&s_ticket);
+        mbedtls_ssl_config_free(&s_conf);
+        mbedtls_pk_free(&s_key);
+        mbedtls_x509_crt_free(&s_cert);
+        mbedtls_ctr_drbg_free(&s_drbg);
+        mbedtls_entropy_free(&s_entropy);
+    }
+
+    return ret;
+}
+
+int32_t SLN_TLS_SERVER_SaveCredential(const char *name, const uint8_t *der, uint32_t len)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    if ((NULL == name) || (NULL == der) || (0 == len) || (len > SLN_TLS_SERVER_CREDENTIAL_MAX_SIZE) ||
+        ((0 != strcmp(name, SLN_TLS_SERVER_CERT_FILE_NAME)) && (0 != strcmp(name, SLN_TLS_SERVER_KEY_FILE_NAME))))
+    {
+        return SLN_FLASH_MGMT_EINVAL;
+    }
+
+    ret = SLN_FLASH_MGMT_Save(name, (uint8_t *)der, len);
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        xSemaphoreGive(get_cred_saved());
+    }
+
+    return ret;
+}
+
+void SLN_TLS_SERVER_WaitCredentials(void)
+{
+    xSemaphoreTake(get_cred_saved(), portMAX_DELAY);
+}
+
+int32_t SLN_TLS_SERVER_Open(sln_tls_session_t *session, struct netconn *conn)
+{
+    int32_t ret = 0;
+
+    if (!s_ready)
+    {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    mbedtls_ssl_init(&session->ssl);
+
+    /* Allocates the record buffers */
+    ret = mbedtls_ssl_setup(&session->ssl, &s_conf);
+    if (0 != ret)
+    {
+        mbedtls_ssl_free(&session->ssl);
+        SLN_METRICS_Add(&s_tlsFailures, 1);
+        return ret;
+    }
+
+    mbedtls_ssl_set_bio(&session->ssl, session, tls_send, tls_recv, NULL);
+    netconn_set_sendtimeout(conn, SLN_TLS_SERVER_SEND_TIMEOUT_MS);
+
+    session->conn        = conn;
+    session->rx          = NULL;
+    session->rxOffset    = 0;
+    session->established = false;
+    session->resumed     = false;
+    session->start       = xTaskGetTickCount();
+
+    return 0;
+}
+
+int32_t SLN_TLS_SERVER_Handshake(sln_tls_session_t *session)
+{
+    int32_t ret = 0;
+
+    /* Step by step to see if the client resumed, the handshake parameters are freed at the end */
+    while (MBEDTLS_SSL_HANDSHAKE_OVER != session->ssl.state)
+    {
+        ret = mbedtls_ssl_handshake_step(&session->ssl);
+
+        if ((NULL != session->ssl.handshake) && (0 != session->ssl.handshake->resume))
+        {
+            session->resumed = true;
+        }
+
+        if (0 != ret)
+        {
+            break;
+        }
+    }
+
+    if (0 == ret)
+    {
+        if (!session->established)
+        {
+            session->established = true;
+
+            SLN_METRICS_Add(&s_tlsHandshakes, 1);
+            SLN_METRICS_Add(&s_tlsResumed, session->resumed ? 1 : 0);
+            SLN_METRICS_Observe(&s_tlsHandshakeMs, (xTaskGetTickCount() - session->start) * portTICK_PERIOD_MS);
+        }
+    }
+    else if (SLN_TLS_SERVER_WANT_READ != ret)
+    {
+        SLN_METRICS_Add(&s_tlsFailures, 1);
+    }
+
+    return ret;
+}
+
+int32_t SLN_TLS_SERVER_Read(sln_tls_session_t *session, uint8_t *data, uint32_t len)
+{
+    int32_t ret = mbedtls_ssl_read(&session->ssl, data, len);
+
+    if ((MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret) || (MBEDTLS_ERR_SSL_CONN_EOF == ret))
+    {
+        return 0;
+    }
+
+    return ret;
+}
+
+int32_t SLN_TLS_SERVER_Write(sln_tls_session_t *session, const uint8_t *data, uint32_t len)
+{
+    int32_t ret = 0;
+
+    while (len > 0)
+    {
+        ret = mbedtls_ssl_write(&session->ssl, data, len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        data += ret;
+        len -= ret;
+    }
+
+    return 0;
+}
+
+void SLN_TLS_SERVER_Close(sln_tls_session_t *session)
+{
+    if (NULL == session->conn)
+    {
+        return;
+    }
+
+    if (session->established)
+    {
+        /* Best effort, the connection may be lost already */
+        mbedtls_ssl_close_notify(&session->ssl);
+    }
+
+    mbedtls_ssl_free(&session->ssl);
+
+    if (NULL != session->rx)
+    {
+        pbuf_free(session->rx);
+        session->rx = NULL;
+    }
+
+    session->conn = NULL;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_TLS_SERVER_H_
+#define _SLN_TLS_SERVER_H_
+
+/*!
+ * SLN TLS Server
+ *
+ * TLS 1.2 sessions over the non-blocking netconns of the TCP server, with mbedTLS. The AES and
+ * SHA-256 of the records run on the DCP through the ksdk port of mbedTLS.
+ *
+ * All the memory of mbedTLS comes from a static pool of SLN_TLS_SERVER_HEAP_SIZE bytes, not the
+ * FreeRTOS heap: a session costs about 11 KB (two 4 KB record buffers), a handshake in progress a few
+ * more. A client coming back resumes its session, from a ticket or the session cache, without the
+ * ECDHE and signature of a full handshake.
+ *
+ * The certificate and private key of the server are files of the flash file system, PEM with the
+ * terminating NUL or DER; the key file is encrypted. They are provisioned with the "tls" shell command,
+ * through SLN_TLS_SERVER_SaveCredential.
+ *
+ * The pool and the contexts shared by the sessions are protected by FreeRTOS mutexes, installed by
+ * SLN_TLS_SERVER_Init (MBEDTLS_THREADING_ALT, see threading_alt.h): mbedTLS may be used by other tasks
+ * once it ran.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "lwip/api.h"
+#include "mbedtls/ssl.h"
+
+#define SLN_TLS_SERVER_CERT_FILE_NAME "tls_srv_crt.dat"
+#define SLN_TLS_SERVER_KEY_FILE_NAME  "tls_srv_key.dat"
+
+/*! @brief Largest certificate or key file */
+#define SLN_TLS_SERVER_CREDENTIAL_MAX_SIZE (2048U)
+
+/*! @brief Pool of the mbedTLS allocations, for the sessions of all the clients */
+#ifndef SLN_TLS_SERVER_HEAP_SIZE
+#define SLN_TLS_SERVER_HEAP_SIZE (48 * 1024)
+#endif
+
+/*! @brief Validity of the session tickets, in seconds */
+#define SLN_TLS_SERVER_TICKET_LIFETIME (24 * 60 * 60)
+
+/*! @brief A client not taking a record for that long is considered lost */
+#define SLN_TLS_SERVER_SEND_TIMEOUT_MS (3000)
+
+/*! @brief Returned while the session waits for data of the client */
+#define SLN_TLS_SERVER_WANT_READ MBEDTLS_ERR_SSL_WANT_READ
+
+/*! @brief TLS session of a client */
+typedef struct _sln_tls_session
+{
+    mbedtls_ssl_context ssl; /*!< ssl: mbedTLS context, set up while the session is open. */
+    struct netconn *conn;    /*!< conn: Connection of the client, NULL if the session is closed. */
+    struct pbuf *rx;         /*!< rx: Segment received and not read completely, NULL if none. */
+    uint16_t rxOffset;       /*!< rxOffset: Bytes of rx already read. */
+    bool established;        /*!< established: The handshake is over. */
+    bool resumed;            /*!< resumed: The handshake resumed a previous session. */
+    TickType_t start;        /*!< start: Tick the session was opened, for the handshake time. */
+} sln_tls_session_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Set up mbedTLS: memory pool, random generator, server credentials and session resumption
+ *
+ * @returns 0 on success, the mbedTLS or SLN_FLASH_MGMT error otherwise; the credentials missing
+ *          are reported as SLN_FLASH_MGMT_ENOENTRY*
+ */
+int32_t SLN_TLS_SERVER_Init(void);
+
+/*!
+ * @brief Store a credential of the server into its file, the next SLN_TLS_SERVER_Init loads it
+ *
+ * @param name SLN_TLS_SERVER_CERT_FILE_NAME or SLN_TLS_SERVER_KEY_FILE_NAME
+ * @param der The certificate or key, DER or PEM with its terminating NUL
+ * @param len Length of the credential, up to SLN_TLS_SERVER_CREDENTIAL_MAX_SIZE
+ *
+ * @returns SLN_FLASH_MGMT_OK on success, the SLN_FLASH_MGMT error otherwise
+ */
+int32_t SLN_TLS_SERVER_SaveCredential(const char *name, const uint8_t *der, uint32_t len);
+
+/*!
+ * @brief Wait for a credential to be stored by SLN_TLS_SERVER_SaveCredential, after SLN_TLS_SERVER_Init failed
+ */
+void SLN_TLS_SERVER_WaitCredentials(void);
+
+/*!
+ * @brief Open the session of a client just accepted, the handshake starts with its first data
+ *
+ * @param session The session, closed
+ * @param conn Connection of the client, received from without waiting
+ *
+ * @returns 0 on success, MBEDTLS_ERR_SSL_ALLOC_FAILED when the pool is exhausted
+ */
+int32_t SLN_TLS_SERVER_Open(sln_tls_session_t *session, struct netconn *conn);
+
+/*!
+ * @brief Continue the handshake with the data received, without waiting for more
+ *
+ * @param session The session
+ *
+ * @returns 0 once established, SLN_TLS_SERVER_WANT_READ while waiting for the client,
+ *          an mbedTLS error if the handshake failed
+ */
+int32_t SLN_TLS_SERVER_Handshake(sln_tls_session_t *session);
+
+/*!
+ * @brief Read application data, without waiting
+ *
+ * @param session The session, established
+ * @param data Buffer for the data
+ * @param len Size of the buffer
+ *
+ * @returns Bytes read, SLN_TLS_SERVER_WANT_READ if none are available, 0 if the client closed
+ *          the session, an mbedTLS error otherwise
+ */
+int32_t SLN_TLS_SERVER_Read(sln_tls_session_t *session, uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Send application data, in one record if it fits, waiting until it is handed to the stack
+ *
+ * @param session The session, established
+ * @param data Data to send
+ * @param len Length of the data
+ *
+ * @returns 0 once all the data is sent, an mbedTLS error otherwise
+ */
+int32_t SLN_TLS_SERVER_Write(sln_tls_session_t *session, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Close the session and free its memory; the connection is left to the caller
+ *
+ * @param session The session, may be closed already
+ */
+void SLN_TLS_SERVER_Close(sln_tls_session_t *session);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_TLS_SERVER_H_ */
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sln_metrics.h"
+#include "sln_zerocopy.h"
+
+SLN_METRICS_DEFINE_COUNTER(s_zerocopySends, "zerocopy.sends");
+SLN_METRICS_DEFINE_COUNTER(s_zerocopyBytes, "zerocopy.bytes");
+SLN_METRICS_DEFINE_COUNTER(s_zerocopyBusy, "zerocopy.busy");
+SLN_METRICS_DEFINE_HISTOGRAM(s_zerocopyHeldMs, "zerocopy.held_ms");
+
+/* Freed by the last holder of the pbuf: the sender, the stack (ARP queue) or the WiFi driver */
+static void zerocopy_free(struct pbuf *p)
+{
+    sln_zerocopy_buf_t *buf           = (sln_zerocopy_buf_t *)p;
+    sln_zerocopy_release_cb_t release = buf->release;
+    void *arg                         = buf->arg;
+
+    SLN_METRICS_Observe(&s_zerocopyHeldMs, (xTaskGetTickCount() - buf->sentTick) * portTICK_PERIOD_MS);
+
+    buf->busy = false;
+
+    if (NULL != release)
+    {
+        release(arg);
+    }
+}
+
+static bool zerocopy_claim(sln_zerocopy_buf_t *buf, sln_zerocopy_release_cb_t release, void *arg)
+{
+    bool claimed = false;
+
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    if (!buf->busy)
+    {
+        buf->busy = true;
+        claimed   = true;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    if (claimed)
+    {
+        buf->release                     = release;
+        buf->arg                         = arg;
+        buf->sentTick                    = xTaskGetTickCount();
+        buf->custom.custom_free_function = zerocopy_free;
+    }
+    else
+    {
+        SLN_METRICS_Add(&s_zerocopyBusy, 1);
+    }
+
+    return claimed;
+}
+
+static err_t zerocopy_send(struct netconn *conn, struct pbuf *p, const ip_addr_t *addr, uint16_t port)
+{
+    struct netbuf netbuf;
+    uint16_t len = p->tot_len;
+    err_t err    = ERR_OK;
+
+    memset(&netbuf, 0, sizeof(netbuf));
+    netbuf.p   = p;
+    netbuf.ptr = p;
+
+    err = netconn_sendto(conn, &netbuf, addr, port);
+    if (ERR_OK == err)
+    {
+        SLN_METRICS_Add(&s_zerocopySends, 1);
+        SLN_METRICS_Add(&s_zerocopyBytes, len);
+    }
+
+    /* The stack and the driver took their own references if they still need the payload */
+    pbuf_free(p);
+
+    return err;
+}
+
+void SLN_ZEROCOPY_Init(void)
+{
+    SLN_METRICS_Register(&s_zerocopySends);
+    SLN_METRICS_Register(&s_zerocopyBytes);
+    SLN_METRICS_Register(&s_zerocopyBusy);
+    SLN_METRICS_Register(&s_zerocopyHeldMs);
+}
+
+err_t SLN_ZEROCOPY_SendTo(struct netconn *conn,
+                          sln_zerocopy_buf_t *buf,
+                          uint16_t len,
+                          const ip_addr_t *addr,
+                          uint16_t port,
+                          sln_zerocopy_release_cb_t release,
+                          void *arg)
+{
+    struct pbuf *p = NULL;
+
+    if ((NULL == buf->mem) || (len > buf->size))
+    {
+        return ERR_ARG;
+    }
+
+    if (!zerocopy_claim(buf, release, arg))
+    {
+        return ERR_INPROGRESS;
+    }
+
+    /* A PBUF_RAM pbuf placed before its payload: the headers are added in the headroom */
+    p = pbuf_alloced_custom(PBUF_TRANSPORT, len, PBUF_RAM, &buf->custom, buf->mem,
+                            (u16_t)(SLN_ZEROCOPY_HEADROOM + buf->size));
+
+    return zerocopy_send(conn, p, addr, port);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_ZEROCOPY_H_
+#define _SLN_ZEROCOPY_H_
+
+/*!
+ * SLN Zero-copy
+ *
+ * Datagrams sent from application buffers through lwIP custom pbufs, released by the stack once the
+ * driver is done with them instead of being copied into the lwIP heap.
+ *
+ * A buffer defined with SLN_ZEROCOPY_DEFINE_BUFFER keeps room for the link, IP and UDP headers in
+ * front of its payload: the stack and the WiFi driver prepend their headers in place and the payload
+ * is never copied.
+ *
+ * TCP is not covered: with LWIP_NETIF_TX_SINGLE_PBUF, tcp_write always copies the data, so the audio
+ * tap and the metrics of the TCP server keep their copies.
+ *
+ * Metrics: zerocopy.sends and zerocopy.bytes, the payload that did not go through the lwIP heap;
+ * zerocopy.busy, sends refused because the buffer was still held; zerocopy.held_ms, the time from
+ * the send to the release, which bounds the datagrams per second of one buffer.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lwip/api.h"
+#include "lwip/pbuf.h"
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "SLN Zero-copy needs LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+
+/*! @brief Room kept in front of the payload of a buffer for the link, IP and UDP headers */
+#define SLN_ZEROCOPY_HEADROOM LWIP_MEM_ALIGN_SIZE(PBUF_TRANSPORT)
+
+/*! @brief Called once the stack and the driver no longer use the payload, from the task that freed it */
+typedef void (*sln_zerocopy_release_cb_t)(void *arg);
+
+/*! @brief Buffer or reference handed to lwIP */
+typedef struct _sln_zerocopy_buf
+{
+    struct pbuf_custom custom;         /*!< custom: The pbuf given to the stack, first member. */
+    uint8_t *mem;                      /*!< mem: Headroom then payload, placed after this struct. */
+    uint16_t size;                     /*!< size: Payload capacity of a buffer. */
+    volatile bool busy;                /*!< busy: Held by the stack or the driver. */
+    sln_zerocopy_release_cb_t release; /*!< release: Callback of the send in progress. */
+    void *arg;                         /*!< arg: Argument of the callback. */
+    uint32_t sentTick;                 /*!< sentTick: Tick of the send in progress. */
+} sln_zerocopy_buf_t;
+
+/*! @brief Define a buffer with room for the headers, used as &var.buf */
+#define SLN_ZEROCOPY_DEFINE_BUFFER(var, payloadSize)        \
+    static struct                                           \
+    {                                                       \
+        sln_zerocopy_buf_t buf;                             \
+        uint8_t mem[SLN_ZEROCOPY_HEADROOM + (payloadSize)]; \
+    } var = {{.mem = var.mem, .size = (payloadSize)}}
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Register the metrics of the zero-copy sends, before the first one
+ */
+void SLN_ZEROCOPY_Init(void);
+
+/*!
+ * @brief Payload of a buffer, to be written only while the buffer is not busy
+ *
+ * @param buf The buffer
+ *
+ * @returns Pointer to the payload
+ */
+static inline void *SLN_ZEROCOPY_Payload(sln_zerocopy_buf_t *buf)
+{
+    return buf->mem + SLN_ZEROCOPY_HEADROOM;
+}
+
+/*!
+ * @brief Check if a buffer is still held by the stack
+ *
+ * @param buf The buffer
+ *
+ * @returns true until its release
+ */
+static inline bool SLN_ZEROCOPY_IsBusy(const sln_zerocopy_buf_t *buf)
+{
+    return buf->busy;
+}
+
+/*!
+ * @brief Send the payload of a buffer in a datagram, without copying it
+ *
+ * @param conn UDP connection
+ * @param buf The buffer, its payload written
+ * @param len Length of the payload
+ * @param addr Destination address
+ * @param port Destination port
+ * @param release Called when the buffer can be written again, may be NULL
+ * @param arg Argument of release
+ *
+ * @returns ERR_OK if sent, the lwIP error otherwise; release is called in both cases,
+ *          but not for ERR_ARG (bad length) or ERR_INPROGRESS (buffer still busy)
+ */
+err_t SLN_ZEROCOPY_SendTo(struct netconn *conn,
+                          sln_zerocopy_buf_t *buf,
+                          uint16_t len,
+                          const ip_addr_t *addr,
+                          uint16_t port,
+                          sln_zerocopy_release_cb_t release,
+                          void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SLN_ZEROCOPY_H_ */
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _FREERTOS_HOST_H_
+#define _FREERTOS_HOST_H_
+
+/*!
+ * FreeRTOS on a Linux host
+ *
+ * The part of the FreeRTOS API used by the modules built on the host, run on POSIX threads. The
+ * threads share one simulated core: a task runs only while it holds the core and gives it back when
+ * it blocks, delays or yields, so the code between two blocking calls runs alone as on the target.
+ * There is no preemption and no priority.
+ *
+ * The tasks created before vTaskStartScheduler wait for it; vTaskStartScheduler returns and the
+ * thread calling it carries on as a task.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define portSTACK_TYPE StackType_t
+
+#define pdFALSE (0)
+#define pdTRUE  (1)
+#define pdPASS  (pdTRUE)
+#define pdFAIL  (pdFALSE)
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS  ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define configTICK_RATE_HZ  (1000)
+#define configMAX_PRIORITIES (8)
+
+#define configPRINTF(x)  printf x
+#define configASSERT(x)  ((x) ? (void)0 : abort())
+#define pvPortMalloc(s)  malloc(s)
+#define vPortFree(p)     free(p)
+
+/* Controls of the objects created by the static API, the host ones live in the handles */
+typedef struct _host_static
+{
+    void *handle;
+} StaticTask_t, StaticQueue_t, StaticSemaphore_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Takes the simulated core, for a thread not created by xTaskCreate; the main thread holds it from the start
+ */
+void HOST_RTOS_Enter(void);
+
+/*!
+ * @brief Gives the simulated core back before a thread not created by xTaskCreate ends or blocks outside of FreeRTOS
+ */
+void HOST_RTOS_Exit(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FREERTOS_HOST_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _BOARD_HOST_H_
+#define _BOARD_HOST_H_
+
+#include "fsl_common.h"
+
+/* Size of the HyperFlash of the board, the simulated flash has the same */
+#define BOARD_FLASH_SIZE (0x4000000U)
+
+#endif /* _BOARD_HOST_H_ */
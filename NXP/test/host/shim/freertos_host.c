@@ -0,0 +1,420 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+struct _host_task
+{
+    pthread_t thread;
+    TaskFunction_t code;
+    void *params;
+    const char *name;
+    pthread_cond_t notified;
+    uint32_t notifications;
+};
+
+struct _host_sem
+{
+    pthread_cond_t cond;
+    UBaseType_t max;
+    UBaseType_t count;
+};
+
+struct _host_queue
+{
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+/* The simulated core, held by the thread running */
+static pthread_mutex_t s_core = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_cond_t s_started = PTHREAD_COND_INITIALIZER;
+static bool s_running           = false;
+
+static struct _host_task s_mainTask = {.name = "main"};
+static __thread struct _host_task *s_currentTask = NULL;
+
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+__attribute__((constructor)) static void host_rtos_boot(void)
+{
+    s_mainTask.thread = pthread_self();
+    s_currentTask     = &s_mainTask;
+    cond_init(&s_mainTask.notified);
+    pthread_mutex_lock(&s_core);
+}
+
+/* Waits on a condition, giving the core back meanwhile; false on timeout */
+static bool cond_wait(pthread_cond_t *cond, const struct timespec *deadline)
+{
+    if (NULL == deadline)
+    {
+        pthread_cond_wait(cond, &s_core);
+        return true;
+    }
+
+    return ETIMEDOUT != pthread_cond_timedwait(cond, &s_core, deadline);
+}
+
+/* Deadline of a wait of some ticks, NULL for portMAX_DELAY */
+static const struct timespec *deadline_of(TickType_t ticks, struct timespec *deadline)
+{
+    if (portMAX_DELAY == ticks)
+    {
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / 1000U;
+    deadline->tv_nsec += (long)(ticks % 1000U) * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+
+    return deadline;
+}
+
+void HOST_RTOS_Enter(void)
+{
+    pthread_mutex_lock(&s_core);
+}
+
+void HOST_RTOS_Exit(void)
+{
+    pthread_mutex_unlock(&s_core);
+}
+
+static void *task_entry(void *arg)
+{
+    struct _host_task *task = (struct _host_task *)arg;
+
+    pthread_mutex_lock(&s_core);
+    s_currentTask = task;
+
+    while (!s_running)
+    {
+        cond_wait(&s_started, NULL);
+    }
+
+    task->code(task->params);
+
+    // A task returning is an error on the target, stop it as vTaskDelete would
+    pthread_mutex_unlock(&s_core);
+
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code,
+                       const char *name,
+                       uint32_t stackDepth,
+                       void *params,
+                       UBaseType_t priority,
+                       TaskHandle_t *created)
+{
+    struct _host_task *task = calloc(1, sizeof(struct _host_task));
+
+    if (NULL == task)
+    {
+        return pdFAIL;
+    }
+
+    task->code   = code;
+    task->params = params;
+    task->name   = name;
+    cond_init(&task->notified);
+
+    if (0 != pthread_create(&task->thread, NULL, task_entry, task))
+    {
+        free(task);
+        return pdFAIL;
+    }
+
+    pthread_detach(task->thread);
+
+    if (NULL != created)
+    {
+        *created = task;
+    }
+
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t code,
+                               const char *name,
+                               uint32_t stackDepth,
+                               void *params,
+                               UBaseType_t priority,
+                               StackType_t *stack,
+                               StaticTask_t *tcb)
+{
+    TaskHandle_t task = NULL;
+
+    xTaskCreate(code, name, stackDepth, params, priority, &task);
+
+    return task;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only a task deleting itself is supported, the thread ends with the core given back
+    if ((NULL == task) || (task == s_currentTask))
+    {
+        pthread_mutex_unlock(&s_core);
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskStartScheduler(void)
+{
+    s_running = true;
+    pthread_cond_broadcast(&s_started);
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return s_running ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_currentTask;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (TickType_t)((uint64_t)now.tv_sec * 1000U + (uint64_t)now.tv_nsec / 1000000U);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec delay = {.tv_sec = ticks / 1000U, .tv_nsec = (long)(ticks % 1000U) * 1000000L};
+
+    pthread_mutex_unlock(&s_core);
+    nanosleep(&delay, NULL);
+    pthread_mutex_lock(&s_core);
+}
+
+void vTaskYield(void)
+{
+    pthread_mutex_unlock(&s_core);
+    sched_yield();
+    pthread_mutex_lock(&s_core);
+}
+
+// The tasks are never freed, a notification given to a task that ended is lost
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notifications++;
+    pthread_cond_signal(&task->notified);
+
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks)
+{
+    struct _host_task *task = s_currentTask;
+    struct timespec deadline;
+    const struct timespec *until = deadline_of(ticks, &deadline);
+    uint32_t count               = 0;
+
+    while (0 == task->notifications)
+    {
+        if ((0 == ticks) || !cond_wait(&task->notified, until))
+        {
+            break;
+        }
+    }
+
+    count = task->notifications;
+    if (0 != count)
+    {
+        task->notifications = clearOnExit ? 0 : (count - 1);
+    }
+
+    return count;
+}
+
+SemaphoreHandle_t HOST_SemaphoreCreate(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *ctrl)
+{
+    struct _host_sem *sem = calloc(1, sizeof(struct _host_sem));
+
+    if (NULL != sem)
+    {
+        cond_init(&sem->cond);
+        sem->max   = max;
+        sem->count = initial;
+    }
+
+    return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (NULL != sem)
+    {
+        pthread_cond_destroy(&sem->cond);
+        free(sem);
+    }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec deadline;
+    const struct timespec *until = deadline_of(ticks, &deadline);
+
+    while (0 == sem->count)
+    {
+        if ((0 == ticks) || !cond_wait(&sem->cond, until))
+        {
+            if (0 == sem->count)
+            {
+                return pdFALSE;
+            }
+        }
+    }
+
+    sem->count--;
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max)
+    {
+        return pdFALSE;
+    }
+
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+
+    return pdTRUE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    struct _host_queue *queue = calloc(1, sizeof(struct _host_queue));
+
+    if (NULL == queue)
+    {
+        return NULL;
+    }
+
+    queue->storage = calloc(length, itemSize);
+    if (NULL == queue->storage)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    cond_init(&queue->notEmpty);
+    cond_init(&queue->notFull);
+    queue->length   = length;
+    queue->itemSize = itemSize;
+
+    return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *storage, StaticQueue_t *ctrl)
+{
+    return xQueueCreate(length, itemSize);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (NULL != queue)
+    {
+        pthread_cond_destroy(&queue->notEmpty);
+        pthread_cond_destroy(&queue->notFull);
+        free(queue->storage);
+        free(queue);
+    }
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    const struct timespec *until = deadline_of(ticks, &deadline);
+
+    while (queue->count == queue->length)
+    {
+        if ((0 == ticks) || !cond_wait(&queue->notFull, until))
+        {
+            if (queue->count == queue->length)
+            {
+                return pdFALSE;
+            }
+        }
+    }
+
+    memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    pthread_cond_signal(&queue->notEmpty);
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    const struct timespec *until = deadline_of(ticks, &deadline);
+
+    while (0 == queue->count)
+    {
+        if ((0 == ticks) || !cond_wait(&queue->notEmpty, until))
+        {
+            if (0 == queue->count)
+            {
+                return pdFALSE;
+            }
+        }
+    }
+
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->notFull);
+
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _FSL_COMMON_HOST_H_
+#define _FSL_COMMON_HOST_H_
+
+/*!
+ * Common definitions of the SDK for a Linux host
+ *
+ * The status codes and helpers of fsl_common.h, and the parts of the Cortex-M7 core used by the modules
+ * built on the host: the cycle counter of the DWT follows the time of the host at SystemCoreClock, the
+ * inline assembly is compiled out and the barriers are compiler ones.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+
+enum _status_groups
+{
+    kStatusGroup_Generic               = 0,
+    kStatusGroup_DCP                   = 67,
+    kStatusGroup_ApplicationRangeStart = 101,
+};
+
+enum _generic_status
+{
+    kStatus_Success              = MAKE_STATUS(kStatusGroup_Generic, 0),
+    kStatus_Fail                 = MAKE_STATUS(kStatusGroup_Generic, 1),
+    kStatus_ReadOnly             = MAKE_STATUS(kStatusGroup_Generic, 2),
+    kStatus_OutOfRange           = MAKE_STATUS(kStatusGroup_Generic, 3),
+    kStatus_InvalidArgument      = MAKE_STATUS(kStatusGroup_Generic, 4),
+    kStatus_Timeout              = MAKE_STATUS(kStatusGroup_Generic, 5),
+    kStatus_NoTransferInProgress = MAKE_STATUS(kStatusGroup_Generic, 6),
+};
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+#endif
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define SDK_ALIGN(var, alignbytes) var __attribute__((aligned(alignbytes)))
+
+/* Inline assembly of the target compiled out, the code around it still checked by the compiler */
+#define __ASM    if (0) __asm__
+#define __DMB()  __sync_synchronize()
+#define __DSB()  __sync_synchronize()
+#define __ISB()  __sync_synchronize()
+#define __NOP()  ((void)0)
+
+/* Core cycle counter, refreshed from the time of the host at each access */
+typedef struct _host_dwt
+{
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct _host_core_debug
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+/* System control block, VTOR set by the tests to the vector table of the bank running */
+typedef struct _host_scb
+{
+    uint32_t VTOR;
+} SCB_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+#define DWT       (HOST_DWT())
+#define CoreDebug (HOST_CoreDebug())
+#define SCB       (HOST_SCB())
+
+extern uint32_t SystemCoreClock;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+DWT_Type *HOST_DWT(void);
+CoreDebug_Type *HOST_CoreDebug(void);
+SCB_Type *HOST_SCB(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FSL_COMMON_HOST_H_ */
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <time.h>
+
+#include "fsl_common.h"
+
+uint32_t SystemCoreClock = 600000000U;
+
+static DWT_Type s_dwt;
+static CoreDebug_Type s_coreDebug;
+static SCB_Type s_scb;
+
+DWT_Type *HOST_DWT(void)
+{
+    struct timespec now;
+    uint64_t ns = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+
+    // Wraps as the 32 bits counter of the core
+    s_dwt.CYCCNT = (uint32_t)((ns * (SystemCoreClock / 1000000U)) / 1000U);
+
+    return &s_dwt;
+}
+
+CoreDebug_Type *HOST_CoreDebug(void)
+{
+    return &s_coreDebug;
+}
+
+SCB_Type *HOST_SCB(void)
+{
+    return &s_scb;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _FSL_DCP_HOST_H_
+#define _FSL_DCP_HOST_H_
+
+/*!
+ * DCP driver for a Linux host
+ *
+ * The API of fsl_dcp.h computed in software, blocking and non blocking calls alike. The key slots keep
+ * their key as the DCP does and the OTP keys are a fixed key. HOST_DCP_SetFailing makes every call fail,
+ * as a DCP in error, to exercise the CPU fallbacks of the callers.
+ */
+
+#include "fsl_common.h"
+
+typedef struct _host_dcp DCP_Type;
+
+#define DCP ((DCP_Type *)0)
+
+#define DCP_AES_BLOCK_SIZE  16
+#define DCP_SHA_BLOCK_SIZE  128U
+#define DCP_HASH_BLOCK_SIZE DCP_SHA_BLOCK_SIZE
+#define DCP_HASH_CTX_SIZE   64
+
+enum _dcp_status
+{
+    kStatus_DCP_Again = MAKE_STATUS(kStatusGroup_DCP, 0),
+};
+
+typedef enum _dcp_channel
+{
+    kDCP_Channel0 = (1u << 16),
+    kDCP_Channel1 = (1u << 17),
+    kDCP_Channel2 = (1u << 18),
+    kDCP_Channel3 = (1u << 19),
+} dcp_channel_t;
+
+typedef enum _dcp_key_slot
+{
+    kDCP_KeySlot0     = 0U,
+    kDCP_KeySlot1     = 1U,
+    kDCP_KeySlot2     = 2U,
+    kDCP_KeySlot3     = 3U,
+    kDCP_OtpKey       = 4U,
+    kDCP_OtpUniqueKey = 5U,
+    kDCP_PayloadKey   = 6U,
+} dcp_key_slot_t;
+
+typedef enum _dcp_swap
+{
+    kDCP_NoSwap = 0x0U,
+} dcp_swap_t;
+
+typedef struct _dcp_work_packet
+{
+    uint32_t nextCmdAddress;
+    uint32_t control0;
+    uint32_t control1;
+    uint32_t sourceBufferAddress;
+    uint32_t destinationBufferAddress;
+    uint32_t bufferSize;
+    uint32_t payloadPointer;
+    uint32_t status;
+} dcp_work_packet_t;
+
+typedef struct _dcp_handle
+{
+    dcp_channel_t channel;
+    dcp_key_slot_t keySlot;
+    uint32_t swapConfig;
+    uint32_t keyWord[4];
+    uint32_t iv[4];
+} dcp_handle_t;
+
+typedef struct _dcp_config
+{
+    bool gatherResidualWrites;
+    bool enableContextCaching;
+    bool enableContextSwitching;
+    uint8_t enableChannel;
+    uint8_t enableChannelInterrupt;
+} dcp_config_t;
+
+typedef enum _dcp_hash_algo_t
+{
+    kDCP_Sha1,
+    kDCP_Sha256,
+    kDCP_Crc32,
+} dcp_hash_algo_t;
+
+typedef struct _dcp_hash_ctx_t
+{
+    uint32_t x[DCP_HASH_CTX_SIZE];
+} dcp_hash_ctx_t;
+
+/*! @brief Counters of the simulated DCP */
+typedef struct _host_dcp_stats
+{
+    uint32_t aesCalls;  /*!< aesCalls: AES calls done. */
+    uint32_t hashCalls; /*!< hashCalls: Hash and CRC calls done. */
+    uint32_t failed;    /*!< failed: Calls failed by HOST_DCP_SetFailing. */
+} host_dcp_stats_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Makes every following DCP call fail, or work again
+ *
+ * @param failing True to fail the calls
+ */
+void HOST_DCP_SetFailing(bool failing);
+
+/*!
+ * @brief Copies the counters of the simulated DCP
+ *
+ * @param stats Filled with the counters
+ */
+void HOST_DCP_GetStats(host_dcp_stats_t *stats);
+
+void DCP_Init(DCP_Type *base, const dcp_config_t *config);
+void DCP_Deinit(DCP_Type *base);
+void DCP_GetDefaultConfig(dcp_config_t *config);
+status_t DCP_WaitForChannelComplete(DCP_Type *base, dcp_handle_t *handle);
+status_t DCP_AES_SetKey(DCP_Type *base, dcp_handle_t *handle, const uint8_t *key, size_t keySize);
+status_t DCP_AES_EncryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *plaintext, uint8_t *ciphertext, size_t size);
+status_t DCP_AES_DecryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *ciphertext, uint8_t *plaintext, size_t size);
+status_t DCP_AES_EncryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *plaintext,
+                            uint8_t *ciphertext,
+                            size_t size,
+                            const uint8_t iv[16]);
+status_t DCP_AES_DecryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *ciphertext,
+                            uint8_t *plaintext,
+                            size_t size,
+                            const uint8_t iv[16]);
+status_t DCP_AES_EncryptCbcNonBlocking(DCP_Type *base,
+                                       dcp_handle_t *handle,
+                                       dcp_work_packet_t *dcpPacket,
+                                       const uint8_t *plaintext,
+                                       uint8_t *ciphertext,
+                                       size_t size,
+                                       const uint8_t *iv);
+status_t DCP_AES_DecryptCbcNonBlocking(DCP_Type *base,
+                                       dcp_handle_t *handle,
+                                       dcp_work_packet_t *dcpPacket,
+                                       const uint8_t *ciphertext,
+                                       uint8_t *plaintext,
+                                       size_t size,
+                                       const uint8_t *iv);
+status_t DCP_HASH_Init(DCP_Type *base, dcp_handle_t *handle, dcp_hash_ctx_t *ctx, dcp_hash_algo_t algo);
+status_t DCP_HASH_Update(DCP_Type *base, dcp_hash_ctx_t *ctx, const uint8_t *input, size_t inputSize);
+status_t DCP_HASH_Finish(DCP_Type *base, dcp_hash_ctx_t *ctx, uint8_t *output, size_t *outputSize);
+status_t DCP_HASH(DCP_Type *base,
+                  dcp_handle_t *handle,
+                  dcp_hash_algo_t algo,
+                  const uint8_t *input,
+                  size_t inputSize,
+                  uint8_t *output,
+                  size_t *outputSize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FSL_DCP_HOST_H_ */
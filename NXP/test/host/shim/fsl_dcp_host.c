@@ -0,0 +1,392 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include "fsl_dcp.h"
+
+#include "mbedtls/aes.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+
+/* CRC-32/MPEG-2, as computed by the DCP */
+#define CRC32_POLYNOMIAL (0x04C11DB7UL)
+#define CRC32_INIT       (0xFFFFFFFFUL)
+
+#define DCP_KEY_SIZE   (16U)
+#define DCP_SLOT_COUNT (4U)
+
+/* State of a hash kept in dcp_hash_ctx_t */
+typedef struct _host_hash_ctx
+{
+    dcp_hash_algo_t algo;
+    uint32_t crc;
+    union
+    {
+        mbedtls_sha1_context sha1;
+        mbedtls_sha256_context sha256;
+    };
+} host_hash_ctx_t;
+
+_Static_assert(sizeof(host_hash_ctx_t) <= sizeof(dcp_hash_ctx_t), "hash state larger than dcp_hash_ctx_t");
+
+static uint8_t s_slotKey[DCP_SLOT_COUNT][DCP_KEY_SIZE];
+
+/* Stands for the keys fused in the OTP */
+static const uint8_t s_otpKey[DCP_KEY_SIZE] = {0x4E, 0x58, 0x50, 0x2D, 0x53, 0x4C, 0x4E, 0x2D,
+                                               0x48, 0x4F, 0x53, 0x54, 0x2D, 0x4F, 0x54, 0x50};
+
+static bool s_failing              = false;
+static host_dcp_stats_t s_dcpStats = {0};
+
+static bool dcp_failing(void)
+{
+    if (s_failing)
+    {
+        s_dcpStats.failed++;
+    }
+
+    return s_failing;
+}
+
+static const uint8_t *dcp_key(const dcp_handle_t *handle)
+{
+    if (handle->keySlot < DCP_SLOT_COUNT)
+    {
+        return s_slotKey[handle->keySlot];
+    }
+
+    if (kDCP_PayloadKey == handle->keySlot)
+    {
+        return (const uint8_t *)handle->keyWord;
+    }
+
+    return s_otpKey;
+}
+
+static status_t dcp_aes(const dcp_handle_t *handle,
+                        int mode,
+                        bool cbc,
+                        const uint8_t *in,
+                        uint8_t *out,
+                        size_t size,
+                        const uint8_t *iv)
+{
+    mbedtls_aes_context aes;
+    uint8_t chain[DCP_AES_BLOCK_SIZE];
+    int ret = 0;
+
+    s_dcpStats.aesCalls++;
+
+    if (dcp_failing())
+    {
+        return kStatus_Fail;
+    }
+
+    if ((NULL == handle) || (NULL == in) || (NULL == out) || (size % DCP_AES_BLOCK_SIZE))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    mbedtls_aes_init(&aes);
+
+    if (MBEDTLS_AES_ENCRYPT == mode)
+    {
+        ret = mbedtls_aes_setkey_enc(&aes, dcp_key(handle), DCP_KEY_SIZE * 8U);
+    }
+    else
+    {
+        ret = mbedtls_aes_setkey_dec(&aes, dcp_key(handle), DCP_KEY_SIZE * 8U);
+    }
+
+    if ((0 == ret) && cbc)
+    {
+        memcpy(chain, iv, sizeof(chain));
+        ret = mbedtls_aes_crypt_cbc(&aes, mode, size, chain, in, out);
+    }
+
+    for (size_t offset = 0; (0 == ret) && !cbc && (offset < size); offset += DCP_AES_BLOCK_SIZE)
+    {
+        ret = mbedtls_aes_crypt_ecb(&aes, mode, &in[offset], &out[offset]);
+    }
+
+    mbedtls_aes_free(&aes);
+
+    return (0 == ret) ? kStatus_Success : kStatus_Fail;
+}
+
+static uint32_t dcp_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint32_t)(*data++) << 24;
+
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000UL) ? ((crc << 1) ^ CRC32_POLYNOMIAL) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+void HOST_DCP_SetFailing(bool failing)
+{
+    s_failing = failing;
+}
+
+void HOST_DCP_GetStats(host_dcp_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        *stats = s_dcpStats;
+    }
+}
+
+void DCP_Init(DCP_Type *base, const dcp_config_t *config)
+{
+}
+
+void DCP_Deinit(DCP_Type *base)
+{
+}
+
+void DCP_GetDefaultConfig(dcp_config_t *config)
+{
+    memset(config, 0, sizeof(dcp_config_t));
+}
+
+status_t DCP_WaitForChannelComplete(DCP_Type *base, dcp_handle_t *handle)
+{
+    // The non blocking calls are done when they return
+    return kStatus_Success;
+}
+
+status_t DCP_AES_SetKey(DCP_Type *base, dcp_handle_t *handle, const uint8_t *key, size_t keySize)
+{
+    if (dcp_failing())
+    {
+        return kStatus_Fail;
+    }
+
+    if ((NULL == handle) || (NULL == key) || (DCP_KEY_SIZE != keySize))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    if (handle->keySlot < DCP_SLOT_COUNT)
+    {
+        memcpy(s_slotKey[handle->keySlot], key, DCP_KEY_SIZE);
+    }
+    else if (kDCP_PayloadKey == handle->keySlot)
+    {
+        memcpy(handle->keyWord, key, DCP_KEY_SIZE);
+    }
+
+    return kStatus_Success;
+}
+
+status_t DCP_AES_EncryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *plaintext, uint8_t *ciphertext, size_t size)
+{
+    return dcp_aes(handle, MBEDTLS_AES_ENCRYPT, false, plaintext, ciphertext, size, NULL);
+}
+
+status_t DCP_AES_DecryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *ciphertext, uint8_t *plaintext, size_t size)
+{
+    return dcp_aes(handle, MBEDTLS_AES_DECRYPT, false, ciphertext, plaintext, size, NULL);
+}
+
+status_t DCP_AES_EncryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *plaintext,
+                            uint8_t *ciphertext,
+                            size_t size,
+                            const uint8_t iv[16])
+{
+    return dcp_aes(handle, MBEDTLS_AES_ENCRYPT, true, plaintext, ciphertext, size, iv);
+}
+
+status_t DCP_AES_DecryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *ciphertext,
+                            uint8_t *plaintext,
+                            size_t size,
+                            const uint8_t iv[16])
+{
+    return dcp_aes(handle, MBEDTLS_AES_DECRYPT, true, ciphertext, plaintext, size, iv);
+}
+
+status_t DCP_AES_EncryptCbcNonBlocking(DCP_Type *base,
+                                       dcp_handle_t *handle,
+                                       dcp_work_packet_t *dcpPacket,
+                                       const uint8_t *plaintext,
+                                       uint8_t *ciphertext,
+                                       size_t size,
+                                       const uint8_t *iv)
+{
+    return dcp_aes(handle, MBEDTLS_AES_ENCRYPT, true, plaintext, ciphertext, size, iv);
+}
+
+status_t DCP_AES_DecryptCbcNonBlocking(DCP_Type *base,
+                                       dcp_handle_t *handle,
+                                       dcp_work_packet_t *dcpPacket,
+                                       const uint8_t *ciphertext,
+                                       uint8_t *plaintext,
+                                       size_t size,
+                                       const uint8_t *iv)
+{
+    return dcp_aes(handle, MBEDTLS_AES_DECRYPT, true, ciphertext, plaintext, size, iv);
+}
+
+status_t DCP_HASH_Init(DCP_Type *base, dcp_handle_t *handle, dcp_hash_ctx_t *ctx, dcp_hash_algo_t algo)
+{
+    host_hash_ctx_t *hash = (host_hash_ctx_t *)ctx;
+
+    s_dcpStats.hashCalls++;
+
+    if (dcp_failing())
+    {
+        return kStatus_Fail;
+    }
+
+    if ((NULL == handle) || (NULL == ctx))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    memset(ctx, 0, sizeof(dcp_hash_ctx_t));
+    hash->algo = algo;
+
+    switch (algo)
+    {
+        case kDCP_Sha1:
+            mbedtls_sha1_init(&hash->sha1);
+            mbedtls_sha1_starts_ret(&hash->sha1);
+            break;
+
+        case kDCP_Sha256:
+            mbedtls_sha256_init(&hash->sha256);
+            mbedtls_sha256_starts_ret(&hash->sha256, 0);
+            break;
+
+        case kDCP_Crc32:
+            hash->crc = CRC32_INIT;
+            break;
+
+        default:
+            return kStatus_InvalidArgument;
+    }
+
+    return kStatus_Success;
+}
+
+status_t DCP_HASH_Update(DCP_Type *base, dcp_hash_ctx_t *ctx, const uint8_t *input, size_t inputSize)
+{
+    host_hash_ctx_t *hash = (host_hash_ctx_t *)ctx;
+
+    s_dcpStats.hashCalls++;
+
+    if (dcp_failing())
+    {
+        return kStatus_Fail;
+    }
+
+    if ((NULL == ctx) || ((NULL == input) && (0 != inputSize)))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    switch (hash->algo)
+    {
+        case kDCP_Sha1:
+            mbedtls_sha1_update_ret(&hash->sha1, input, inputSize);
+            break;
+
+        case kDCP_Sha256:
+            mbedtls_sha256_update_ret(&hash->sha256, input, inputSize);
+            break;
+
+        default:
+            hash->crc = dcp_crc32(hash->crc, input, inputSize);
+            break;
+    }
+
+    return kStatus_Success;
+}
+
+status_t DCP_HASH_Finish(DCP_Type *base, dcp_hash_ctx_t *ctx, uint8_t *output, size_t *outputSize)
+{
+    host_hash_ctx_t *hash = (host_hash_ctx_t *)ctx;
+    size_t size           = 0;
+
+    s_dcpStats.hashCalls++;
+
+    if (dcp_failing())
+    {
+        return kStatus_Fail;
+    }
+
+    if ((NULL == ctx) || (NULL == output))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    size = (kDCP_Sha1 == hash->algo) ? 20U : ((kDCP_Sha256 == hash->algo) ? 32U : sizeof(uint32_t));
+
+    if ((NULL != outputSize) && (*outputSize < size))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    switch (hash->algo)
+    {
+        case kDCP_Sha1:
+            mbedtls_sha1_finish_ret(&hash->sha1, output);
+            break;
+
+        case kDCP_Sha256:
+            mbedtls_sha256_finish_ret(&hash->sha256, output);
+            break;
+
+        default:
+            memcpy(output, &hash->crc, sizeof(uint32_t));
+            break;
+    }
+
+    if (NULL != outputSize)
+    {
+        *outputSize = size;
+    }
+
+    return kStatus_Success;
+}
+
+status_t DCP_HASH(DCP_Type *base,
+                  dcp_handle_t *handle,
+                  dcp_hash_algo_t algo,
+                  const uint8_t *input,
+                  size_t inputSize,
+                  uint8_t *output,
+                  size_t *outputSize)
+{
+    dcp_hash_ctx_t ctx;
+    status_t status = DCP_HASH_Init(base, handle, &ctx, algo);
+
+    if (kStatus_Success == status)
+    {
+        status = DCP_HASH_Update(base, &ctx, input, inputSize);
+    }
+
+    if (kStatus_Success == status)
+    {
+        status = DCP_HASH_Finish(base, &ctx, output, outputSize);
+    }
+
+    return status;
+}
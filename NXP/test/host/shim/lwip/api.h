@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _LWIP_API_HOST_H_
+#define _LWIP_API_HOST_H_
+
+/*
+ * UDP netconns of lwIP for the host tests, in the non-blocking mode only: the datagrams received are
+ * given by the test with HOST_NETCONN_Receive, the ones sent are read back with HOST_NETCONN_WaitSent.
+ */
+
+#include "FreeRTOS.h"
+
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+
+#define ERR_OK         (0)
+#define ERR_MEM        (-1)
+#define ERR_WOULDBLOCK (-7)
+#define ERR_CONN       (-11)
+
+#define LWIP_IGMP (0)
+
+typedef struct _ip_addr
+{
+    u32_t addr;
+} ip_addr_t;
+
+#define IPADDR4_INIT(u32val) \
+    {                        \
+        (u32val)             \
+    }
+#define IP_ADDR_ANY ((const ip_addr_t *)NULL)
+
+enum netconn_type
+{
+    NETCONN_UDP = 0x20,
+};
+
+enum netconn_evt
+{
+    NETCONN_EVT_RCVPLUS,
+    NETCONN_EVT_RCVMINUS,
+    NETCONN_EVT_SENDPLUS,
+    NETCONN_EVT_SENDMINUS,
+    NETCONN_EVT_ERROR,
+};
+
+struct netconn;
+
+typedef void (*netconn_callback)(struct netconn *conn, enum netconn_evt event, u16_t len);
+
+/* Data of a datagram, owned when received, referenced when sent */
+struct netbuf
+{
+    void *data;
+    u16_t len;
+};
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct netconn *netconn_new_with_callback(enum netconn_type type, netconn_callback callback);
+err_t netconn_bind(struct netconn *conn, const ip_addr_t *addr, u16_t port);
+void netconn_set_nonblocking(struct netconn *conn, int val);
+err_t netconn_recv(struct netconn *conn, struct netbuf **buf);
+err_t netconn_sendto(struct netconn *conn, struct netbuf *buf, const ip_addr_t *addr, u16_t port);
+err_t netconn_delete(struct netconn *conn);
+
+u16_t netbuf_copy(struct netbuf *buf, void *data, u16_t len);
+err_t netbuf_ref(struct netbuf *buf, const void *data, u16_t len);
+void netbuf_free(struct netbuf *buf);
+void netbuf_delete(struct netbuf *buf);
+
+/*!
+ * @brief Queue a datagram on the netconn bound to a port, and report it to its callback
+ *
+ * @return ERR_OK, ERR_CONN if no netconn is bound to the port
+ */
+err_t HOST_NETCONN_Receive(u16_t port, const void *data, u16_t len);
+
+/*!
+ * @brief Wait for the next datagram sent by a netconn
+ *
+ * @return Length of the datagram, copied up to size bytes, 0 if none was sent in time
+ */
+u16_t HOST_NETCONN_WaitSent(void *data, u16_t size, TickType_t ticks);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _LWIP_API_HOST_H_ */
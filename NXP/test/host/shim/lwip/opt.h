@@ -0,0 +1,16 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _LWIP_OPT_HOST_H_
+#define _LWIP_OPT_HOST_H_
+
+/* The netconns of the host tests only, see lwip/api.h */
+#include "lwip/api.h"
+
+#endif /* _LWIP_OPT_HOST_H_ */
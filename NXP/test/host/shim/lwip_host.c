@@ -0,0 +1,269 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "fsl_common.h"
+#include "lwip/api.h"
+#include "semphr.h"
+
+/* Datagram waiting in a receive or sent list */
+typedef struct _host_datagram
+{
+    struct _host_datagram *next;
+    u16_t len;
+    uint8_t data[];
+} host_datagram_t;
+
+typedef struct _host_datagram_list
+{
+    host_datagram_t *head;
+    host_datagram_t *tail;
+} host_datagram_list_t;
+
+struct netconn
+{
+    netconn_callback callback;
+    u16_t port;
+    host_datagram_list_t received;
+};
+
+/* Netconns bound, one per port */
+#define HOST_NETCONN_MAX_BOUND (4)
+
+static struct netconn *s_bound[HOST_NETCONN_MAX_BOUND];
+static host_datagram_list_t s_sent;
+static SemaphoreHandle_t s_sentCount = NULL;
+
+static bool list_push(host_datagram_list_t *list, const void *data, u16_t len)
+{
+    host_datagram_t *datagram = malloc(sizeof(host_datagram_t) + len);
+
+    if (NULL == datagram)
+    {
+        return false;
+    }
+
+    datagram->next = NULL;
+    datagram->len  = len;
+    memcpy(datagram->data, data, len);
+
+    if (NULL == list->tail)
+    {
+        list->head = datagram;
+    }
+    else
+    {
+        list->tail->next = datagram;
+    }
+    list->tail = datagram;
+
+    return true;
+}
+
+static host_datagram_t *list_pop(host_datagram_list_t *list)
+{
+    host_datagram_t *datagram = list->head;
+
+    if (NULL != datagram)
+    {
+        list->head = datagram->next;
+        if (NULL == list->head)
+        {
+            list->tail = NULL;
+        }
+    }
+
+    return datagram;
+}
+
+struct netconn *netconn_new_with_callback(enum netconn_type type, netconn_callback callback)
+{
+    struct netconn *conn = calloc(1, sizeof(struct netconn));
+
+    if (NULL != conn)
+    {
+        conn->callback = callback;
+    }
+
+    return conn;
+}
+
+err_t netconn_bind(struct netconn *conn, const ip_addr_t *addr, u16_t port)
+{
+    for (uint32_t idx = 0; idx < HOST_NETCONN_MAX_BOUND; idx++)
+    {
+        if ((NULL != s_bound[idx]) && (port == s_bound[idx]->port))
+        {
+            return ERR_CONN;
+        }
+    }
+
+    for (uint32_t idx = 0; idx < HOST_NETCONN_MAX_BOUND; idx++)
+    {
+        if (NULL == s_bound[idx])
+        {
+            conn->port   = port;
+            s_bound[idx] = conn;
+            return ERR_OK;
+        }
+    }
+
+    return ERR_MEM;
+}
+
+void netconn_set_nonblocking(struct netconn *conn, int val)
+{
+    // Only the non-blocking mode is simulated
+    configASSERT(0 != val);
+}
+
+err_t netconn_recv(struct netconn *conn, struct netbuf **buf)
+{
+    host_datagram_t *datagram = list_pop(&conn->received);
+    struct netbuf *received   = NULL;
+
+    if (NULL == datagram)
+    {
+        return ERR_WOULDBLOCK;
+    }
+
+    received = malloc(sizeof(struct netbuf));
+    if (NULL == received)
+    {
+        free(datagram);
+        return ERR_MEM;
+    }
+
+    // The netbuf owns the datagram, freed by netbuf_delete
+    received->data = datagram;
+    received->len  = datagram->len;
+    *buf           = received;
+
+    return ERR_OK;
+}
+
+err_t netconn_sendto(struct netconn *conn, struct netbuf *buf, const ip_addr_t *addr, u16_t port)
+{
+    if (NULL == s_sentCount)
+    {
+        s_sentCount = xSemaphoreCreateCounting(0xFFFFU, 0);
+    }
+
+    if (!list_push(&s_sent, buf->data, buf->len))
+    {
+        return ERR_MEM;
+    }
+
+    xSemaphoreGive(s_sentCount);
+
+    return ERR_OK;
+}
+
+err_t netconn_delete(struct netconn *conn)
+{
+    host_datagram_t *datagram = NULL;
+
+    for (uint32_t idx = 0; idx < HOST_NETCONN_MAX_BOUND; idx++)
+    {
+        if (conn == s_bound[idx])
+        {
+            s_bound[idx] = NULL;
+        }
+    }
+
+    while (NULL != (datagram = list_pop(&conn->received)))
+    {
+        free(datagram);
+    }
+
+    free(conn);
+
+    return ERR_OK;
+}
+
+u16_t netbuf_copy(struct netbuf *buf, void *data, u16_t len)
+{
+    const host_datagram_t *datagram = (const host_datagram_t *)buf->data;
+    u16_t copied                    = MIN(len, buf->len);
+
+    memcpy(data, datagram->data, copied);
+
+    return copied;
+}
+
+err_t netbuf_ref(struct netbuf *buf, const void *data, u16_t len)
+{
+    buf->data = (void *)data;
+    buf->len  = len;
+
+    return ERR_OK;
+}
+
+void netbuf_free(struct netbuf *buf)
+{
+    buf->data = NULL;
+    buf->len  = 0;
+}
+
+void netbuf_delete(struct netbuf *buf)
+{
+    free(buf->data);
+    free(buf);
+}
+
+err_t HOST_NETCONN_Receive(u16_t port, const void *data, u16_t len)
+{
+    for (uint32_t idx = 0; idx < HOST_NETCONN_MAX_BOUND; idx++)
+    {
+        struct netconn *conn = s_bound[idx];
+
+        if ((NULL != conn) && (port == conn->port))
+        {
+            if (!list_push(&conn->received, data, len))
+            {
+                return ERR_MEM;
+            }
+
+            // Reported as by the tcpip thread
+            if (NULL != conn->callback)
+            {
+                conn->callback(conn, NETCONN_EVT_RCVPLUS, len);
+            }
+
+            return ERR_OK;
+        }
+    }
+
+    return ERR_CONN;
+}
+
+u16_t HOST_NETCONN_WaitSent(void *data, u16_t size, TickType_t ticks)
+{
+    host_datagram_t *datagram = NULL;
+    u16_t len                 = 0;
+
+    if (NULL == s_sentCount)
+    {
+        s_sentCount = xSemaphoreCreateCounting(0xFFFFU, 0);
+    }
+
+    if (pdTRUE != xSemaphoreTake(s_sentCount, ticks))
+    {
+        return 0;
+    }
+
+    datagram = list_pop(&s_sent);
+    len      = datagram->len;
+    memcpy(data, datagram->data, MIN(size, len));
+    free(datagram);
+
+    return len;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _MBEDTLS_HOST_CONFIG_H_
+#define _MBEDTLS_HOST_CONFIG_H_
+
+/* Software AES and SHA-256 of mbedTLS, behind the simulated DCP of fsl_dcp_host.c */
+#define MBEDTLS_AES_C
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+
+#include "mbedtls/check_config.h"
+
+#endif /* _MBEDTLS_HOST_CONFIG_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _QUEUE_HOST_H_
+#define _QUEUE_HOST_H_
+
+#include "FreeRTOS.h"
+
+typedef struct _host_queue *QueueHandle_t;
+
+#define xQueueSend(q, item, ticks)       xQueueSendToBack(q, item, ticks)
+#define xQueueSendFromISR(q, item, woke) xQueueSendToBack(q, item, 0)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *storage, StaticQueue_t *ctrl);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _QUEUE_HOST_H_ */
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SEMPHR_HOST_H_
+#define _SEMPHR_HOST_H_
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/* A mutex is a semaphore of one count, given at creation; no owner check and no priority inheritance */
+typedef struct _host_sem *SemaphoreHandle_t;
+
+#define xSemaphoreCreateMutex()                  HOST_SemaphoreCreate(1, 1, NULL)
+#define xSemaphoreCreateMutexStatic(ctrl)        HOST_SemaphoreCreate(1, 1, ctrl)
+#define xSemaphoreCreateBinary()                 HOST_SemaphoreCreate(1, 0, NULL)
+#define xSemaphoreCreateBinaryStatic(ctrl)       HOST_SemaphoreCreate(1, 0, ctrl)
+#define xSemaphoreCreateCounting(max, init)      HOST_SemaphoreCreate(max, init, NULL)
+#define xSemaphoreCreateCountingStatic(m, i, c)  HOST_SemaphoreCreate(m, i, c)
+#define xSemaphoreGiveFromISR(sem, woke)         xSemaphoreGive(sem)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+SemaphoreHandle_t HOST_SemaphoreCreate(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *ctrl);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _SEMPHR_HOST_H_ */
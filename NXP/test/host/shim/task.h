@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _TASK_HOST_H_
+#define _TASK_HOST_H_
+
+#include "FreeRTOS.h"
+
+typedef struct _host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define taskSCHEDULER_SUSPENDED   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING     ((BaseType_t)2)
+
+#define tskIDLE_PRIORITY ((UBaseType_t)0U)
+
+#define taskYIELD() vTaskYield()
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+BaseType_t xTaskCreate(TaskFunction_t code,
+                       const char *name,
+                       uint32_t stackDepth,
+                       void *params,
+                       UBaseType_t priority,
+                       TaskHandle_t *created);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t code,
+                               const char *name,
+                               uint32_t stackDepth,
+                               void *params,
+                               UBaseType_t priority,
+                               StackType_t *stack,
+                               StaticTask_t *tcb);
+void vTaskDelete(TaskHandle_t task);
+void vTaskStartScheduler(void);
+BaseType_t xTaskGetSchedulerState(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskYield(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _TASK_HOST_H_ */
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "wwd_host.h"
+#include "RTOS/wwd_rtos_interface.h"
+
+/* Packet buffer of WWD, the pbuf of lwIP on the target */
+struct pbuf
+{
+    uint8_t *payload;
+    uint16_t len;
+    uint16_t capacity;
+    wwd_buffer_dir_t direction;
+    uint8_t storage[];
+};
+
+static uint32_t s_bufferLimit[2] = {UINT32_MAX, UINT32_MAX};
+static uint32_t s_bufferCount[2];
+
+void HOST_WWD_SetBufferLimit(wwd_buffer_dir_t direction, uint32_t count)
+{
+    s_bufferLimit[direction] = count;
+}
+
+uint32_t HOST_WWD_GetBufferCount(wwd_buffer_dir_t direction)
+{
+    return s_bufferCount[direction];
+}
+
+wwd_result_t host_rtos_init_semaphore(host_semaphore_type_t *semaphore)
+{
+    *semaphore = xSemaphoreCreateCounting(0x7FFFFFFFU, 0);
+
+    return (NULL != *semaphore) ? WWD_SUCCESS : WWD_SEMAPHORE_ERROR;
+}
+
+wwd_result_t host_rtos_get_semaphore(host_semaphore_type_t *semaphore,
+                                     uint32_t timeout_ms,
+                                     wiced_bool_t will_set_in_isr)
+{
+    TickType_t ticks = (NEVER_TIMEOUT == timeout_ms) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+    return (pdTRUE == xSemaphoreTake(*semaphore, ticks)) ? WWD_SUCCESS : WWD_TIMEOUT;
+}
+
+wwd_result_t host_rtos_set_semaphore(host_semaphore_type_t *semaphore, wiced_bool_t called_from_ISR)
+{
+    return (pdTRUE == xSemaphoreGive(*semaphore)) ? WWD_SUCCESS : WWD_SEMAPHORE_ERROR;
+}
+
+wwd_result_t host_rtos_deinit_semaphore(host_semaphore_type_t *semaphore)
+{
+    if (NULL != semaphore)
+    {
+        vSemaphoreDelete(*semaphore);
+        *semaphore = NULL;
+    }
+
+    return WWD_SUCCESS;
+}
+
+wwd_time_t host_rtos_get_time(void)
+{
+    return (wwd_time_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+wwd_result_t internal_host_buffer_get(wiced_buffer_t *buffer,
+                                      wwd_buffer_dir_t direction,
+                                      unsigned short size,
+                                      unsigned long timeout_ms)
+{
+    wiced_buffer_t taken = NULL;
+
+    *buffer = NULL;
+
+    // No wait for a buffer released by another task, the tests take and release them from one
+    if (s_bufferCount[direction] >= s_bufferLimit[direction])
+    {
+        return WWD_BUFFER_UNAVAILABLE_TEMPORARY;
+    }
+
+    taken = malloc(sizeof(struct pbuf) + HOST_WWD_BUFFER_HEADROOM + size);
+    if (NULL == taken)
+    {
+        return WWD_BUFFER_ALLOC_FAIL;
+    }
+
+    taken->payload   = &taken->storage[HOST_WWD_BUFFER_HEADROOM];
+    taken->len       = size;
+    taken->capacity  = size;
+    taken->direction = direction;
+
+    s_bufferCount[direction]++;
+    *buffer = taken;
+
+    return WWD_SUCCESS;
+}
+
+wwd_result_t host_buffer_get(wiced_buffer_t *buffer, wwd_buffer_dir_t direction, unsigned short size, wiced_bool_t wait)
+{
+    return internal_host_buffer_get(buffer, direction, size, (WICED_TRUE == wait) ? NEVER_TIMEOUT : 0);
+}
+
+void host_buffer_release(wiced_buffer_t buffer, wwd_buffer_dir_t direction)
+{
+    if (NULL != buffer)
+    {
+        configASSERT(0 != s_bufferCount[buffer->direction]);
+        s_bufferCount[buffer->direction]--;
+        free(buffer);
+    }
+}
+
+uint8_t *host_buffer_get_current_piece_data_pointer(wiced_buffer_t buffer)
+{
+    return buffer->payload;
+}
+
+uint16_t host_buffer_get_current_piece_size(wiced_buffer_t buffer)
+{
+    return buffer->len;
+}
+
+wwd_result_t host_buffer_set_size(wiced_buffer_t buffer, unsigned short size)
+{
+    // From the current pointer to the end of the space allocated
+    if ((buffer->payload + size) > (&buffer->storage[HOST_WWD_BUFFER_HEADROOM] + buffer->capacity))
+    {
+        return WWD_BUFFER_SIZE_SET_ERROR;
+    }
+
+    buffer->len = size;
+
+    return WWD_SUCCESS;
+}
+
+wwd_result_t host_buffer_add_remove_at_front(wiced_buffer_t *buffer, int32_t add_remove_amount)
+{
+    wiced_buffer_t moved = *buffer;
+
+    // Negative to add space for a header, positive to remove one, as pbuf_header the other way round
+    if (((moved->payload + add_remove_amount) < moved->storage) || (add_remove_amount > (int32_t)moved->len))
+    {
+        return WWD_BUFFER_POINTER_MOVE_ERROR;
+    }
+
+    moved->payload += add_remove_amount;
+    moved->len = (uint16_t)(moved->len - add_remove_amount);
+
+    return WWD_SUCCESS;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _WWD_HOST_H_
+#define _WWD_HOST_H_
+
+/*
+ * Port of WWD for the host tests: the host_rtos semaphores on the FreeRTOS shim, the packet buffers on the
+ * heap. A test limits the buffers of a direction to simulate an exhausted pool.
+ */
+
+#include "network/wwd_buffer_interface.h"
+#include "network/wwd_network_constants.h"
+
+/*! @brief Space kept in front of each buffer, for the headers of the bus, SDPCM and BDC */
+#define HOST_WWD_BUFFER_HEADROOM (sizeof(wwd_buffer_header_t) + WICED_LINK_OVERHEAD_BELOW_ETHERNET_FRAME_MAX)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Limit the buffers of a direction taken at the same time, UINT32_MAX (the default) for no limit
+ */
+void HOST_WWD_SetBufferLimit(wwd_buffer_dir_t direction, uint32_t count);
+
+/*!
+ * @brief Number of buffers of a direction taken and not released yet
+ */
+uint32_t HOST_WWD_GetBufferCount(wwd_buffer_dir_t direction);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _WWD_HOST_H_ */
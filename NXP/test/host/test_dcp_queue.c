@@ -0,0 +1,316 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * DCP queue on the simulated DCP: the CPU crypto matches mbedTLS, the jobs the DCP fails give the same
+ * results on the CPU, and the two clients share the rounds of the queue task. Prints the throughput
+ * of the queue with the DCP and with the CPU fallbacks.
+ */
+
+#include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
+
+#include "sln_cpu_crypto.h"
+#include "sln_dcp_queue.h"
+#include "test_host.h"
+
+#define TEST_DATA_LEN   (4096U)
+#define TEST_BENCH_JOBS (400U)
+
+static uint8_t s_data[TEST_DATA_LEN];
+static uint8_t s_out[TEST_DATA_LEN];
+static uint8_t s_ref[TEST_DATA_LEN];
+
+static sln_encrypt_ctx_t s_keyCtx = {
+    .key     = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C},
+    .iv      = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F},
+    .keySize = SLN_CPU_AES128_KEY_SIZE,
+    .handle  = {.keySlot = kDCP_KeySlot2},
+};
+
+static volatile uint32_t s_jobsDone   = 0;
+static volatile uint32_t s_jobsFailed = 0;
+
+static void job_done(status_t status, void *arg)
+{
+    if (kStatus_Success != status)
+    {
+        s_jobsFailed++;
+    }
+    s_jobsDone++;
+}
+
+static void ref_sha256(const uint8_t *in, size_t len, uint8_t *digest)
+{
+    mbedtls_sha256_ret(in, len, digest, 0);
+}
+
+static void ref_aes_cbc(const uint8_t *in, uint8_t *out, size_t len, int mode)
+{
+    mbedtls_aes_context aes;
+    uint8_t iv[SLN_CPU_AES_BLOCK_SIZE];
+
+    memcpy(iv, s_keyCtx.iv, sizeof(iv));
+    mbedtls_aes_init(&aes);
+    if (MBEDTLS_AES_ENCRYPT == mode)
+    {
+        mbedtls_aes_setkey_enc(&aes, s_keyCtx.key, 128);
+    }
+    else
+    {
+        mbedtls_aes_setkey_dec(&aes, s_keyCtx.key, 128);
+    }
+    mbedtls_aes_crypt_cbc(&aes, mode, len, iv, in, out);
+    mbedtls_aes_free(&aes);
+}
+
+/* SHA-256 and AES-128-CBC of the CPU against the vectors of FIPS 180-2 and 197, then against mbedTLS */
+static void test_cpu_crypto(void)
+{
+    static const uint8_t abcDigest[SLN_CPU_SHA256_DIGEST_SIZE] = {
+        0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+        0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD};
+    static const uint8_t fipsKey[SLN_CPU_AES128_KEY_SIZE] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                                             0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+    static const uint8_t fipsPlain[SLN_CPU_AES_BLOCK_SIZE]  = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                                              0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+    static const uint8_t fipsCipher[SLN_CPU_AES_BLOCK_SIZE] = {0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30,
+                                                               0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A};
+    static const size_t lengths[] = {0, 1, 55, 56, 63, 64, 65, 1000, TEST_DATA_LEN};
+    const uint8_t zeroIv[SLN_CPU_AES_BLOCK_SIZE] = {0};
+    sln_cpu_sha256_t sha;
+    uint8_t digest[SLN_CPU_SHA256_DIGEST_SIZE];
+    uint8_t refDigest[SLN_CPU_SHA256_DIGEST_SIZE];
+    uint8_t block[SLN_CPU_AES_BLOCK_SIZE];
+
+    SLN_CPU_CRYPTO_Sha256Init(&sha);
+    SLN_CPU_CRYPTO_Sha256Update(&sha, (const uint8_t *)"abc", 3);
+    SLN_CPU_CRYPTO_Sha256Finish(&sha, digest);
+    TEST_CHECK(0 == memcmp(abcDigest, digest, sizeof(digest)));
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(lengths); i++)
+    {
+        // Fed in uneven pieces, across the block boundaries
+        SLN_CPU_CRYPTO_Sha256Init(&sha);
+        for (size_t offset = 0; offset < lengths[i]; offset += 37)
+        {
+            SLN_CPU_CRYPTO_Sha256Update(&sha, &s_data[offset], MIN(37U, lengths[i] - offset));
+        }
+        SLN_CPU_CRYPTO_Sha256Finish(&sha, digest);
+
+        ref_sha256(s_data, lengths[i], refDigest);
+        TEST_CHECK(0 == memcmp(refDigest, digest, sizeof(digest)));
+    }
+
+    TEST_CHECK(kStatus_Success == SLN_CPU_CRYPTO_AesCbc(fipsKey, zeroIv, fipsPlain, block, sizeof(block), true));
+    TEST_CHECK(0 == memcmp(fipsCipher, block, sizeof(block)));
+    TEST_CHECK(kStatus_Success == SLN_CPU_CRYPTO_AesCbc(fipsKey, zeroIv, block, block, sizeof(block), false));
+    TEST_CHECK(0 == memcmp(fipsPlain, block, sizeof(block)));
+
+    ref_aes_cbc(s_data, s_ref, TEST_DATA_LEN, MBEDTLS_AES_ENCRYPT);
+    TEST_CHECK(kStatus_Success ==
+               SLN_CPU_CRYPTO_AesCbc(s_keyCtx.key, s_keyCtx.iv, s_data, s_out, TEST_DATA_LEN, true));
+    TEST_CHECK(0 == memcmp(s_ref, s_out, TEST_DATA_LEN));
+
+    // In place, as the file system decrypts
+    TEST_CHECK(kStatus_Success ==
+               SLN_CPU_CRYPTO_AesCbc(s_keyCtx.key, s_keyCtx.iv, s_out, s_out, TEST_DATA_LEN, false));
+    TEST_CHECK(0 == memcmp(s_data, s_out, TEST_DATA_LEN));
+
+    TEST_CHECK(kStatus_InvalidArgument ==
+               SLN_CPU_CRYPTO_AesCbc(s_keyCtx.key, s_keyCtx.iv, s_data, s_out, TEST_DATA_LEN - 1, true));
+}
+
+static status_t run_hash(dcp_hash_ctx_t *hashCtx, const uint8_t *in, uint32_t len, uint8_t *digest)
+{
+    sln_dcp_job_t job = {.op = kSLN_DCP_HashUpdate, .hashCtx = hashCtx, .in = in, .len = len};
+    status_t status   = SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job);
+
+    if (kStatus_Success == status)
+    {
+        job.op  = kSLN_DCP_HashFinish;
+        job.out = digest;
+        job.len = SLN_CPU_SHA256_DIGEST_SIZE;
+        status  = SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job);
+    }
+
+    return status;
+}
+
+/* CRC and AES jobs redone by the CPU while the DCP fails, except the ones with an OTP key */
+static void test_job_fallbacks(void)
+{
+    sln_dcp_queue_stats_t before = {0};
+    sln_dcp_queue_stats_t after  = {0};
+    sln_encrypt_ctx_t otpCtx     = s_keyCtx;
+    uint32_t refCrc              = 0;
+    uint32_t crc                 = 0;
+    sln_dcp_job_t job            = {.op = kSLN_DCP_Crc32, .in = s_data, .len = TEST_DATA_LEN, .crc = &refCrc};
+
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+
+    HOST_DCP_SetFailing(true);
+    SLN_DCP_QUEUE_GetStats(&before);
+
+    job.crc = &crc;
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+    TEST_CHECK(refCrc == crc);
+
+    ref_aes_cbc(s_data, s_ref, TEST_DATA_LEN, MBEDTLS_AES_ENCRYPT);
+    job = (sln_dcp_job_t){.op = kSLN_DCP_AesCbcEncrypt, .ctx = &s_keyCtx, .in = s_data, .out = s_out,
+                          .len = TEST_DATA_LEN};
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+    TEST_CHECK(0 == memcmp(s_ref, s_out, TEST_DATA_LEN));
+
+    job.op = kSLN_DCP_AesCbcDecrypt;
+    job.in = s_out;
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+    TEST_CHECK(0 == memcmp(s_data, s_out, TEST_DATA_LEN));
+
+    otpCtx.handle.keySlot = kDCP_OtpKey;
+    job.ctx               = &otpCtx;
+    TEST_CHECK(kStatus_Success != SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+
+    SLN_DCP_QUEUE_GetStats(&after);
+    TEST_CHECK(before.swFallbacks + 3 == after.swFallbacks);
+    TEST_CHECK(before.failures + 1 == after.failures);
+
+    // The key the DCP refused was not kept as loaded, the DCP gets it once back
+    HOST_DCP_SetFailing(false);
+    job = (sln_dcp_job_t){.op = kSLN_DCP_AesCbcEncrypt, .ctx = &s_keyCtx, .in = s_data, .out = s_out,
+                          .len = TEST_DATA_LEN};
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_FileSystem, &job));
+    TEST_CHECK(0 == memcmp(s_ref, s_out, TEST_DATA_LEN));
+    SLN_DCP_QUEUE_GetStats(&before);
+    TEST_CHECK(before.swFallbacks == after.swFallbacks);
+}
+
+/* A hash the DCP fails halfway fails, the hashes started afterwards run on the CPU */
+static void test_hash_fallback(void)
+{
+    dcp_hash_ctx_t hashCtx;
+    host_dcp_stats_t dcpBefore = {0};
+    host_dcp_stats_t dcpAfter  = {0};
+    uint8_t refDigest[SLN_CPU_SHA256_DIGEST_SIZE];
+    uint8_t digest[SLN_CPU_SHA256_DIGEST_SIZE];
+    sln_dcp_job_t job = {.op = kSLN_DCP_HashUpdate, .hashCtx = &hashCtx, .in = s_data, .len = TEST_DATA_LEN};
+
+    ref_sha256(s_data, TEST_DATA_LEN, refDigest);
+
+    // On the DCP
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_HashInit(kSLN_DCP_Client_Ota, &hashCtx, kDCP_Sha256));
+    TEST_CHECK(kStatus_Success == run_hash(&hashCtx, s_data, TEST_DATA_LEN, digest));
+    TEST_CHECK(0 == memcmp(refDigest, digest, sizeof(digest)));
+
+    // DCP refusing the start of the hash
+    HOST_DCP_SetFailing(true);
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_HashInit(kSLN_DCP_Client_Ota, &hashCtx, kDCP_Sha256));
+    TEST_CHECK(kStatus_Success == run_hash(&hashCtx, s_data, TEST_DATA_LEN, digest));
+    TEST_CHECK(0 == memcmp(refDigest, digest, sizeof(digest)));
+    HOST_DCP_SetFailing(false);
+
+    // DCP failing halfway
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_HashInit(kSLN_DCP_Client_Ota, &hashCtx, kDCP_Sha256));
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job));
+    HOST_DCP_SetFailing(true);
+    TEST_CHECK(kStatus_Success != SLN_DCP_QUEUE_Run(kSLN_DCP_Client_Ota, &job));
+    HOST_DCP_SetFailing(false);
+
+    // The DCP is not trusted with hashes anymore
+    HOST_DCP_GetStats(&dcpBefore);
+    TEST_CHECK(kStatus_Success == SLN_DCP_QUEUE_HashInit(kSLN_DCP_Client_Ota, &hashCtx, kDCP_Sha256));
+    TEST_CHECK(kStatus_Success == run_hash(&hashCtx, s_data, TEST_DATA_LEN, digest));
+    TEST_CHECK(0 == memcmp(refDigest, digest, sizeof(digest)));
+    HOST_DCP_GetStats(&dcpAfter);
+    TEST_CHECK(dcpBefore.hashCalls == dcpAfter.hashCalls);
+}
+
+/* Both clients keep their queues full of 4 KB jobs, CRCs for the file system and AES for the OTA */
+static void bench_queue(const char *name)
+{
+    sln_dcp_queue_stats_t before = {0};
+    sln_dcp_queue_stats_t after  = {0};
+    uint32_t crc                 = 0;
+    uint32_t submitted           = 0;
+    sln_dcp_client_t client      = kSLN_DCP_Client_FileSystem;
+    TickType_t start             = 0;
+    TickType_t elapsed           = 0;
+    sln_dcp_job_t jobs[kSLN_DCP_Client_Count] = {
+        {.op = kSLN_DCP_Crc32, .in = s_data, .len = TEST_DATA_LEN, .crc = &crc, .cb = job_done},
+        {.op  = kSLN_DCP_AesCbcEncrypt,
+         .ctx = &s_keyCtx,
+         .in  = s_data,
+         .out = s_out,
+         .len = TEST_DATA_LEN,
+         .cb  = job_done},
+    };
+
+    SLN_DCP_QUEUE_GetStats(&before);
+    s_jobsDone   = 0;
+    s_jobsFailed = 0;
+    start        = xTaskGetTickCount();
+
+    while (s_jobsDone < TEST_BENCH_JOBS)
+    {
+        // The queue task runs while this task waits
+        while (submitted < TEST_BENCH_JOBS)
+        {
+            client = (sln_dcp_client_t)(submitted % kSLN_DCP_Client_Count);
+            if (kStatus_Success != SLN_DCP_QUEUE_Submit(client, &jobs[client]))
+            {
+                break;
+            }
+            submitted++;
+        }
+        vTaskDelay(1);
+    }
+
+    elapsed = MAX(xTaskGetTickCount() - start, 1U);
+    SLN_DCP_QUEUE_GetStats(&after);
+
+    configPRINTF(("DCP queue, %s: %d jobs in %d ms, %d jobs/s, %d KB/s, %d CPU jobs\r\n", name, TEST_BENCH_JOBS,
+                  elapsed, TEST_BENCH_JOBS * 1000U / elapsed,
+                  TEST_BENCH_JOBS * (TEST_DATA_LEN / 1024U) * 1000U / elapsed, after.swFallbacks - before.swFallbacks));
+
+    TEST_CHECK(0 == s_jobsFailed);
+    for (uint32_t i = 0; i < kSLN_DCP_Client_Count; i++)
+    {
+        TEST_CHECK(after.jobs[i] - before.jobs[i] == TEST_BENCH_JOBS / kSLN_DCP_Client_Count);
+    }
+    TEST_CHECK(kSLN_DCP_Client_Count == after.maxRoundJobs);
+}
+
+int main(void)
+{
+    sln_dcp_queue_stats_t stats = {0};
+
+    for (uint32_t i = 0; i < TEST_DATA_LEN; i++)
+    {
+        s_data[i] = (uint8_t)(i * 7U + (i >> 8));
+    }
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(true));
+
+    SLN_DCP_QUEUE_GetStats(NULL);
+
+    test_cpu_crypto();
+    test_job_fallbacks();
+    test_hash_fallback();
+
+    bench_queue("DCP");
+    HOST_DCP_SetFailing(true);
+    bench_queue("CPU fallbacks");
+    HOST_DCP_SetFailing(false);
+
+    SLN_DCP_QUEUE_GetStats(&stats);
+    configPRINTF(("DCP queue: %d + %d jobs, %d failures, %d CPU jobs\r\n", stats.jobs[kSLN_DCP_Client_FileSystem],
+                  stats.jobs[kSLN_DCP_Client_Ota], stats.failures, stats.swFallbacks));
+
+    return TEST_HOST_Result("DCP queue CPU fallbacks");
+}
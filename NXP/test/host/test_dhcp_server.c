@@ -0,0 +1,323 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * DHCP server of the provisioning access point: the requests of a few clients are replayed on the
+ * simulated netconn of port 67 and the replies checked as the clients would, then the server is stopped
+ * and started again as APP_NETWORK_Wifi_StopAP and StartAP do, and must still answer. Last, the requests
+ * handled per second, the clients renewing their leases in bursts.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#include "dhcp_server.h"
+#include "lwip/api.h"
+#include "sln_metrics.h"
+#include "test_host.h"
+
+/* Offsets of the BOOTP fields, the options follow the magic cookie */
+#define TEST_BOOTP_OP      (0)
+#define TEST_BOOTP_HLEN    (2)
+#define TEST_BOOTP_XID     (4)
+#define TEST_BOOTP_CIADDR  (12)
+#define TEST_BOOTP_YIADDR  (16)
+#define TEST_BOOTP_CHADDR  (28)
+#define TEST_BOOTP_MAGIC   (236)
+#define TEST_BOOTP_OPTIONS (240)
+#define TEST_BOOTP_SIZE    (300)
+
+#define TEST_DHCPDISCOVER (1)
+#define TEST_DHCPOFFER    (2)
+#define TEST_DHCPREQUEST  (3)
+#define TEST_DHCPACK      (5)
+#define TEST_DHCPNAK      (6)
+#define TEST_DHCPRELEASE  (7)
+
+/* Leases of the pool of dhcp_server.c, from 192.168.1.100 */
+#define TEST_POOL_SIZE  (16)
+#define TEST_POOL_FIRST (100)
+
+/* Address of the access point, as APP_NETWORK_Wifi_StartAP sets it */
+#define TEST_SERVER_ADDR (0x0101A8C0U)
+
+/* Time a reply may take, and time after which none is expected */
+#define TEST_REPLY_TIMEOUT_MS    (1000)
+#define TEST_NO_REPLY_TIMEOUT_MS (100)
+
+#define TEST_RESTARTS       (20)
+#define TEST_RENEWAL_ROUNDS (2000)
+
+static const uint8_t s_serverId[4] = {192, 168, 1, 1};
+
+static uint8_t s_request[TEST_BOOTP_SIZE];
+static uint8_t s_reply[TEST_BOOTP_SIZE + 64];
+
+/* The registry of sln_metrics.c needs the lwIP statistics, the metrics are not read here */
+void SLN_METRICS_Register(sln_metric_t *metric)
+{
+}
+
+static void client_mac(uint32_t client, uint8_t *mac)
+{
+    // Same vendor part for all, as the phones of one brand
+    mac[0] = 0x3C;
+    mac[1] = 0x2E;
+    mac[2] = 0xF9;
+    mac[3] = 0x10;
+    mac[4] = (uint8_t)(client >> 8);
+    mac[5] = (uint8_t)client;
+}
+
+/* Request of a client; requested and server id omitted when 0 */
+static uint16_t build_request(uint32_t client, uint8_t type, uint32_t ciaddr, uint32_t requested, bool serverId)
+{
+    uint8_t *option = &s_request[TEST_BOOTP_OPTIONS];
+    uint32_t xid    = 0x5A000000U + client;
+
+    memset(s_request, 0, sizeof(s_request));
+    s_request[TEST_BOOTP_OP]     = 1;
+    s_request[1]                 = 1;
+    s_request[TEST_BOOTP_HLEN]   = 6;
+    memcpy(&s_request[TEST_BOOTP_XID], &xid, 4);
+    memcpy(&s_request[TEST_BOOTP_CIADDR], &ciaddr, 4);
+    client_mac(client, &s_request[TEST_BOOTP_CHADDR]);
+    memcpy(&s_request[TEST_BOOTP_MAGIC], (const uint8_t[]){0x63, 0x82, 0x53, 0x63}, 4);
+
+    *option++ = 53;
+    *option++ = 1;
+    *option++ = type;
+
+    if (0 != requested)
+    {
+        *option++ = 50;
+        *option++ = 4;
+        memcpy(option, &requested, 4);
+        option += 4;
+    }
+
+    if (serverId)
+    {
+        *option++ = 54;
+        *option++ = 4;
+        memcpy(option, s_serverId, 4);
+        option += 4;
+    }
+
+    // Parameter request list, as sent by the clients and ignored by the server
+    *option++ = 55;
+    *option++ = 3;
+    *option++ = 1;
+    *option++ = 3;
+    *option++ = 6;
+    *option++ = 255;
+
+    return (uint16_t)(option - s_request);
+}
+
+static uint32_t pool_addr(uint32_t lease)
+{
+    uint8_t addr[4] = {192, 168, 1, (uint8_t)(TEST_POOL_FIRST + lease)};
+    uint32_t ip     = 0;
+
+    memcpy(&ip, addr, 4);
+
+    return ip;
+}
+
+/* Type of the reply to the last request, 0 if none; the address given in yiaddr */
+static uint8_t wait_reply(uint32_t *yiaddr, uint32_t timeoutMs)
+{
+    uint16_t len = HOST_NETCONN_WaitSent(s_reply, sizeof(s_reply), pdMS_TO_TICKS(timeoutMs));
+
+    if (len < (TEST_BOOTP_OPTIONS + 3))
+    {
+        return 0;
+    }
+
+    TEST_CHECK(2 == s_reply[TEST_BOOTP_OP]);
+    TEST_CHECK(0 == memcmp(&s_reply[TEST_BOOTP_MAGIC], (const uint8_t[]){0x63, 0x82, 0x53, 0x63}, 4));
+    TEST_CHECK((53 == s_reply[TEST_BOOTP_OPTIONS]) && (1 == s_reply[TEST_BOOTP_OPTIONS + 1]));
+
+    if (NULL != yiaddr)
+    {
+        memcpy(yiaddr, &s_reply[TEST_BOOTP_YIADDR], 4);
+    }
+
+    return s_reply[TEST_BOOTP_OPTIONS + 2];
+}
+
+/* Give a request to the server, once its thread bound the port after a start */
+static bool send_request(uint16_t len)
+{
+    for (uint32_t waited = 0; waited < TEST_REPLY_TIMEOUT_MS; waited++)
+    {
+        if (ERR_CONN != HOST_NETCONN_Receive(67, s_request, len))
+        {
+            return true;
+        }
+
+        vTaskDelay(1);
+    }
+
+    return false;
+}
+
+static uint8_t exchange(uint32_t client, uint8_t type, uint32_t ciaddr, uint32_t requested, uint32_t *yiaddr)
+{
+    uint16_t len = build_request(client, type, ciaddr, requested, TEST_DHCPDISCOVER != type);
+
+    if (!send_request(len))
+    {
+        return 0;
+    }
+
+    return wait_reply(yiaddr, (TEST_DHCPRELEASE == type) ? TEST_NO_REPLY_TIMEOUT_MS : TEST_REPLY_TIMEOUT_MS);
+}
+
+/* DISCOVER then REQUEST of the address offered, returns the address bound, 0 if none */
+static uint32_t bind_client(uint32_t client)
+{
+    uint32_t offered = 0;
+    uint32_t acked   = 0;
+
+    if (TEST_DHCPOFFER != exchange(client, TEST_DHCPDISCOVER, 0, 0, &offered))
+    {
+        return 0;
+    }
+
+    if ((TEST_DHCPACK != exchange(client, TEST_DHCPREQUEST, 0, offered, &acked)) || (acked != offered))
+    {
+        return 0;
+    }
+
+    return acked;
+}
+
+/* A provisioning session: clients binding, a wrong request, a release and a return, a full pool */
+static void test_replay(void)
+{
+    uint32_t addrs[TEST_POOL_SIZE] = {0};
+    uint32_t addr                  = 0;
+
+    for (uint32_t client = 0; client < 4; client++)
+    {
+        addrs[client] = bind_client(client);
+        TEST_CHECK(pool_addr(client) == addrs[client]);
+    }
+
+    // Address of another client, then renewal of its own
+    TEST_CHECK(TEST_DHCPNAK == exchange(1, TEST_DHCPREQUEST, 0, addrs[2], &addr));
+    TEST_CHECK(0 == addr);
+    TEST_CHECK(TEST_DHCPACK == exchange(1, TEST_DHCPREQUEST, addrs[1], 0, &addr));
+    TEST_CHECK(addrs[1] == addr);
+
+    // Released, the address stays attached to the client coming back
+    TEST_CHECK(0 == exchange(2, TEST_DHCPRELEASE, addrs[2], 0, NULL));
+    TEST_CHECK(addrs[2] == bind_client(2));
+
+    for (uint32_t client = 4; client < TEST_POOL_SIZE; client++)
+    {
+        addrs[client] = bind_client(client);
+        TEST_CHECK(pool_addr(client) == addrs[client]);
+    }
+
+    // All the leases are bound, a new client gets no offer
+    TEST_CHECK(0 == exchange(TEST_POOL_SIZE, TEST_DHCPDISCOVER, 0, 0, NULL));
+
+    // A client bound is offered its address again
+    TEST_CHECK(TEST_DHCPOFFER == exchange(7, TEST_DHCPDISCOVER, 0, 0, &addr));
+    TEST_CHECK(addrs[7] == addr);
+}
+
+/* Access point stopped and started again right away: the new server must answer */
+static void test_restart(void)
+{
+    uint32_t answered = 0;
+
+    for (uint32_t restart = 0; restart < TEST_RESTARTS; restart++)
+    {
+        quit_dhcp_server();
+        start_dhcp_server(TEST_SERVER_ADDR);
+
+        // Leases of the previous server are dropped, the first client gets the first address
+        answered += (pool_addr(0) == bind_client(restart)) ? 1 : 0;
+    }
+
+    if (TEST_RESTARTS != answered)
+    {
+        printf("[FAIL] %d of %d restarted servers answered\r\n", answered, TEST_RESTARTS);
+        g_testFailures++;
+    }
+}
+
+/* The clients renew their leases in bursts, the server answers a burst from one wake up */
+static void test_throughput(void)
+{
+    struct timespec start;
+    struct timespec end;
+    uint32_t requests = 0;
+    uint32_t acks     = 0;
+    double seconds    = 0;
+
+    // The whole pool for the clients of the test
+    quit_dhcp_server();
+    start_dhcp_server(TEST_SERVER_ADDR);
+
+    for (uint32_t client = 0; client < TEST_POOL_SIZE; client++)
+    {
+        TEST_CHECK(pool_addr(client) == bind_client(100 + client));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t round = 0; round < TEST_RENEWAL_ROUNDS; round++)
+    {
+        for (uint32_t client = 0; client < TEST_POOL_SIZE; client++)
+        {
+            uint16_t len = build_request(100 + client, TEST_DHCPREQUEST, pool_addr(client), 0, false);
+
+            requests += send_request(len) ? 1 : 0;
+        }
+
+        for (uint32_t client = 0; client < TEST_POOL_SIZE; client++)
+        {
+            acks += (TEST_DHCPACK == wait_reply(NULL, TEST_REPLY_TIMEOUT_MS)) ? 1 : 0;
+        }
+
+        // A server not answering would only time out for every round
+        if (acks != requests)
+        {
+            break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    TEST_CHECK((TEST_RENEWAL_ROUNDS * TEST_POOL_SIZE == requests) && (requests == acks));
+
+    configPRINTF(("%d renewals in bursts of %d: %.0f requests/s\r\n", requests, TEST_POOL_SIZE,
+                  (seconds > 0) ? (requests / seconds) : 0.0));
+}
+
+int main(void)
+{
+    vTaskStartScheduler();
+
+    start_dhcp_server(TEST_SERVER_ADDR);
+
+    test_replay();
+    test_restart();
+    test_throughput();
+
+    quit_dhcp_server();
+
+    return TEST_HOST_Result("DHCP server");
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Update of the application: an image is streamed into the bank not running, then set as the one to boot
+ * in the FICA. The power is cut at each program or erase of the update in turn, then the start finishes
+ * the switch as main.c does. The bootloader must never find a valid descriptor over a mixed table, and
+ * after the start the FICA must hold the previous or the new table.
+ */
+
+#include "fica_definition.h"
+#include "sln_app_fwupdate.h"
+#include "sln_cpu_crypto.h"
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "sln_flash_writer.h"
+#include "test_host.h"
+
+/* Two full stream buffers and a partial one */
+#define TEST_IMAGE_SIZE (2U * FWUPDATE_STREAM_CHUNK_SIZE + 100U)
+
+static uint8_t s_image[TEST_IMAGE_SIZE];
+static fica_t s_oldTable;
+static fica_t s_newTable;
+static fwupdate_stream_info_t s_info;
+
+static const fica_t *read_fica(void)
+{
+    return (const fica_t *)SLN_Flash_Get_Read_Address(FICA_START_ADDR);
+}
+
+/* Table and vector table as the bootloader leaves them, application A running */
+static void boot_bank_a(void)
+{
+    uint32_t vectors[2]   = {0x20200000U, SLN_Flash_Get_Read_Address(FICA_IMG_APP_A_ADDR) + 0x401U};
+    fica_record_t *record = &s_oldTable.records[FICA_IMG_TYPE_APP_A];
+
+    memset(&s_oldTable, 0, sizeof(s_oldTable));
+    s_oldTable.header.descriptor    = FICA_ICA_DESC;
+    s_oldTable.header.version       = FICA_VER;
+    s_oldTable.header.communication = 0xFFFFFFFFU;
+    s_oldTable.header.currType      = FICA_IMG_TYPE_APP_A;
+    s_oldTable.header.newType       = FICA_IMG_TYPE_APP_A;
+    s_oldTable.header.currBootType  = FICA_IMG_TYPE_BOOTLOADER;
+
+    record->descriptor = FICA_REC_START_ID;
+    record->imgType    = FICA_IMG_TYPE_APP_A;
+    record->imgAddr    = FICA_IMG_APP_A_ADDR;
+
+    TEST_CHECK(kStatus_Success == SLN_FLASH_WRITER_EraseSync(FICA_IMG_APP_A_ADDR));
+    TEST_CHECK(kStatus_Success ==
+               SLN_FLASH_WRITER_ProgramSync(FICA_IMG_APP_A_ADDR, (const uint8_t *)vectors, sizeof(vectors)));
+
+    SCB->VTOR = SLN_Flash_Get_Read_Address(FICA_IMG_APP_A_ADDR);
+}
+
+/* Back to the previous table, without a copy of the new one */
+static void restore_old_table(void)
+{
+    TEST_CHECK(kStatus_Success == SLN_FLASH_WRITER_EraseSync(FICA_START_ADDR));
+    TEST_CHECK(kStatus_Success ==
+               SLN_FLASH_WRITER_ProgramSync(FICA_START_ADDR, (const uint8_t *)&s_oldTable, sizeof(s_oldTable)));
+    TEST_CHECK(kStatus_Success == SLN_FLASH_WRITER_EraseSync(FWUPDATE_FICA_COPY_ADDR));
+}
+
+static fwupdate_stream_status_t stream_image(void)
+{
+    fwupdate_stream_status_t status = FWUpdate_stream_start(&s_info);
+
+    for (uint32_t offset = 0; (FWUPDATE_STREAM_OK == status) && (offset < TEST_IMAGE_SIZE); offset += 1000U)
+    {
+        status = FWUpdate_stream_write(&s_image[offset], MIN(1000U, TEST_IMAGE_SIZE - offset));
+    }
+
+    if (FWUPDATE_STREAM_OK == status)
+    {
+        status = FWUpdate_stream_finish();
+    }
+
+    FWUpdate_stream_abort();
+
+    return status;
+}
+
+/* Returns 1 if the FICA holds the previous table, 2 if the new one, 3 if no valid table, 0 for a mixed one */
+static int read_table(void)
+{
+    const fica_t *fica = read_fica();
+
+    if (0 == memcmp(fica, &s_oldTable, sizeof(s_oldTable)))
+    {
+        return 1;
+    }
+
+    if (0 == memcmp(fica, &s_newTable, sizeof(s_newTable)))
+    {
+        return 2;
+    }
+
+    return (FICA_ICA_DESC != fica->header.descriptor) ? 3 : 0;
+}
+
+static bool copy_erased(void)
+{
+    const uint8_t *copy = (const uint8_t *)SLN_Flash_Get_Read_Address(FWUPDATE_FICA_COPY_ADDR);
+
+    for (uint32_t idx = 0; idx < sizeof(fica_t); idx++)
+    {
+        if (0xFF != copy[idx])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* An update without a cut sets bank B as the one to boot */
+static void test_update(void)
+{
+    const fica_record_t *record = &read_fica()->records[FICA_IMG_TYPE_APP_B];
+
+    restore_old_table();
+
+    TEST_CHECK(FWUPDATE_STREAM_OK == stream_image());
+    TEST_CHECK(0 == memcmp((const void *)SLN_Flash_Get_Read_Address(FICA_IMG_APP_B_ADDR), s_image, TEST_IMAGE_SIZE));
+    TEST_CHECK(FICA_IMG_TYPE_APP_B == read_fica()->header.currType);
+    TEST_CHECK((FICA_IMG_APP_B_ADDR == record->imgAddr) && (TEST_IMAGE_SIZE == record->imgLen));
+    TEST_CHECK(0 == memcmp(record->imgPkiSig, s_info.signature, sizeof(record->imgPkiSig)));
+    TEST_CHECK(copy_erased());
+
+    memcpy(&s_newTable, read_fica(), sizeof(s_newTable));
+
+    // Nothing to finish at the next start
+    TEST_CHECK(0 == FWUpdate_recover_boot_image());
+    TEST_CHECK(2 == read_table());
+}
+
+/* Cut the power at each operation of the update in turn, then start again */
+static void test_power_cut(void)
+{
+    sln_flash_sim_config_t config = {.strictNor = true};
+    sln_flash_sim_stats_t stats   = {0};
+    uint32_t cuts                 = 0;
+    uint32_t finished             = 0;
+    uint32_t newTables            = 0;
+    bool cut                      = true;
+
+    SLN_FLASH_SIM_ResetStats();
+
+    for (uint32_t cutAfter = 1; cut; cutAfter++)
+    {
+        fwupdate_stream_status_t status = FWUPDATE_STREAM_OK;
+        int32_t ret                     = 0;
+        int table                       = 0;
+
+        restore_old_table();
+
+        config.powerCutAfter = cutAfter;
+        SLN_FLASH_SIM_SetConfig(&config);
+        status               = stream_image();
+        cut                  = SLN_FLASH_SIM_IsPoweredOff();
+        config.powerCutAfter = 0;
+        SLN_FLASH_SIM_SetConfig(&config);
+
+        SLN_FLASH_SIM_PowerOn();
+
+        // What the bootloader finds
+        if (0 == read_table())
+        {
+            printf("[FAIL] valid descriptor over a mixed table after a power cut at operation %d\r\n", cutAfter);
+            g_testFailures++;
+        }
+
+        // The start of the application, then the one after its reset
+        ret = FWUpdate_recover_boot_image();
+        TEST_CHECK(0 <= ret);
+        TEST_CHECK(0 == FWUpdate_recover_boot_image());
+
+        table = read_table();
+        cuts += cut ? 1 : 0;
+        finished += (1 == ret) ? 1 : 0;
+        newTables += (2 == table) ? 1 : 0;
+
+        if ((1 != table) && (2 != table))
+        {
+            printf("[FAIL] no valid table after a power cut at operation %d\r\n", cutAfter);
+            g_testFailures++;
+        }
+        else if (!cut)
+        {
+            TEST_CHECK((FWUPDATE_STREAM_OK == status) && (2 == table));
+        }
+
+        TEST_CHECK(copy_erased());
+    }
+
+    SLN_FLASH_SIM_GetStats(&stats);
+    TEST_CHECK(0 == stats.norViolations);
+    TEST_CHECK(0 != finished);
+
+    configPRINTF(("Update of %d bytes: %d power cuts, new table kept after %d, switch finished at start after %d\r\n",
+                  TEST_IMAGE_SIZE, cuts, newTables, finished));
+}
+
+int main(void)
+{
+    sln_cpu_sha256_t sha;
+
+    for (uint32_t idx = 0; idx < TEST_IMAGE_SIZE; idx++)
+    {
+        s_image[idx] = (uint8_t)(idx * 11 + 3);
+    }
+
+    SLN_CPU_CRYPTO_Sha256Init(&sha);
+    SLN_CPU_CRYPTO_Sha256Update(&sha, s_image, TEST_IMAGE_SIZE);
+    SLN_CPU_CRYPTO_Sha256Finish(&sha, s_info.sha256);
+
+    s_info.imageLen     = TEST_IMAGE_SIZE;
+    s_info.hasSignature = true;
+    memset(s_info.signature, 0x5A, sizeof(s_info.signature));
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(true));
+
+    boot_bank_a();
+
+    test_update();
+    test_power_cut();
+
+    return TEST_HOST_Result("application update");
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Runs the file system benchmarks of sln_flash_bench.c on the simulated flash: first with the flash
+ * taking no time, which leaves the software cost, then a few with the timings of the HyperFlash.
+ */
+
+#include "sln_flash_bench.h"
+#include "test_host.h"
+
+/* Page program and sector erase times of the S26KS512S HyperFlash, typical */
+#define HYPERFLASH_PROGRAM_US (475U)
+#define HYPERFLASH_ERASE_US   (930000U)
+
+/* Operations benchmarked on the encrypted file and with the HyperFlash timings */
+static const char *const s_ops[] = {"Save", "Read", "ReadDataPtr"};
+
+static void bench_ops(const char *name, uint32_t size)
+{
+    sln_flash_bench_result_t result;
+
+    configPRINTF(("Flash benchmarks on %s, %d bytes\r\n", name, size));
+
+    for (uint32_t op = 0; op < ARRAY_SIZE(s_ops); op++)
+    {
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_BENCH_RunOp(name, s_ops[op], size, &result));
+        TEST_CHECK(SLN_FLASH_BENCH_ITERATIONS == result.calls);
+
+        configPRINTF(("%-12s %8d ops/s, avg %d us, max %d us, %d erases\r\n", result.op, result.opsPerSec,
+                      result.avgUs, result.maxUs, result.erases));
+    }
+}
+
+int main(void)
+{
+    sln_flash_sim_config_t config = {.strictNor = true};
+    sln_flash_sim_stats_t stats   = {0};
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(true));
+
+    SLN_FLASH_SIM_SetConfig(&config);
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_BENCH_Run(TEST_FILE_PLAIN));
+    bench_ops(TEST_FILE_ENCRYPTED, 4096);
+
+    config.programUs = HYPERFLASH_PROGRAM_US;
+    config.eraseUs   = HYPERFLASH_ERASE_US;
+    SLN_FLASH_SIM_SetConfig(&config);
+    bench_ops(TEST_FILE_PLAIN, 4096);
+
+    // Every program stayed a valid NOR one
+    SLN_FLASH_SIM_GetStats(&stats);
+    TEST_CHECK(0 == stats.norViolations);
+
+    return TEST_HOST_Result("flash benchmarks");
+}
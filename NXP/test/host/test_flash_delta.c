@@ -0,0 +1,194 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Delta records of the logged files: a range changed with SLN_FLASH_MGMT_UpdateRange is written as a
+ * delta record of the key/value store, then folded into a full record by a read, a reboot, a compaction
+ * or a full chain. The file must read back with all its changes, whatever folded it, and a power cut
+ * during a change must leave the previous or the new value.
+ */
+
+#include "sln_flash.h"
+#include "sln_flash_kvs.h"
+#include "sln_flash_sim.h"
+#include "test_host.h"
+
+/* Size of the settings of the application, and of a file filling a good part of a store sector */
+#define TEST_SETTINGS_SIZE (44U)
+#define TEST_BIG_SIZE      (4000U)
+
+/* Key of the store not used by the files of the test */
+#define TEST_OTHER_KEY (SLN_FLASH_KVS_MAX_KEYS - 1)
+
+static uint8_t s_expected[TEST_BIG_SIZE];
+static uint8_t s_read[TEST_BIG_SIZE];
+
+static bool read_back(uint32_t size)
+{
+    uint32_t len = sizeof(s_read);
+
+    return (SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Read(TEST_FILE_LOGGED, s_read, &len)) && (size == len) &&
+           (0 == memcmp(s_expected, s_read, len));
+}
+
+/* Change a byte of the file, as the settings cache does for a volume step */
+static int32_t change_byte(uint32_t offset, uint8_t value)
+{
+    s_expected[offset] = value;
+
+    return SLN_FLASH_MGMT_UpdateRange(TEST_FILE_LOGGED, offset, &s_expected[offset], 1);
+}
+
+static void reboot(void)
+{
+    SLN_FLASH_SIM_PowerOn();
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, false));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+}
+
+/* Changes without a read in between stay delta records, folded when the chain is full and by the next read */
+static void test_delta_chain(void)
+{
+    sln_flash_kvs_stats_t stats = {0};
+    sln_flash_kvs_stats_t start = {0};
+    uint32_t changes            = 3 * SLN_FLASH_KVS_MAX_DELTAS;
+    uint32_t fullBytes          = 0;
+
+    for (uint32_t idx = 0; idx < TEST_SETTINGS_SIZE; idx++)
+    {
+        s_expected[idx] = (uint8_t)(idx * 5);
+    }
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_LOGGED, s_expected, TEST_SETTINGS_SIZE));
+
+    SLN_FLASH_KVS_GetStats(&start);
+    fullBytes = start.flashBytes;
+
+    for (uint32_t step = 0; step < changes; step++)
+    {
+        TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(8 + (step % 4), (uint8_t)(100 + step)));
+    }
+
+    SLN_FLASH_KVS_GetStats(&stats);
+    TEST_CHECK((stats.deltas - start.deltas) + (stats.folds - start.folds) == changes);
+    TEST_CHECK((stats.folds - start.folds) == (changes / (SLN_FLASH_KVS_MAX_DELTAS + 1)));
+
+    configPRINTF(("%d changes of 1 byte of %d bytes: %d flash bytes each, %d for a full save\r\n", changes,
+                  TEST_SETTINGS_SIZE, (stats.flashBytes - start.flashBytes) / changes, fullBytes));
+
+    // Folded by the read
+    TEST_CHECK(read_back(TEST_SETTINGS_SIZE));
+
+    // Folded by the start
+    TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(20, 0x5A));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(0, 0xA5));
+    reboot();
+    TEST_CHECK(read_back(TEST_SETTINGS_SIZE));
+
+    // Unchanged bytes, then a range past the end of the file
+    TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(0, 0xA5));
+    TEST_CHECK(SLN_FLASH_MGMT_EINVAL2 == SLN_FLASH_MGMT_UpdateRange(TEST_FILE_LOGGED, TEST_SETTINGS_SIZE, s_read, 1));
+    TEST_CHECK(read_back(TEST_SETTINGS_SIZE));
+}
+
+/*
+ * Records of another key fill the store around the file until it wraps around several times: the compactions
+ * reach the sector of the full value and of the delta records of the file, which must be folded, not dropped.
+ */
+static void test_delta_compaction(void)
+{
+    sln_flash_kvs_stats_t stats = {0};
+
+    for (uint32_t idx = 0; idx < TEST_BIG_SIZE; idx++)
+    {
+        s_expected[idx] = (uint8_t)(idx * 3);
+    }
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_LOGGED, s_expected, TEST_BIG_SIZE));
+    memcpy(s_read, s_expected, TEST_BIG_SIZE);
+
+    for (uint32_t round = 0; round < (3 * SLN_FLASH_KVS_SECTOR_COUNT * (SECTOR_SIZE / TEST_BIG_SIZE)); round++)
+    {
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_KVS_Write(TEST_OTHER_KEY, NULL, 0, s_read, TEST_BIG_SIZE, NULL));
+
+        if (0 == (round % 50))
+        {
+            TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(round % 512, (uint8_t)round));
+        }
+    }
+
+    SLN_FLASH_KVS_GetStats(&stats);
+    TEST_CHECK(0 != stats.compactions);
+    TEST_CHECK(0 != stats.folds);
+    TEST_CHECK(read_back(TEST_BIG_SIZE));
+
+    reboot();
+    TEST_CHECK(read_back(TEST_BIG_SIZE));
+}
+
+/* Cut the power at each operation of a change in turn, with delta records already in the chain */
+static void test_delta_power_cut(void)
+{
+    sln_flash_sim_config_t config = {.strictNor = true};
+    uint8_t before[TEST_SETTINGS_SIZE];
+    uint32_t cuts = 0;
+    bool cut      = true;
+
+    for (uint32_t cutAfter = 1; cut; cutAfter++)
+    {
+        uint32_t len = sizeof(s_read);
+
+        for (uint32_t idx = 0; idx < TEST_SETTINGS_SIZE; idx++)
+        {
+            s_expected[idx] = (uint8_t)(idx + 1);
+        }
+
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_LOGGED, s_expected, TEST_SETTINGS_SIZE));
+        TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(4, 0x44));
+        TEST_CHECK(SLN_FLASH_MGMT_OK == change_byte(30, 0x30));
+        memcpy(before, s_expected, sizeof(before));
+
+        config.powerCutAfter = cutAfter;
+        SLN_FLASH_SIM_SetConfig(&config);
+        change_byte(12, 0x12);
+        cut                  = SLN_FLASH_SIM_IsPoweredOff();
+        config.powerCutAfter = 0;
+        SLN_FLASH_SIM_SetConfig(&config);
+
+        reboot();
+
+        cuts += cut ? 1 : 0;
+
+        if ((SLN_FLASH_MGMT_OK != SLN_FLASH_MGMT_Read(TEST_FILE_LOGGED, s_read, &len)) ||
+            (TEST_SETTINGS_SIZE != len) ||
+            ((0 != memcmp(s_read, before, len)) && (0 != memcmp(s_read, s_expected, len))))
+        {
+            printf("[FAIL] no good value after a power cut at operation %d\r\n", cutAfter);
+            g_testFailures++;
+        }
+        else if (!cut)
+        {
+            TEST_CHECK(0 == memcmp(s_read, s_expected, len));
+        }
+    }
+
+    TEST_CHECK(0 != cuts);
+}
+
+int main(void)
+{
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(false));
+
+    test_delta_chain();
+    test_delta_compaction();
+    test_delta_power_cut();
+
+    return TEST_HOST_Result("logged file delta records");
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Formats of the encrypted files: the files saved now always end with a padded block and read back
+ * whatever their last bytes, the files of older firmware, written here as it did, still read back.
+ */
+
+#include "sln_cpu_crypto.h"
+#include "sln_encrypt.h"
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "test_host.h"
+
+/* Key and IV of the file system */
+static const uint8_t s_key[SLN_CPU_AES128_KEY_SIZE] = {0x2c, 0x7d, 0x13, 0x18, 0x26, 0xb0, 0xd0, 0xaa,
+                                                       0xab, 0xf7, 0x16, 0x88, 0x09, 0xcf, 0x4f, 0x3e};
+static const uint8_t s_iv[SLN_CPU_AES_BLOCK_SIZE]   = {0xef, 0xf0, 0xf9, 0xec, 0xfc, 0xf1, 0xf4, 0xf9,
+                                                     0xf8, 0xf9, 0xfa, 0x02, 0xfc, 0xfd, 0xfe, 0xff};
+
+/* Sizes around the block size */
+static const uint32_t s_sizes[] = {1, 5, 15, 16, 17, 31, 32, 37, 48, 64, 200};
+
+static uint8_t s_data[256];
+static uint8_t s_read[256];
+static uint8_t s_crypt[256];
+
+static bool read_back(uint32_t size)
+{
+    uint32_t len = 0;
+
+    if ((SLN_FLASH_MGMT_OK != SLN_FLASH_MGMT_Read(TEST_FILE_ENCRYPTED, NULL, &len)) || (size != len))
+    {
+        return false;
+    }
+
+    len = sizeof(s_read);
+
+    return (SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Read(TEST_FILE_ENCRYPTED, s_read, &len)) && (size == len) &&
+           (0 == memcmp(s_data, s_read, len));
+}
+
+/*
+ * With padLike the data ends with a byte that is also a valid padding. Older firmware read such block aligned files
+ * short, so the legacy files are only written without it.
+ */
+static void fill_data(uint32_t size, bool padLike)
+{
+    for (uint32_t idx = 0; idx < size; idx++)
+    {
+        s_data[idx] = (uint8_t)(idx * 13 + size);
+    }
+
+    s_data[size - 1] = padLike ? 0x01 : 0xA5;
+}
+
+/* Write the encrypted file as older firmware did: block aligned data has all its blocks chained */
+static void write_legacy_file(uint32_t size)
+{
+    uint32_t address          = g_testFileTable[1].address;
+    uint32_t chained          = size - (size % SLN_CPU_AES_BLOCK_SIZE);
+    uint32_t cryptLen         = SLN_Encrypt_Get_Legacy_Crypt_Length(size);
+    sln_file_header_t hdr     = {0};
+    sln_flash_map_t map       = {0};
+    sln_encrypt_ctx_t crcCtx  = {.keySize = 16};
+    uint8_t page[FLASH_PAGE_SIZE];
+    size_t crcSize = sizeof(uint32_t);
+    uint32_t crc   = 0;
+
+    SLN_CPU_CRYPTO_AesCbc(s_key, s_iv, s_data, s_crypt, chained, true);
+
+    if (chained < size)
+    {
+        uint8_t pad = (uint8_t)(cryptLen - size);
+        uint8_t last[SLN_CPU_AES_BLOCK_SIZE];
+
+        memcpy(last, &s_data[chained], size - chained);
+        memset(&last[size - chained], pad, pad);
+        SLN_CPU_CRYPTO_AesCbc(s_key, s_iv, last, &s_crypt[chained], sizeof(last), true);
+    }
+
+    TEST_CHECK(SLN_ENCRYPT_STATUS_OK == SLN_Crc(&crcCtx, s_crypt, cryptLen, &crc, &crcSize));
+
+    // Older firmware set the 5 padding bits, now the format and the reserved bits
+    hdr.valid        = 1;
+    hdr.clean        = 1;
+    hdr.format       = 0x3;
+    hdr.reserved     = 0x7;
+    hdr.sizeBytes    = cryptLen;
+    hdr.isSize14bits = 1;
+    hdr.crc          = crc;
+
+    memset(&map, SLN_FLASH_MGMT_MAP_FREE, sizeof(map));
+    map.map[0] = SLN_FLASH_MGMT_MAP_CURRENT;
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &hdr, sizeof(hdr));
+    memcpy(&page[sizeof(hdr)], s_crypt, cryptLen);
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, true));
+    TEST_CHECK(kStatus_Success == SLN_Write_Flash_Page(address, (uint8_t *)&map, sizeof(map)));
+    TEST_CHECK(kStatus_Success == SLN_Write_Flash_Page(address + SLN_FLASH_MAP_SIZE, page, sizeof(page)));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+}
+
+static const sln_file_header_t *get_header(void)
+{
+    const uint8_t *data = NULL;
+    uint32_t len        = 0;
+
+    if (SLN_FLASH_MGMT_OK != SLN_FLASH_MGMT_ReadDataPtr(TEST_FILE_ENCRYPTED, &data, &len))
+    {
+        return NULL;
+    }
+
+    return (const sln_file_header_t *)(data - sizeof(sln_file_header_t));
+}
+
+/* New files: a padding block after block aligned data, no byte taken for padding */
+static void test_padded_format(void)
+{
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(s_sizes); idx++)
+    {
+        const sln_file_header_t *hdr = NULL;
+
+        fill_data(s_sizes[idx], true);
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_ENCRYPTED, s_data, s_sizes[idx]));
+
+        if (!read_back(s_sizes[idx]))
+        {
+            printf("[FAIL] %d bytes not read back\r\n", s_sizes[idx]);
+            g_testFailures++;
+        }
+
+        hdr = get_header();
+        TEST_CHECK((NULL != hdr) && (SLN_FLASH_FILE_FORMAT_PADDED == hdr->format));
+        TEST_CHECK((NULL != hdr) && (SLN_Encrypt_Get_Crypt_Length(s_sizes[idx]) == hdr->sizeBytes));
+    }
+}
+
+/* Files of older firmware read back, and are saved again in the new format */
+static void test_legacy_format(void)
+{
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(s_sizes); idx++)
+    {
+        const sln_file_header_t *hdr = NULL;
+
+        fill_data(s_sizes[idx], false);
+        write_legacy_file(s_sizes[idx]);
+
+        hdr = get_header();
+        TEST_CHECK((NULL != hdr) && (SLN_FLASH_FILE_FORMAT_LEGACY == hdr->format));
+
+        if (!read_back(s_sizes[idx]))
+        {
+            printf("[FAIL] legacy file of %d bytes not read back\r\n", s_sizes[idx]);
+            g_testFailures++;
+        }
+
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_ENCRYPTED, s_data, s_sizes[idx]));
+        TEST_CHECK(read_back(s_sizes[idx]));
+
+        hdr = get_header();
+        TEST_CHECK((NULL != hdr) && (SLN_FLASH_FILE_FORMAT_PADDED == hdr->format));
+    }
+}
+
+int main(void)
+{
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(false));
+
+    test_padded_format();
+    test_legacy_format();
+
+    return TEST_HOST_Result("encrypted file formats");
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Errors of the file system start: a step failing for one file does not stop the others, every file
+ * is still indexed and the first error is the one returned.
+ */
+
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "test_host.h"
+
+/* Files of 100 pages with their header, the start compacts the sector after 5 saves */
+#define TEST_BIG_SIZE (99U * FLASH_PAGE_SIZE)
+#define TEST_LOG_SIZE (100U)
+
+static uint8_t s_data[TEST_BIG_SIZE];
+static uint8_t s_read[TEST_BIG_SIZE];
+
+static bool read_back(const char *name, uint32_t size)
+{
+    uint32_t len = sizeof(s_read);
+
+    return (SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Read(name, s_read, &len)) && (size == len) &&
+           (0 == memcmp(s_data, s_read, len));
+}
+
+/* The compaction run by the start fails, the files of the later steps are indexed all the same */
+static void test_failed_compaction(void)
+{
+    sln_flash_sim_config_t config = {.strictNor = true};
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_LOGGED, s_data, TEST_LOG_SIZE));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_ENCRYPTED, s_data, TEST_LOG_SIZE));
+
+    for (uint32_t fill = 0; fill < 5; fill++)
+    {
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_PLAIN, s_data, TEST_BIG_SIZE));
+    }
+
+    // The first program or erase of the start, the erase of the spare sector, fails
+    config.powerCutAfter = 1;
+    SLN_FLASH_SIM_SetConfig(&config);
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, false));
+    TEST_CHECK(SLN_FLASH_MGMT_EIO == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+
+    TEST_CHECK(read_back(TEST_FILE_PLAIN, TEST_BIG_SIZE));
+    TEST_CHECK(read_back(TEST_FILE_ENCRYPTED, TEST_LOG_SIZE));
+    TEST_CHECK(read_back(TEST_FILE_LOGGED, TEST_LOG_SIZE));
+
+    config.powerCutAfter = 0;
+    SLN_FLASH_SIM_SetConfig(&config);
+    SLN_FLASH_SIM_PowerOn();
+
+    // Compacted by the next start
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, false));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+    TEST_CHECK(read_back(TEST_FILE_PLAIN, TEST_BIG_SIZE));
+    TEST_CHECK(read_back(TEST_FILE_LOGGED, TEST_LOG_SIZE));
+}
+
+int main(void)
+{
+    for (uint32_t idx = 0; idx < TEST_BIG_SIZE; idx++)
+    {
+        s_data[idx] = (uint8_t)(idx * 3);
+    }
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(false));
+
+    test_failed_compaction();
+
+    return TEST_HOST_Result("flash init errors");
+}
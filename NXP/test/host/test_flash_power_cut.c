@@ -0,0 +1,160 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Power cuts during a save: the power is cut at each program or erase of the save in turn, then the
+ * file system is started again as after a reboot. The file must read back as the previous or the new
+ * copy, whole and with a good CRC, never as a mix or a missing file.
+ */
+
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "test_host.h"
+
+/* Files of 100 pages with their header, the sector fills after 5 saves */
+#define TEST_BIG_SIZE   (99U * FLASH_PAGE_SIZE)
+#define TEST_SMALL_SIZE (1000U)
+
+static uint8_t s_old[TEST_BIG_SIZE];
+static uint8_t s_new[TEST_BIG_SIZE];
+static uint8_t s_read[TEST_BIG_SIZE];
+
+/* Start the file system again on the flash as the power cut left it */
+static void reboot(void)
+{
+    SLN_FLASH_SIM_PowerOn();
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, false));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+}
+
+/* Returns 1 if the file is the previous copy, 2 if the new one, 0 otherwise */
+static int read_copy(const char *name, uint32_t oldLen, uint32_t newLen)
+{
+    uint32_t len = sizeof(s_read);
+
+    if (SLN_FLASH_MGMT_OK != SLN_FLASH_MGMT_Read(name, s_read, &len))
+    {
+        return 0;
+    }
+
+    if ((oldLen == len) && (0 == memcmp(s_old, s_read, len)))
+    {
+        return 1;
+    }
+
+    if ((newLen == len) && (0 == memcmp(s_new, s_read, len)))
+    {
+        return 2;
+    }
+
+    return 0;
+}
+
+/*
+ * Cut the power at each operation of the save of the new copy in turn, after fill saves of the previous one.
+ * With inInit the save is not cut, the power is cut in the compaction run by the next start instead.
+ */
+static void test_power_cut(const char *name, uint32_t oldLen, uint32_t newLen, uint32_t fills, bool inInit)
+{
+    sln_flash_sim_config_t config = {.strictNor = true};
+    sln_flash_sim_stats_t stats   = {0};
+    uint32_t cuts                 = 0;
+    uint32_t newCopies            = 0;
+    bool cut                      = true;
+
+    for (uint32_t cutAfter = 1; cut; cutAfter++)
+    {
+        int32_t ret = SLN_FLASH_MGMT_OK;
+        int copy    = 0;
+
+        config.powerCutAfter = 0;
+        SLN_FLASH_SIM_SetConfig(&config);
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, true));
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, false));
+
+        for (uint32_t fill = 0; fill < fills; fill++)
+        {
+            TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(name, s_old, oldLen));
+        }
+
+        if (inInit)
+        {
+            config.powerCutAfter = cutAfter;
+            SLN_FLASH_SIM_SetConfig(&config);
+            SLN_FLASH_MGMT_Deinit(g_testFileTable, false);
+            SLN_FLASH_MGMT_Init(g_testFileTable, false);
+        }
+        else
+        {
+            config.powerCutAfter = cutAfter;
+            SLN_FLASH_SIM_SetConfig(&config);
+            ret = SLN_FLASH_MGMT_Save(name, s_new, newLen);
+        }
+
+        cut                  = SLN_FLASH_SIM_IsPoweredOff();
+        config.powerCutAfter = 0;
+        SLN_FLASH_SIM_SetConfig(&config);
+
+        if (!cut)
+        {
+            TEST_CHECK(SLN_FLASH_MGMT_OK == ret);
+        }
+
+        reboot();
+
+        copy = read_copy(name, oldLen, newLen);
+        cuts += cut ? 1 : 0;
+        newCopies += (2 == copy) ? 1 : 0;
+
+        if (0 == copy)
+        {
+            printf("[FAIL] %s: no good copy after a power cut at operation %d\r\n", name, cutAfter);
+            g_testFailures++;
+        }
+        else if (!cut)
+        {
+            TEST_CHECK((inInit ? 1 : 2) == copy);
+        }
+
+        // The file system keeps working after the cut
+        TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(name, s_new, newLen));
+        TEST_CHECK(2 == read_copy(name, oldLen, newLen));
+    }
+
+    SLN_FLASH_SIM_GetStats(&stats);
+    TEST_CHECK(0 == stats.norViolations);
+
+    configPRINTF(("%s, %d bytes over %d bytes%s: %d power cuts, new copy kept after %d\r\n", name, newLen, oldLen,
+                  inInit ? ", compaction at start" : (fills > 1) ? ", compaction" : "", cuts, newCopies));
+}
+
+int main(void)
+{
+    for (uint32_t idx = 0; idx < TEST_BIG_SIZE; idx++)
+    {
+        s_old[idx] = (uint8_t)idx;
+        s_new[idx] = (uint8_t)(idx * 7 + 1);
+    }
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(false));
+    SLN_FLASH_SIM_ResetStats();
+
+    // New copy appended after the previous one in the sector
+    test_power_cut(TEST_FILE_PLAIN, TEST_SMALL_SIZE, TEST_SMALL_SIZE + 300, 1, false);
+    test_power_cut(TEST_FILE_ENCRYPTED, TEST_SMALL_SIZE, TEST_SMALL_SIZE - 100, 1, false);
+
+    // Sector full, the new copy goes through the spare sector
+    test_power_cut(TEST_FILE_PLAIN, TEST_BIG_SIZE, TEST_BIG_SIZE, 5, false);
+
+    // Sector nearly full, compacted by the next start through the spare sector
+    test_power_cut(TEST_FILE_PLAIN, TEST_BIG_SIZE, TEST_BIG_SIZE, 5, true);
+
+    return TEST_HOST_Result("flash power cuts");
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Scheduling of the flash writer on the simulated flash: the erases run in suspended steps while
+ * the other tasks read and program the flash, and the erases of the file system queue behind the
+ * one the writer has suspended instead of hitting the busy flash.
+ */
+
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "sln_flash_writer.h"
+#include "test_host.h"
+
+/* A sector erase of 20 ms, so the writer needs many steps of SLN_FLASH_WRITER_SLICE_US */
+#define TEST_ERASE_US   (20000U)
+#define TEST_PROGRAM_US (50U)
+
+/* Sector not used by the files of the tests */
+#define TEST_SPARE_SECTOR SLN_FLASH_MGMT_FILE_ADDR(8)
+
+static volatile bool s_eraseDone      = false;
+static volatile status_t s_eraseStatus = kStatus_Fail;
+
+static uint8_t s_data[1000];
+static uint8_t s_read[1000];
+
+static void erase_done(status_t status, void *arg)
+{
+    s_eraseStatus = status;
+    s_eraseDone   = true;
+}
+
+/* Queue an erase of the spare sector and let the writer run it until it is suspended */
+static void start_background_erase(void)
+{
+    sln_flash_sim_stats_t stats = {0};
+    uint32_t suspends           = 0;
+
+    SLN_FLASH_SIM_GetStats(&stats);
+    suspends = stats.suspends;
+
+    s_eraseDone = false;
+    TEST_CHECK(kStatus_Success == SLN_FLASH_WRITER_Erase(TEST_SPARE_SECTOR, erase_done, NULL));
+
+    while (stats.suspends == suspends)
+    {
+        vTaskDelay(1);
+        SLN_FLASH_SIM_GetStats(&stats);
+    }
+}
+
+static void wait_background_erase(void)
+{
+    while (!s_eraseDone)
+    {
+        vTaskDelay(1);
+    }
+
+    TEST_CHECK(kStatus_Success == s_eraseStatus);
+}
+
+/* Files saved and read while the writer erases in the background */
+static void test_program_while_suspended(void)
+{
+    uint32_t len = sizeof(s_read);
+
+    start_background_erase();
+
+    memset(s_data, 0xA5, sizeof(s_data));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_PLAIN, s_data, sizeof(s_data)));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_LOGGED, s_data, 100));
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Read(TEST_FILE_PLAIN, s_read, &len));
+    TEST_CHECK((sizeof(s_data) == len) && (0 == memcmp(s_data, s_read, len)));
+
+    wait_background_erase();
+}
+
+/* The erases of the file system wait for the suspended one */
+static void test_erase_while_suspended(void)
+{
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Save(TEST_FILE_ENCRYPTED, s_data, sizeof(s_data)));
+
+    start_background_erase();
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Erase(TEST_FILE_ENCRYPTED));
+    TEST_CHECK(s_eraseDone);
+
+    start_background_erase();
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Deinit(g_testFileTable, true));
+    TEST_CHECK(SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Init(g_testFileTable, true));
+    TEST_CHECK(s_eraseDone);
+}
+
+/* The flash takes no other erase while one is suspended, the rule the writer is there for */
+static void test_direct_erase_refused(void)
+{
+    sln_flash_sim_stats_t before = {0};
+    sln_flash_sim_stats_t after  = {0};
+
+    start_background_erase();
+
+    SLN_FLASH_SIM_GetStats(&before);
+    TEST_CHECK(kStatus_Success != SLN_Erase_Sector(g_testFileTable[0].address));
+    SLN_FLASH_SIM_GetStats(&after);
+    TEST_CHECK(after.busyErrors == before.busyErrors + 1);
+
+    wait_background_erase();
+}
+
+/* A step failing while the flash erases leaves the flash idle, the next erase can start */
+static void test_failed_step(sln_flash_sim_config_t *config)
+{
+    sln_flash_erase_t erase = {.address = TEST_SPARE_SECTOR, .started = false};
+    uint32_t value          = 0;
+
+    config->suspendFails = true;
+    SLN_FLASH_SIM_SetConfig(config);
+
+    TEST_CHECK(kStatus_Fail == SLN_Erase_Sector_Step(&erase, 100));
+    TEST_CHECK(!erase.started);
+
+    TEST_CHECK(kStatus_Success == SLN_FLASH_SIM_ReadStatus(&value));
+    TEST_CHECK(HYPERFLASH_STATUS_READY == value);
+
+    config->suspendFails = false;
+    SLN_FLASH_SIM_SetConfig(config);
+
+    TEST_CHECK(kStatus_Success == SLN_FLASH_WRITER_EraseSync(g_testFileTable[0].address));
+}
+
+int main(void)
+{
+    sln_flash_sim_config_t config   = {.strictNor = true, .eraseUs = TEST_ERASE_US, .programUs = TEST_PROGRAM_US};
+    sln_flash_sim_stats_t stats     = {0};
+    sln_flash_writer_stats_t writer = {0};
+
+    TEST_CHECK(SLN_FLASH_MGMT_OK == TEST_HOST_Boot(true));
+    SLN_FLASH_SIM_SetConfig(&config);
+    SLN_FLASH_SIM_ResetStats();
+
+    test_program_while_suspended();
+    test_erase_while_suspended();
+
+    SLN_FLASH_SIM_GetStats(&stats);
+    TEST_CHECK(0 == stats.busyErrors);
+    TEST_CHECK(0 == stats.norViolations);
+
+    test_direct_erase_refused();
+    test_failed_step(&config);
+
+    SLN_FLASH_WRITER_GetStats(&writer);
+    configPRINTF(("Writer: %d requests, %d failures, %d erase steps, longest erase %d ms\r\n", writer.requests,
+                  writer.failures, writer.eraseSteps, writer.maxEraseMs));
+    TEST_CHECK(0 == writer.failures);
+    TEST_CHECK(writer.eraseSteps > writer.requests);
+
+    return TEST_HOST_Result("flash writer scheduling");
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <unistd.h>
+
+#include "sln_dcp_queue.h"
+#include "sln_flash.h"
+#include "sln_flash_sim.h"
+#include "sln_flash_writer.h"
+#include "test_host.h"
+
+int g_testFailures = 0;
+
+sln_flash_entry_t g_testFileTable[] = {
+    {TEST_FILE_PLAIN, SLN_FLASH_MGMT_FILE_ADDR(0), SLN_FLASH_PLAIN, SLN_FLASH_SECTOR},
+    {TEST_FILE_ENCRYPTED, SLN_FLASH_MGMT_FILE_ADDR(1), SLN_FLASH_ENCRYPTED, SLN_FLASH_SECTOR},
+    {TEST_FILE_LOGGED, SLN_FLASH_MGMT_FILE_ADDR(2), SLN_FLASH_PLAIN, SLN_FLASH_LOGGED},
+    {{0}, 0, false, false},
+};
+
+int32_t TEST_HOST_Boot(bool withTasks)
+{
+    int32_t ret = SLN_FLASH_MGMT_OK;
+
+    // A new flash each run, erased
+    unlink(SLN_FLASH_SIM_FILE);
+
+    if (withTasks)
+    {
+        SLN_DCP_QUEUE_Init();
+    }
+
+    SLN_Flash_Init();
+
+    ret = SLN_FLASH_MGMT_Init(g_testFileTable, false);
+
+    if (withTasks)
+    {
+        SLN_FLASH_WRITER_Init();
+        vTaskStartScheduler();
+    }
+
+    return ret;
+}
+
+int TEST_HOST_Result(const char *name)
+{
+    printf("[%s] %s, %d failed checks\r\n", (0 == g_testFailures) ? "PASS" : "FAIL", name, g_testFailures);
+
+    return (0 == g_testFailures) ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _TEST_HOST_H_
+#define _TEST_HOST_H_
+
+/*!
+ * Helpers of the host tests
+ *
+ * A test is a program returning 0 when it passes; TEST_CHECK prints the failed condition and
+ * counts it in g_testFailures.
+ */
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sln_flash_mgmt.h"
+
+#define TEST_CHECK(cond)                                                          \
+    do                                                                            \
+    {                                                                             \
+        if (!(cond))                                                              \
+        {                                                                         \
+            printf("[FAIL] %s:%d: %s\r\n", __FILE__, __LINE__, #cond);            \
+            g_testFailures++;                                                     \
+        }                                                                         \
+    } while (0)
+
+/*! @brief Files of the tests: a plain, an encrypted and a logged one, then spare sectors */
+#define TEST_FILE_PLAIN     "plain.dat"
+#define TEST_FILE_ENCRYPTED "encrypted.dat"
+#define TEST_FILE_LOGGED    "logged.dat"
+
+extern int g_testFailures;
+extern sln_flash_entry_t g_testFileTable[];
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Starts the file system of a test on a new simulated flash, as main.c does on the target
+ *
+ * @param withTasks Start the DCP queue and flash writer tasks, else their calls run inline
+ *
+ * @returns Result of SLN_FLASH_MGMT_Init
+ */
+int32_t TEST_HOST_Boot(bool withTasks);
+
+/*!
+ * @brief Prints the result of a test
+ *
+ * @param name Name of the test
+ *
+ * @returns Exit code of the test program
+ */
+int TEST_HOST_Result(const char *name);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _TEST_HOST_H_ */
@@ -0,0 +1,688 @@
+/*
+ * Copyright 2022 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+/*
+ * Superframes of WWD, on a simulated bus: the test plays the WLAN chip. The Ethernet frames sent are
+ * aggregated by wwd_sdpcm_get_superframe_to_send and parsed back as the firmware does, within the bus
+ * data credits the chip grants. The superframes the chip sends are announced by a glom descriptor and
+ * split by wwd_sdpcm_process_rx_superframe, the malformed ones rejected. Last, the frames aggregated
+ * per second.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#include "test_host.h"
+#include "wwd_host.h"
+#include "internal/wwd_internal.h"
+#include "internal/wwd_sdpcm.h"
+#include "internal/wwd_thread.h"
+#include "internal/bus_protocols/wwd_bus_protocol_interface.h"
+#include "network/wwd_network_interface.h"
+
+/* Wire format of the chip, as in wwd_sdpcm.c */
+#define TEST_SDPCM_HEADER_LEN (12)
+#define TEST_DATA_HEADER_LEN  (TEST_SDPCM_HEADER_LEN + 2)
+#define TEST_BDC_HEADER_LEN   (4)
+#define TEST_HWEXT_LEN        (8)
+#define TEST_GLOM_HEADER_LEN  (TEST_DATA_HEADER_LEN + TEST_HWEXT_LEN)
+#define TEST_GLOM_ALIGN       (4)
+#define TEST_CHANNEL_CONTROL  (0)
+#define TEST_CHANNEL_DATA     (2)
+#define TEST_CHANNEL_GLOM     (3)
+#define TEST_GLOMDESC_FLAG    (0x80)
+#define TEST_HWEXT_LAST_FRAME (1U << 24)
+#define TEST_BDC_FLAGS        (2 << 4)
+
+/* Ethernet frames of the test, of the local experimental EtherType */
+#define TEST_ETHER_HEADER_LEN (14)
+#define TEST_ETHERTYPE        (0x88B5)
+#define TEST_FRAME_MAX        (1500)
+#define TEST_FRAMES_MAX       (32)
+
+#define TEST_RX_SUPERFRAME_MAX (WWD_SDPCM_RX_GLOM_MAX_BYTES)
+
+#define TEST_THROUGHPUT_FRAMES     (200000)
+#define TEST_THROUGHPUT_FRAME_SIZE (256)
+
+typedef struct _test_frame
+{
+    uint32_t id;
+    uint16_t len;
+} test_frame_t;
+
+/* Frames sent by WWD, checked in order by the chip */
+static test_frame_t s_txFrames[TEST_FRAMES_MAX];
+static uint32_t s_txHead;
+static uint32_t s_txTail;
+static uint32_t s_txId;
+
+/* Frames the network stack received from WWD */
+static test_frame_t s_rxFrames[TEST_FRAMES_MAX];
+static uint32_t s_rxCount;
+
+/* State of the chip */
+static uint8_t s_chipSequence;
+static uint8_t s_chipCredit = 1;
+static uint8_t s_chipRxSequence;
+static wiced_bool_t s_flowControlled;
+static bool s_checkFrames = true;
+
+static uint8_t s_rxSuperframe[TEST_RX_SUPERFRAME_MAX];
+static uint16_t s_rxSizes[WWD_SDPCM_RX_GLOM_MAX_PACKETS];
+
+/* Simulated bus and network stack, called by wwd_sdpcm.c */
+
+uint8_t wwd_tos_map[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+wwd_wlan_status_t wwd_wlan_status;
+
+wiced_bool_t wwd_bus_is_flow_controlled(void)
+{
+    return s_flowControlled;
+}
+
+wwd_result_t wwd_bus_set_flow_control(uint8_t value)
+{
+    s_flowControlled = (0 != value) ? WICED_TRUE : WICED_FALSE;
+
+    return WWD_SUCCESS;
+}
+
+wwd_result_t wwd_ensure_wlan_bus_is_up(void)
+{
+    return WWD_SUCCESS;
+}
+
+void wwd_thread_notify(void)
+{
+}
+
+wiced_bool_t wwd_wifi_monitor_mode_is_enabled(void)
+{
+    return WICED_FALSE;
+}
+
+static uint16_t read16(const uint8_t *data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t read32(const uint8_t *data)
+{
+    return (uint32_t)read16(data) | ((uint32_t)read16(&data[2]) << 16);
+}
+
+static void write16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+static void make_frame(uint8_t *frame, uint32_t id, uint16_t len)
+{
+    memset(frame, 0xFF, 6);
+    frame[6]  = 0x02;
+    frame[7]  = 0x00;
+    frame[8]  = (uint8_t)(id >> 24);
+    frame[9]  = (uint8_t)(id >> 16);
+    frame[10] = (uint8_t)(id >> 8);
+    frame[11] = (uint8_t)id;
+    frame[12] = (uint8_t)(TEST_ETHERTYPE >> 8);
+    frame[13] = (uint8_t)TEST_ETHERTYPE;
+
+    for (uint32_t idx = TEST_ETHER_HEADER_LEN; idx < len; idx++)
+    {
+        frame[idx] = (uint8_t)(id * 7 + idx);
+    }
+}
+
+static bool frame_matches(const uint8_t *frame, uint16_t len, const test_frame_t *expected)
+{
+    uint8_t good[TEST_FRAME_MAX];
+
+    make_frame(good, expected->id, expected->len);
+
+    return (len == expected->len) && (0 == memcmp(frame, good, len));
+}
+
+void host_network_process_ethernet_data(wiced_buffer_t buffer, wwd_interface_t interface)
+{
+    const uint8_t *frame = host_buffer_get_current_piece_data_pointer(buffer);
+    uint16_t len         = host_buffer_get_current_piece_size(buffer);
+
+    // The source address carries the id of the frame
+    if (s_rxCount < TEST_FRAMES_MAX)
+    {
+        s_rxFrames[s_rxCount].id  = ((uint32_t)frame[8] << 24) | ((uint32_t)frame[9] << 16) | (frame[10] << 8);
+        s_rxFrames[s_rxCount].id |= frame[11];
+        s_rxFrames[s_rxCount].len = len;
+
+        if ((TEST_FRAME_MAX < len) || !frame_matches(frame, len, &s_rxFrames[s_rxCount]) ||
+            (WWD_STA_INTERFACE != interface))
+        {
+            printf("[FAIL] frame %d received corrupted\r\n", s_rxFrames[s_rxCount].id);
+            g_testFailures++;
+        }
+    }
+
+    s_rxCount++;
+    host_buffer_release(buffer, WWD_NETWORK_RX);
+}
+
+/* Transmit side */
+
+static void send_frame(uint16_t len)
+{
+    wiced_buffer_t buffer = NULL;
+
+    TEST_CHECK(WWD_SUCCESS == host_buffer_get(&buffer, WWD_NETWORK_TX, len, WICED_FALSE));
+    make_frame(host_buffer_get_current_piece_data_pointer(buffer), s_txId, len);
+
+    s_txFrames[s_txTail % TEST_FRAMES_MAX].id  = s_txId++;
+    s_txFrames[s_txTail % TEST_FRAMES_MAX].len = len;
+    s_txTail++;
+
+    wwd_network_send_ethernet_data(buffer, WWD_STA_INTERFACE);
+}
+
+/*
+ * The chip reading a superframe: each packet 4 bytes aligned, its hardware extension giving its length and
+ * tail padding, the last one flagged. Returns the number of packets, -1 if the superframe is malformed.
+ */
+static int32_t chip_receive_superframe(const uint8_t *data, uint16_t size)
+{
+    uint32_t offset = 0;
+    int32_t count   = 0;
+    bool last       = false;
+
+    while (offset < size)
+    {
+        const uint8_t *packet = &data[offset];
+        uint16_t space        = 0;
+        uint16_t length       = 0;
+        uint16_t pad          = 0;
+
+        if (last || (0 != (offset % TEST_GLOM_ALIGN)) || ((size - offset) < TEST_GLOM_HEADER_LEN))
+        {
+            return -1;
+        }
+
+        space  = read16(packet);
+        length = (uint16_t)read32(&packet[4]);
+        pad    = (uint16_t)(read32(&packet[8]) >> 16);
+        last   = (0 != (read32(&packet[4]) & TEST_HWEXT_LAST_FRAME));
+
+        if ((read16(&packet[2]) != (uint16_t)~space) || (space > (size - offset)) || ((length + pad) != space) ||
+            (length < TEST_GLOM_HEADER_LEN) || (pad >= TEST_GLOM_ALIGN))
+        {
+            return -1;
+        }
+
+        for (uint16_t idx = length; idx < space; idx++)
+        {
+            if (0 != packet[idx])
+            {
+                return -1;
+            }
+        }
+
+        // Software header after the hardware extension, its length including it
+        if ((s_chipSequence != packet[12]) || (TEST_CHANNEL_DATA != (packet[13] & 0x0F)) ||
+            (TEST_GLOM_HEADER_LEN != packet[15]))
+        {
+            return -1;
+        }
+        s_chipSequence++;
+
+        if (s_checkFrames)
+        {
+            const uint8_t *bdc = &packet[TEST_GLOM_HEADER_LEN];
+            uint16_t frameLen  = (uint16_t)(length - TEST_GLOM_HEADER_LEN - TEST_BDC_HEADER_LEN);
+
+            if ((s_txHead == s_txTail) || (TEST_BDC_FLAGS != bdc[0]) || (0 != bdc[3]) ||
+                !frame_matches(&bdc[TEST_BDC_HEADER_LEN], frameLen, &s_txFrames[s_txHead % TEST_FRAMES_MAX]))
+            {
+                return -1;
+            }
+        }
+        s_txHead++;
+
+        offset += space;
+        count++;
+    }
+
+    return last ? count : -1;
+}
+
+/* Superframe of the frames queued; the number of packets, 0 if none was sent */
+static wwd_result_t transmit(uint8_t *count)
+{
+    uint8_t *data = NULL;
+    uint16_t size = 0;
+    wwd_result_t result;
+
+    result = wwd_sdpcm_get_superframe_to_send(&data, &size, count);
+    if (WWD_SUCCESS == result)
+    {
+        TEST_CHECK(size <= WWD_SDPCM_TX_GLOM_MAX_BYTES);
+
+        if ((int32_t)*count != chip_receive_superframe(data, size))
+        {
+            printf("[FAIL] superframe of %d packets, %d bytes, malformed\r\n", *count, size);
+            g_testFailures++;
+        }
+    }
+
+    return result;
+}
+
+/* Receive side */
+
+static void write_header(uint8_t *packet, uint16_t len, uint8_t channel, uint8_t headerLen, uint8_t flow,
+                         uint8_t credit)
+{
+    write16(packet, len);
+    write16(&packet[2], (uint16_t)~len);
+    packet[4]  = s_chipRxSequence++;
+    packet[5]  = channel;
+    packet[6]  = 0;
+    packet[7]  = headerLen;
+    packet[8]  = flow;
+    packet[9]  = credit;
+    packet[10] = 0;
+    packet[11] = 0;
+}
+
+/* A packet of its own on the bus, as wwd_bus_read_frame passes it */
+static void chip_send_packet(const uint8_t *packet, uint16_t len)
+{
+    wiced_buffer_t buffer = NULL;
+
+    TEST_CHECK(WWD_SUCCESS == host_buffer_get(&buffer, WWD_NETWORK_RX, sizeof(wwd_buffer_header_t) + len, WICED_FALSE));
+    memcpy(host_buffer_get_current_piece_data_pointer(buffer) + sizeof(wwd_buffer_header_t), packet, len);
+
+    wwd_sdpcm_process_rx_packet(buffer);
+}
+
+/* Credit update without data: the host may send the packets before the one of sequence number credit */
+static void chip_send_credit(uint8_t credit, uint8_t flow)
+{
+    uint8_t packet[TEST_SDPCM_HEADER_LEN];
+
+    write_header(packet, sizeof(packet), TEST_CHANNEL_CONTROL, TEST_SDPCM_HEADER_LEN, flow, credit);
+    chip_send_packet(packet, sizeof(packet));
+}
+
+/* Room for more packets in the chip */
+static void chip_grant(uint8_t more, uint8_t flow)
+{
+    s_chipCredit = (uint8_t)(s_chipCredit + more);
+    chip_send_credit(s_chipCredit, flow);
+}
+
+/* Superframe of frames of the given lengths, each packet carrying the credit; returns its size */
+static uint16_t build_superframe(uint32_t firstId, const uint16_t *lens, uint32_t count, uint8_t credit)
+{
+    uint32_t offset = TEST_SDPCM_HEADER_LEN;
+
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        uint8_t *packet = &s_rxSuperframe[offset];
+        uint16_t len    = (uint16_t)(TEST_DATA_HEADER_LEN + TEST_BDC_HEADER_LEN + lens[idx]);
+
+        write_header(packet, len, TEST_CHANNEL_DATA, TEST_DATA_HEADER_LEN, 0, credit);
+        packet[12] = 0;
+        packet[13] = 0;
+        packet[TEST_DATA_HEADER_LEN]     = TEST_BDC_FLAGS;
+        packet[TEST_DATA_HEADER_LEN + 1] = 0;
+        packet[TEST_DATA_HEADER_LEN + 2] = 0;
+        packet[TEST_DATA_HEADER_LEN + 3] = 0;
+        make_frame(&packet[TEST_DATA_HEADER_LEN + TEST_BDC_HEADER_LEN], firstId + idx, lens[idx]);
+
+        // Each packet in the space of a whole number of words, the first one after the superframe header
+        s_rxSizes[idx] = (uint16_t)(((len + 3U) & ~3U) + ((0 == idx) ? TEST_SDPCM_HEADER_LEN : 0));
+        memset(&packet[len], 0, s_rxSizes[idx] - len - ((0 == idx) ? TEST_SDPCM_HEADER_LEN : 0));
+        offset += s_rxSizes[idx] - ((0 == idx) ? TEST_SDPCM_HEADER_LEN : 0);
+    }
+
+    write_header(s_rxSuperframe, (uint16_t)offset, TEST_CHANNEL_GLOM, TEST_SDPCM_HEADER_LEN, 0, credit);
+
+    return (uint16_t)offset;
+}
+
+/* Glom descriptor of count packets; returns the size of the superframe announced */
+static uint16_t chip_announce(const uint16_t *sizes, uint32_t count)
+{
+    uint8_t packet[TEST_SDPCM_HEADER_LEN + 2 * (WWD_SDPCM_RX_GLOM_MAX_PACKETS + 1)];
+    uint16_t len = (uint16_t)(TEST_SDPCM_HEADER_LEN + 2 * count);
+
+    write_header(packet, len, TEST_CHANNEL_GLOM | TEST_GLOMDESC_FLAG, TEST_SDPCM_HEADER_LEN, 0, 0);
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        write16(&packet[TEST_SDPCM_HEADER_LEN + 2 * idx], sizes[idx]);
+    }
+
+    chip_send_packet(packet, len);
+
+    return wwd_sdpcm_take_rx_superframe_size();
+}
+
+static bool received_in_order(uint32_t firstId, const uint16_t *lens, uint32_t count)
+{
+    if (count != s_rxCount)
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        if ((firstId + idx != s_rxFrames[idx].id) || (lens[idx] != s_rxFrames[idx].len))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Frames of several sizes, each padded to a word, sent in one superframe */
+static void test_superframe_layout(void)
+{
+    static const uint16_t lens[] = {60, 61, 62, 63, 1400};
+    uint8_t count                = 0;
+
+    chip_grant(13, 0);
+    TEST_CHECK(16 == wwd_sdpcm_get_available_credits());
+
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(lens); idx++)
+    {
+        send_frame(lens[idx]);
+    }
+
+    TEST_CHECK(WICED_TRUE == wwd_sdpcm_has_tx_packet());
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(ARRAY_SIZE(lens) == count);
+    TEST_CHECK(s_txHead == s_txTail);
+    TEST_CHECK(WWD_NO_PACKET_TO_SEND == transmit(&count));
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_TX));
+}
+
+/* No more than WWD_SDPCM_TX_GLOM_MAX_PACKETS packets nor WWD_SDPCM_TX_GLOM_MAX_BYTES bytes in a superframe */
+static void test_superframe_limits(void)
+{
+    uint32_t sent  = 0;
+    uint8_t count  = 0;
+    uint16_t large = TEST_FRAME_MAX;
+
+    chip_grant(20, 0);
+    for (uint32_t idx = 0; idx < WWD_SDPCM_TX_GLOM_MAX_PACKETS + 4; idx++)
+    {
+        send_frame(100);
+    }
+
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(WWD_SDPCM_TX_GLOM_MAX_PACKETS == count);
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(4 == count);
+
+    // Large frames fill the buffer before the packet limit, the ones left follow in the next superframes
+    chip_grant(20, 0);
+    for (uint32_t idx = 0; idx < WWD_SDPCM_TX_GLOM_MAX_PACKETS; idx++)
+    {
+        send_frame(large);
+    }
+
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK((0 != count) && (count < WWD_SDPCM_TX_GLOM_MAX_PACKETS));
+    TEST_CHECK(((count + 1) * (uint32_t)(TEST_GLOM_HEADER_LEN + TEST_BDC_HEADER_LEN + large)) >
+               WWD_SDPCM_TX_GLOM_MAX_BYTES);
+
+    for (sent = count; (sent < WWD_SDPCM_TX_GLOM_MAX_PACKETS) && (WWD_SUCCESS == transmit(&count)); sent += count)
+    {
+    }
+
+    TEST_CHECK(WWD_SDPCM_TX_GLOM_MAX_PACKETS == sent);
+    TEST_CHECK(s_txHead == s_txTail);
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_TX));
+}
+
+/* A superframe takes the credits left, no more; flow control holds the queue until the chip releases it */
+static void test_credits(void)
+{
+    uint8_t count = 0;
+
+    // One credit at the start
+    chip_grant(2, 0);
+    for (uint32_t idx = 0; idx < 5; idx++)
+    {
+        send_frame(80);
+    }
+
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(3 == count);
+    TEST_CHECK(0 == wwd_sdpcm_get_available_credits());
+    TEST_CHECK(WWD_NO_CREDITS == transmit(&count));
+
+    // A credit too far ahead of the last one is taken as corrupted and ignored
+    chip_send_credit((uint8_t)(s_chipCredit + CHIP_MAX_BUS_DATA_CREDIT_DIFF + 1), 0);
+    TEST_CHECK(0 == wwd_sdpcm_get_available_credits());
+
+    chip_grant(5, 1);
+    TEST_CHECK(5 == wwd_sdpcm_get_available_credits());
+    TEST_CHECK(WWD_FLOW_CONTROLLED == transmit(&count));
+
+    chip_send_credit(s_chipCredit, 0);
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(2 == count);
+    TEST_CHECK(3 == wwd_sdpcm_get_available_credits());
+    TEST_CHECK(s_txHead == s_txTail);
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_TX));
+}
+
+/* A lone data frame waits WWD_SDPCM_TX_GLOM_LATENCY_MS at most for others to be sent with */
+static void test_latency(void)
+{
+    uint8_t count = 0;
+
+    wwd_sdpcm_set_tx_glom_enabled(WICED_TRUE);
+    chip_grant(16, 0);
+
+    send_frame(100);
+    TEST_CHECK(0 != wwd_sdpcm_get_tx_glom_wait_time());
+    TEST_CHECK(WWD_PENDING == transmit(&count));
+    send_frame(100);
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(2 == count);
+
+    send_frame(100);
+    TEST_CHECK(WWD_PENDING == transmit(&count));
+    vTaskDelay(pdMS_TO_TICKS(WWD_SDPCM_TX_GLOM_LATENCY_MS + 1));
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(1 == count);
+
+    // Until the chip takes superframes, the frames are not held back
+    wwd_sdpcm_set_tx_glom_enabled(WICED_FALSE);
+    send_frame(100);
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(1 == count);
+    TEST_CHECK(s_txHead == s_txTail);
+}
+
+/* A superframe announced by its descriptor is split into its frames, its credits taken */
+static void test_rx_superframe(void)
+{
+    static const uint16_t lens[] = {60, 1500, 97, 342};
+    uint8_t credits              = wwd_sdpcm_get_available_credits();
+    uint16_t size                = 0;
+
+    s_chipCredit = (uint8_t)(s_chipCredit + 7);
+    s_rxCount    = 0;
+    size         = build_superframe(1000, lens, ARRAY_SIZE(lens), s_chipCredit);
+
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    TEST_CHECK(0 == wwd_sdpcm_take_rx_superframe_size());
+
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    TEST_CHECK(received_in_order(1000, lens, ARRAY_SIZE(lens)));
+    TEST_CHECK((credits + 7) == wwd_sdpcm_get_available_credits());
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_RX));
+
+    // A packet on its own is not taken for a superframe
+    chip_grant(0, 0);
+    TEST_CHECK(0 == wwd_sdpcm_take_rx_superframe_size());
+}
+
+/* Malformed descriptors announce nothing, malformed superframes deliver the frames before the fault only */
+static void test_rx_malformed(void)
+{
+    static const uint16_t lens[] = {200, 300, 400};
+    uint16_t sizes[WWD_SDPCM_RX_GLOM_MAX_PACKETS + 1];
+    uint16_t size = 0;
+
+    // Too many packets, too many bytes
+    for (uint32_t idx = 0; idx < ARRAY_SIZE(sizes); idx++)
+    {
+        sizes[idx] = 64;
+    }
+    TEST_CHECK(0 == chip_announce(sizes, ARRAY_SIZE(sizes)));
+    sizes[0] = TEST_RX_SUPERFRAME_MAX;
+    TEST_CHECK(0 == chip_announce(sizes, 2));
+    TEST_CHECK(0 == chip_announce(sizes, 0));
+
+    // Bad superframe header: nothing delivered, and the descriptor is not kept for the next one
+    s_rxCount = 0;
+    size      = build_superframe(2000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    s_rxSuperframe[2] ^= 0x01;
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    s_rxSuperframe[2] ^= 0x01;
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    TEST_CHECK(0 == s_rxCount);
+
+    // Superframe header longer than the superframe read: nothing delivered
+    size = build_superframe(2000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, (uint16_t)(size - 1));
+    TEST_CHECK(0 == s_rxCount);
+
+    // Superframe shorter than its descriptor: the frames read whole only
+    size = build_superframe(2000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    write16(s_rxSuperframe, (uint16_t)(size - 1));
+    write16(&s_rxSuperframe[2], (uint16_t) ~(size - 1));
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, (uint16_t)(size - 1));
+    TEST_CHECK(received_in_order(2000, lens, 2));
+
+    // Bad frame tag of the second packet: the first frame only
+    s_rxCount = 0;
+    size      = build_superframe(2000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    s_rxSuperframe[s_rxSizes[0] + 3] ^= 0x80;
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    TEST_CHECK(received_in_order(2000, lens, 1));
+
+    // Packet longer than its space in the superframe
+    s_rxCount = 0;
+    size      = build_superframe(2000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    s_rxSizes[1] -= TEST_GLOM_ALIGN;
+    s_rxSizes[2] += TEST_GLOM_ALIGN;
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    TEST_CHECK(received_in_order(2000, lens, 1));
+
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_RX));
+}
+
+/* Without a free buffer the frames are dropped, not the credits they carry */
+static void test_rx_no_buffer(void)
+{
+    static const uint16_t lens[] = {100, 100};
+    uint8_t credits              = wwd_sdpcm_get_available_credits();
+    uint8_t count                = 0;
+    uint16_t size                = 0;
+
+    s_chipCredit = (uint8_t)(s_chipCredit + 4);
+    s_rxCount    = 0;
+    size         = build_superframe(3000, lens, ARRAY_SIZE(lens), s_chipCredit);
+    TEST_CHECK(size == chip_announce(s_rxSizes, ARRAY_SIZE(lens)));
+
+    HOST_WWD_SetBufferLimit(WWD_NETWORK_RX, 0);
+    wwd_sdpcm_process_rx_superframe(s_rxSuperframe, size);
+    HOST_WWD_SetBufferLimit(WWD_NETWORK_RX, UINT32_MAX);
+
+    TEST_CHECK(0 == s_rxCount);
+    TEST_CHECK((credits + 4) == wwd_sdpcm_get_available_credits());
+
+    for (uint32_t idx = 0; idx < 4; idx++)
+    {
+        send_frame(64);
+    }
+    TEST_CHECK(WWD_SUCCESS == transmit(&count));
+    TEST_CHECK(4 == count);
+}
+
+/* Frames aggregated and parsed back per second, the chip granting credits for each superframe */
+static void test_throughput(void)
+{
+    struct timespec start;
+    struct timespec end;
+    uint32_t superframes = 0;
+    uint32_t frames      = 0;
+    double seconds       = 0;
+    uint8_t count        = 0;
+
+    s_checkFrames = false;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (frames < TEST_THROUGHPUT_FRAMES)
+    {
+        chip_grant(WWD_SDPCM_TX_GLOM_MAX_PACKETS, 0);
+        for (uint32_t idx = 0; idx < WWD_SDPCM_TX_GLOM_MAX_PACKETS; idx++)
+        {
+            send_frame(TEST_THROUGHPUT_FRAME_SIZE);
+        }
+
+        if ((WWD_SUCCESS != transmit(&count)) || (WWD_SDPCM_TX_GLOM_MAX_PACKETS != count))
+        {
+            printf("[FAIL] superframe %d not sent whole\r\n", superframes);
+            g_testFailures++;
+            break;
+        }
+
+        frames += count;
+        superframes++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    s_checkFrames = true;
+
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    configPRINTF(("%d frames of %d bytes in %d superframes: %.0f frames/s\r\n", frames, TEST_THROUGHPUT_FRAME_SIZE,
+                  superframes, frames / seconds));
+}
+
+int main(void)
+{
+    TEST_CHECK(WWD_SUCCESS == wwd_sdpcm_init());
+
+    test_credits();
+    test_superframe_layout();
+    test_superframe_limits();
+    test_latency();
+    test_rx_superframe();
+    test_rx_malformed();
+    test_rx_no_buffer();
+    test_throughput();
+
+    wwd_sdpcm_quit();
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_TX));
+    TEST_CHECK(0 == HOST_WWD_GetBufferCount(WWD_NETWORK_RX));
+
+    return TEST_HOST_Result("WWD superframes");
+}
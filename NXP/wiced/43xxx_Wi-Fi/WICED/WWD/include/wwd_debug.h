@@ -279,6 +279,9 @@ int platform_wprint_permission(void);
 #define WWD_STATS_CONDITIONAL_INCREMENT_VARIABLE( condition, var )     \
     do { if (condition) { wwd_stats.var++; }} while ( 0 )
 
+#define WWD_STATS_ADD_TO_VARIABLE( var, value )                        \
+    do { wwd_stats.var += (value); } while ( 0 )
+
 typedef struct
 {
     uint32_t tx_total;      /* Total number of TX packets sent from WWD */
@@ -288,6 +291,10 @@ typedef struct
     uint32_t tx_fail;       /* Number of times TX packet failed */
     uint32_t no_credit;     /* Number of times WWD could not send due to no credit */
     uint32_t flow_control;  /* Number of times WWD Flow control is enabled */
+    uint32_t tx_superframes;        /* Number of bus transfers of glommed TX packets */
+    uint32_t tx_superframe_packets; /* Number of TX packets sent in those transfers */
+    uint32_t rx_superframes;        /* Number of superframes received */
+    uint32_t rx_superframe_packets; /* Number of RX packets received in superframes */
 } wwd_stats_t;
 extern wwd_stats_t wwd_stats;
 
@@ -295,6 +302,7 @@ extern wwd_stats_t wwd_stats;
 
 #define WWD_STATS_INCREMENT_VARIABLE( var )
 #define WWD_STATS_CONDITIONAL_INCREMENT_VARIABLE( condition, var )
+#define WWD_STATS_ADD_TO_VARIABLE( var, value )
 
 #endif /* WWD_ENABLE_STATS */
 extern void wwd_init_stats ( void );
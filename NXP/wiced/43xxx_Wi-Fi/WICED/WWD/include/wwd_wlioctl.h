@@ -749,6 +749,7 @@ typedef struct eventmsgs_ext
 #define IOVAR_PSPOLL_PERIOD              "pspoll_prd"
 #define IOVAR_STR_VENDOR_IE              "vndr_ie"
 #define IOVAR_STR_TX_GLOM                "bus:txglom"
+#define IOVAR_STR_RX_GLOM                "bus:rxglom"
 #define IOVAR_STR_ACTION_FRAME           "wifiaction"
 #define IOVAR_STR_AC_PARAMS_STA          "wme_ac_sta"
 #define IOVAR_STR_COUNTERS               "counters"
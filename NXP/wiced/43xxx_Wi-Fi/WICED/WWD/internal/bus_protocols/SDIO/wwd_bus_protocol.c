@@ -108,6 +108,10 @@ static wiced_bool_t wwd_bus_flow_controlled = WICED_FALSE;
 wwd_bus_stats_t wwd_bus_stats;
 #endif /* WWD_ENABLE_STATS */
 
+#ifdef WWD_SDPCM_GLOM
+static uint32_t wwd_bus_rx_superframe[ WWD_SDPCM_RX_GLOM_MAX_BYTES / sizeof(uint32_t) ];
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 extern sdio_bus_width_t g_buswidth;
 
 /******************************************************
@@ -181,6 +185,9 @@ void wwd_wait_for_wlan_event( host_semaphore_type_t* transceive_semaphore )
     wwd_result_t result = WWD_SUCCESS;
     uint32_t timeout_ms = 1;
     uint32_t delayed_release_timeout_ms;
+#ifdef WWD_SDPCM_GLOM
+    uint32_t glom_wait_ms;
+#endif /* ifdef WWD_SDPCM_GLOM */
 
     REFERENCE_DEBUG_ONLY_VARIABLE( result );
 
@@ -200,6 +207,15 @@ void wwd_wait_for_wlan_event( host_semaphore_type_t* transceive_semaphore )
         }
     }
 
+#ifdef WWD_SDPCM_GLOM
+    /* Wake up when a packet held back for glomming has waited long enough */
+    glom_wait_ms = wwd_sdpcm_get_tx_glom_wait_time( );
+    if ( glom_wait_ms != 0 )
+    {
+        timeout_ms = MIN( timeout_ms, glom_wait_ms );
+    }
+#endif /* ifdef WWD_SDPCM_GLOM */
+
     /* Check if we have run out of bus credits */
     if ( wwd_sdpcm_has_tx_packet() == WICED_TRUE && wwd_sdpcm_get_available_credits( ) == 0 )
     {
@@ -230,6 +246,19 @@ wwd_result_t wwd_bus_send_buffer( wiced_buffer_t buffer )
     return retval;
 }
 
+#ifdef WWD_SDPCM_GLOM
+wwd_result_t wwd_bus_send_superframe( uint8_t* data, uint16_t size )
+{
+    wwd_result_t retval;
+    retval = wwd_bus_transfer_bytes( BUS_WRITE, WLAN_FUNCTION, 0, size, (wwd_transfer_bytes_packet_t*) data );
+    if ( retval == WWD_SUCCESS )
+    {
+        DELAYED_BUS_RELEASE_SCHEDULE( WICED_TRUE );
+    }
+    return retval;
+}
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 wwd_result_t wwd_bus_init( void )
 {
     uint8_t        byte_data;
@@ -520,12 +549,32 @@ wwd_result_t wwd_bus_read_frame( /*@out@*/ wiced_buffer_t* buffer )
     uint16_t hwtag[8];
     uint16_t extra_space_required;
     wwd_result_t result;
+#ifdef WWD_SDPCM_GLOM
+    uint16_t superframe_size;
+#endif /* ifdef WWD_SDPCM_GLOM */
 
     *buffer = NULL;
 
     /* Ensure the wlan backplane bus is up */
     VERIFY_RESULT( wwd_ensure_wlan_bus_is_up() );
 
+#ifdef WWD_SDPCM_GLOM
+    /* A glom descriptor announced a superframe: read it whole, its packets are processed from there */
+    superframe_size = wwd_sdpcm_take_rx_superframe_size( );
+    if ( superframe_size != 0 )
+    {
+        result = wwd_bus_sdio_transfer(BUS_READ, WLAN_FUNCTION, 0, superframe_size, (uint8_t*) wwd_bus_rx_superframe, RESPONSE_NEEDED);
+        if ( result != WWD_SUCCESS )
+        {
+            (void) wwd_bus_sdio_abort_read( WICED_FALSE ); /* ignore return - not much can be done if this fails */
+            return WWD_SDIO_RX_FAIL;
+        }
+        DELAYED_BUS_RELEASE_SCHEDULE( WICED_TRUE );
+        wwd_sdpcm_process_rx_superframe( (uint8_t*) wwd_bus_rx_superframe, superframe_size );
+        return WWD_SUCCESS;
+    }
+#endif /* ifdef WWD_SDPCM_GLOM */
+
     /* Read the frame header and verify validity */
     memset( hwtag, 0, sizeof(hwtag) );
 
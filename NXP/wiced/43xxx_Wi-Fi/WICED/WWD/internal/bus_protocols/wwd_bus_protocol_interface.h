@@ -93,6 +93,9 @@ extern wwd_result_t wwd_bus_read_register_value        ( wwd_bus_function_t func
 
 /* Device data transfer functions */
 extern wwd_result_t wwd_bus_send_buffer                ( wiced_buffer_t buffer );
+#ifdef WWD_SDPCM_GLOM
+extern wwd_result_t wwd_bus_send_superframe            ( uint8_t* data, uint16_t size );
+#endif /* ifdef WWD_SDPCM_GLOM */
 extern wwd_result_t wwd_bus_transfer_bytes             ( wwd_bus_transfer_direction_t direction, wwd_bus_function_t function, uint32_t address, uint16_t size, /*@in@*/ /*@out@*/ wwd_transfer_bytes_packet_t* data );
 extern wwd_result_t wwd_bus_transfer_backplane_bytes   ( wwd_bus_transfer_direction_t direction, uint32_t address, uint32_t size, /*@in@*/ /*@out@*/ uint8_t* data );
 
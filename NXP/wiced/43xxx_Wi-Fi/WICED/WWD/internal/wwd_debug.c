@@ -65,9 +65,11 @@ wwd_result_t wwd_print_stats ( wiced_bool_t reset_after_print )
 #ifdef WWD_ENABLE_STATS
     WPRINT_MACRO(( "WWD Stats.. \n"
                    "tx_total:%ld, rx_total:%ld, tx_no_mem:%ld, rx_no_mem:%ld\n"
-                   "tx_fail:%ld, no_credit:%ld, flow_control:%ld\n",
+                   "tx_fail:%ld, no_credit:%ld, flow_control:%ld\n"
+                   "tx_superframes:%ld, tx_superframe_packets:%ld, rx_superframes:%ld, rx_superframe_packets:%ld\n",
                    wwd_stats.tx_total, wwd_stats.rx_total, wwd_stats.tx_no_mem, wwd_stats.rx_no_mem,
-                   wwd_stats.tx_fail, wwd_stats.no_credit, wwd_stats.flow_control ));
+                   wwd_stats.tx_fail, wwd_stats.no_credit, wwd_stats.flow_control,
+                   wwd_stats.tx_superframes, wwd_stats.tx_superframe_packets, wwd_stats.rx_superframes, wwd_stats.rx_superframe_packets ));
 
     if ( reset_after_print == WICED_TRUE )
     {
@@ -206,7 +206,7 @@ wwd_result_t wwd_management_wifi_on( wiced_country_code_t country )
     wwd_wifi_set_mac_address(mac_address);
 #endif
 
-    /* Turn off SDPCM TX Glomming */
+    /* Turn off SDPCM TX Glomming (superframes sent by the WLAN chip), unless WWD can receive them */
     /* Note: This is only required for later chips.
      * The 4319 has glomming off by default however the 43362 has it on by default.
      */
@@ -218,15 +218,38 @@ wwd_result_t wwd_management_wifi_on( wiced_country_code_t country )
         return WWD_BUFFER_ALLOC_FAIL;
         /*@-unreachable@*/
     }
+#ifdef WWD_SDPCM_GLOM
+    *data = 1;
+#else
     *data = 0;
+#endif /* ifdef WWD_SDPCM_GLOM */
     retval = wwd_sdpcm_send_iovar( SDPCM_SET, buffer, 0, WWD_STA_INTERFACE );
     if (( retval != WWD_SUCCESS ) && (retval != WWD_UNSUPPORTED))
     {
         /* Note: System may time out here if bus interrupts are not working properly */
-        WPRINT_WWD_ERROR(("Could not turn off TX glomming\n"));
+        WPRINT_WWD_ERROR(("Could not set TX glomming\n"));
         return retval;
     }
 
+#ifdef WWD_SDPCM_GLOM
+    /* Let the WLAN chip receive the superframes built by WWD; until it accepts, the packets are sent one by one */
+    wwd_sdpcm_set_tx_glom_enabled( WICED_FALSE );
+    data = (uint32_t*) wwd_sdpcm_get_iovar_buffer( &buffer, (uint16_t) 4, IOVAR_STR_RX_GLOM );
+    if ( data == NULL )
+    {
+        wiced_assert( "Could not get buffer for IOVAR", 0 != 0 );
+        return WWD_BUFFER_ALLOC_FAIL;
+    }
+    *data = (uint32_t) 1;
+    retval = wwd_sdpcm_send_iovar( SDPCM_SET, buffer, 0, WWD_STA_INTERFACE );
+    if ( ( retval != WWD_SUCCESS ) && ( retval != WWD_UNSUPPORTED ) )
+    {
+        WPRINT_WWD_ERROR(("Could not turn on RX glomming\n"));
+        return retval;
+    }
+    wwd_sdpcm_set_tx_glom_enabled( ( retval == WWD_SUCCESS ) ? WICED_TRUE : WICED_FALSE );
+#endif /* ifdef WWD_SDPCM_GLOM */
+
     /* Turn APSTA on */
     data = (uint32_t*) wwd_sdpcm_get_iovar_buffer( &buffer, (uint16_t) sizeof(*data), IOVAR_STR_APSTA );
     if ( data == NULL )
@@ -99,6 +99,13 @@
 #define SDPCM_HEADER_LEN              (12)
 #define BDC_HEADER_LEN                 (4)
 
+#define SDPCM_GLOM_CHANNEL             (3)      /** Channel of the superframe headers and glom descriptors */
+#define SDPCM_GLOMDESC_FLAG         (0x80)      /** Flag of the glom descriptors in the channel_and_flags field */
+#define SDPCM_HWEXT_LEN                (8)      /** Hardware extension header of each packet of a transmitted superframe */
+#define SDPCM_HWEXT_LAST_FRAME_SHIFT  (24)      /** Bit of the first hardware extension word marking the last packet */
+#define SDPCM_HWEXT_TAIL_PAD_SHIFT    (16)      /** Shift of the tail padding in the second hardware extension word */
+#define SDPCM_GLOM_ALIGN               (4)      /** Alignment of the packets of a transmitted superframe */
+
 /* Event flags */
 #define WLC_EVENT_MSG_LINK      (0x01)    /** link is up */
 #define WLC_EVENT_MSG_FLUSHTXQ  (0x02)    /** flush tx queue on MIC error */
@@ -200,6 +207,13 @@ typedef struct
     sdpcm_header_t         sdpcm_header;
 } sdpcm_common_header_t;
 
+typedef struct
+{
+    uint16_t           frametag[2];
+    uint32_t           hwext[2];     /* Length and last frame flag, tail padding */
+    sdpcm_sw_header_t  sw_header;
+} sdpcm_glom_header_t;
+
 typedef struct
 {
     sdpcm_common_header_t  common;
@@ -295,6 +309,17 @@ static wiced_buffer_t /*@owned@*/ /*@null@*/ wwd_sdpcm_send_queue_tail   = (wice
 
 static wwd_wifi_raw_packet_processor_t       wwd_sdpcm_raw_packet_processor = NULL;
 
+#ifdef WWD_SDPCM_GLOM
+static uint32_t     wwd_sdpcm_tx_superframe[ WWD_SDPCM_TX_GLOM_MAX_BYTES / sizeof(uint32_t) ];
+static wiced_bool_t wwd_sdpcm_tx_glom_enabled       = WICED_FALSE;
+static wwd_time_t   wwd_sdpcm_send_queue_start_time = 0;
+static wiced_bool_t wwd_sdpcm_send_queue_may_wait   = WICED_FALSE;
+
+static uint16_t     wwd_sdpcm_rx_superframe_size    = 0;
+static uint16_t     wwd_sdpcm_rx_subframe_sizes[ WWD_SDPCM_RX_GLOM_MAX_PACKETS ];
+static uint8_t      wwd_sdpcm_rx_subframe_count     = 0;
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 static uint32_t        wwd_host_interface_to_bss_index_array[3] = { WWD_STA_INTERFACE, WWD_AP_INTERFACE, WWD_P2P_INTERFACE }; /* Default mapping of host interface to BSS index */
 static wwd_interface_t wwd_bss_index_to_host_interface_array[3] = { WWD_STA_INTERFACE, WWD_AP_INTERFACE, WWD_P2P_INTERFACE };
 
@@ -361,6 +386,9 @@ static void            wwd_sdpcm_set_next_buffer_in_queue ( wiced_buffer_t buffe
 static void            wwd_sdpcm_send_common              ( /*@only@*/ wiced_buffer_t buffer, sdpcm_header_type_t header_type );
 static uint8_t         wwd_map_dscp_to_priority           ( uint8_t dscp_val );
 static wwd_interface_t wwd_wifi_get_source_interface      ( uint8_t flags2 );
+#ifdef WWD_SDPCM_GLOM
+static void            wwd_sdpcm_process_rx_glom_descriptor( sdpcm_common_header_t* packet, uint16_t size );
+#endif /* ifdef WWD_SDPCM_GLOM */
 /******************************************************
  *             Function definitions
  ******************************************************/
@@ -857,6 +885,16 @@ void wwd_sdpcm_process_rx_packet( /*@only@*/ wiced_buffer_t buffer )
             }
             break;
 
+#ifdef WWD_SDPCM_GLOM
+        case SDPCM_GLOM_CHANNEL:
+            if ( ( packet->sdpcm_header.sw_header.channel_and_flags & SDPCM_GLOMDESC_FLAG ) != 0 )
+            {
+                wwd_sdpcm_process_rx_glom_descriptor( packet, size );
+            }
+            host_buffer_release( buffer, WWD_NETWORK_RX );
+            break;
+#endif /* ifdef WWD_SDPCM_GLOM */
+
         default:
             wiced_minor_assert("SDPCM packet of unknown channel received - dropping packet", 0 != 0);
             host_buffer_release( buffer, WWD_NETWORK_RX );
@@ -1386,6 +1424,241 @@ uint8_t wwd_sdpcm_get_available_credits( void )
     return (uint8_t)( wwd_sdpcm_last_bus_data_credit - wwd_sdpcm_packet_transmit_sequence_number );
 }
 
+#ifdef WWD_SDPCM_GLOM
+/** Records whether the WLAN chip accepts superframes from the host
+ *
+ *  Set once the chip has taken the "bus:rxglom" IOVAR. Until then, and if it refused it,
+ *  the packets are sent one by one.
+ *
+ * @param enabled : WICED_TRUE if the packets may be sent in superframes
+ */
+void wwd_sdpcm_set_tx_glom_enabled( wiced_bool_t enabled )
+{
+    wwd_sdpcm_tx_glom_enabled = enabled;
+}
+
+/** Returns whether the packets are sent in superframes
+ *
+ * @return WICED_TRUE if the WLAN chip accepts superframes from the host
+ */
+wiced_bool_t wwd_sdpcm_is_tx_glom_enabled( void )
+{
+    return wwd_sdpcm_tx_glom_enabled;
+}
+
+/** Returns how long the packet queued alone may still wait for others to be sent with
+ *
+ *  Only a data packet, queued when the send queue was empty, waits; and for
+ *  WWD_SDPCM_TX_GLOM_LATENCY_MS at most. IOCTLs are never held back.
+ *
+ * @return Time to wait in milliseconds, 0 if the queued packets should be sent now
+ */
+uint32_t wwd_sdpcm_get_tx_glom_wait_time( void )
+{
+#if ( WWD_SDPCM_TX_GLOM_LATENCY_MS > 0 )
+    sdpcm_common_header_t* packet;
+    wwd_time_t             waited;
+
+    if ( ( wwd_sdpcm_tx_glom_enabled == WICED_FALSE ) || ( wwd_sdpcm_send_queue_head == NULL ) ||
+         ( wwd_sdpcm_send_queue_head != wwd_sdpcm_send_queue_tail ) || ( wwd_sdpcm_send_queue_may_wait == WICED_FALSE ) )
+    {
+        return 0;
+    }
+
+    packet = (sdpcm_common_header_t*) host_buffer_get_current_piece_data_pointer( wwd_sdpcm_send_queue_head );
+    if ( ( packet->sdpcm_header.sw_header.channel_and_flags & 0x0f ) != (uint8_t) DATA_HEADER )
+    {
+        return 0;
+    }
+
+    waited = host_rtos_get_time( ) - wwd_sdpcm_send_queue_start_time;
+    if ( waited >= (wwd_time_t) WWD_SDPCM_TX_GLOM_LATENCY_MS )
+    {
+        return 0;
+    }
+    return (uint32_t) ( WWD_SDPCM_TX_GLOM_LATENCY_MS - waited );
+#else
+    return 0;
+#endif /* if ( WWD_SDPCM_TX_GLOM_LATENCY_MS > 0 ) */
+}
+
+/** Gets a superframe of queued packets to send
+ *
+ *  Takes packets from the send queue while the bus data credits, WWD_SDPCM_TX_GLOM_MAX_PACKETS and
+ *  the superframe buffer allow, and copies them one after the other, each with its hardware extension
+ *  header and padded to SDPCM_GLOM_ALIGN. The packets are released once copied.
+ *
+ * @param data         : receives the superframe, valid until the next call
+ * @param size         : receives the size of the superframe
+ * @param packet_count : receives the number of packets in the superframe
+ *
+ * @return WWD_SUCCESS, WWD_PENDING while a lone packet waits for others, or the result
+ *         of @ref wwd_sdpcm_get_packet_to_send if no packet could be taken
+ */
+wwd_result_t wwd_sdpcm_get_superframe_to_send( /*@out@*/ uint8_t** data, /*@out@*/ uint16_t* size, /*@out@*/ uint8_t* packet_count )
+{
+    uint8_t*               superframe  = (uint8_t*) wwd_sdpcm_tx_superframe;
+    sdpcm_glom_header_t*   glom_header = NULL;
+    sdpcm_common_header_t* packet;
+    wiced_buffer_t         buffer;
+    wwd_result_t           result;
+    uint16_t               offset = 0;
+    uint16_t               length;
+    uint16_t               tail_pad;
+    uint8_t                count  = 0;
+
+    *data         = superframe;
+    *size         = 0;
+    *packet_count = 0;
+
+    if ( wwd_sdpcm_get_tx_glom_wait_time( ) != 0 )
+    {
+        return WWD_PENDING;
+    }
+
+    while ( ( count < (uint8_t) WWD_SDPCM_TX_GLOM_MAX_PACKETS ) && ( wwd_sdpcm_send_queue_head != NULL ) )
+    {
+        /* Only this thread takes packets off the queue, the head can be looked at without the mutex */
+        packet   = (sdpcm_common_header_t*) host_buffer_get_current_piece_data_pointer( wwd_sdpcm_send_queue_head );
+        length   = (uint16_t) ( packet->sdpcm_header.frametag[0] + SDPCM_HWEXT_LEN );
+        tail_pad = (uint16_t) ( ROUND_UP( length, SDPCM_GLOM_ALIGN ) - length );
+        if ( ( (uint32_t) offset + length + tail_pad ) > sizeof(wwd_sdpcm_tx_superframe) )
+        {
+            wiced_assert( "Packet larger than the superframe buffer", count != 0 );
+            break;
+        }
+
+        result = wwd_sdpcm_get_packet_to_send( &buffer );
+        if ( result != WWD_SUCCESS )
+        {
+            if ( count == 0 )
+            {
+                return result;
+            }
+            break;
+        }
+
+        /* Copy the packet with the hardware extension header inserted after the frame tag */
+        packet      = (sdpcm_common_header_t*) host_buffer_get_current_piece_data_pointer( buffer );
+        glom_header = (sdpcm_glom_header_t*) &superframe[ offset ];
+        memcpy( &glom_header->sw_header, &packet->sdpcm_header.sw_header, (size_t) ( packet->sdpcm_header.frametag[0] - sizeof(packet->sdpcm_header.frametag) ) );
+        glom_header->frametag[0]             = (uint16_t) ( length + tail_pad );
+        glom_header->frametag[1]             = (uint16_t) ~( length + tail_pad );
+        glom_header->hwext[0]                = length;
+        glom_header->hwext[1]                = (uint32_t) tail_pad << SDPCM_HWEXT_TAIL_PAD_SHIFT;
+        glom_header->sw_header.header_length = (uint8_t) ( glom_header->sw_header.header_length + SDPCM_HWEXT_LEN );
+        memset( &superframe[ offset + length ], 0, tail_pad );
+        host_buffer_release( buffer, WWD_NETWORK_TX );
+
+        offset = (uint16_t) ( offset + length + tail_pad );
+        count++;
+    }
+
+    if ( glom_header == NULL )
+    {
+        return WWD_NO_PACKET_TO_SEND;
+    }
+    glom_header->hwext[0] |= (uint32_t) 1 << SDPCM_HWEXT_LAST_FRAME_SHIFT;
+
+    /* The packets left over did not fit, they are sent next without waiting */
+    wwd_sdpcm_send_queue_may_wait = WICED_FALSE;
+
+    *size         = offset;
+    *packet_count = count;
+    return WWD_SUCCESS;
+}
+
+/** Returns the size of the superframe announced by the last glom descriptor, to be read next
+ *
+ *  The superframe is announced once: a second call returns 0.
+ *
+ * @return Size of the superframe in bytes, 0 if the next frame is a single packet
+ */
+uint16_t wwd_sdpcm_take_rx_superframe_size( void )
+{
+    uint16_t size = wwd_sdpcm_rx_superframe_size;
+
+    wwd_sdpcm_rx_superframe_size = 0;
+    return size;
+}
+
+/** Splits a received superframe into packets and processes them
+ *
+ *  The superframe starts with its own SDPCM header on the glom channel, then come the packets,
+ *  each taking the space given by the glom descriptor, the first one including the superframe header.
+ *  Each packet is copied into a buffer of its own and passed to @ref wwd_sdpcm_process_rx_packet.
+ *
+ * @param data : The superframe read from the bus
+ * @param size : Size of the superframe
+ */
+void wwd_sdpcm_process_rx_superframe( uint8_t* data, uint16_t size )
+{
+    sdpcm_header_t* header = (sdpcm_header_t*) data;
+    wiced_buffer_t  buffer;
+    uint16_t        offset;
+    uint16_t        space;
+    uint16_t        length;
+    uint8_t         i;
+
+    /* Check the superframe header */
+    if ( ( size < (uint16_t) SDPCM_HEADER_LEN ) ||
+         ( ( header->frametag[0] ^ header->frametag[1] ) != (uint16_t) 0xFFFF ) ||
+         ( header->frametag[0] > size ) ||
+         ( ( header->sw_header.channel_and_flags & 0x0f ) != (uint8_t) SDPCM_GLOM_CHANNEL ) ||
+         ( header->sw_header.header_length < (uint8_t) SDPCM_HEADER_LEN ) ||
+         ( header->sw_header.header_length > wwd_sdpcm_rx_subframe_sizes[0] ) )
+    {
+        WPRINT_WWD_DEBUG(("Received a superframe with an invalid header\n"));
+        wwd_sdpcm_rx_subframe_count = 0;
+        return;
+    }
+
+    WWD_STATS_INCREMENT_VARIABLE( rx_superframes );
+
+    offset = header->sw_header.header_length;
+    space  = (uint16_t) ( wwd_sdpcm_rx_subframe_sizes[0] - offset );
+
+    for ( i = 0; i < wwd_sdpcm_rx_subframe_count; i++ )
+    {
+        if ( i != 0 )
+        {
+            space = wwd_sdpcm_rx_subframe_sizes[i];
+        }
+        if ( ( (uint32_t) offset + space ) > size )
+        {
+            WPRINT_WWD_DEBUG(("Superframe shorter than its glom descriptor\n"));
+            break;
+        }
+
+        header = (sdpcm_header_t*) &data[ offset ];
+        length = header->frametag[0];
+        if ( ( ( length ^ header->frametag[1] ) != (uint16_t) 0xFFFF ) || ( length < (uint16_t) SDPCM_HEADER_LEN ) || ( length > space ) )
+        {
+            WPRINT_WWD_DEBUG(("Received a superframe packet with a frametag which is wrong\n"));
+            break;
+        }
+
+        if ( host_buffer_get( &buffer, WWD_NETWORK_RX, (unsigned short) ( length + sizeof(wwd_buffer_header_t) ), WICED_FALSE ) != WWD_SUCCESS )
+        {
+            /* Drop the packet, but not the bus data credits it carries */
+            WWD_STATS_INCREMENT_VARIABLE( rx_no_mem );
+            wwd_sdpcm_update_credit( (uint8_t*) header );
+        }
+        else
+        {
+            memcpy( host_buffer_get_current_piece_data_pointer( buffer ) + sizeof(wwd_buffer_header_t), header, length );
+            WWD_STATS_INCREMENT_VARIABLE( rx_total );
+            WWD_STATS_INCREMENT_VARIABLE( rx_superframe_packets );
+            wwd_sdpcm_process_rx_packet( buffer );
+        }
+
+        offset = (uint16_t) ( offset + space );
+    }
+
+    wwd_sdpcm_rx_subframe_count = 0;
+}
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 
 /** Sets a handler functions for monitor mode
  *
@@ -1475,6 +1748,10 @@ static void wwd_sdpcm_send_common( /*@only@*/ wiced_buffer_t buffer, sdpcm_heade
     if ( wwd_sdpcm_send_queue_head == NULL )
     {
         wwd_sdpcm_send_queue_head = buffer;
+#ifdef WWD_SDPCM_GLOM
+        wwd_sdpcm_send_queue_start_time = host_rtos_get_time( );
+        wwd_sdpcm_send_queue_may_wait   = WICED_TRUE;
+#endif /* ifdef WWD_SDPCM_GLOM */
     }
     host_rtos_set_semaphore( &wwd_sdpcm_send_queue_mutex, WICED_FALSE );
 
@@ -1482,6 +1759,55 @@ static void wwd_sdpcm_send_common( /*@only@*/ wiced_buffer_t buffer, sdpcm_heade
 }
 
 
+#ifdef WWD_SDPCM_GLOM
+/** Records the packets of the superframe announced by a glom descriptor
+ *
+ *  The descriptor lists the space of each packet of the superframe the WLAN chip sends next,
+ *  as 16 bit little endian sizes.
+ *
+ * @param packet : The glom descriptor packet
+ * @param size   : Size of the packet, from its frame tag
+ */
+static void wwd_sdpcm_process_rx_glom_descriptor( sdpcm_common_header_t* packet, uint16_t size )
+{
+    uint8_t* sizes = &( (uint8_t*) &packet->sdpcm_header )[ packet->sdpcm_header.sw_header.header_length ];
+    uint16_t count;
+    uint32_t total = 0;
+    uint16_t i;
+
+    wwd_sdpcm_rx_superframe_size = 0;
+    wwd_sdpcm_rx_subframe_count  = 0;
+
+    if ( packet->sdpcm_header.sw_header.header_length >= size )
+    {
+        WPRINT_WWD_DEBUG(("Received an empty glom descriptor\n"));
+        return;
+    }
+
+    count = (uint16_t) ( ( size - packet->sdpcm_header.sw_header.header_length ) / sizeof(uint16_t) );
+    if ( count > (uint16_t) WWD_SDPCM_RX_GLOM_MAX_PACKETS )
+    {
+        wiced_minor_assert( "Superframe has too many packets", 0 == 1 );
+        return;
+    }
+
+    for ( i = 0; i < count; i++ )
+    {
+        wwd_sdpcm_rx_subframe_sizes[i] = (uint16_t) ( sizes[ 2 * i ] | ( sizes[ 2 * i + 1 ] << 8 ) );
+        total += wwd_sdpcm_rx_subframe_sizes[i];
+    }
+
+    if ( ( count == 0 ) || ( total > (uint32_t) WWD_SDPCM_RX_GLOM_MAX_BYTES ) )
+    {
+        wiced_minor_assert( "Superframe too large for the receive buffer", 0 == 1 );
+        return;
+    }
+
+    wwd_sdpcm_rx_subframe_count  = (uint8_t) count;
+    wwd_sdpcm_rx_superframe_size = (uint16_t) total;
+}
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 static wiced_buffer_t wwd_sdpcm_get_next_buffer_in_queue( wiced_buffer_t buffer )
 {
     wwd_buffer_header_t* packet = (wwd_buffer_header_t*) host_buffer_get_current_piece_data_pointer( buffer );
@@ -65,6 +65,34 @@ typedef enum sdpcm_command_type_enum
     SDPCM_SET = CDCF_IOC_SET
 } sdpcm_command_type_t;
 
+/* SDPCM glomming: with WWD_SDPCM_GLOM defined, the queued packets are sent to the WLAN chip
+ * as superframes, several packets in one bus transfer, once the chip accepts them ("bus:rxglom").
+ * The superframes of the chip ("bus:txglom") are received in one transfer too.
+ */
+#ifdef WWD_SDPCM_GLOM
+
+#ifndef WWD_SDPCM_TX_GLOM_MAX_PACKETS
+#define WWD_SDPCM_TX_GLOM_MAX_PACKETS   (8)             /** Maximum number of packets in a transmitted superframe */
+#endif /* ifndef WWD_SDPCM_TX_GLOM_MAX_PACKETS */
+
+#ifndef WWD_SDPCM_TX_GLOM_MAX_BYTES
+#define WWD_SDPCM_TX_GLOM_MAX_BYTES     (8 * 1024)      /** Size of the transmit superframe buffer, a multiple of the bus block size */
+#endif /* ifndef WWD_SDPCM_TX_GLOM_MAX_BYTES */
+
+#ifndef WWD_SDPCM_TX_GLOM_LATENCY_MS
+#define WWD_SDPCM_TX_GLOM_LATENCY_MS    (0)             /** Time a lone data packet may wait for others to be sent with. 0: no wait */
+#endif /* ifndef WWD_SDPCM_TX_GLOM_LATENCY_MS */
+
+#ifndef WWD_SDPCM_RX_GLOM_MAX_PACKETS
+#define WWD_SDPCM_RX_GLOM_MAX_PACKETS   (16)            /** Maximum number of packets in a received superframe */
+#endif /* ifndef WWD_SDPCM_RX_GLOM_MAX_PACKETS */
+
+#ifndef WWD_SDPCM_RX_GLOM_MAX_BYTES
+#define WWD_SDPCM_RX_GLOM_MAX_BYTES     (8 * 1024)      /** Size of the receive superframe buffer, a multiple of the bus block size */
+#endif /* ifndef WWD_SDPCM_RX_GLOM_MAX_BYTES */
+
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 
 /* IOCTL swapping mode for Big Endian host with Little Endian wlan.  Default to off */
 #ifdef IL_BIGENDIAN
@@ -104,6 +132,14 @@ extern wiced_bool_t                   wwd_sdpcm_has_tx_packet( void );
 extern wwd_result_t                   wwd_sdpcm_get_packet_to_send                  ( /*@out@*/ wiced_buffer_t* buffer );
 extern void                           wwd_sdpcm_update_credit                       ( uint8_t* data );
 extern uint8_t                        wwd_sdpcm_get_available_credits               ( void );
+#ifdef WWD_SDPCM_GLOM
+extern void                           wwd_sdpcm_set_tx_glom_enabled                 ( wiced_bool_t enabled );
+extern wiced_bool_t                   wwd_sdpcm_is_tx_glom_enabled                  ( void );
+extern wwd_result_t                   wwd_sdpcm_get_superframe_to_send              ( /*@out@*/ uint8_t** data, /*@out@*/ uint16_t* size, /*@out@*/ uint8_t* packet_count );
+extern uint32_t                       wwd_sdpcm_get_tx_glom_wait_time               ( void );
+extern uint16_t                       wwd_sdpcm_take_rx_superframe_size             ( void );
+extern void                           wwd_sdpcm_process_rx_superframe               ( uint8_t* data, uint16_t size );
+#endif /* ifdef WWD_SDPCM_GLOM */
 extern void                           wwd_update_host_interface_to_bss_index_mapping( wwd_interface_t interface, uint32_t bssid_index );
 extern wwd_result_t wwd_sdpcm_register_fw_cmd_exit_hook( void (*func)( sdpcm_command_type_t type, uint32_t command, const char* name, wwd_interface_t interface ) );
 
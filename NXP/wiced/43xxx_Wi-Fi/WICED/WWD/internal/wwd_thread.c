@@ -149,6 +149,46 @@ wwd_result_t wwd_thread_init( void ) /*@globals undef wwd_thread, undef wwd_tran
     return WWD_SUCCESS;
 }
 
+#ifdef WWD_SDPCM_GLOM
+/** Sends the queued packets together in one superframe
+ *
+ * @return    1 : superframe was sent
+ *            0 : no packet sent
+ */
+static int8_t wwd_thread_send_superframe( void ) /*@modifies internalState @*/
+{
+    uint8_t* superframe;
+    uint16_t size;
+    uint8_t  packet_count;
+    wwd_result_t result;
+
+    if ( wwd_sdpcm_get_superframe_to_send( &superframe, &size, &packet_count ) != WWD_SUCCESS )
+    {
+        return 0;
+    }
+
+    /* Ensure the wlan backplane bus is up */
+    result = wwd_ensure_wlan_bus_is_up();
+    if ( result != WWD_SUCCESS )
+    {
+        wiced_assert("Could not bring bus back up", 0 != 0 );
+        return 0;
+    }
+
+    if ( wwd_bus_send_superframe( superframe, size ) != WWD_SUCCESS )
+    {
+        WWD_STATS_INCREMENT_VARIABLE( tx_fail );
+        WPRINT_WWD_ERROR(("error sending superframe\r\n" ));
+        return 0;
+    }
+
+    WWD_STATS_ADD_TO_VARIABLE( tx_total, packet_count );
+    WWD_STATS_INCREMENT_VARIABLE( tx_superframes );
+    WWD_STATS_ADD_TO_VARIABLE( tx_superframe_packets, packet_count );
+    return (int8_t) 1;
+}
+#endif /* ifdef WWD_SDPCM_GLOM */
+
 /** Sends the first queued packet
  *
  * Checks the queue to determine if there is any packets waiting
@@ -166,6 +206,14 @@ int8_t wwd_thread_send_one_packet( void ) /*@modifies internalState @*/
     wiced_buffer_t tmp_buf_hnd = NULL;
     wwd_result_t result;
 
+#ifdef WWD_SDPCM_GLOM
+    /* Once the WLAN chip accepts them, the queued packets go together in one superframe */
+    if ( wwd_sdpcm_is_tx_glom_enabled( ) == WICED_TRUE )
+    {
+        return wwd_thread_send_superframe( );
+    }
+#endif /* ifdef WWD_SDPCM_GLOM */
+
     if ( wwd_sdpcm_get_packet_to_send( &tmp_buf_hnd ) != WWD_SUCCESS )
     {
         /*@-mustfreeonly@*/ /* Failed to get a packet */